@@ -17,10 +17,23 @@
  *
  * This plug-in provides an OpenSSL ECDSA implementation for BGPSEC.
  *
- * @version 0.3.0.0
+ * @version 0.4.0.0
  *
  * ChangeLog:
  * -----------------------------------------------------------------------------
+ *   0.4.0.0 - 2026/10/18
+ *             * Added the verify cache. Signature segments that were verified
+ *               once are not verified again until the key is removed.
+ *             * Added verify threads. The signature segments of one path
+ *               are verified in parallel if configured using THREADS:<n>.
+ *             * Added validateBatch.
+ *             * The message digests of all signature segments are generated
+ *               together using the multi buffer SHA256 (sha256_mb).
+ *             * Keys retrieved from the key storage are released using
+ *               ks_releaseKey.
+ *             * Keys, signatures and the SHA256 fallback use the crypto
+ *               backend. Built with BOSSL_EVP the plug-in uses EVP_PKEY
+ *               (libSRxBGPSecOpenSSL3).
  *   0.3.0.0 - 2017/09/13 - oborchert
  *             * Modified init in such that not finding the ski-list file during
  *               init does NOT return an ERROR, it returns a USER INFO instead. 
@@ -108,16 +121,65 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <setjmp.h>
+#include <pthread.h>
 
 
 /* general API header which will be public to the customer side */
 #include "../srx/srxcryptoapi.h"
+#include "crypto_backend.h"
 #include "key_storage.h"
+#include "verify_cache.h"
+#include "sha256_mb.h"
 
 /** This define is used in init() to specify if configured keys should
  * immediately be converted into EC_KEYs*/
 #define DO_CONVERT true
 #define DEBUG_TBD
+/** The maximum number of verify threads that can be configured. */
+#define BOSSL_MAX_VERIFY_THREADS    16
+/** Paths with fewer signature segments are validated by the caller alone. */
+#define BOSSL_MIN_PARALLEL_SEGMENTS 2
+/** Up to this number of segments the message digests are kept on the stack */
+#define BOSSL_STACK_SEGMENTS        16
+/** The init value token that specifies the number of verify threads. */
+#define BOSSL_THREADS_TOKEN         "THREADS:"
+
+/** The validation of all signature segments of one path. */
+typedef struct _BOSSL_VerifyJob {
+  /** The validation data of the path */
+  SCA_BGPSecValidationData* data;
+  /** The number of signature segments */
+  int          segmentCount;
+  /** The message digests of the signature segments */
+  u_int8_t*    digests;
+  /** The next segment to be claimed, protected by the pool mutex */
+  int          nextIdx;
+  /** The number of segments not yet finished */
+  int          pending;
+  /** Set once a segment is found invalid */
+  bool         failed;
+  /** The combined status of all segments */
+  sca_status_t status;
+  /** The next job with unclaimed segments */
+  struct _BOSSL_VerifyJob* next;
+} BOSSL_VerifyJob;
+
+/** The threads verifying signature segments of queued jobs. */
+typedef struct {
+  pthread_t        threads[BOSSL_MAX_VERIFY_THREADS];
+  /** The number of running threads */
+  int              numThreads;
+  /** Tells the threads to terminate */
+  bool             stop;
+  /** The jobs with unclaimed segments */
+  BOSSL_VerifyJob* jobs;
+  /** Protects the list of jobs and the segment claims */
+  pthread_mutex_t  mutex;
+  /** Signaled when a job is added or the threads have to stop */
+  pthread_cond_t   jobCond;
+  /** Signaled when the last segment of a job is finished */
+  pthread_cond_t   doneCond;
+} BOSSL_VerifyPool;
 
 /** indicates if the library is initialized */
 static bool BOSSL_initialized = false;
@@ -125,7 +187,21 @@ static bool BOSSL_initialized = false;
 static KeyStorage* BOSSL_pubKeys = NULL;
 /** contains the private key storage. The more keys the slower signing. */
 static KeyStorage* BOSSL_privKeys = NULL;
+/** contains the signature segments verified already. */
+static VerifyCache BOSSL_verifyCache;
+/** indicates if the verify cache could be initialized. */
+static bool BOSSL_useVerifyCache = false;
+/** the number of threads that verify signature segments next to the caller. */
+static int BOSSL_verifyThreads = 0;
+/** the threads used to verify the signature segments of one path in parallel */
+static BOSSL_VerifyPool BOSSL_verifyPool = {
+  .numThreads = 0, .stop = false, .jobs = NULL,
+  .mutex    = PTHREAD_MUTEX_INITIALIZER,
+  .jobCond  = PTHREAD_COND_INITIALIZER,
+  .doneCond = PTHREAD_COND_INITIALIZER
+};
 inline void printHex(int , unsigned char* );
+static void* _verifyThreadLoop(void* arg);
 
 /**
  * Read the given file and pre-load all keys. The following non error status
@@ -276,6 +352,52 @@ static void _readKeyFile(char* fName, bool isPrivate, sca_status_t* status,
   }
 }
 
+/**
+ * Start the configured number of verify threads.
+ *
+ * @since 0.4.0.0
+ */
+static void _startVerifyThreads()
+{
+  int idx = 0;
+
+  BOSSL_verifyPool.stop       = false;
+  BOSSL_verifyPool.jobs       = NULL;
+  BOSSL_verifyPool.numThreads = 0;
+  for (; idx < BOSSL_verifyThreads; idx++)
+  {
+    if (pthread_create(&BOSSL_verifyPool.threads[idx], NULL,
+                       _verifyThreadLoop, NULL) != 0)
+    {
+      sca_debugLog(LOG_WARNING, "Could only start %d of %d verify threads!\n",
+                   idx, BOSSL_verifyThreads);
+      break;
+    }
+    BOSSL_verifyPool.numThreads++;
+  }
+}
+
+/**
+ * Stop all verify threads. No validation may be in progress.
+ *
+ * @since 0.4.0.0
+ */
+static void _stopVerifyThreads()
+{
+  int idx = 0;
+
+  pthread_mutex_lock(&BOSSL_verifyPool.mutex);
+  BOSSL_verifyPool.stop = true;
+  pthread_cond_broadcast(&BOSSL_verifyPool.jobCond);
+  pthread_mutex_unlock(&BOSSL_verifyPool.mutex);
+
+  for (; idx < BOSSL_verifyPool.numThreads; idx++)
+  {
+    pthread_join(BOSSL_verifyPool.threads[idx], NULL);
+  }
+  BOSSL_verifyPool.numThreads = 0;
+}
+
 /**
  * The init method initialized the API. Only one failure can be imagined here,
  * a consecutive call of the init method. Next to the specified error status
@@ -330,10 +452,28 @@ int init(const char* value, int logLevel, sca_status_t* status)
 
   if (!BOSSL_initialized)
   {
+    if (cb_init())
+    {
+      sca_debugLog(LOG_INFO, "Use the %s crypto backend.\n", cb_getName());
+    }
+    else
+    {
+      sca_debugLog(LOG_ERR, "Could not initialize the %s crypto backend!\n",
+                   cb_getName());
+      myStatus |= API_STATUS_ERR_USER1;
+    }
     BOSSL_pubKeys  = malloc(sizeof(KeyStorage));
     BOSSL_privKeys = malloc(sizeof(KeyStorage));
     ks_init(BOSSL_pubKeys,  SCA_ECDSA_ALGORITHM, false);
     ks_init(BOSSL_privKeys, SCA_ECDSA_ALGORITHM, true);
+    // Without the cache each signature segment is verified.
+    BOSSL_useVerifyCache = vc_init(&BOSSL_verifyCache);
+    // Without verify threads the caller verifies all segments.
+    BOSSL_verifyThreads = 0;
+    if (mb_init())
+    {
+      sca_debugLog(LOG_INFO, "Use the multi buffer SHA256 (AVX2).\n");
+    }
     // used to determine which keys are contained in a possible file.
     bool isPrivate = false;
 
@@ -343,6 +483,34 @@ int init(const char* value, int logLevel, sca_status_t* status)
 
     while (strLen > 0 && ((myStatus & API_STATUS_ERROR_MASK) == 0 ))
     {
+      // Check for the number of verify threads THREADS:<n>
+      if (strncmp(tmpValue, BOSSL_THREADS_TOKEN,
+                  strlen(BOSSL_THREADS_TOKEN)) == 0)
+      {
+        char* endPtr  = NULL;
+        long  threads = 0;
+
+        tmpValue += strlen(BOSSL_THREADS_TOKEN);
+        strLen   -= strlen(BOSSL_THREADS_TOKEN);
+        threads = strtol(tmpValue, &endPtr, 10);
+        if ((endPtr == tmpValue) || (threads < 0)
+            || ((*endPtr != ';') && (*endPtr != '\0')))
+        {
+          myStatus |= API_STATUS_ERR_USER2;
+          continue;
+        }
+        BOSSL_verifyThreads = (int)MIN(threads, BOSSL_MAX_VERIFY_THREADS);
+        strLen   -= endPtr - tmpValue;
+        tmpValue  = endPtr;
+        if (strLen > 0)
+        {
+          // Jump over the ';'
+          tmpValue++;
+          strLen--;
+        }
+        continue;
+      }
+
       // Check for either value, PUB: or PRIV:
       int typeLen = strspn(tmpValue, "PUBRIV:");
       if (typeLen != 0)
@@ -433,12 +601,25 @@ int init(const char* value, int logLevel, sca_status_t* status)
     sca_debugLog(LOG_INFO, "The internal key initialized storage holds (%u "
                            "private and %u public keys)!\n",
                            BOSSL_privKeys->size, BOSSL_pubKeys->size);
+    _startVerifyThreads();
+    if (BOSSL_verifyPool.numThreads > 0)
+    {
+      sca_debugLog(LOG_INFO, "Signature segments are verified using %d "
+                             "additional threads.\n",
+                             BOSSL_verifyPool.numThreads);
+    }
   }
   else
   {
     retVal = API_FAILURE;
     ks_release(BOSSL_privKeys);
     ks_release(BOSSL_pubKeys);
+    cb_release();
+    if (BOSSL_useVerifyCache)
+    {
+      vc_release(&BOSSL_verifyCache);
+      BOSSL_useVerifyCache = false;
+    }
     BOSSL_initialized = false;
   }
 
@@ -479,18 +660,22 @@ int release(sca_status_t* status)
 {
   if (BOSSL_initialized)
   {
-    ks_empty(BOSSL_pubKeys);
-    free(BOSSL_pubKeys->head);
-    BOSSL_pubKeys->head = NULL;
-    free(BOSSL_pubKeys);
+    _stopVerifyThreads();
+
+    ks_release(BOSSL_pubKeys);
     BOSSL_pubKeys = NULL;
 
-    ks_empty(BOSSL_privKeys);
-    free(BOSSL_privKeys->head);
-    BOSSL_privKeys->head = NULL;
-    free(BOSSL_privKeys);
+    ks_release(BOSSL_privKeys);
     BOSSL_privKeys = NULL;
 
+    cb_release();
+
+    if (BOSSL_useVerifyCache)
+    {
+      vc_release(&BOSSL_verifyCache);
+      BOSSL_useVerifyCache = false;
+    }
+
     BOSSL_initialized = false;
   }
 
@@ -568,10 +753,10 @@ static unsigned char* _createSha256Digest(const unsigned char* message,
                                           u_int8_t* digestBuff)
 {
   unsigned char result[SHA256_DIGEST_LENGTH];
-  SHA256_CTX sha256ctx;
-  SHA256_Init(&sha256ctx);
-  SHA256_Update(&sha256ctx, message, length);
-  SHA256_Final(result, &sha256ctx);
+  u_int32_t     msgLength = length;
+
+  // Same implementation as used for the segments during validation.
+  mb_sha256(1, &message, &msgLength, result);
 
   if (digestBuff != NULL)
   {
@@ -581,31 +766,434 @@ static unsigned char* _createSha256Digest(const unsigned char* message,
 }
 
 /**
- * Perform BGPSEC path validation. This function required the keys to be
- * pre-registered to perform the validation.
- * The caller manages the memory and MUST assure the memory is intact until
- * the function returns.
+ * Validate the signature segment at the given position of the hash message.
+ * This function can be called by multiple threads for the same path.
  *
- * The following error status codes can be set:
+ * @param data The validation data containing the hash message.
+ * @param idx The index of the signature segment.
+ * @param hashDigest The message digest of the segment (see _createDigests).
+ * @param status The status of the segment, see validate.
  *
- * API_STATUS_ERR_USER1: The hash input could not be generated
- * API_STATUS_ERR_INVALID_KEY: The hex key retrieved from the storage is NULL.
- * API_STATUS_NO_DATA: No data to validate passed.
- * API_STATUS_INFO_KEY_NOTFOUND: One or more of the keys could not be found.
- * API_STATUS_INFO_SIGNATURE: One or more signatures could not be validated.
+ * @return API_VALRESULT_VALID or API_VALRESULT_INVALID
  *
+ * @since 0.4.0.0
+ */
+static int _validateSegment(SCA_BGPSecValidationData* data, int idx,
+                            u_int8_t* hashDigest, sca_status_t* status)
+{
+  int        retVal    = API_VALRESULT_INVALID;
+  u_int32_t* asn       = NULL;
+  CB_Key**   ecdsa_key = NULL;
+  u_int8_t*  signature = NULL;
+  u_int16_t  sigLength = 0;
+  SCA_BGPSEC_SignatureSegment* sigSeg = NULL;
+  SCA_HashMessage* hashMessage = data->hashMessage[0];
+
+  u_int16_t noKeys = 0;
+  int ecIdx = 0;
+  // The verify cache generation at the time the key is retrieved
+  u_int32_t generation = 0;
+
+  // We want to have the signer key, This will be found in the next
+  // path segment.
+  if (idx+1 < hashMessage->segmentCount)
+  {
+    asn = (u_int32_t*)hashMessage->hashMessageValPtr[idx+1]->hashMessagePtr;
+  }
+  else
+  {
+    // Jump to the origin AS
+    asn = (u_int32_t*)(hashMessage->hashMessageValPtr[idx]->hashMessagePtr+6);
+  }
+  sigSeg = (SCA_BGPSEC_SignatureSegment*)hashMessage->hashMessageValPtr[idx]->signaturePtr;
+
+  if (BOSSL_useVerifyCache)
+  {
+    generation = vc_getGeneration(&BOSSL_verifyCache);
+  }
+  /* The OpenSSL encoded key. */
+  ecdsa_key = (CB_Key**)ks_getKey(BOSSL_pubKeys, sigSeg->ski, *asn,
+                        &noKeys, ks_eckey_e, status);
+  if (ecdsa_key != NULL)
+  {
+    if (sca_getCurrentLogLevel() >= LOG_DEBUG)
+    {
+      sca_debugLog(LOG_DEBUG, "\nHash(validate):");
+      printHex(hashMessage->hashMessageValPtr[idx]->hashMessageLength,
+               hashMessage->hashMessageValPtr[idx]->hashMessagePtr);
+      sca_debugLog(LOG_DEBUG, "\nDigest(validate):");
+      printHex(SHA256_DIGEST_LENGTH, hashDigest);
+    }
+
+    signature = hashMessage->hashMessageValPtr[idx]->signaturePtr
+                + sizeof(SCA_BGPSEC_SignatureSegment);
+    // find the signature:
+    sigLength = ntohs(sigSeg->siglen);
+
+    // Verified already with the same key?
+    if (BOSSL_useVerifyCache
+        && vc_lookup(&BOSSL_verifyCache, sigSeg->ski, *asn, hashDigest,
+                     signature, sigLength))
+    {
+      sca_debugLog(LOG_DEBUG, "stack[%d] VERIFY SUCCESS (cached)\n", idx+1);
+      ks_releaseKey(BOSSL_pubKeys);
+      return API_VALRESULT_VALID;
+    }
+
+    for (ecIdx=0; ecIdx < noKeys && retVal==API_VALRESULT_INVALID; ecIdx++)
+    {
+      if (ecdsa_key[ecIdx] != NULL)
+      { // Toggle through the keys
+        /* verify the signature */
+        if (cb_verify(ecdsa_key[ecIdx], hashDigest, signature, sigLength)
+           == 1)
+        {
+          retVal = API_VALRESULT_VALID;
+          sca_debugLog(LOG_DEBUG, "\033[92m""stack[%d] VERIFY SUCCESS""\033[0m \n", idx+1);
+        }
+        else
+        {
+          retVal = API_VALRESULT_INVALID;
+          sca_debugLog(LOG_DEBUG,
+              "\033[91m""stack[%d] VERIFY FAILED (SKI: %02X%02X%02X%02X)""\033[0m \n",
+              idx+1,
+              sigSeg->ski[0], sigSeg->ski[1], sigSeg->ski[2], sigSeg->ski[3]);
+          break;
+        }
+      }
+      else
+      {
+        // Most likely a registration error!
+        *status |= API_STATUS_ERR_INVLID_KEY;
+        sca_debugLog(LOG_WARNING, "The key storage returned a NULL eckey\n");
+      }
+    }
+
+    ks_releaseKey(BOSSL_pubKeys);
+
+    if ((retVal == API_VALRESULT_VALID) && BOSSL_useVerifyCache)
+    {
+      vc_store(&BOSSL_verifyCache, sigSeg->ski, *asn, hashDigest,
+               signature, sigLength, generation);
+    }
+
+    if (retVal == API_VALRESULT_INVALID)
+    {
+      *status |= API_STATUS_INFO_SIGNATURE;
+      sca_debugLog(LOG_DEBUG, "[%s:%d] verify failed and quit: ret:%d idx:%d, ecIdx:%d\n",
+          __FUNCTION__, __LINE__, retVal, idx, ecIdx );
+    }
+  }
+  else
+  {
+    *status |= API_STATUS_INFO_KEY_NOTFOUND;
+    sca_debugLog(LOG_DEBUG,
+        "\033[91m""NO KEY -> VERIFY FAILED (SKI: %02X%02X%02X%02X)""\033[0m \n",
+              sigSeg->ski[0], sigSeg->ski[1], sigSeg->ski[2], sigSeg->ski[3]);
+  }
+
+  return retVal;
+}
+
+/**
+ * Remove the job from the list of jobs with unclaimed segments. The pool mutex
+ * MUST be held.
  *
- * @param data This structure contains all necessary information to perform
- *             the path validation. The status flag will contain more
- *             information
+ * @param job The job to be removed.
  *
- * @return API_VALRESULT_VALID(1) or API_VALRESULT_INVALID(0). For 0 refer to
- *          the status code. Internal errors result in invalid.
+ * @since 0.4.0.0
  */
-int validate(SCA_BGPSecValidationData* data)
+static void _unlinkVerifyJob(BOSSL_VerifyJob* job)
+{
+  BOSSL_VerifyJob** jobPtr = &BOSSL_verifyPool.jobs;
+
+  while (*jobPtr != NULL)
+  {
+    if (*jobPtr == job)
+    {
+      *jobPtr = job->next;
+      job->next = NULL;
+      break;
+    }
+    jobPtr = &(*jobPtr)->next;
+  }
+}
+
+/**
+ * Claim the next segment of the job. Once a segment of the job is found
+ * invalid, all segments not claimed so far are dropped. The job is removed
+ * from the list of jobs as soon as no segment is left. The pool mutex MUST be
+ * held.
+ *
+ * @param job The job.
+ * @param idx OUT - The index of the claimed segment.
+ *
+ * @return true if a segment was claimed.
+ *
+ * @since 0.4.0.0
+ */
+static bool _claimVerifySegment(BOSSL_VerifyJob* job, int* idx)
+{
+  bool claimed = false;
+  int  dropped = 0;
+
+  if (job->nextIdx < job->segmentCount)
+  {
+    if (__atomic_load_n(&job->failed, __ATOMIC_ACQUIRE))
+    {
+      // The path is invalid already, skip all remaining segments.
+      dropped = job->segmentCount - job->nextIdx;
+      job->nextIdx = job->segmentCount;
+      if (__atomic_sub_fetch(&job->pending, dropped, __ATOMIC_ACQ_REL) == 0)
+      {
+        pthread_cond_broadcast(&BOSSL_verifyPool.doneCond);
+      }
+    }
+    else
+    {
+      *idx = job->nextIdx++;
+      claimed = true;
+    }
+
+    if (job->nextIdx == job->segmentCount)
+    {
+      _unlinkVerifyJob(job);
+    }
+  }
+
+  return claimed;
+}
+
+/**
+ * Validate a claimed segment of the job and report the result to the job.
+ * The pool mutex MUST NOT be held. The job memory is not accessed anymore
+ * after the pending counter is decremented.
+ *
+ * @param job The job.
+ * @param idx The index of the claimed segment.
+ *
+ * @since 0.4.0.0
+ */
+static void _processVerifySegment(BOSSL_VerifyJob* job, int idx)
+{
+  sca_status_t status = API_STATUS_OK;
+
+  if (_validateSegment(job->data, idx, 
+                       job->digests + (idx * SHA256_DIGEST_LENGTH), &status)
+      != API_VALRESULT_VALID)
+  {
+    __atomic_store_n(&job->failed, true, __ATOMIC_RELEASE);
+  }
+  __atomic_or_fetch(&job->status, status, __ATOMIC_RELAXED);
+
+  if (__atomic_sub_fetch(&job->pending, 1, __ATOMIC_ACQ_REL) == 0)
+  {
+    pthread_mutex_lock(&BOSSL_verifyPool.mutex);
+    pthread_cond_broadcast(&BOSSL_verifyPool.doneCond);
+    pthread_mutex_unlock(&BOSSL_verifyPool.mutex);
+  }
+}
+
+/**
+ * The loop of a verify thread. Segments of the first job in the list are
+ * claimed and validated until the pool is stopped.
+ *
+ * @param arg Not used.
+ *
+ * @return NULL
+ *
+ * @since 0.4.0.0
+ */
+static void* _verifyThreadLoop(void* arg)
+{
+  BOSSL_VerifyJob* job = NULL;
+  int              idx = 0;
+
+  pthread_mutex_lock(&BOSSL_verifyPool.mutex);
+  while (!BOSSL_verifyPool.stop)
+  {
+    job = BOSSL_verifyPool.jobs;
+    if (job == NULL)
+    {
+      pthread_cond_wait(&BOSSL_verifyPool.jobCond, &BOSSL_verifyPool.mutex);
+    }
+    else if (_claimVerifySegment(job, &idx))
+    {
+      pthread_mutex_unlock(&BOSSL_verifyPool.mutex);
+      _processVerifySegment(job, idx);
+      pthread_mutex_lock(&BOSSL_verifyPool.mutex);
+    }
+  }
+  pthread_mutex_unlock(&BOSSL_verifyPool.mutex);
+
+  return NULL;
+}
+
+/**
+ * Initialize the job that validates all signature segments of the path.
+ *
+ * @param job The job to be initialized.
+ * @param data The validation data containing the hash message.
+ * @param segmentCount The number of signature segments.
+ * @param digests The message digests of the signature segments.
+ *
+ * @since 0.4.0.0
+ */
+static void _initVerifyJob(BOSSL_VerifyJob* job, SCA_BGPSecValidationData* data,
+                           int segmentCount, u_int8_t* digests)
+{
+  memset(job, 0, sizeof(BOSSL_VerifyJob));
+  job->data         = data;
+  job->segmentCount = segmentCount;
+  job->digests      = digests;
+  job->pending      = segmentCount;
+  job->status       = API_STATUS_OK;
+}
+
+/**
+ * Append the jobs to the list of jobs served by the verify threads. Jobs are
+ * served in the order they arrive.
+ *
+ * @param jobs The array of jobs.
+ * @param count The number of jobs in the array.
+ *
+ * @since 0.4.0.0
+ */
+static void _submitVerifyJobs(BOSSL_VerifyJob* jobs, int count)
+{
+  BOSSL_VerifyJob** jobPtr = NULL;
+  int               idx    = 0;
+
+  pthread_mutex_lock(&BOSSL_verifyPool.mutex);
+  for (jobPtr = &BOSSL_verifyPool.jobs; *jobPtr != NULL;
+       jobPtr = &(*jobPtr)->next);
+  for (; idx < count; idx++)
+  {
+    *jobPtr = &jobs[idx];
+    jobPtr  = &jobs[idx].next;
+  }
+  pthread_cond_broadcast(&BOSSL_verifyPool.jobCond);
+  pthread_mutex_unlock(&BOSSL_verifyPool.mutex);
+}
+
+/**
+ * Validate the segments of the submitted job that are not claimed by the
+ * verify threads and wait until all segments are finished. The validation
+ * stops with the first invalid segment.
+ *
+ * @param job The submitted job.
+ *
+ * @return API_VALRESULT_VALID or API_VALRESULT_INVALID
+ *
+ * @since 0.4.0.0
+ */
+static int _finishVerifyJob(BOSSL_VerifyJob* job)
+{
+  int idx = 0;
+
+  pthread_mutex_lock(&BOSSL_verifyPool.mutex);
+  while (_claimVerifySegment(job, &idx))
+  {
+    pthread_mutex_unlock(&BOSSL_verifyPool.mutex);
+    _processVerifySegment(job, idx);
+    pthread_mutex_lock(&BOSSL_verifyPool.mutex);
+  }
+  // All segments are claimed, wait for the ones still in progress.
+  while (__atomic_load_n(&job->pending, __ATOMIC_ACQUIRE) > 0)
+  {
+    pthread_cond_wait(&BOSSL_verifyPool.doneCond, &BOSSL_verifyPool.mutex);
+  }
+  pthread_mutex_unlock(&BOSSL_verifyPool.mutex);
+
+  job->data->status |= job->status;
+
+  return job->failed ? API_VALRESULT_INVALID : API_VALRESULT_VALID;
+}
+
+/**
+ * Generate the message digests of all signature segments of the given
+ * validation data in one pass. The digests are stored in the order of the
+ * data elements and their segments.
+ *
+ * @param count The number of validation data elements.
+ * @param data The validation data, each containing the hash message.
+ * @param buff A buffer for the digests of up to BOSSL_STACK_SEGMENTS segments.
+ *
+ * @return The digests, either buff or allocated memory that has to be freed
+ *         by the caller. NULL if not enough memory is available.
+ *
+ * @since 0.4.0.0
+ */
+static u_int8_t* _createDigests(int count, SCA_BGPSecValidationData** data,
+                                u_int8_t* buff)
+{
+  const u_int8_t*  stackMessages[BOSSL_STACK_SEGMENTS];
+  u_int32_t        stackLengths[BOSSL_STACK_SEGMENTS];
+  const u_int8_t** messages = stackMessages;
+  u_int32_t*       lengths  = stackLengths;
+  u_int8_t*        digests  = buff;
+  SCA_HashMessage* hashMessage = NULL;
+  int              total  = 0;
+  int              idx    = 0;
+  int              segIdx = 0;
+
+  for (idx = 0; idx < count; idx++)
+  {
+    total += data[idx]->hashMessage[0]->segmentCount;
+  }
+  if (total > BOSSL_STACK_SEGMENTS)
+  {
+    messages = malloc(total * sizeof(u_int8_t*));
+    lengths  = malloc(total * sizeof(u_int32_t));
+    digests  = malloc(total * SHA256_DIGEST_LENGTH);
+    if ((messages == NULL) || (lengths == NULL) || (digests == NULL))
+    {
+      sca_debugLog(LOG_ERR, "Not enough memory to hash %d segments!\n", total);
+      free(messages);
+      free(lengths);
+      free(digests);
+      return NULL;
+    }
+  }
+
+  total = 0;
+  for (idx = 0; idx < count; idx++)
+  {
+    hashMessage = data[idx]->hashMessage[0];
+    for (segIdx = 0; segIdx < hashMessage->segmentCount; segIdx++, total++)
+    {
+      messages[total] = hashMessage->hashMessageValPtr[segIdx]->hashMessagePtr;
+      lengths[total]  = 
+                    hashMessage->hashMessageValPtr[segIdx]->hashMessageLength;
+    }
+  }
+  if (total > 0)
+  {
+    mb_sha256(total, messages, lengths, digests);
+  }
+
+  if (messages != stackMessages)
+  {
+    free(messages);
+    free(lengths);
+  }
+
+  return digests;
+}
+
+/**
+ * Check the validation data and generate the hash message if none was 
+ * generated prior.
+ *
+ * @param data The validation data.
+ *
+ * @return API_VALRESULT_VALID if the signature segments can be validated, 
+ *         otherwise API_VALRESULT_INVALID (see status).
+ *
+ * @since 0.4.0.0
+ */
+static int _prepareValidation(SCA_BGPSecValidationData* data)
 {
-  // @TODO: Currently we only deal with the first validation data result.
-  //       It needs to be modified in such that it uses both results [0] and [1]
   int retVal = API_VALRESULT_INVALID;
 
   // Do some preliminary check
@@ -640,116 +1228,199 @@ int validate(SCA_BGPSecValidationData* data)
     }
   }
 
+  return retVal;
+}
+
+/**
+ * Perform BGPSEC path validation. This function required the keys to be
+ * pre-registered to perform the validation.
+ * The caller manages the memory and MUST assure the memory is intact until
+ * the function returns.
+ *
+ * The following error status codes can be set:
+ *
+ * API_STATUS_ERR_USER1: The hash input could not be generated
+ * API_STATUS_ERR_INVALID_KEY: The hex key retrieved from the storage is NULL.
+ * API_STATUS_NO_DATA: No data to validate passed.
+ * API_STATUS_INFO_KEY_NOTFOUND: One or more of the keys could not be found.
+ * API_STATUS_INFO_SIGNATURE: One or more signatures could not be validated.
+ *
+ *
+ * @param data This structure contains all necessary information to perform
+ *             the path validation. The status flag will contain more
+ *             information
+ *
+ * @return API_VALRESULT_VALID(1) or API_VALRESULT_INVALID(0). For 0 refer to
+ *          the status code. Internal errors result in invalid.
+ */
+int validate(SCA_BGPSecValidationData* data)
+{
+  // @TODO: Currently we only deal with the first validation data result.
+  //       It needs to be modified in such that it uses both results [0] and [1]
+  int retVal = _prepareValidation(data);
+  BOSSL_VerifyJob job;
+  // Temporary space for the generated message digests (hash)
+  u_int8_t  buff[BOSSL_STACK_SEGMENTS * SHA256_DIGEST_LENGTH];
+  u_int8_t* digests = NULL;
+
   // Now perform validation
   if (retVal == API_VALRESULT_VALID)
   {
-    // Now we can validate each signature -> This can be multi threaded
-    // in this case the variables below need to be declared in each thread
-    // separately.
-    u_int32_t* asn       = NULL;
-    EC_KEY**   ecdsa_key = NULL;
-    u_int8_t*  signature = NULL;
-    u_int16_t  sigLength = 0;
-    SCA_BGPSEC_SignatureSegment* sigSeg = NULL;
+    int segmentCount = data->hashMessage[0]->segmentCount;
     int idx = 0;
 
-    u_int16_t noKeys = 0;
-    int ecIdx = 0;
-
-    // Temporary space for the generated message digest (hash)
-    u_int8_t hashDigest[SHA256_DIGEST_LENGTH];
+    // Generate the hashes (messageDigest that was signed) of all segments.
+    digests = _createDigests(1, &data, buff);
+    if (digests == NULL)
+    {
+      data->status |= API_STATUS_ERR_INSUF_BUFFER;
+      return API_VALRESULT_INVALID;
+    }
 
-    for (; idx < data->hashMessage[0]->segmentCount; idx++)
+    if ((BOSSL_verifyPool.numThreads > 0)
+        && (segmentCount >= BOSSL_MIN_PARALLEL_SEGMENTS))
     {
-      // We want to have the signer key, This will be found in the next
-      // path segment.
-      if (idx+1 < data->hashMessage[0]->segmentCount)
-      {
-        asn = (u_int32_t*)data->hashMessage[0]->hashMessageValPtr[idx+1]->hashMessagePtr;
-      }
-      else
+      _initVerifyJob(&job, data, segmentCount, digests);
+      _submitVerifyJobs(&job, 1);
+      retVal = _finishVerifyJob(&job);
+    }
+    else
+    {
+      for (; (idx < segmentCount) && (retVal == API_VALRESULT_VALID); idx++)
       {
-        // Jump to the origin AS
-        asn = (u_int32_t*)(data->hashMessage[0]->hashMessageValPtr[idx]->hashMessagePtr+6);
+        retVal = _validateSegment(data, idx, 
+                                  digests + (idx * SHA256_DIGEST_LENGTH),
+                                  &data->status);
       }
-      sigSeg = (SCA_BGPSEC_SignatureSegment*)data->hashMessage[0]->hashMessageValPtr[idx]->signaturePtr;
+    }
 
-      /* The OpenSSL encoded key. */
-      ecdsa_key = (EC_KEY**)ks_getKey(BOSSL_pubKeys, sigSeg->ski, *asn,
-                            &noKeys, ks_eckey_e, &data->status);
-      if (ecdsa_key != NULL)
-      {
-        // Generate the hash (messageDigest that will be signed.)
-        _createSha256Digest (
-                 data->hashMessage[0]->hashMessageValPtr[idx]->hashMessagePtr,
-                 data->hashMessage[0]->hashMessageValPtr[idx]->hashMessageLength,
-                 (u_int8_t*)&hashDigest);
+    if (digests != buff)
+    {
+      free(digests);
+    }
+  }
 
-        if (sca_getCurrentLogLevel() >= LOG_DEBUG)
-        {
-          sca_debugLog(LOG_DEBUG, "\nHash(validate):");
-          printHex(data->hashMessage[0]->hashMessageValPtr[idx]->hashMessageLength,
-              data->hashMessage[0]->hashMessageValPtr[idx]->hashMessagePtr);
-          sca_debugLog(LOG_DEBUG, "\nDigest(validate):");
-          printHex(SHA256_DIGEST_LENGTH, (u_int8_t*)hashDigest);
-        }
+  return retVal;
+}
 
-        signature = data->hashMessage[0]->hashMessageValPtr[idx]->signaturePtr
-                    + sizeof(SCA_BGPSEC_SignatureSegment);
-        // find the signature:
-        sigLength = ntohs(sigSeg->siglen);
+/**
+ * Perform BGPSEC path validation for multiple updates. Each element is 
+ * validated as done by validate. In case verify threads are configured, the 
+ * signature segments of all elements are handed to the threads at once, this 
+ * way the threads are used even for short paths.
+ *
+ * @param count The number of elements in the given arrays.
+ * @param data Array containing the validation data objects.
+ * @param results Array that receives the validation result of each element.
+ *
+ * @return API_SUCCESS or API_FAILURE if at least one element has an error bit
+ *         set in its status.
+ *
+ * @since 0.4.0.0
+ */
+int validateBatch(int count, SCA_BGPSecValidationData** data, int* results)
+{
+  int                        retVal   = API_SUCCESS;
+  SCA_BGPSecValidationData** prepared = NULL;
+  BOSSL_VerifyJob*           jobs     = NULL;
+  u_int8_t                   buff[BOSSL_STACK_SEGMENTS * SHA256_DIGEST_LENGTH];
+  u_int8_t*                  digests  = NULL;
+  u_int8_t*                  digest   = NULL;
+  int                        numPrepared = 0;
+  int                        idx      = 0;
+  int                        segIdx   = 0;
+
+  if ((count <= 0) || (data == NULL) || (results == NULL))
+  {
+    return API_FAILURE;
+  }
 
-        retVal = API_VALRESULT_INVALID;
-        for (ecIdx=0; ecIdx < noKeys && retVal==API_VALRESULT_INVALID; ecIdx++)
-        {
-          if (ecdsa_key[ecIdx] != NULL)
-          { // Toggle through the keys
-            /* verify the signature */
-            if (ECDSA_verify(0, hashDigest, SHA256_DIGEST_LENGTH,
-                             signature, sigLength, ecdsa_key[ecIdx])
-               == 1)
-            {
-              retVal = API_VALRESULT_VALID;
-              sca_debugLog(LOG_DEBUG, "\033[92m""stack[%d] VERIFY SUCCESS""\033[0m \n", idx+1);
-            }
-            else
-            {
-              retVal = API_VALRESULT_INVALID;
-              sca_debugLog(LOG_DEBUG,
-                  "\033[91m""stack[%d] VERIFY FAILED (SKI: %02X%02X%02X%02X)""\033[0m \n",
-                  idx+1,
-                  sigSeg->ski[0], sigSeg->ski[1], sigSeg->ski[2], sigSeg->ski[3]);
-              break;
-            }
-          }
-          else
-          {
-            // Most likely a registration error!
-            data->status |= API_STATUS_ERR_INVLID_KEY;
-            sca_debugLog(LOG_WARNING, "The key storage returned a NULL eckey\n");
-          }
-        }
+  prepared = malloc(count * sizeof(SCA_BGPSecValidationData*));
+  if (BOSSL_verifyPool.numThreads > 0)
+  {
+    jobs = malloc(count * sizeof(BOSSL_VerifyJob));
+  }
 
-        if (retVal == API_VALRESULT_INVALID)
-        {
-          data->status |= API_STATUS_INFO_SIGNATURE;
-          sca_debugLog(LOG_DEBUG, "[%s:%d] verify failed and quit: ret:%d idx:%d, ecIdx:%d\n",
-              __FUNCTION__, __LINE__, retVal, idx, ecIdx );
-          break; // No further validation needed
-        }
+  for (idx = 0; idx < count; idx++)
+  {
+    results[idx] = _prepareValidation(data[idx]);
+    if ((results[idx] == API_VALRESULT_VALID) && (prepared != NULL))
+    {
+      prepared[numPrepared++] = data[idx];
+    }
+  }
+
+  // Generate the hashes of all segments of all elements together.
+  if (numPrepared > 0)
+  {
+    digests = _createDigests(numPrepared, prepared, buff);
+  }
+
+  // The digests are stored in the order of the prepared elements.
+  digest = digests;
+  numPrepared = 0;
+  for (idx = 0; idx < count; idx++)
+  {
+    if (results[idx] != API_VALRESULT_VALID)
+    {
+      continue;
+    }
+    if (digests == NULL)
+    {
+      data[idx]->status |= API_STATUS_ERR_INSUF_BUFFER;
+      results[idx] = API_VALRESULT_INVALID;
+      continue;
+    }
+    if (jobs != NULL)
+    {
+      _initVerifyJob(&jobs[numPrepared++], data[idx],
+                     data[idx]->hashMessage[0]->segmentCount, digest);
+    }
+    else
+    {
+      // No verify threads, validate the element right away.
+      for (segIdx = 0; 
+           (segIdx < data[idx]->hashMessage[0]->segmentCount)
+           && (results[idx] == API_VALRESULT_VALID); segIdx++)
+      {
+        results[idx] = _validateSegment(data[idx], segIdx, 
+                             digest + (segIdx * SHA256_DIGEST_LENGTH),
+                             &data[idx]->status);
       }
-      else
+    }
+    digest += data[idx]->hashMessage[0]->segmentCount * SHA256_DIGEST_LENGTH;
+  }
+
+  if ((jobs != NULL) && (numPrepared > 0))
+  {
+    _submitVerifyJobs(jobs, numPrepared);
+    // The jobs are stored in the order of the elements with a valid result.
+    numPrepared = 0;
+    for (idx = 0; idx < count; idx++)
+    {
+      if (results[idx] == API_VALRESULT_VALID)
       {
-        retVal = API_VALRESULT_INVALID;
-        data->status |= API_STATUS_INFO_KEY_NOTFOUND;
-        sca_debugLog(LOG_DEBUG,
-            "\033[91m""NO KEY -> VERIFY FAILED (SKI: %02X%02X%02X%02X)""\033[0m \n",
-                  sigSeg->ski[0], sigSeg->ski[1], sigSeg->ski[2], sigSeg->ski[3]);
-        break; // No further validation needed
+        results[idx] = _finishVerifyJob(&jobs[numPrepared++]);
       }
     }
   }
 
+  if (digests != buff)
+  {
+    free(digests);
+  }
+  free(jobs);
+  free(prepared);
+
+  for (idx = 0; idx < count; idx++)
+  {
+    if ((data[idx] == NULL) 
+        || ((data[idx]->status & API_STATUS_ERROR_MASK) != 0))
+    {
+      retVal = API_FAILURE;
+    }
+  }
+
   return retVal;
 }
 
@@ -830,7 +1501,7 @@ static int _sign(SCA_BGPSecSignData* bgpsec_data)
     // First find the key
     u_int16_t noKeys = 0;
     bgpsec_data->status = API_STATUS_OK;
-    EC_KEY** ec_keys = (EC_KEY**)ks_getKey(BOSSL_privKeys, bgpsec_data->ski,
+    CB_Key** ec_keys = (CB_Key**)ks_getKey(BOSSL_privKeys, bgpsec_data->ski,
         bgpsec_data->myHost->asn, &noKeys,
         ks_eckey_e, &bgpsec_data->status);
     if (noKeys != 0)
@@ -853,7 +1524,7 @@ static int _sign(SCA_BGPSecSignData* bgpsec_data)
         memcpy(bgpsec_data->hashMessage->hashMessageValPtr[0]->hashMessagePtr-2,
             bgpsec_data->myHost, LEN_SECPATHSEGMENT);
 
-      u_int16_t sigLen  = ECDSA_size(ec_keys[0]);
+      u_int16_t sigLen  = cb_getSignatureSize(ec_keys[0]);
       uint usedLen = 0;
       u_int8_t* sigBuff = malloc(sigLen);
       memset (sigBuff, 0, sigLen);
@@ -893,8 +1564,8 @@ static int _sign(SCA_BGPSecSignData* bgpsec_data)
       }
 
       // Use only the first key.
-      int res = ECDSA_sign(0, hashDigest, SHA256_DIGEST_LENGTH,
-          sigBuff, (unsigned int*)&usedLen, ec_keys[0]);
+      int res = cb_sign(ec_keys[0], hashDigest, sigBuff, (u_int32_t*)&usedLen);
+      ks_releaseKey(BOSSL_privKeys);
 
       /* after signing restore the saved pointer from the temp message holder */
       if(!origin)
@@ -1103,7 +1774,15 @@ u_int8_t registerPublicKey(BGPSecKey* key, sca_key_source_t source,
 u_int8_t unregisterPublicKey(BGPSecKey* key, sca_key_source_t source,
                              sca_status_t* status)
 {
-  return ks_delKey(BOSSL_pubKeys, key, source, status);
+  u_int8_t retVal = ks_delKey(BOSSL_pubKeys, key, source, status);
+
+  // Signatures verified with the removed key are not valid anymore.
+  if (BOSSL_useVerifyCache && (key != NULL))
+  {
+    vc_removeKey(&BOSSL_verifyCache, key->ski, key->asn);
+  }
+
+  return retVal;
 }
 
 /**
@@ -1145,6 +1824,10 @@ static void _cleanKeys(sca_key_source_t source, sca_status_t* status,
 u_int8_t cleanKeys(sca_key_source_t source, sca_status_t* status)
 {
   _cleanKeys(source, status, false);  
+  if (BOSSL_useVerifyCache)
+  {
+    vc_empty(&BOSSL_verifyCache);
+  }
   return API_SUCCESS;
 }
 
@@ -1192,6 +1875,7 @@ bool isAlgorithmSupported(u_int8_t algoID)
 
   compAPI.sign                 = sign;
   compAPI.validate             = validate;
+  compAPI.validateBatch        = validateBatch;
 
   compAPI.freeHashMessage      = freeHashMessage;
   compAPI.freeSignature        = freeSignature;
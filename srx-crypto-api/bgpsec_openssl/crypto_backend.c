@@ -0,0 +1,675 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * The OpenSSL functions used for keys, signatures and message digests. See
+ * crypto_backend.h for details.
+ *
+ * @version 0.4.0.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ *  0.4.0.0 - 2026/10/18
+ *            * Created crypto backend
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <openssl/asn1.h>
+#include <openssl/ecdsa.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <openssl/sha.h>
+#include <openssl/x509.h>
+#include "crypto_backend.h"
+
+#ifdef BOSSL_EVP
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
+
+/** The message digest used for all digests. */
+static EVP_MD*       CB_sha256 = NULL;
+/** Provides the EVP_MD_CTX of the calling thread. */
+static pthread_key_t CB_mdCtxKey;
+/** Indicates if the backend is initialized. */
+static bool          CB_initialized = false;
+
+/**
+ * Free the EVP_MD_CTX of a terminating thread.
+ *
+ * @param ctx The context of the thread.
+ */
+static void _cb_freeMdCtx(void* ctx)
+{
+  EVP_MD_CTX_free((EVP_MD_CTX*)ctx);
+}
+
+/**
+ * Initialize the backend.
+ *
+ * @return true if the backend could be initialized.
+ */
+bool cb_init()
+{
+  if (!CB_initialized)
+  {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    // Fetch once instead of an implicit fetch by each digest.
+    CB_sha256 = EVP_MD_fetch(NULL, "SHA256", NULL);
+#else
+    CB_sha256 = (EVP_MD*)EVP_sha256();
+#endif
+    if (CB_sha256 != NULL)
+    {
+      CB_initialized = pthread_key_create(&CB_mdCtxKey, _cb_freeMdCtx) == 0;
+    }
+  }
+
+  return CB_initialized;
+}
+
+/**
+ * Release the resources of the backend. The threads that used the backend,
+ * except the calling one, MUST be terminated already.
+ */
+void cb_release()
+{
+  if (CB_initialized)
+  {
+    CB_initialized = false;
+    _cb_freeMdCtx(pthread_getspecific(CB_mdCtxKey));
+    pthread_key_delete(CB_mdCtxKey);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    EVP_MD_free(CB_sha256);
+#endif
+    CB_sha256 = NULL;
+  }
+}
+
+/**
+ * Return the name of the backend.
+ *
+ * @return "EVP"
+ */
+const char* cb_getName()
+{
+  return "EVP";
+}
+
+/**
+ * The curve of a key is managed by the EVP key itself.
+ *
+ * @param curve The OpenSSL curve NID.
+ *
+ * @return NULL
+ */
+EC_GROUP* cb_newGroup(int curve)
+{
+  return NULL;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+/**
+ * Read the header of the next DER element and check its tag.
+ *
+ * @param p The position in the DER data, moved to the content of the element.
+ * @param end The end of the DER data.
+ * @param tag The expected universal tag.
+ * @param length OUT value that receives the length of the content.
+ *
+ * @return true if the element has the expected tag and fits into the data.
+ */
+static bool _cb_getElement(const unsigned char** p, const unsigned char* end,
+                           int tag, long* length)
+{
+  int myTag   = 0;
+  int myClass = 0;
+  int ret     = ASN1_get_object(p, length, &myTag, &myClass, end - *p);
+
+  return    ((ret & 0x80) == 0) && (myTag == tag)
+         && (myClass == V_ASN1_UNIVERSAL) && (*length <= end - *p);
+}
+
+/**
+ * Decode the DER encoded SubjectPublicKeyInfo of an EC key. The generic
+ * d2i_PUBKEY of OpenSSL 3 runs the decoder framework which takes longer than
+ * the key check. Here the key is created from the encoded point instead.
+ *
+ * @param keyData The DER encoded key
+ * @param keyLength The length of the DER encoded key
+ *
+ * @return The key or NULL.
+ */
+static EVP_PKEY* _cb_decodePublicKey(const u_int8_t* keyData, long keyLength)
+{
+  const unsigned char* p         = (const unsigned char*)keyData;
+  const unsigned char* end       = p + keyLength;
+  ASN1_OBJECT*         algorithm = NULL;
+  ASN1_OBJECT*         curve     = NULL;
+  EVP_PKEY_CTX*        ctx       = NULL;
+  EVP_PKEY*            pkey      = NULL;
+  OSSL_PARAM           params[3];
+  long                 length    = 0;
+
+  // SEQUENCE { SEQUENCE { algorithm, curve }, BIT STRING point }
+  if (   _cb_getElement(&p, end, V_ASN1_SEQUENCE, &length)
+      && _cb_getElement(&p, end, V_ASN1_SEQUENCE, &length))
+  {
+    algorithm = d2i_ASN1_OBJECT(NULL, &p, end - p);
+    curve     = (algorithm != NULL) ? d2i_ASN1_OBJECT(NULL, &p, end - p)
+                                    : NULL;
+  }
+
+  if (   (curve != NULL)
+      && (OBJ_obj2nid(algorithm) == NID_X9_62_id_ecPublicKey)
+      && (OBJ_obj2nid(curve) != NID_undef)
+      && _cb_getElement(&p, end, V_ASN1_BIT_STRING, &length)
+      && (length > 1) && (p[0] == 0))
+  {
+    // The first byte of the bit string is the number of unused bits.
+    params[0] = OSSL_PARAM_construct_utf8_string(OSSL_PKEY_PARAM_GROUP_NAME,
+                                  (char*)OBJ_nid2sn(OBJ_obj2nid(curve)), 0);
+    params[1] = OSSL_PARAM_construct_octet_string(OSSL_PKEY_PARAM_PUB_KEY,
+                                                  (void*)(p + 1), length - 1);
+    params[2] = OSSL_PARAM_construct_end();
+    ctx = EVP_PKEY_CTX_new_from_name(NULL, "EC", NULL);
+    if (   (ctx == NULL) || (EVP_PKEY_fromdata_init(ctx) != 1)
+        || (EVP_PKEY_fromdata(ctx, &pkey, EVP_PKEY_PUBLIC_KEY, params) != 1))
+    {
+      pkey = NULL;
+    }
+    EVP_PKEY_CTX_free(ctx);
+  }
+
+  ASN1_OBJECT_free(algorithm);
+  ASN1_OBJECT_free(curve);
+
+  return pkey;
+}
+#endif
+
+/**
+ * Convert the DER key into an EVP key and perform the key check.
+ *
+ * @param keyData The DER encoded key
+ * @param keyLength The length of the DER encoded key
+ * @param isPrivate indicate if the key is private
+ * @param group Not used by this backend.
+ * @param status Adds return information in case something goes wrong - the
+ *               status flag will NOT be initialized within the function.
+ *
+ * @return The key or NULL. In the later case check status.
+ */
+CB_Key* cb_convertKey(u_int8_t* keyData, u_int16_t keyLength, bool isPrivate,
+                      EC_GROUP* group, sca_status_t* status)
+{
+  const unsigned char* p    = (const unsigned char*)keyData;
+  EVP_PKEY*            pkey = NULL;
+  EVP_PKEY_CTX*        ctx  = NULL;
+  CB_Key*              key  = NULL;
+
+  if (keyData != NULL)
+  {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    pkey = isPrivate ? d2i_PrivateKey(EVP_PKEY_EC, NULL, &p, (long)keyLength)
+                     : _cb_decodePublicKey(keyData, (long)keyLength);
+#else
+    pkey = isPrivate ? d2i_PrivateKey(EVP_PKEY_EC, NULL, &p, (long)keyLength)
+                     : d2i_PUBKEY(NULL, &p, (long)keyLength);
+#endif
+  }
+
+  if (pkey != NULL)
+  {
+    ctx = EVP_PKEY_CTX_new(pkey, NULL);
+    if (   (EVP_PKEY_base_id(pkey) != EVP_PKEY_EC) || (ctx == NULL)
+        || ((isPrivate ? EVP_PKEY_check(ctx) : EVP_PKEY_public_check(ctx))
+            != 1))
+    {
+      EVP_PKEY_free(pkey);
+      pkey = NULL;
+      *status |= API_STATUS_ERR_INVLID_KEY;
+    }
+    EVP_PKEY_CTX_free(ctx);
+  }
+  else
+  {
+    *status |= API_STATUS_ERR_NO_DATA;
+  }
+
+  if (pkey != NULL)
+  {
+    key = calloc(1, sizeof(CB_Key));
+    if (key != NULL)
+    {
+      key->pkey      = pkey;
+      key->isPrivate = isPrivate;
+    }
+    else
+    {
+      EVP_PKEY_free(pkey);
+      *status |= API_STATUS_ERR_INSUF_KEYSTORAGE;
+    }
+  }
+
+  return key;
+}
+
+/**
+ * Free the key including its contexts.
+ *
+ * @param key The key, can be NULL.
+ */
+void cb_freeKey(CB_Key* key)
+{
+  int idx = 0;
+
+  if (key != NULL)
+  {
+    for (; idx < CB_KEY_CONTEXTS; idx++)
+    {
+      EVP_PKEY_CTX_free(key->ctx[idx]);
+    }
+    EVP_PKEY_free(key->pkey);
+    memset(key, 0, sizeof(CB_Key));
+    free(key);
+  }
+}
+
+/**
+ * Create a context of the key that is initialized for verify or sign.
+ *
+ * @param key The key.
+ *
+ * @return The context or NULL.
+ */
+static EVP_PKEY_CTX* _cb_newContext(CB_Key* key)
+{
+  EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(key->pkey, NULL);
+
+  if (ctx != NULL)
+  {
+    if ((key->isPrivate ? EVP_PKEY_sign_init(ctx)
+                        : EVP_PKEY_verify_init(ctx)) != 1)
+    {
+      EVP_PKEY_CTX_free(ctx);
+      ctx = NULL;
+    }
+  }
+
+  return ctx;
+}
+
+/**
+ * Claim one of the contexts of the key. If all contexts are in use by other
+ * threads a temporary context is created.
+ *
+ * @param key The key.
+ * @param slot OUT value that receives the claimed slot or -1 for a temporary
+ *             context.
+ *
+ * @return The context or NULL.
+ */
+static EVP_PKEY_CTX* _cb_claimContext(CB_Key* key, int* slot)
+{
+  int idx = 0;
+
+  for (; idx < CB_KEY_CONTEXTS; idx++)
+  {
+    if (!__atomic_test_and_set(&key->busy[idx], __ATOMIC_ACQUIRE))
+    {
+      // Only the thread holding the slot creates its context.
+      if (key->ctx[idx] == NULL)
+      {
+        key->ctx[idx] = _cb_newContext(key);
+      }
+      if (key->ctx[idx] != NULL)
+      {
+        *slot = idx;
+        return key->ctx[idx];
+      }
+      __atomic_clear(&key->busy[idx], __ATOMIC_RELEASE);
+      break;
+    }
+  }
+
+  *slot = -1;
+  return _cb_newContext(key);
+}
+
+/**
+ * Return the context claimed with _cb_claimContext.
+ *
+ * @param key The key.
+ * @param slot The claimed slot.
+ * @param ctx The context.
+ */
+static void _cb_releaseContext(CB_Key* key, int slot, EVP_PKEY_CTX* ctx)
+{
+  if (slot >= 0)
+  {
+    __atomic_clear(&key->busy[slot], __ATOMIC_RELEASE);
+  }
+  else
+  {
+    EVP_PKEY_CTX_free(ctx);
+  }
+}
+
+/**
+ * Verify the signature over the SHA256 digest.
+ *
+ * @param key The public key.
+ * @param digest The message digest (CB_DIGEST_LENGTH).
+ * @param signature The DER encoded signature.
+ * @param sigLength The length of the signature.
+ *
+ * @return 1 if valid, 0 if invalid and -1 in case of an error.
+ */
+int cb_verify(CB_Key* key, const u_int8_t* digest, const u_int8_t* signature,
+              u_int16_t sigLength)
+{
+  int           slot   = -1;
+  int           retVal = -1;
+  EVP_PKEY_CTX* ctx    = _cb_claimContext(key, &slot);
+
+  if (ctx != NULL)
+  {
+    retVal = EVP_PKEY_verify(ctx, signature, sigLength, digest,
+                             CB_DIGEST_LENGTH);
+    _cb_releaseContext(key, slot, ctx);
+  }
+
+  // EVP reports malformed signatures as errors, ECDSA_verify as invalid.
+  return retVal < 0 ? 0 : retVal;
+}
+
+/**
+ * Return the maximum size of a signature generated with the key.
+ *
+ * @param key The private key.
+ *
+ * @return The size in bytes.
+ */
+int cb_getSignatureSize(CB_Key* key)
+{
+  return EVP_PKEY_size(key->pkey);
+}
+
+/**
+ * Sign the SHA256 digest.
+ *
+ * @param key The private key.
+ * @param digest The message digest (CB_DIGEST_LENGTH).
+ * @param sigBuff The buffer receiving the DER encoded signature, it MUST have
+ *                at least cb_getSignatureSize bytes.
+ * @param sigLength OUT value that receives the length of the signature.
+ *
+ * @return 1 if the signature was generated, otherwise 0.
+ */
+int cb_sign(CB_Key* key, const u_int8_t* digest, u_int8_t* sigBuff,
+            u_int32_t* sigLength)
+{
+  int           slot   = -1;
+  int           retVal = 0;
+  size_t        length = (size_t)cb_getSignatureSize(key);
+  EVP_PKEY_CTX* ctx    = _cb_claimContext(key, &slot);
+
+  if (ctx != NULL)
+  {
+    retVal = EVP_PKEY_sign(ctx, sigBuff, &length, digest, CB_DIGEST_LENGTH)
+             == 1;
+    _cb_releaseContext(key, slot, ctx);
+  }
+  *sigLength = retVal ? (u_int32_t)length : 0;
+
+  return retVal;
+}
+
+/**
+ * Generate the SHA256 digest of the message using the EVP_MD_CTX of the
+ * calling thread.
+ *
+ * @param message The message.
+ * @param length The length of the message.
+ * @param digest The buffer receiving the digest (CB_DIGEST_LENGTH).
+ */
+void cb_sha256(const u_int8_t* message, u_int32_t length, u_int8_t* digest)
+{
+  EVP_MD_CTX* ctx = NULL;
+
+  if (CB_initialized)
+  {
+    ctx = pthread_getspecific(CB_mdCtxKey);
+    if (ctx == NULL)
+    {
+      ctx = EVP_MD_CTX_new();
+      if (ctx != NULL && pthread_setspecific(CB_mdCtxKey, ctx) != 0)
+      {
+        EVP_MD_CTX_free(ctx);
+        ctx = NULL;
+      }
+    }
+  }
+
+  if (   (ctx == NULL)
+      || (EVP_DigestInit_ex(ctx, CB_sha256, NULL) != 1)
+      || (EVP_DigestUpdate(ctx, message, length) != 1)
+      || (EVP_DigestFinal_ex(ctx, digest, NULL) != 1))
+  {
+    EVP_Digest(message, length, digest, NULL, EVP_sha256(), NULL);
+  }
+}
+
+#else
+
+/**
+ * Initialize the backend.
+ *
+ * @return true
+ */
+bool cb_init()
+{
+  return true;
+}
+
+/**
+ * Nothing to release.
+ */
+void cb_release()
+{
+}
+
+/**
+ * Return the name of the backend.
+ *
+ * @return "EC_KEY"
+ */
+const char* cb_getName()
+{
+  return "EC_KEY";
+}
+
+/**
+ * Create the group of the given curve including the precomputed
+ * multiplication tables. Keys that use the group share the tables.
+ *
+ * @param curve The OpenSSL curve NID.
+ *
+ * @return The group or NULL.
+ */
+EC_GROUP* cb_newGroup(int curve)
+{
+  EC_GROUP* group = NULL;
+
+  if (curve != NID_undef)
+  {
+    group = EC_GROUP_new_by_curve_name(curve);
+    if (group != NULL && !EC_GROUP_precompute_mult(group, NULL))
+    {
+      sca_debugLog(LOG_WARNING, "Could not precompute the multiplication "
+                                "tables of curve %d\n", curve);
+      EC_GROUP_free(group);
+      group = NULL;
+    }
+  }
+
+  return group;
+}
+
+/**
+ * Convert the DER key stored in the keyData into an EC_KEY.
+ * The following status will be returned:
+ * API_STATUS_ERR_INVLID_KEY - The key could be converted but did fail the
+ *                             EC_KEY_check
+ * API_STATUS_ERR_NO_DATA - The DER key is missing.
+ *
+ * @param keyData The DER encoded key
+ * @param keyLength The length of the DER encoded key
+ * @param isPrivate indicate if the key is private
+ * @param group The group with precomputed multiplication tables that will be
+ *              used by the key if it is of the same curve. Can be NULL.
+ * @param status Adds return information in case something goes wrong - the
+ *               status flag will NOT be initialized within the function.
+ *
+ * @return The key or NULL. In the later case check status.
+ */
+CB_Key* cb_convertKey(u_int8_t* keyData, u_int16_t keyLength, bool isPrivate,
+                      EC_GROUP* group, sca_status_t* status)
+{
+  char* p    = (char*)keyData;
+  EC_KEY* ec_key = NULL;
+  if (isPrivate)
+  {
+    ec_key = d2i_ECPrivateKey(NULL, (const unsigned char**)&p, (long)keyLength);
+  }
+  else
+  {
+    size_t ecdsa_key_int;
+    ecdsa_key_int = (size_t) d2i_EC_PUBKEY(NULL, (const unsigned char**)&p,
+                                           (long)keyLength);
+    ec_key = (EC_KEY*)ecdsa_key_int;
+  }
+
+  // Now we need to get the EC_KEY
+  if (ec_key != NULL)
+  {
+    if (!EC_KEY_check_key(ec_key))
+    {
+      EC_KEY_free(ec_key);
+      ec_key = NULL;
+      *status |= API_STATUS_ERR_INVLID_KEY;
+    }
+    else if (group != NULL
+             && EC_GROUP_cmp(EC_KEY_get0_group(ec_key), group, NULL) == 0)
+    {
+      // Share the precomputed tables instead of the key's own group.
+      if (!EC_KEY_set_group(ec_key, group))
+      {
+        EC_KEY_free(ec_key);
+        ec_key = NULL;
+        *status |= API_STATUS_ERR_INSUF_KEYSTORAGE;
+      }
+    }
+  }
+  else
+  {
+    *status |= API_STATUS_ERR_NO_DATA;
+  }
+
+  return ec_key;
+}
+
+/**
+ * Free the key.
+ *
+ * @param key The key, can be NULL.
+ */
+void cb_freeKey(CB_Key* key)
+{
+  if (key != NULL)
+  {
+    EC_KEY_free(key);
+  }
+}
+
+/**
+ * Verify the signature over the SHA256 digest.
+ *
+ * @param key The public key.
+ * @param digest The message digest (CB_DIGEST_LENGTH).
+ * @param signature The DER encoded signature.
+ * @param sigLength The length of the signature.
+ *
+ * @return 1 if valid, 0 if invalid and -1 in case of an error.
+ */
+int cb_verify(CB_Key* key, const u_int8_t* digest, const u_int8_t* signature,
+              u_int16_t sigLength)
+{
+  return ECDSA_verify(0, digest, CB_DIGEST_LENGTH, signature, sigLength, key);
+}
+
+/**
+ * Return the maximum size of a signature generated with the key.
+ *
+ * @param key The private key.
+ *
+ * @return The size in bytes.
+ */
+int cb_getSignatureSize(CB_Key* key)
+{
+  return ECDSA_size(key);
+}
+
+/**
+ * Sign the SHA256 digest.
+ *
+ * @param key The private key.
+ * @param digest The message digest (CB_DIGEST_LENGTH).
+ * @param sigBuff The buffer receiving the DER encoded signature, it MUST have
+ *                at least cb_getSignatureSize bytes.
+ * @param sigLength OUT value that receives the length of the signature.
+ *
+ * @return 1 if the signature was generated, otherwise 0.
+ */
+int cb_sign(CB_Key* key, const u_int8_t* digest, u_int8_t* sigBuff,
+            u_int32_t* sigLength)
+{
+  return ECDSA_sign(0, digest, CB_DIGEST_LENGTH, sigBuff,
+                    (unsigned int*)sigLength, key);
+}
+
+/**
+ * Generate the SHA256 digest of the message.
+ *
+ * @param message The message.
+ * @param length The length of the message.
+ * @param digest The buffer receiving the digest (CB_DIGEST_LENGTH).
+ */
+void cb_sha256(const u_int8_t* message, u_int32_t length, u_int8_t* digest)
+{
+  SHA256(message, length, digest);
+}
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * The OpenSSL functions used for keys, signatures and message digests. The
+ * plug-in is built twice from the same sources:
+ *
+ * libSRxBGPSecOpenSSL uses EC_KEY, ECDSA_verify / ECDSA_sign and SHA256.
+ *
+ * libSRxBGPSecOpenSSL3 (BOSSL_EVP defined) uses EVP_PKEY. Each key keeps up
+ * to CB_KEY_CONTEXTS EVP_PKEY_CTX that are initialized once for verify or
+ * sign and re-used by the threads using the key. Each thread keeps its own
+ * EVP_MD_CTX for the message digests. On OpenSSL 3 this avoids the legacy
+ * EC_KEY shim and the fetch and allocation of contexts per call.
+ *
+ * @version 0.4.0.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ *  0.4.0.0 - 2026/10/18
+ *            * Created crypto backend
+ */
+#ifndef CRYPTO_BACKEND_H
+#define CRYPTO_BACKEND_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include "../srx/srxcryptoapi.h"
+
+/** The number of re-usable contexts per key */
+#define CB_KEY_CONTEXTS 4
+/** The length of the SHA256 message digest */
+#define CB_DIGEST_LENGTH 32
+
+#ifdef BOSSL_EVP
+/**
+ * A key of the EVP backend.
+ */
+typedef struct
+{
+  /** The key. */
+  EVP_PKEY*     pkey;
+  /** Indicates if the contexts are initialized for signing. */
+  bool          isPrivate;
+  /** The contexts, created when first needed. */
+  EVP_PKEY_CTX* ctx[CB_KEY_CONTEXTS];
+  /** Indicates which context is currently used by a thread. */
+  bool          busy[CB_KEY_CONTEXTS];
+} CB_Key;
+#else
+/** The legacy backend uses the EC_KEY itself. */
+typedef EC_KEY CB_Key;
+#endif
+
+/**
+ * Initialize the backend.
+ *
+ * @return true if the backend could be initialized.
+ */
+bool cb_init();
+
+/**
+ * Release the resources of the backend. The threads that used the backend,
+ * except the calling one, MUST be terminated already.
+ */
+void cb_release();
+
+/**
+ * Return the name of the backend.
+ *
+ * @return "EVP" or "EC_KEY"
+ */
+const char* cb_getName();
+
+/**
+ * Create the group of the given curve including the precomputed
+ * multiplication tables. Keys that use the group share the tables.
+ *
+ * @param curve The OpenSSL curve NID.
+ *
+ * @return The group or NULL if not supported by the backend.
+ */
+EC_GROUP* cb_newGroup(int curve);
+
+/**
+ * Convert the DER key into the key used by the backend.
+ * The following status will be returned:
+ * API_STATUS_ERR_INVLID_KEY - The key could be converted but did fail the
+ *                             key check
+ * API_STATUS_ERR_NO_DATA - The DER key is missing.
+ *
+ * @param keyData The DER encoded key
+ * @param keyLength The length of the DER encoded key
+ * @param isPrivate indicate if the key is private
+ * @param group The group with precomputed multiplication tables that will be
+ *              used by the key if it is of the same curve. Can be NULL.
+ * @param status Adds return information in case something goes wrong - the
+ *               status flag will NOT be initialized within the function.
+ *
+ * @return The key or NULL. In the later case check status.
+ */
+CB_Key* cb_convertKey(u_int8_t* keyData, u_int16_t keyLength, bool isPrivate,
+                      EC_GROUP* group, sca_status_t* status);
+
+/**
+ * Free the key.
+ *
+ * @param key The key, can be NULL.
+ */
+void cb_freeKey(CB_Key* key);
+
+/**
+ * Verify the signature over the SHA256 digest.
+ *
+ * @param key The public key.
+ * @param digest The message digest (CB_DIGEST_LENGTH).
+ * @param signature The DER encoded signature.
+ * @param sigLength The length of the signature.
+ *
+ * @return 1 if valid, 0 if invalid and -1 in case of an error.
+ */
+int cb_verify(CB_Key* key, const u_int8_t* digest, const u_int8_t* signature,
+              u_int16_t sigLength);
+
+/**
+ * Return the maximum size of a signature generated with the key.
+ *
+ * @param key The private key.
+ *
+ * @return The size in bytes.
+ */
+int cb_getSignatureSize(CB_Key* key);
+
+/**
+ * Sign the SHA256 digest.
+ *
+ * @param key The private key.
+ * @param digest The message digest (CB_DIGEST_LENGTH).
+ * @param sigBuff The buffer receiving the DER encoded signature, it MUST have
+ *                at least cb_getSignatureSize bytes.
+ * @param sigLength OUT value that receives the length of the signature.
+ *
+ * @return 1 if the signature was generated, otherwise 0.
+ */
+int cb_sign(CB_Key* key, const u_int8_t* digest, u_int8_t* sigBuff,
+            u_int32_t* sigLength);
+
+/**
+ * Generate the SHA256 digest of the message.
+ *
+ * @param message The message.
+ * @param length The length of the message.
+ * @param digest The buffer receiving the digest (CB_DIGEST_LENGTH).
+ */
+void cb_sha256(const u_int8_t* message, u_int32_t length, u_int8_t* digest);
+
+#endif /* CRYPTO_BACKEND_H */
@@ -27,10 +27,18 @@
  * Known Issue:
  *   At this time only PEM formated private keys can be loaded.
  * 
- * @version 0.3.0.3
+ * @version 0.4.0.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ *  0.4.0.0 - 2026/10/18
+ *            * Keys are converted, checked and freed by the crypto backend.
+ *            * Replaced the ASN byte sum buckets with a hash table over ASN and
+ *              SKI that grows with the number of keys.
+ *            * Added read write locking, added function ks_releaseKey.
+ *            * Keys are converted during registration only and use the 
+ *              storage group with precomputed multiplication tables.
+ *            * Fixed the size calculation in ks_delKey.
  *  0.3.0.3 - 2021/05/08 - oborchert
  *            * Renamed all instances of volt to vault
  *  0.3.0.0 - 2017/09/13 - oborchert
@@ -55,30 +63,146 @@
  *          - 2016/05/25 - oborchert
  *            * Created Key Storage
  */
+#include <pthread.h>
 #include <stdbool.h>
 #include <syslog.h>
 #include <uthash.h>
 #include <sys/types.h>
 #include <openssl/ec.h>
+#include <openssl/obj_mac.h>
 #include <openssl/x509.h>
 #include "../srx/srxcryptoapi.h"
+#include "crypto_backend.h"
 #include "key_storage.h"
 
+/** The initial number of buckets, MUST be a power of two. */
 #define KS_BUCKETS 256
+/** The FNV-1a offset basis */
+#define KS_FNV_BASIS 2166136261u
+/** The FNV-1a prime */
+#define KS_FNV_PRIME 16777619u
 
 /**
- * REturn the bucket of the given ASN
+ * Return the bucket of the given ASN and SKI. The FNV-1a hash is used.
  * 
+ * @param storage The key storage.
  * @param asn The AS number - format not important.
+ * @param ski The SKI of the key (SKI_LENGTH)
  * 
- * @return The bucket number of the ASN
+ * @return The bucket number of the key
  */
-static u_int8_t _ks_getBucket(u_int32_t asn)
+static u_int32_t _ks_getBucket(KeyStorage* storage, u_int32_t asn, 
+                               u_int8_t* ski)
 {      
-  u_int8_t bucket = (asn >> 24) + ((asn >> 16) & 0xFF) + ((asn >> 8) & 0xFF)
-                    + (asn & 0xFF);
-  bucket = bucket & 255;
-  return bucket;
+  u_int32_t hash = KS_FNV_BASIS;
+  u_int8_t* asnBytes = (u_int8_t*)&asn;
+  int idx = 0;
+  
+  for (; idx < sizeof(u_int32_t); idx++)
+  {
+    hash = (hash ^ asnBytes[idx]) * KS_FNV_PRIME;
+  }
+  for (idx = 0; idx < SKI_LENGTH; idx++)
+  {
+    hash = (hash ^ ski[idx]) * KS_FNV_PRIME;
+  }
+  
+  return hash & (storage->numBuckets - 1);
+}
+
+/**
+ * Find the element of the given ASN and SKI. The caller MUST hold the storage
+ * lock.
+ * 
+ * @param storage The key storage.
+ * @param asn The AS number of the key.
+ * @param ski The SKI of the key (SKI_LENGTH)
+ * @param bucket OUT value that receives the bucket of the key, can be NULL.
+ * 
+ * @return The element or NULL if not found.
+ * 
+ * @since 0.4.0.0
+ */
+static KS_Key_Element* _ks_findElem(KeyStorage* storage, u_int32_t asn,
+                                    u_int8_t* ski, u_int32_t* bucket)
+{
+  u_int32_t       myBucket = _ks_getBucket(storage, asn, ski);
+  KS_Key_Element* elem     = storage->head[myBucket];
+  
+  while (elem != NULL)
+  {
+    if ((elem->asn == asn) && (memcmp(elem->ski, ski, SKI_LENGTH) == 0))
+    {
+      break;
+    }
+    elem = elem->next;
+  }
+  
+  if (bucket != NULL)
+  {
+    *bucket = myBucket;
+  }
+  
+  return elem;
+}
+
+/**
+ * Add the element as head of the given bucket. The caller MUST hold the 
+ * storage write lock.
+ * 
+ * @param storage The key storage.
+ * @param bucket The bucket of the element.
+ * @param elem The element to be added.
+ * 
+ * @since 0.4.0.0
+ */
+static void _ks_linkElem(KeyStorage* storage, u_int32_t bucket, 
+                         KS_Key_Element* elem)
+{
+  elem->prev = NULL;
+  elem->next = storage->head[bucket];
+  if (elem->next != NULL)
+  {
+    elem->next->prev = elem;
+  }
+  storage->head[bucket] = elem;
+}
+
+/**
+ * Double the number of buckets and move all elements into their new bucket.
+ * If not enough memory is available the storage remains unchanged. The caller 
+ * MUST hold the storage write lock.
+ * 
+ * @param storage The key storage.
+ * 
+ * @since 0.4.0.0
+ */
+static void _ks_grow(KeyStorage* storage)
+{
+  KS_Key_Element** oldHead    = storage->head;
+  u_int32_t        oldBuckets = storage->numBuckets;
+  KS_Key_Element*  elem       = NULL;
+  KS_Key_Element*  next       = NULL;
+  u_int32_t        idx        = 0;
+  
+  storage->head = calloc(oldBuckets * 2, sizeof(KS_Key_Element*));
+  if (storage->head == NULL)
+  {
+    storage->head = oldHead;
+    return;
+  }
+  
+  storage->numBuckets = oldBuckets * 2;
+  for (; idx < oldBuckets; idx++)
+  {
+    for (elem = oldHead[idx]; elem != NULL; elem = next)
+    {
+      next = elem->next;
+      _ks_linkElem(storage, _ks_getBucket(storage, elem->asn, elem->ski), 
+                   elem);
+    }
+  }
+  free(oldHead);
 }
 
 
@@ -117,56 +241,6 @@ static BGPSecKey* _ks_clone(BGPSecKey* key)
   return clone;  
 }
 
-/**
- * Convert the DER key stored in the keyData into an EC_KEY.
- * The following status will be returned:
- * API_STATUS_ERR_INVLID_KEY - The key could be converted but did fail the 
- *                             EC_KEY_check
- * API_STATUS_ERR_NO_DATA - The DER key is missing.
- * 
- * @param keyData The DER encoded key
- * @param keyLength The length of the DER encoded key
- * @param isPrivate indicate if the key is private
- * @param status Adds return information in case something goes wrong - the 
- *               status flag will NOT be initialized within the function.
- * 
- * @return The key or NULL. In the later case check status.
- */
-static EC_KEY* _ks_convertKey(u_int8_t* keyData, u_int16_t keyLength, 
-                              bool isPrivate, sca_status_t* status)
-{
-  char* p    = (char*)keyData;
-  EC_KEY* ec_key = NULL;
-  if (isPrivate)
-  {
-    ec_key = d2i_ECPrivateKey(NULL, (const unsigned char**)&p, (long)keyLength);
-  }
-  else
-  {
-    size_t ecdsa_key_int;
-    ecdsa_key_int = (size_t) d2i_EC_PUBKEY(NULL, (const unsigned char**)&p, 
-                                           (long)keyLength);
-    ec_key = (EC_KEY*)ecdsa_key_int;
-  }
-
-  // Now we need to get the EC_KEY
-  if (ec_key != NULL)
-  {
-    if (!EC_KEY_check_key(ec_key))
-    {
-      EC_KEY_free(ec_key);
-      ec_key = NULL;
-      *status |= API_STATUS_ERR_INVLID_KEY;
-    }
-  }
-  else
-  {
-    *status |= API_STATUS_ERR_NO_DATA;    
-  }
-  
-  return ec_key;
-}
-
 /**
  * Retrieve the EC_KEY associated to the given ski and asn. Here the source is
  * ignored.
@@ -199,72 +273,37 @@ void** ks_getKey(KeyStorage* storage, u_int8_t* ski, u_int32_t asn,
   
   if (myStatus == API_STATUS_OK)
   {
-    // find the correct elem list
-    u_int8_t bucket = _ks_getBucket(asn);    
-    KS_Key_Element* elem = storage->head[bucket];
+    pthread_rwlock_rdlock(&storage->lock);
+    KS_Key_Element* elem = _ks_findElem(storage, asn, ski, NULL);
     
-    while (elem != NULL)
+    if (elem != NULL)
     {
-      if (elem->asn < asn)
-      {
-        // Move forward in the list
-        elem = elem->next;
-        continue;
-      }
-      if (elem->asn > asn)
-      {
-        // Key Not found
-        myStatus = API_STATUS_INFO_KEY_NOTFOUND;
-        elem = NULL;
-        break;
-      }
-      // ASN Element found - check ski
-      if (memcmp(elem->ski, ski, SKI_LENGTH) != 0)
-      {
-        // No match, move on
-        elem = elem->next;
-        continue;
-      }
-      
       // ASN and ski match
-      int idx = 0;
       if (kType == ks_eckey_e) 
       {
+        int idx = 0;
         keys = (void**)elem->ec_key;
-      }
-      else
-      {
-        keys = (void**)elem->derKey;
-      }
-
-      if (kType == ks_eckey_e)
-      {
+        // Keys are converted during registration only.
         for(; idx < elem->noKeys; idx++)
         {
-          if (elem->ec_key[idx] != NULL)
+          if (elem->derKey[idx] == NULL)
           {
-            continue;
+            // DER Key not found
+            myStatus |= API_STATUS_ERR_USER1;
           }
-          // Load the key
-          if (elem->derKey[idx] != NULL)
-          {
-            elem->ec_key[idx] = _ks_convertKey(elem->derKey[idx]->keyData,
-                                               elem->derKey[idx]->keyLength,
-                                               storage->isPrivate, &myStatus);
-            if (myStatus & API_STATUS_ERR_NO_DATA)
-            {
-              myStatus |= API_STATUS_ERR_USER1;
-            }
-            continue;
-          }
-          // DER Key not found
-          myStatus |= API_STATUS_ERR_USER1;
-        }      
+        }
+      }
+      else
+      {
+        keys = (void**)elem->derKey;
       }
       // Found the key
       *noKeys = elem->noKeys;
-      break;
-    }     
+    }
+    else
+    {
+      pthread_rwlock_unlock(&storage->lock);
+    }
   }
   
   if (status != NULL)
@@ -278,6 +317,20 @@ void** ks_getKey(KeyStorage* storage, u_int8_t* ski, u_int32_t asn,
   return keys;
 }
 
+/**
+ * Release the keys returned by ks_getKey. This function MUST be called exactly
+ * once for each call of ks_getKey that returned keys. The keys MUST NOT be
+ * used afterwards.
+ * 
+ * @param storage The storage the keys were retrieved from.
+ * 
+ * @since 0.4.0.0
+ */
+void ks_releaseKey(KeyStorage* storage)
+{
+  pthread_rwlock_unlock(&storage->lock);
+}
+
 /**
  * Destroy the BGPSec Key
  * 
@@ -297,13 +350,17 @@ static void _ks_freeKey(BGPSecKey* key)
  * Generate a KeyStorage element. All internal memory is allocated using malloc!
  * 
  * @param key The key to be added. Here a copy of the Key will be stored!
+ * @param convert if true then convert the DER key into the EC_KEY
+ * @param isPrivate indicate if the key is private
+ * @param group The group used by the EC_KEY, can be NULL.
  * @param status The status of the generation.
  *              API_STATUS_ERR_NO_DATA if the conversion would not be performed.
  * 
  * @return a new key storage element or NULL if an error occurred - see status.
  */
 static KS_Key_Element* _ks_createKS_Element(BGPSecKey* key, bool convert,
-                                            bool isPrivate, sca_status_t* status)
+                                            bool isPrivate, EC_GROUP* group,
+                                            sca_status_t* status)
 {  
   KS_Key_Element* elem = malloc(sizeof(KS_Key_Element));
   sca_status_t myStatus = API_STATUS_OK;
@@ -327,8 +384,8 @@ static KS_Key_Element* _ks_createKS_Element(BGPSecKey* key, bool convert,
       if (elem->derKey[0] != NULL)
       {
         // create the array space for the ec_key
-        elem->ec_key = malloc(sizeof(EC_KEY*) * elem->noKeys);
-        memset(elem->ec_key, 0, sizeof(EC_KEY*) * elem->noKeys);
+        elem->ec_key = malloc(sizeof(CB_Key*) * elem->noKeys);
+        memset(elem->ec_key, 0, sizeof(CB_Key*) * elem->noKeys);
         if (elem->ec_key != NULL)
         {
           if (convert)
@@ -342,9 +399,9 @@ static KS_Key_Element* _ks_createKS_Element(BGPSecKey* key, bool convert,
             if (elem->derKey[0]->keyData != NULL)
             {              
               // This is now expected!!
-              elem->ec_key[0] = _ks_convertKey(elem->derKey[0]->keyData, 
+              elem->ec_key[0] = cb_convertKey(elem->derKey[0]->keyData, 
                                                elem->derKey[0]->keyLength, 
-                                               isPrivate, &myStatus);
+                                               isPrivate, group, &myStatus);
               if (elem->ec_key[0] == NULL)
               {
                 _ks_freeKey(elem->derKey[0]);
@@ -414,7 +471,7 @@ static KS_Key_Element* _ks_createKS_Element(BGPSecKey* key, bool convert,
  * @param head The head index.
  * @param elem The element to be removed
  */
-static void _ks_freeKS_Elem(KeyStorage* storage, int head,
+static void _ks_freeKS_Elem(KeyStorage* storage, u_int32_t head,
                             KS_Key_Element* elem)
 {  
   storage->size -= elem->noKeys;
@@ -423,7 +480,6 @@ static void _ks_freeKS_Elem(KeyStorage* storage, int head,
   if (elem->prev != NULL) 
   {     
     elem->prev->next = elem->next;
-    elem->prev = NULL;
   }
   else
   { // elem MUST be the head, otherwise it would have a previous 'prev' element
@@ -433,8 +489,9 @@ static void _ks_freeKS_Elem(KeyStorage* storage, int head,
   if (elem->next != NULL)
   {
     elem->next->prev = elem->prev;
-    elem->next = NULL;
   }
+  elem->prev = NULL;
+  elem->next = NULL;
   
   // Now free the allocated memory
   int kIdx = 0;
@@ -444,7 +501,7 @@ static void _ks_freeKS_Elem(KeyStorage* storage, int head,
     elem->derKey[kIdx] = NULL;
     if (elem->ec_key[kIdx] != NULL)
     {
-      EC_KEY_free(elem->ec_key[kIdx]);
+      cb_freeKey(elem->ec_key[kIdx]);
       elem->ec_key[kIdx] = NULL;
     }
   }
@@ -455,6 +512,20 @@ static void _ks_freeKS_Elem(KeyStorage* storage, int head,
   free(elem);
 }
 
+/**
+ * Return the curve of the given algorithm.
+ * 
+ * @param algoID The algorithm ID
+ * 
+ * @return The OpenSSL curve NID or NID_undef.
+ * 
+ * @since 0.4.0.0
+ */
+static int _ks_getCurve(u_int8_t algoID)
+{
+  return (algoID == SCA_ECDSA_ALGORITHM) ? NID_X9_62_prime256v1 : NID_undef;
+}
+
 /**
  * Initialized the key storage
  * 
@@ -469,8 +540,13 @@ void ks_init(KeyStorage* storage, u_int8_t algoID, bool isPrivate)
     storage->algorithmID = algoID;
     storage->isPrivate = isPrivate;
     storage->size = 0;
+    storage->numBuckets = KS_BUCKETS;
     storage->head = malloc(sizeof(KS_Key_Element*) * KS_BUCKETS);
     memset (storage->head, 0, sizeof(KS_Key_Element*) * KS_BUCKETS);
+    pthread_rwlock_init(&storage->lock, NULL);
+    
+    // The multiplication tables are computed once and shared by all keys.
+    storage->group = cb_newGroup(_ks_getCurve(algoID));
   }
 }
 
@@ -488,6 +564,11 @@ void ks_release(KeyStorage* storage)
     {
       free (storage->head);
     }      
+    if (storage->group != NULL)
+    {
+      EC_GROUP_free(storage->group);
+    }
+    pthread_rwlock_destroy(&storage->lock);
     free(storage);
   }
 }
@@ -521,17 +602,13 @@ int ks_delKey(KeyStorage* storage, BGPSecKey* key, sca_key_source_t source,
 {
   int retVal = API_SUCCESS; 
   int myStatus = API_STATUS_OK;
-  int             bucket = 0;
+  u_int32_t       bucket = 0;
   KS_Key_Element* elem   = NULL;
+  bool            locked = false;
   
   if (storage != NULL && key != NULL)
   {
-    if (key->algoID == storage->algorithmID)
-    {
-      bucket = _ks_getBucket(key->asn);
-      elem = storage->head[bucket];
-    }
-    else
+    if (key->algoID != storage->algorithmID)
     {
       // Algorithm ID does not match.
       myStatus = API_STATUS_ERR_USER1;
@@ -543,111 +620,100 @@ int ks_delKey(KeyStorage* storage, BGPSecKey* key, sca_key_source_t source,
     myStatus = API_STATUS_ERR_NO_DATA;
   }
     
+  if (myStatus == API_STATUS_OK)
+  {
+    pthread_rwlock_wrlock(&storage->lock);
+    locked = true;
+    elem = _ks_findElem(storage, key->asn, key->ski, &bucket);
+    if (elem == NULL)
+    {
+      // Key Not found
+      myStatus = API_STATUS_INFO_KEY_NOTFOUND;
+    }
+  }
+  
   if (elem != NULL)
   {
+    // ASN and ski match
+    // Now if key has a DER key delete only the DER portion, otherwise delete 
+    // the complete element.
+    int idx = 0;
     bool deleted = false;
-    while (elem != NULL)
+    if (key->keyData != NULL)
     {
-      if (elem->asn < key->asn)
-      {
-        // Move forward in the list
-        elem = elem->next;
-        continue;
-      }
-      if (elem->asn > key->asn)
-      {
-        // Key Not found
-        myStatus = API_STATUS_INFO_KEY_NOTFOUND;
-        elem = NULL;
-        break;
-      }
-
-      // ASN Element found - check ski
-      if (memcmp(elem->ski, key->ski, SKI_LENGTH) != 0)
+      //Find the correct key version to delete.
+      for (; idx < elem->noKeys; idx++)
       {
-        // No match, move on
-        elem = elem->next;
-        continue;
-      }
-      
-      // ASN and ski match
-      // Now if key has a DER key delete only the DER portion, otherwise delete 
-      // the complete element.
-      int idx = 0;
-      if (key->keyData != NULL)
-      {
-        //Find the correct key version to delete.
-        for (; idx < elem->noKeys; idx++)
+        if (deleted)
         {
-          if (deleted)
+          // move the current key to the previous emptied position
+          // This results in no empty place within the array and the last
+          // element entry is empty. Good for later rezising
+          elem->derKey[idx-1] = elem->derKey[idx];
+          elem->ec_key[idx-1] = elem->ec_key[idx];
+          elem->derKey[idx] = NULL;
+          elem->ec_key[idx] = NULL;
+        }
+        else
+        {  
+          if (elem->derKey[idx]->keyLength == key->keyLength)
           {
-            // move the current key to the previous emptied position
-            // This results in no empty place within the array and the last
-            // element entry is empty. Good for later rezising
-            elem->derKey[idx-1] = elem->derKey[idx];
-            elem->ec_key[idx-1] = elem->ec_key[idx];
-            elem->derKey[idx] = NULL;
-            elem->ec_key[idx] = NULL;
-          }
-          else
-          {  
-            if (elem->derKey[idx]->keyLength == key->keyLength)
+            if (memcmp(elem->derKey[idx]->keyData, key->keyData, 
+                       key->keyLength) == 0)
             {
-              if (memcmp(elem->derKey[idx]->keyData, key->keyData, 
-                         key->keyLength) == 0)
+              // Now delete this version of the ec_key
+              if (elem->ec_key[idx] != NULL)
               {
-                // Now delete this version of the ec_key
-                if (elem->ec_key[idx] != NULL)
-                {
-                  // This array is is OpenSSL malloc'ed
-                  EC_KEY_free(elem->ec_key[idx]);
-                  elem->ec_key[idx] = NULL;
-                }
-                // Now free the der_key
-                _ks_freeKey(elem->derKey[idx]);
-                elem->derKey[idx] = NULL;
-                deleted = true;
-                elem->noKeys--;
-                storage->size--;
+                // This array is is OpenSSL malloc'ed
+                cb_freeKey(elem->ec_key[idx]);
+                elem->ec_key[idx] = NULL;
               }
+              // Now free the der_key
+              _ks_freeKey(elem->derKey[idx]);
+              elem->derKey[idx] = NULL;
+              deleted = true;
             }
           }
         }
-        if (deleted)
+      }
+      if (deleted)
+      {
+        elem->noKeys--;
+        storage->size--;
+        if (elem->noKeys == 0)
+        {
+          // This was the only key, remove the complete element
+          _ks_freeKS_Elem(storage, bucket, elem);
+        }
+        else
         {
-          if (elem->noKeys == 0)
+          // some more duplicate keys exist. 
+          // Now resize
+          void** dk = realloc(elem->derKey, sizeof(BGPSecKey*) * elem->noKeys);
+          if (dk != NULL)
           {
-            // This was the only key, remove the complete element
-            _ks_freeKS_Elem(storage, bucket, elem);
+            elem->derKey = (BGPSecKey**)dk;
           }
-          else
+          void** ek = realloc(elem->ec_key, sizeof(CB_Key*) * elem->noKeys);
+          if (ek != NULL)
           {
-            // some more duplicate keys exist. 
-            // Now resize
-            void** dk = realloc(elem->derKey, sizeof(BGPSecKey*) + elem->noKeys);
-            if (dk != NULL)
-            {
-              elem->derKey = (BGPSecKey**)dk;
-            }
-            void** ek = realloc(elem->ec_key, sizeof(EC_KEY*) + elem->noKeys);
-            if (ek != NULL)
-            {
-              elem->ec_key = (EC_KEY**)ek;
-            }
+            elem->ec_key = (CB_Key**)ek;
           }
         }
       }
-      else
-      {
-        // DER is NULL so delete the complete element.
-        storage->size -= elem->noKeys;
-        _ks_freeKS_Elem(storage, bucket, elem);
-        deleted = true;
-      }
-      elem = NULL;
+    }
+    else
+    {
+      // DER is NULL so delete the complete element.
+      _ks_freeKS_Elem(storage, bucket, elem);
     }
   }
   
+  if (locked)
+  {
+    pthread_rwlock_unlock(&storage->lock);
+  }
+  
   if (status != NULL)
   {
     *status = myStatus;
@@ -665,10 +731,11 @@ void ks_empty(KeyStorage* storage)
 {
   if (storage != NULL)
   {
+    pthread_rwlock_wrlock(&storage->lock);
     if (storage->head != NULL)
     { // Should NOT be NULL
-      int idx = 0;
-      for (; idx < KS_BUCKETS; idx++)
+      u_int32_t idx = 0;
+      for (; idx < storage->numBuckets; idx++)
       {
         while (storage->head[idx] != NULL)
         {
@@ -676,11 +743,13 @@ void ks_empty(KeyStorage* storage)
         }
       }
     }
-  }
-  if (storage->size != 0)
-  {
-    sca_debugLog(LOG_WARNING, "Key storage could not be emptied! [%p]\n", 
-                 storage);
+    pthread_rwlock_unlock(&storage->lock);
+    
+    if (storage->size != 0)
+    {
+      sca_debugLog(LOG_WARNING, "Key storage could not be emptied! [%p]\n", 
+                   storage);
+    }
   }
 }
 
@@ -701,25 +770,21 @@ void ks_empty(KeyStorage* storage)
  * @param key The BGPSecKey to be stored.
  * @param source The source where the ley came from.
  * @param status an OUT value that provides more information.
- * @param convert if true then convert the DER key into the EC_KEY
+ * @param convert if true then convert the DER key into the EC_KEY. Keys that 
+ *                are not converted here are only available as DER keys.
  * 
  * @return API_SUCESS if it could be stored, otherwise API_FAILED. 
  */
 int ks_storeKey(KeyStorage* storage, BGPSecKey* key, sca_key_source_t source, 
                 sca_status_t* status, bool convert)
 {
-  sca_status_t myStatus = API_STATUS_OK;
-  int  retVal   = API_SUCCESS;
-  int  bucket   = 0;
+  sca_status_t    myStatus = API_STATUS_OK;
+  u_int32_t       bucket   = 0;
+  KS_Key_Element* elem     = NULL;
          
   if (storage != NULL && key != NULL)
   {
-    if (key->algoID == storage->algorithmID)
-    {
-      // The asn is in big endian format, 
-      bucket = _ks_getBucket(key->asn);    
-    }
-    else
+    if (key->algoID != storage->algorithmID)
     {
       // Algorithm ID does not match.
       myStatus = API_STATUS_ERR_USER1;
@@ -731,139 +796,86 @@ int ks_storeKey(KeyStorage* storage, BGPSecKey* key, sca_key_source_t source,
     myStatus = API_STATUS_ERR_NO_DATA;
   }
   
-  if (storage->head[bucket] != NULL)
+  if (myStatus == API_STATUS_OK)
   {
-    // we have to find the position to insert the new key
-    KS_Key_Element* elem = storage->head[bucket];
-    while (elem != NULL)
+    pthread_rwlock_wrlock(&storage->lock);
+    elem = _ks_findElem(storage, key->asn, key->ski, &bucket);
+    if (elem == NULL)
     {
-      if (elem->asn < key->asn)
+      // A new key, the conversion is done before it is visible to readers.
+      elem = _ks_createKS_Element(key, convert, storage->isPrivate, 
+                                  storage->group, &myStatus);
+      if (elem != NULL)
       {
-        if (elem->next != NULL)
-        {
-          elem = elem->next;
-          continue;
-        }
-        // add as last element          
+        _ks_linkElem(storage, bucket, elem);
         storage->size++;
-        elem->next = _ks_createKS_Element(key, convert, storage->isPrivate, 
-                                          &myStatus);
-        elem->next->prev = elem;
-        break;
-      }
-
-      if (elem->asn > key->asn)
-      {
-        // insert before the element
-        KS_Key_Element* newElem = _ks_createKS_Element(key, convert, 
-                                                 storage->isPrivate, &myStatus);
-        storage->size++;
-        newElem->next = elem;
-        newElem->prev = elem->prev;
-        elem->prev    = newElem;
-        if (newElem->prev != NULL)
+        if (storage->size > storage->numBuckets)
         {
-          newElem->prev->next = newElem;
+          _ks_grow(storage);
         }
-        else
-        {
-          // new head
-          storage->head[bucket] = newElem;
-        }
-        break;
       }
+    }
+    else
+    {
+      // check if the key already exist.
+      int  kIdx = 0;
+      bool inserted = false;
 
-      // as numbers are a match. check ski
-      if (memcmp(elem->ski, key->ski, SKI_LENGTH) == 0)
+      // Go through all internal keys (most likely only one) and check if it 
+      // is already stored.
+      for (; kIdx < elem->noKeys && !inserted; kIdx++)
       {
-        // check if the key already exist.
-        int  kIdx = 0;
-        bool inserted = false;
-
-        // Go through all internal keys (most likely only one) and check if it 
-        // is already stored.
-        for (; kIdx < elem->noKeys && !inserted; kIdx++)
+        if (elem->derKey[kIdx]->keyLength == key->keyLength)
         {
-          if (elem->derKey[kIdx]->keyLength == key->keyLength)
+          // check if the key is already stored
+          if (memcmp(elem->derKey[kIdx]->keyData, key->keyData, key->keyLength) == 0)
           {
-            // check if the key is already stored
-            if (memcmp(elem->derKey[kIdx]->keyData, key->keyData, key->keyLength) == 0)
-            {
-              // duplicate key
-              inserted = true; // stop the for loop
-              myStatus |= API_STATUS_INFO_USER1;
-            }
+            // duplicate key
+            inserted = true; // stop the for loop
+            myStatus |= API_STATUS_INFO_USER1;
           }
         }
-
-        // If not inserted then we have an SKI collision and we need to add it
-        if (!inserted)
-        {
-          // add one more key / ec_key
-          elem->noKeys++;
-          // Re-allocate the internal arrays.
-          BGPSecKey** dk = realloc(elem->derKey, sizeof(BGPSecKey*) * elem->noKeys);
-          EC_KEY** ek = realloc(elem->ec_key, sizeof(EC_KEY*) * elem->noKeys);
-                    
-          if (dk != NULL && ek != NULL)
-          {
-            storage->size++;
-            elem->derKey = dk;
-            elem->ec_key = ek;
-            elem->derKey[elem->noKeys-1] = _ks_clone(key);
-            elem->ec_key[elem->noKeys-1] = _ks_convertKey(key->keyData, 
-                                 key->keyLength, storage->isPrivate, &myStatus);
-            inserted = true;
-          }
-          else
-          {
-            // not enough memory for the ec_key, shrink the key back
-            myStatus |= API_STATUS_ERR_INSUF_KEYSTORAGE;
-            elem->noKeys--;
-            if (dk != NULL)
-            {
-              elem->derKey = realloc(dk, sizeof(BGPSecKey*) * elem->noKeys);
-            }
-            if (ek != NULL)
-            {
-              elem->ec_key = realloc(ek, sizeof(EC_KEY*) * elem->noKeys);
-            }
-          }
-        }
-        break; // The while (elem != NULL) loop.
       }
-      else
+
+      // If not inserted then we have an SKI collision and we need to add it
+      if (!inserted)
       {
-        // ASN matches but not SKI
-        // move to the next or add as last.
-        if (elem->next != NULL)
+        // add one more key / ec_key
+        elem->noKeys++;
+        // Re-allocate the internal arrays.
+        BGPSecKey** dk = realloc(elem->derKey, sizeof(BGPSecKey*) * elem->noKeys);
+        CB_Key** ek = realloc(elem->ec_key, sizeof(CB_Key*) * elem->noKeys);
+                  
+        if (dk != NULL && ek != NULL)
         {
-          elem = elem->next;
+          storage->size++;
+          elem->derKey = dk;
+          elem->ec_key = ek;
+          elem->derKey[elem->noKeys-1] = _ks_clone(key);
+          elem->ec_key[elem->noKeys-1] = convert 
+                             ? cb_convertKey(key->keyData, key->keyLength, 
+                                              storage->isPrivate, storage->group,
+                                              &myStatus)
+                             : NULL;
+          inserted = true;
         }
         else
         {
-          elem->next = _ks_createKS_Element(key, convert, storage->isPrivate, 
-                                            &myStatus);
-          if (elem->next != NULL)
+          // not enough memory for the ec_key, shrink the key back
+          myStatus |= API_STATUS_ERR_INSUF_KEYSTORAGE;
+          elem->noKeys--;
+          if (dk != NULL)
           {
-            storage->size++;            
+            elem->derKey = realloc(dk, sizeof(BGPSecKey*) * elem->noKeys);
+          }
+          if (ek != NULL)
+          {
+            elem->ec_key = realloc(ek, sizeof(CB_Key*) * elem->noKeys);
           }
-         // else set some status and return API_FAILURE ?????
-          break; // The while (elem != NULL) loop.
         }
       }
     }
-  }
-  else
-  {
-    // we have a new head
-    storage->head[bucket] = _ks_createKS_Element(key, convert, 
-                                                 storage->isPrivate, &myStatus);
-    if (storage->head[bucket] != NULL)
-    {
-      storage->size++;      
-    }
-    // else set some status and return API_FAILURE ?????
+    pthread_rwlock_unlock(&storage->lock);
   }
   
   if (status != NULL)
@@ -871,8 +883,8 @@ int ks_storeKey(KeyStorage* storage, BGPSecKey* key, sca_key_source_t source,
     *status = myStatus;
   }
   
-  return retVal = ((myStatus & API_STATUS_ERROR_MASK) != 0) ? API_FAILURE
-                                                            : API_SUCCESS;
+  return ((myStatus & API_STATUS_ERROR_MASK) != 0) ? API_FAILURE
+                                                   : API_SUCCESS;
 }
 
 /** 
@@ -888,48 +900,25 @@ int ks_storeKey(KeyStorage* storage, BGPSecKey* key, sca_key_source_t source,
 int ks_removeSource(KeyStorage* storage, sca_key_source_t source)
 {
   printf ("KEYSTORAGE: ks_removeSource not implemented yet.");
-  int idx = 0;
+  u_int32_t idx = 0;
   KS_Key_Element* keyElem  = NULL;
+  KS_Key_Element* next     = NULL;
   
+  pthread_rwlock_wrlock(&storage->lock);
   // Walk through all buckets
-  for (; idx < KS_BUCKETS; idx++)
+  for (; idx < storage->numBuckets; idx++)
   {
-    // set element to kead and check from here
-    keyElem  = storage->head[idx];
-    if (keyElem != NULL)
+    // This bucket contains keys, walk the list.
+    for (keyElem = storage->head[idx]; keyElem != NULL; keyElem = next)
     {
-      // This bucket contains keys, walk the list.
-      while (keyElem != NULL)
+      next = keyElem->next;
+      if (keyElem->source == source)
       {
-        if (keyElem->source == source)
-        {
-          if (keyElem->next != NULL)
-          {
-            // Move to the next already and then remove the element
-            keyElem = keyElem->next;
-            _ks_freeKS_Elem(storage, idx, keyElem->prev);  
-          }
-          else if (keyElem->prev != NULL)
-          {
-            // No next available, goto the previous and then remove it.
-            keyElem = keyElem->prev;
-            _ks_freeKS_Elem(storage, idx, keyElem->next);  
-          }
-          else
-          {
-            // It seams only this element is available, remove it
-            _ks_freeKS_Elem(storage, idx, keyElem);  
-            keyElem = NULL;
-          }
-        }
-        else
-        {
-          keyElem = keyElem->next;
-        }
+        _ks_freeKS_Elem(storage, idx, keyElem);  
       }
     }
   }
-  
+  pthread_rwlock_unlock(&storage->lock);
   
   return 0;
 }
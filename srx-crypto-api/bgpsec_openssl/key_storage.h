@@ -27,10 +27,18 @@
  * Known Issue:
  *   At this time only pem formated private keys can be loaded.
  * 
- * @version 0.3.0.0
+ * @version 0.4.0.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ *  0.4.0.0 - 2026/10/18
+ *            * Keys are indexed by a hash of ASN and SKI. The number of buckets
+ *              grows with the number of keys.
+ *            * Added a read write lock to the storage. Keys returned by
+ *              ks_getKey MUST be released using the new function 
+ *              ks_releaseKey.
+ *            * EC keys share a group with precomputed multiplication tables.
+ *            * The keys are of the type CB_Key provided by the crypto backend.
  *  0.3.0.0 - 2017/08/18 - oborchert
  *            * Added source to structure _KS_Key_Element
  *            * Added source parameter to ks_... functions.
@@ -52,9 +60,11 @@
 #ifndef KEY_STORAGE_H
 #define KEY_STORAGE_H
 
+#include <pthread.h>
 #include <sys/types.h>
 #include <openssl/ec.h>
 #include "../srx/srxcryptoapi.h"
+#include "crypto_backend.h"
 
 /** Used to prevent an overflow */
 #define MAX_KEY_USED 0xFFFF
@@ -88,9 +98,9 @@ typedef struct _KS_Key_Element
   BGPSecKey** derKey;
   /** Contains the OpenSSL Key if loaded into memory - each array element 
    * corresponds to the DER formated key. 
-   * IMPORTANT: All ec_keys are allocated using OpenSSL based malloc, 
-   * NOT malloc. To free them use ECKEY_free()*/
-  EC_KEY**    ec_key; 
+   * IMPORTANT: All ec_keys are allocated by the crypto backend, 
+   * NOT malloc. To free them use cb_freeKey()*/
+  CB_Key**    ec_key; 
   /** Number of times this key is used up to MAX_KEY_USED. */
   u_int16_t  timesUsed;
   /** Indicates how many different DER keys are stored. Normally 1 but > 1 in 
@@ -106,8 +116,16 @@ typedef struct
   bool isPrivate;
   /** The bucket head elements of the storage. */
   KS_Key_Element** head;  
+  /** The number of buckets, always a power of two. */
+  u_int32_t numBuckets;
   /** The number of keys stored in the storage. */
   u_int32_t size;
+  /** The curve of the keys including the precomputed multiplication tables, 
+   * shared by all EC keys of the storage. Can be NULL. */
+  EC_GROUP* group;
+  /** Readers hold the lock while using keys, writers while modifying the 
+   * storage. */
+  pthread_rwlock_t lock;
 } KeyStorage;
 
 /**
@@ -138,11 +156,23 @@ void ks_init(KeyStorage* storage, u_int8_t algoID, bool isPrivate);
  *        available at a higher position
  * 
  * @return the array of EC_Keys/BGPsecKeys(DER_Keys) or NULL of not found. If 
- *         NULL check status value.
+ *         NULL check status value. If keys are returned the storage stays 
+ *         read locked until ks_releaseKey is called.
  */
 void** ks_getKey(KeyStorage* storage, u_int8_t* ski, u_int32_t asn, 
                  u_int16_t* noKeys, KS_Key_Type kType, sca_status_t* status);
 
+/**
+ * Release the keys returned by ks_getKey. This function MUST be called exactly
+ * once for each call of ks_getKey that returned keys. The keys MUST NOT be
+ * used afterwards.
+ * 
+ * @param storage The storage the keys were retrieved from.
+ * 
+ * @since 0.4.0.0
+ */
+void ks_releaseKey(KeyStorage* storage);
+
 /**
  * Store the key in the given KeyStorage.
  * 
@@ -152,7 +182,8 @@ void** ks_getKey(KeyStorage* storage, u_int8_t* ski, u_int32_t asn,
  * @param key The BGPSecKey to be stored.
  * @param source The source of the key.
  * @param status an OUT value that provides more information.
- * @param convert if true then convert the DER key into the EC_KEY
+ * @param convert if true then convert the DER key into the EC_KEY. Keys that 
+ *                are not converted here are only available as DER keys.
  * 
  * @return API_SUCESS if it could be stored, otherwise API_FAILED. 
  */
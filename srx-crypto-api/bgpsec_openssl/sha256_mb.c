@@ -0,0 +1,407 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Multi buffer SHA256. See sha256_mb.h for details.
+ *
+ * @version 0.4.0.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ *  0.4.0.0 - 2026/10/18
+ *            * Created multi buffer SHA256
+ *            * Messages not hashed by the kernel use cb_sha256.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "crypto_backend.h"
+#include "sha256_mb.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define MB_AVX2_KERNEL
+#ifndef bit_SHA
+#define bit_SHA (1 << 29)
+#endif
+#endif
+
+/** The SHA256 block size */
+#define MB_BLOCK_SIZE     64
+/** Up to this number of messages the ordering is kept on the stack */
+#define MB_STACK_MESSAGES 256
+
+/** -1 = not determined, 0 = OpenSSL, 1 = AVX2 kernel */
+static int _mb_useKernel = -1;
+
+/**
+ * Determine which SHA256 implementation is used. This function is called by
+ * mb_sha256 if needed, it can be called during initialization to prevent the
+ * first call from doing so.
+ *
+ * @return true if the multi buffer kernel is used.
+ */
+bool mb_init()
+{
+  int use = 0;
+#ifdef MB_AVX2_KERNEL
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  bool         shaExt = false;
+
+  __builtin_cpu_init();
+  // OpenSSL uses the SHA extensions, they outperform the AVX2 kernel.
+  if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+  {
+    shaExt = (ebx & bit_SHA) != 0;
+  }
+  use = (__builtin_cpu_supports("avx2") && !shaExt) ? 1 : 0;
+#endif
+  __atomic_store_n(&_mb_useKernel, use, __ATOMIC_RELAXED);
+
+  return use == 1;
+}
+
+#ifdef MB_AVX2_KERNEL
+
+/** The SHA256 round constants */
+static const u_int32_t _mb_K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+  0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+  0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+  0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+  0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+  0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/** The SHA256 initial hash value */
+static const u_int32_t _mb_H0[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+/** A message and its position in the list of messages */
+typedef struct {
+  u_int32_t length;
+  int       idx;
+} MB_Message;
+
+/**
+ * Return the number of blocks of the padded message.
+ *
+ * @param length The length of the message
+ *
+ * @return The number of blocks.
+ */
+static u_int32_t _mb_numBlocks(u_int32_t length)
+{
+  // The padding adds 0x80 and the 64 bit length
+  return (u_int32_t)(((u_int64_t)length + 9 + MB_BLOCK_SIZE - 1)
+                     / MB_BLOCK_SIZE);
+}
+
+/**
+ * Return the given block of the padded message. Blocks that contain padding
+ * are assembled in the given buffer.
+ *
+ * @param message The message
+ * @param length The length of the message
+ * @param block The block number
+ * @param buff A buffer of MB_BLOCK_SIZE bytes
+ *
+ * @return The block.
+ */
+static const u_int8_t* _mb_getBlock(const u_int8_t* message, u_int32_t length,
+                                    u_int32_t block, u_int8_t* buff)
+{
+  u_int64_t offset = (u_int64_t)block * MB_BLOCK_SIZE;
+  u_int64_t bits   = (u_int64_t)length * 8;
+  int       idx    = 0;
+
+  if (offset + MB_BLOCK_SIZE <= length)
+  {
+    return message + offset;
+  }
+
+  memset(buff, 0, MB_BLOCK_SIZE);
+  if (offset <= length)
+  {
+    memcpy(buff, message + offset, length - offset);
+    buff[length - offset] = 0x80;
+  }
+  if (block == _mb_numBlocks(length) - 1)
+  {
+    for (idx = 0; idx < 8; idx++)
+    {
+      buff[MB_BLOCK_SIZE - 1 - idx] = (u_int8_t)(bits >> (8 * idx));
+    }
+  }
+
+  return buff;
+}
+
+/**
+ * Compare two messages by their length.
+ *
+ * @param a The first message
+ * @param b The second message
+ *
+ * @return <0, 0, >0
+ */
+static int _mb_compareLength(const void* a, const void* b)
+{
+  const MB_Message* msgA = (const MB_Message*)a;
+  const MB_Message* msgB = (const MB_Message*)b;
+
+  return (msgA->length > msgB->length) - (msgA->length < msgB->length);
+}
+
+/** Rotate each lane right */
+#define MB_ROTR(X, N) \
+  _mm256_or_si256(_mm256_srli_epi32((X), (N)), _mm256_slli_epi32((X), 32-(N)))
+/** Add each lane */
+#define MB_ADD(X, Y)  _mm256_add_epi32((X), (Y))
+/** Xor each lane */
+#define MB_XOR3(X, Y, Z) _mm256_xor_si256(_mm256_xor_si256((X), (Y)), (Z))
+/** Load the big endian word of the block */
+#define MB_LOAD(BLOCK, T) __builtin_bswap32(((const u_int32_t*)(BLOCK))[T])
+
+/**
+ * Hash up to MB_LANES messages in parallel.
+ *
+ * @param numLanes The number of messages
+ * @param messages The messages
+ * @param lengths The length of each message
+ * @param digests The digest buffer of each message
+ */
+__attribute__((target("avx2")))
+static void _mb_hashLanes(int numLanes, const u_int8_t** messages,
+                          const u_int32_t* lengths, u_int8_t** digests)
+{
+  __m256i         state[8];
+  __m256i         a, b, c, d, e, f, g, h;
+  __m256i         W[16];
+  __m256i         mask, T1, T2, s0, s1;
+  u_int32_t       numBlocks[MB_LANES];
+  u_int32_t       maxBlocks = 0;
+  u_int8_t        buff[MB_LANES][MB_BLOCK_SIZE];
+  u_int32_t       words[MB_LANES];
+  const u_int8_t* block[MB_LANES];
+  u_int32_t       out[8][MB_LANES] __attribute__((aligned(32)));
+  u_int32_t       blk  = 0;
+  int             lane = 0;
+  int             t    = 0;
+
+  for (t = 0; t < 8; t++)
+  {
+    state[t] = _mm256_set1_epi32(_mb_H0[t]);
+  }
+  for (lane = 0; lane < MB_LANES; lane++)
+  {
+    numBlocks[lane] = (lane < numLanes) ? _mb_numBlocks(lengths[lane]) : 0;
+    maxBlocks = (numBlocks[lane] > maxBlocks) ? numBlocks[lane] : maxBlocks;
+    // Idle lanes hash the empty buffer, the result is dropped.
+    memset(buff[lane], 0, MB_BLOCK_SIZE);
+    block[lane] = buff[lane];
+  }
+
+  for (blk = 0; blk < maxBlocks; blk++)
+  {
+    for (lane = 0; lane < MB_LANES; lane++)
+    {
+      words[lane] = (blk < numBlocks[lane]) ? 0xFFFFFFFF : 0;
+      if (blk < numBlocks[lane])
+      {
+        block[lane] = _mb_getBlock(messages[lane], lengths[lane], blk,
+                                   buff[lane]);
+      }
+    }
+    mask = _mm256_loadu_si256((const __m256i*)words);
+
+    for (t = 0; t < 16; t++)
+    {
+      W[t] = _mm256_set_epi32(MB_LOAD(block[7], t), MB_LOAD(block[6], t),
+                              MB_LOAD(block[5], t), MB_LOAD(block[4], t),
+                              MB_LOAD(block[3], t), MB_LOAD(block[2], t),
+                              MB_LOAD(block[1], t), MB_LOAD(block[0], t));
+    }
+
+    a = state[0]; b = state[1]; c = state[2]; d = state[3];
+    e = state[4]; f = state[5]; g = state[6]; h = state[7];
+
+    for (t = 0; t < 64; t++)
+    {
+      if (t >= 16)
+      {
+        s0 = MB_XOR3(MB_ROTR(W[(t-15) & 15], 7), MB_ROTR(W[(t-15) & 15], 18),
+                     _mm256_srli_epi32(W[(t-15) & 15], 3));
+        s1 = MB_XOR3(MB_ROTR(W[(t-2) & 15], 17), MB_ROTR(W[(t-2) & 15], 19),
+                     _mm256_srli_epi32(W[(t-2) & 15], 10));
+        W[t & 15] = MB_ADD(MB_ADD(W[t & 15], s0), MB_ADD(W[(t-7) & 15], s1));
+      }
+      // T1 = h + S1(e) + Ch(e,f,g) + K[t] + W[t]
+      T1 = MB_ADD(h, MB_XOR3(MB_ROTR(e, 6), MB_ROTR(e, 11), MB_ROTR(e, 25)));
+      T1 = MB_ADD(T1, _mm256_xor_si256(_mm256_and_si256(e, f),
+                                       _mm256_andnot_si256(e, g)));
+      T1 = MB_ADD(T1, MB_ADD(_mm256_set1_epi32(_mb_K[t]), W[t & 15]));
+      // T2 = S0(a) + Maj(a,b,c)
+      T2 = MB_ADD(MB_XOR3(MB_ROTR(a, 2), MB_ROTR(a, 13), MB_ROTR(a, 22)),
+                  MB_XOR3(_mm256_and_si256(a, b), _mm256_and_si256(a, c),
+                          _mm256_and_si256(b, c)));
+      h = g; g = f; f = e;
+      e = MB_ADD(d, T1);
+      d = c; c = b; b = a;
+      a = MB_ADD(T1, T2);
+    }
+
+    // Only lanes that processed a block of their message are updated.
+    state[0] = _mm256_blendv_epi8(state[0], MB_ADD(state[0], a), mask);
+    state[1] = _mm256_blendv_epi8(state[1], MB_ADD(state[1], b), mask);
+    state[2] = _mm256_blendv_epi8(state[2], MB_ADD(state[2], c), mask);
+    state[3] = _mm256_blendv_epi8(state[3], MB_ADD(state[3], d), mask);
+    state[4] = _mm256_blendv_epi8(state[4], MB_ADD(state[4], e), mask);
+    state[5] = _mm256_blendv_epi8(state[5], MB_ADD(state[5], f), mask);
+    state[6] = _mm256_blendv_epi8(state[6], MB_ADD(state[6], g), mask);
+    state[7] = _mm256_blendv_epi8(state[7], MB_ADD(state[7], h), mask);
+  }
+
+  for (t = 0; t < 8; t++)
+  {
+    _mm256_store_si256((__m256i*)out[t], state[t]);
+  }
+  for (lane = 0; lane < numLanes; lane++)
+  {
+    for (t = 0; t < 8; t++)
+    {
+      u_int32_t word = __builtin_bswap32(out[t][lane]);
+      memcpy(digests[lane] + (t * 4), &word, sizeof(u_int32_t));
+    }
+  }
+}
+
+/**
+ * Hash the messages using the AVX2 kernel. The messages are ordered by their
+ * length, groups of fewer than MB_MIN_MESSAGES messages are hashed using
+ * OpenSSL.
+ *
+ * @param count The number of messages.
+ * @param messages The messages.
+ * @param lengths The length of each message.
+ * @param digests The digest buffer.
+ */
+static void _mb_sha256Kernel(int count, const u_int8_t** messages,
+                             const u_int32_t* lengths, u_int8_t* digests)
+{
+  MB_Message      stackOrder[MB_STACK_MESSAGES];
+  MB_Message*     order = stackOrder;
+  const u_int8_t* laneMsg[MB_LANES];
+  u_int32_t       laneLen[MB_LANES];
+  u_int8_t*       laneDigest[MB_LANES];
+  int             pos   = 0;
+  int             lanes = 0;
+  int             lane  = 0;
+
+  if (count > MB_STACK_MESSAGES)
+  {
+    order = malloc(count * sizeof(MB_Message));
+    if (order == NULL)
+    {
+      for (pos = 0; pos < count; pos++)
+      {
+        cb_sha256(messages[pos], lengths[pos], digests + (pos * MB_DIGEST_LENGTH));
+      }
+      return;
+    }
+  }
+  for (pos = 0; pos < count; pos++)
+  {
+    order[pos].length = lengths[pos];
+    order[pos].idx    = pos;
+  }
+  qsort(order, count, sizeof(MB_Message), _mb_compareLength);
+
+  for (pos = 0; pos < count; pos += lanes)
+  {
+    lanes = ((count - pos) < MB_LANES) ? (count - pos) : MB_LANES;
+    for (lane = 0; lane < lanes; lane++)
+    {
+      laneMsg[lane]    = messages[order[pos + lane].idx];
+      laneLen[lane]    = lengths[order[pos + lane].idx];
+      laneDigest[lane] = digests + (order[pos + lane].idx * MB_DIGEST_LENGTH);
+    }
+    if (lanes >= MB_MIN_MESSAGES)
+    {
+      _mb_hashLanes(lanes, laneMsg, laneLen, laneDigest);
+    }
+    else
+    {
+      for (lane = 0; lane < lanes; lane++)
+      {
+        cb_sha256(laneMsg[lane], laneLen[lane], laneDigest[lane]);
+      }
+    }
+  }
+
+  if (order != stackOrder)
+  {
+    free(order);
+  }
+}
+
+#endif // MB_AVX2_KERNEL
+
+/**
+ * Generate the SHA256 digest of each given message.
+ *
+ * @param count The number of messages.
+ * @param messages The messages.
+ * @param lengths The length of each message.
+ * @param digests The array of count * MB_DIGEST_LENGTH bytes that receives
+ *                the digests in the order of the messages.
+ */
+void mb_sha256(int count, const u_int8_t** messages, const u_int32_t* lengths,
+               u_int8_t* digests)
+{
+  int use = __atomic_load_n(&_mb_useKernel, __ATOMIC_RELAXED);
+  int idx = 0;
+
+  if (use < 0)
+  {
+    use = mb_init() ? 1 : 0;
+  }
+
+#ifdef MB_AVX2_KERNEL
+  if ((use == 1) && (count >= MB_MIN_MESSAGES))
+  {
+    _mb_sha256Kernel(count, messages, lengths, digests);
+    return;
+  }
+#endif
+
+  for (; idx < count; idx++)
+  {
+    cb_sha256(messages[idx], lengths[idx], digests + (idx * MB_DIGEST_LENGTH));
+  }
+}
@@ -0,0 +1,73 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Multi buffer SHA256. The digests of multiple messages are generated
+ * together, MB_LANES messages at a time, using the AVX2 instruction set. The
+ * messages are ordered by their length before they are assigned to the lanes
+ * to keep the number of idle lanes low.
+ *
+ * The AVX2 kernel is only used if the CPU supports AVX2 but not the SHA
+ * extensions. Otherwise, or if only a few messages are given, each message is
+ * hashed using OpenSSL.
+ *
+ * @version 0.4.0.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ *  0.4.0.0 - 2026/10/18
+ *            * Created multi buffer SHA256
+ */
+#ifndef SHA256_MB_H
+#define SHA256_MB_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+/** The number of messages hashed in parallel */
+#define MB_LANES          8
+/** The minimum number of messages to use the multi buffer kernel */
+#define MB_MIN_MESSAGES   4
+/** The length of the SHA256 message digest */
+#define MB_DIGEST_LENGTH  32
+
+/**
+ * Determine which SHA256 implementation is used. This function is called by
+ * mb_sha256 if needed, it can be called during initialization to prevent the
+ * first call from doing so.
+ *
+ * @return true if the multi buffer kernel is used.
+ */
+bool mb_init();
+
+/**
+ * Generate the SHA256 digest of each given message.
+ *
+ * @param count The number of messages.
+ * @param messages The messages.
+ * @param lengths The length of each message.
+ * @param digests The array of count * MB_DIGEST_LENGTH bytes that receives
+ *                the digests in the order of the messages.
+ */
+void mb_sha256(int count, const u_int8_t** messages, const u_int32_t* lengths,
+               u_int8_t* digests);
+
+#endif /* SHA256_MB_H */
@@ -0,0 +1,266 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * This files is used for testing the multi buffer SHA256. The digests of each
+ * implementation are compared with the digests generated by OpenSSL. The
+ * implementation is included to select it regardless of the CPU features,
+ * the AVX2 kernel is only tested if the CPU supports AVX2. The program is
+ * built with "make check".
+ *
+ * @version 0.4.0.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ *  0.4.0.0 - 2026/10/18
+ *            * File created
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/sha.h>
+#include "sha256_mb.c"
+
+/** The number of messages of the largest test */
+#define MAX_MESSAGES   300
+/** The length of the longest message */
+#define MAX_LENGTH     1000
+
+/** Lengths around the padding and block boundaries and multi block ones */
+static const u_int32_t LENGTHS[] = { 0, 55, 56, 64, 119, 1, 120, 128, 200,
+                                     MAX_LENGTH };
+#define NUM_LENGTHS    (sizeof(LENGTHS) / sizeof(u_int32_t))
+
+/** The messages, each filled with its own pattern */
+static u_int8_t        _data[MAX_MESSAGES][MAX_LENGTH];
+static const u_int8_t* _messages[MAX_MESSAGES];
+static u_int32_t       _lengths[MAX_MESSAGES];
+static u_int8_t        _digests[MAX_MESSAGES * MB_DIGEST_LENGTH];
+
+/**
+ * Replaces the function of the SRxCryptoAPI, the test does not log.
+ */
+void sca_debugLog(int level, const char *format, ...)
+{
+}
+
+/**
+ * check the value against expected, if not match then exit.
+ *
+ * @param val the value to be checked
+ * @param expected the value to be checked against (expected value)
+ * @param error the error string in case of exit
+ */
+static void assert_int(int val, int expected, char* error)
+{
+  if (val != expected)
+  {
+    printf ("Error: %s; Expected %i but received %i\n", error, expected, val);
+    exit (EXIT_FAILURE);
+  }
+}
+
+/**
+ * Set the lengths of the messages, the given lengths are repeated.
+ *
+ * @param count The number of messages.
+ * @param lengths The lengths to be used.
+ * @param numLengths The number of lengths.
+ */
+static void _setLengths(int count, const u_int32_t* lengths, int numLengths)
+{
+  int idx;
+
+  for (idx = 0; idx < count; idx++)
+  {
+    _lengths[idx] = lengths[idx % numLengths];
+  }
+  memset(_digests, 0, sizeof(_digests));
+}
+
+/**
+ * Compare the digest of each message with the one generated by OpenSSL.
+ *
+ * @param count The number of messages.
+ * @param error The error string in case of a mismatch.
+ */
+static void _checkDigests(int count, char* error)
+{
+  u_int8_t digest[SHA256_DIGEST_LENGTH];
+  int      idx;
+
+  for (idx = 0; idx < count; idx++)
+  {
+    SHA256(_messages[idx], _lengths[idx], digest);
+    if (memcmp(digest, _digests + (idx * MB_DIGEST_LENGTH),
+               MB_DIGEST_LENGTH) != 0)
+    {
+      printf ("Error: %s; Digest of message %i (%u bytes) differs\n", error,
+              idx, _lengths[idx]);
+      exit (EXIT_FAILURE);
+    }
+  }
+}
+
+/**
+ * Fill the messages.
+ *
+ * @return true if the AVX2 kernel can be tested.
+ */
+static bool _initialize()
+{
+  bool useKernel = false;
+  int  idx, pos;
+
+  printf ("Initialize experiment\n");
+  for (idx = 0; idx < MAX_MESSAGES; idx++)
+  {
+    for (pos = 0; pos < MAX_LENGTH; pos++)
+    {
+      _data[idx][pos] = (u_int8_t)(idx * 31 + pos);
+    }
+    _messages[idx] = _data[idx];
+  }
+  printf ("         %s is used by default.\n",
+          mb_init() ? "The AVX2 kernel" : "OpenSSL");
+#ifdef MB_AVX2_KERNEL
+  useKernel = __builtin_cpu_supports("avx2");
+#endif
+  printf ("         passed.\n");
+
+  return useKernel;
+}
+
+#ifdef MB_AVX2_KERNEL
+/**
+ * Hash full lane sets with the AVX2 kernel.
+ */
+static void _test1()
+{
+  int idx;
+
+  printf ("Test #1: Hash all lanes using the AVX2 kernel!\n");
+
+  // One message per length in each lane set, they are ordered by length.
+  _setLengths(MB_LANES, LENGTHS, NUM_LENGTHS);
+  _mb_sha256Kernel(MB_LANES, _messages, _lengths, _digests);
+  _checkDigests(MB_LANES, "Full lane set");
+
+  for (idx = 0; idx < NUM_LENGTHS; idx++)
+  {
+    _setLengths(MB_LANES, LENGTHS + idx, 1);
+    _mb_sha256Kernel(MB_LANES, _messages, _lengths, _digests);
+    _checkDigests(MB_LANES, "Lane set of equal length");
+  }
+
+  // More messages than kept on the stack
+  _setLengths(MAX_MESSAGES, LENGTHS, NUM_LENGTHS);
+  _mb_sha256Kernel(MAX_MESSAGES, _messages, _lengths, _digests);
+  _checkDigests(MAX_MESSAGES, "Many lane sets");
+  printf ("         passed.\n");
+}
+
+/**
+ * Hash partially filled lane sets with the AVX2 kernel.
+ */
+static void _test2()
+{
+  u_int8_t* laneDigest[MB_LANES];
+  int       lanes, idx;
+
+  printf ("Test #2: Hash partially filled lanes using the AVX2 kernel!\n");
+
+  for (lanes = 1; lanes < MB_LANES; lanes++)
+  {
+    _setLengths(lanes, LENGTHS + (NUM_LENGTHS - lanes), lanes);
+    for (idx = 0; idx < lanes; idx++)
+    {
+      laneDigest[idx] = _digests + (idx * MB_DIGEST_LENGTH);
+    }
+    _mb_hashLanes(lanes, _messages, _lengths, laneDigest);
+    _checkDigests(lanes, "Partial lane set");
+  }
+
+  // The last lane set is partially filled or hashed using OpenSSL
+  for (lanes = MB_LANES + 1; lanes < (2 * MB_LANES); lanes++)
+  {
+    _setLengths(lanes, LENGTHS, NUM_LENGTHS);
+    _mb_sha256Kernel(lanes, _messages, _lengths, _digests);
+    _checkDigests(lanes, "Partial last lane set");
+  }
+  printf ("         passed.\n");
+}
+#endif // MB_AVX2_KERNEL
+
+/**
+ * Hash the messages using OpenSSL, either because it is selected or because
+ * there are too few messages for the AVX2 kernel.
+ */
+static void _test3()
+{
+  int count;
+
+  printf ("Test #3: Hash the messages without the AVX2 kernel!\n");
+
+  __atomic_store_n(&_mb_useKernel, 0, __ATOMIC_RELAXED);
+  _setLengths(MAX_MESSAGES, LENGTHS, NUM_LENGTHS);
+  mb_sha256(MAX_MESSAGES, _messages, _lengths, _digests);
+  _checkDigests(MAX_MESSAGES, "Scalar implementation");
+
+  __atomic_store_n(&_mb_useKernel, 1, __ATOMIC_RELAXED);
+  for (count = 1; count < MB_MIN_MESSAGES; count++)
+  {
+    _setLengths(count, LENGTHS, NUM_LENGTHS);
+    mb_sha256(count, _messages, _lengths, _digests);
+    _checkDigests(count, "Too few messages for the kernel");
+  }
+  mb_init();
+  printf ("         passed.\n");
+}
+
+/**
+ * This is the main function
+ */
+int main(int argc, char** argv)
+{
+  bool useKernel = _initialize();
+
+#ifdef MB_AVX2_KERNEL
+  if (useKernel)
+  {
+    printf("\nRun test #1 for full lane sets\n");
+    _test1();
+
+    printf("\nRun test #2 for partially filled lane sets\n");
+    _test2();
+  }
+  else
+#endif
+  {
+    printf("\nSkip test #1 and #2, the CPU does not support AVX2\n");
+  }
+
+  printf("\nRun test #3 for the implementation without the AVX2 kernel\n");
+  _test3();
+
+  printf ("End of all tests!\n");
+  return (EXIT_SUCCESS);
+}
@@ -0,0 +1,263 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * This files is used for testing the verify cache, mainly that no signature
+ * segment of a removed key is stored or found after vc_removeKey. The program
+ * is built with "make check".
+ *
+ * @version 0.4.0.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ *  0.4.0.0 - 2026/10/18
+ *            * File created
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include "../srx/srxcryptoapi.h"
+#include "verify_cache.h"
+
+#define SIG_LENGTH  72
+#define KEY_A_ASN   65001
+#define KEY_B_ASN   65002
+
+/**
+ * Replaces the function of the SRxCryptoAPI, the test does not log.
+ */
+void sca_debugLog(int level, const char *format, ...)
+{
+}
+
+/**
+ * check the value against expected, if not match then exit.
+ *
+ * @param val the value to be checked
+ * @param expected the value to be checked against (expected value)
+ * @param error the error string in case of exit
+ */
+static void assert_int(int val, int expected, char* error)
+{
+  if (val != expected)
+  {
+    printf ("Error: %s; Expected %i but received %i\n", error, expected, val);
+    exit (EXIT_FAILURE);
+  }
+}
+
+/**
+ * A signature segment, the SKI, the digest and the signature are filled with
+ * the given seed.
+ */
+typedef struct
+{
+  u_int8_t  ski[SKI_LENGTH];
+  u_int32_t asn;
+  u_int8_t  digest[VC_DIGEST_LENGTH];
+  u_int8_t  signature[SIG_LENGTH];
+} TestSegment;
+
+/**
+ * Fill the given segment.
+ *
+ * @param segment The segment to be filled.
+ * @param key The first byte of the SKI, segments with the same key and ASN
+ *            are signed by the same key.
+ * @param asn The ASN of the signer in host format.
+ * @param seed The value the digest and signature are filled with.
+ *
+ * @return the segment.
+ */
+static TestSegment* _setSegment(TestSegment* segment, u_int8_t key,
+                                u_int32_t asn, u_int8_t seed)
+{
+  int idx;
+
+  memset(segment->ski, 0xAB, SKI_LENGTH);
+  segment->ski[0] = key;
+  segment->asn    = htonl(asn);
+  for (idx = 0; idx < VC_DIGEST_LENGTH; idx++)
+  {
+    segment->digest[idx] = seed + idx;
+  }
+  for (idx = 0; idx < SIG_LENGTH; idx++)
+  {
+    segment->signature[idx] = seed * 3 + idx;
+  }
+  return segment;
+}
+
+/**
+ * Return if the segment is found in the cache.
+ *
+ * @param cache The cache.
+ * @param segment The segment.
+ *
+ * @return true if the segment is cached.
+ */
+static bool _lookup(VerifyCache* cache, TestSegment* segment)
+{
+  return vc_lookup(cache, segment->ski, segment->asn, segment->digest,
+                   segment->signature, SIG_LENGTH);
+}
+
+/**
+ * Store the segment in the cache.
+ *
+ * @param cache The cache.
+ * @param segment The segment.
+ * @param generation The generation retrieved before the key.
+ */
+static void _store(VerifyCache* cache, TestSegment* segment,
+                   u_int32_t generation)
+{
+  vc_store(cache, segment->ski, segment->asn, segment->digest,
+           segment->signature, SIG_LENGTH, generation);
+}
+
+/**
+ * Initialize the cache.
+ *
+ * @param cache The cache.
+ */
+static void _initialize(VerifyCache* cache)
+{
+  printf ("Initialize experiment\n");
+  assert_int(vc_init(cache), true, "Initialize cache");
+  printf ("         passed.\n");
+}
+
+/**
+ * Store segments of two keys, removing one key removes only its segments.
+ *
+ * @param cache The cache.
+ */
+static void _test1(VerifyCache* cache)
+{
+  TestSegment a1, a2, b1;
+  u_int32_t   generation;
+
+  printf ("Test #1: Remove the segments of one key!\n");
+
+  _setSegment(&a1, 1, KEY_A_ASN, 1);
+  _setSegment(&a2, 1, KEY_A_ASN, 2);
+  _setSegment(&b1, 2, KEY_B_ASN, 1);
+
+  assert_int(_lookup(cache, &a1), false, "Lookup before store");
+  generation = vc_getGeneration(cache);
+  _store(cache, &a1, generation);
+  _store(cache, &a2, generation);
+  _store(cache, &b1, generation);
+  assert_int(_lookup(cache, &a1), true, "Lookup key A segment 1");
+  assert_int(_lookup(cache, &a2), true, "Lookup key A segment 2");
+  assert_int(_lookup(cache, &b1), true, "Lookup key B segment 1");
+
+  vc_removeKey(cache, a1.ski, a1.asn);
+  assert_int(vc_getGeneration(cache), generation + 1, "Generation");
+  assert_int(_lookup(cache, &a1), false, "Lookup removed segment 1");
+  assert_int(_lookup(cache, &a2), false, "Lookup removed segment 2");
+  assert_int(_lookup(cache, &b1), true, "Lookup segment of other key");
+  printf ("         passed.\n");
+}
+
+/**
+ * A segment verified with a key retrieved before the key was removed is not
+ * stored, a segment verified after the removal is stored.
+ *
+ * @param cache The cache.
+ */
+static void _test2(VerifyCache* cache)
+{
+  TestSegment a3, b2;
+  u_int32_t   generation;
+
+  printf ("Test #2: Skip segments verified before the key was removed!\n");
+
+  _setSegment(&a3, 1, KEY_A_ASN, 3);
+  _setSegment(&b2, 2, KEY_B_ASN, 2);
+
+  // The verification retrieves the generation and the key ...
+  generation = vc_getGeneration(cache);
+  // ... while the key gets removed
+  vc_removeKey(cache, a3.ski, a3.asn);
+  _store(cache, &a3, generation);
+  assert_int(_lookup(cache, &a3), false, "Lookup segment of removed key");
+  // The removal of any key invalidates the generation
+  _store(cache, &b2, generation);
+  assert_int(_lookup(cache, &b2), false, "Lookup segment of other key");
+
+  // A verification that started after the removal
+  generation = vc_getGeneration(cache);
+  _store(cache, &a3, generation);
+  _store(cache, &b2, generation);
+  assert_int(_lookup(cache, &a3), true, "Lookup segment of registered key");
+  assert_int(_lookup(cache, &b2), true, "Lookup segment after removal");
+  printf ("         passed.\n");
+}
+
+/**
+ * Emptying the cache removes all segments and invalidates the generation.
+ *
+ * @param cache The cache.
+ */
+static void _test3(VerifyCache* cache)
+{
+  TestSegment a4, b2;
+  u_int32_t   generation;
+
+  printf ("Test #3: Empty the cache!\n");
+
+  _setSegment(&a4, 1, KEY_A_ASN, 4);
+  _setSegment(&b2, 2, KEY_B_ASN, 2);
+
+  generation = vc_getGeneration(cache);
+  vc_empty(cache);
+  assert_int(_lookup(cache, &b2), false, "Lookup after empty");
+  _store(cache, &a4, generation);
+  assert_int(_lookup(cache, &a4), false, "Lookup segment stored after empty");
+  printf ("         passed.\n");
+}
+
+/**
+ * This is the main function
+ */
+int main(int argc, char** argv)
+{
+  VerifyCache cache;
+
+  _initialize(&cache);
+
+  printf("\nRun test #1 for the removal of a key\n");
+  _test1(&cache);
+
+  printf("\nRun test #2 for the generation after the removal of a key\n");
+  _test2(&cache);
+
+  printf("\nRun test #3 for emptying the cache\n");
+  _test3(&cache);
+
+  vc_release(&cache);
+
+  printf ("End of all tests!\n");
+  return (EXIT_SUCCESS);
+}
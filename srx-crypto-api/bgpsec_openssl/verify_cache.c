@@ -0,0 +1,324 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Cache of verified signature segments. See verify_cache.h for details.
+ *
+ * @version 0.4.0.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ *  0.4.0.0 - 2026/10/18
+ *            * Created verify cache
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include "../srx/srxcryptoapi.h"
+#include "verify_cache.h"
+
+/**
+ * Return the set of the given signature segment. The digest is the output of
+ * SHA256 and the signature is random as well, a few bytes of each suffice.
+ *
+ * @param digest The message digest (VC_DIGEST_LENGTH)
+ * @param signature The signature
+ * @param sigLength The length of the signature
+ *
+ * @return The set index
+ */
+static u_int32_t _vc_getSet(u_int8_t* digest, u_int8_t* signature,
+                            u_int16_t sigLength)
+{
+  u_int32_t hash = 0;
+
+  memcpy(&hash, digest, sizeof(u_int32_t));
+  if (sigLength >= sizeof(u_int32_t))
+  {
+    u_int32_t sigPart = 0;
+    memcpy(&sigPart, signature + sigLength - sizeof(u_int32_t),
+           sizeof(u_int32_t));
+    hash ^= sigPart;
+  }
+
+  return hash & (VC_NUM_SETS - 1);
+}
+
+/**
+ * Return the lock that protects the given set.
+ *
+ * @param cache The cache
+ * @param set The set index
+ *
+ * @return The lock
+ */
+static pthread_mutex_t* _vc_getLock(VerifyCache* cache, u_int32_t set)
+{
+  return &cache->locks[set & (VC_NUM_LOCKS - 1)];
+}
+
+/**
+ * Compare the entry with the given signature segment.
+ *
+ * @return true if the entry represents the signature segment.
+ */
+static bool _vc_matches(VC_Entry* entry, u_int8_t* ski, u_int32_t asn,
+                        u_int8_t* digest, u_int8_t* signature,
+                        u_int16_t sigLength)
+{
+  return    entry->used
+         && (entry->asn == asn)
+         && (entry->sigLength == sigLength)
+         && (memcmp(entry->digest, digest, VC_DIGEST_LENGTH) == 0)
+         && (memcmp(entry->ski, ski, SKI_LENGTH) == 0)
+         && (memcmp(entry->signature, signature, sigLength) == 0);
+}
+
+/**
+ * Initialize the verify cache.
+ *
+ * @param cache The cache to be initialized.
+ *
+ * @return true if the cache could be initialized.
+ */
+bool vc_init(VerifyCache* cache)
+{
+  int idx;
+
+  memset(cache, 0, sizeof(VerifyCache));
+  cache->entries = calloc(VC_NUM_SETS * VC_WAYS, sizeof(VC_Entry));
+  cache->victim  = calloc(VC_NUM_SETS, sizeof(u_int8_t));
+  if ((cache->entries == NULL) || (cache->victim == NULL))
+  {
+    free(cache->entries);
+    free(cache->victim);
+    cache->entries = NULL;
+    cache->victim  = NULL;
+    sca_debugLog(LOG_ERR, "Not enough memory for the verify cache!\n");
+    return false;
+  }
+
+  for (idx = 0; idx < VC_NUM_LOCKS; idx++)
+  {
+    pthread_mutex_init(&cache->locks[idx], NULL);
+  }
+
+  return true;
+}
+
+/**
+ * Remove all entries and free the allocated memory.
+ *
+ * @param cache The cache to be released.
+ */
+void vc_release(VerifyCache* cache)
+{
+  int idx;
+
+  if ((cache != NULL) && (cache->entries != NULL))
+  {
+    sca_debugLog(LOG_DEBUG, "Verify cache: %llu hits, %llu misses\n",
+                 (unsigned long long)cache->hits,
+                 (unsigned long long)cache->misses);
+    for (idx = 0; idx < VC_NUM_LOCKS; idx++)
+    {
+      pthread_mutex_destroy(&cache->locks[idx]);
+    }
+    free(cache->entries);
+    free(cache->victim);
+    cache->entries = NULL;
+    cache->victim  = NULL;
+  }
+}
+
+/**
+ * Return the current generation of the cache. This value must be retrieved
+ * BEFORE the key used for the verification is retrieved from the key storage
+ * and passed to vc_store.
+ *
+ * @param cache The cache.
+ *
+ * @return The current generation.
+ */
+u_int32_t vc_getGeneration(VerifyCache* cache)
+{
+  return __atomic_load_n(&cache->generation, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Determine if the signature segment was verified already.
+ *
+ * @param cache The cache.
+ * @param ski The SKI of the signer (SKI_LENGTH).
+ * @param asn The ASN of the signer in network format.
+ * @param digest The message digest (VC_DIGEST_LENGTH).
+ * @param signature The signature.
+ * @param sigLength The length of the signature.
+ *
+ * @return true if the signature segment is known to be valid.
+ */
+bool vc_lookup(VerifyCache* cache, u_int8_t* ski, u_int32_t asn,
+               u_int8_t* digest, u_int8_t* signature, u_int16_t sigLength)
+{
+  bool      found = false;
+  u_int32_t set   = 0;
+  VC_Entry* entry = NULL;
+  int       idx;
+
+  if (sigLength <= VC_MAX_SIG_LENGTH)
+  {
+    set   = _vc_getSet(digest, signature, sigLength);
+    entry = &cache->entries[set * VC_WAYS];
+
+    pthread_mutex_lock(_vc_getLock(cache, set));
+    for (idx = 0; (idx < VC_WAYS) && !found; idx++, entry++)
+    {
+      found = _vc_matches(entry, ski, asn, digest, signature, sigLength);
+    }
+    pthread_mutex_unlock(_vc_getLock(cache, set));
+  }
+
+  __atomic_add_fetch(found ? &cache->hits : &cache->misses, 1,
+                     __ATOMIC_RELAXED);
+
+  return found;
+}
+
+/**
+ * Store a verified signature segment. The entry is not stored if keys were
+ * removed since the given generation was retrieved.
+ *
+ * @param cache The cache.
+ * @param ski The SKI of the signer (SKI_LENGTH).
+ * @param asn The ASN of the signer in network format.
+ * @param digest The message digest (VC_DIGEST_LENGTH).
+ * @param signature The signature.
+ * @param sigLength The length of the signature.
+ * @param generation The generation retrieved before the key was retrieved.
+ */
+void vc_store(VerifyCache* cache, u_int8_t* ski, u_int32_t asn,
+              u_int8_t* digest, u_int8_t* signature, u_int16_t sigLength,
+              u_int32_t generation)
+{
+  u_int32_t set   = 0;
+  VC_Entry* entry = NULL;
+  VC_Entry* slot  = NULL;
+  int       idx;
+
+  if (sigLength > VC_MAX_SIG_LENGTH)
+  {
+    return;
+  }
+
+  set   = _vc_getSet(digest, signature, sigLength);
+  entry = &cache->entries[set * VC_WAYS];
+
+  pthread_mutex_lock(_vc_getLock(cache, set));
+  // The generation is incremented before keys are removed from the cache,
+  // checking it under the lock of the set prevents storing an entry for a
+  // key that is removed already.
+  if (__atomic_load_n(&cache->generation, __ATOMIC_ACQUIRE) == generation)
+  {
+    for (idx = 0; idx < VC_WAYS; idx++)
+    {
+      if (_vc_matches(&entry[idx], ski, asn, digest, signature, sigLength))
+      {
+        // Another thread stored it already
+        slot = NULL;
+        break;
+      }
+      if ((slot == NULL) && !entry[idx].used)
+      {
+        slot = &entry[idx];
+      }
+    }
+    if ((idx == VC_WAYS) && (slot == NULL))
+    {
+      // Replace the oldest entry of the set
+      slot = &entry[cache->victim[set]];
+      cache->victim[set] = (cache->victim[set] + 1) % VC_WAYS;
+    }
+    if (slot != NULL)
+    {
+      slot->used      = true;
+      slot->asn       = asn;
+      slot->sigLength = sigLength;
+      memcpy(slot->ski, ski, SKI_LENGTH);
+      memcpy(slot->digest, digest, VC_DIGEST_LENGTH);
+      memcpy(slot->signature, signature, sigLength);
+    }
+  }
+  pthread_mutex_unlock(_vc_getLock(cache, set));
+}
+
+/**
+ * Remove all entries verified with the key of the given SKI and ASN.
+ *
+ * @param cache The cache.
+ * @param ski The SKI of the key (SKI_LENGTH).
+ * @param asn The ASN of the key in network format.
+ */
+void vc_removeKey(VerifyCache* cache, u_int8_t* ski, u_int32_t asn)
+{
+  u_int32_t set;
+  VC_Entry* entry = NULL;
+  int       idx;
+
+  __atomic_add_fetch(&cache->generation, 1, __ATOMIC_ACQ_REL);
+
+  for (set = 0; set < VC_NUM_SETS; set++)
+  {
+    entry = &cache->entries[set * VC_WAYS];
+    pthread_mutex_lock(_vc_getLock(cache, set));
+    for (idx = 0; idx < VC_WAYS; idx++, entry++)
+    {
+      if (entry->used && (entry->asn == asn)
+          && (memcmp(entry->ski, ski, SKI_LENGTH) == 0))
+      {
+        entry->used = false;
+      }
+    }
+    pthread_mutex_unlock(_vc_getLock(cache, set));
+  }
+}
+
+/**
+ * Remove all entries.
+ *
+ * @param cache The cache.
+ */
+void vc_empty(VerifyCache* cache)
+{
+  u_int32_t set;
+  int       idx;
+
+  __atomic_add_fetch(&cache->generation, 1, __ATOMIC_ACQ_REL);
+
+  for (set = 0; set < VC_NUM_SETS; set++)
+  {
+    pthread_mutex_lock(_vc_getLock(cache, set));
+    for (idx = 0; idx < VC_WAYS; idx++)
+    {
+      cache->entries[set * VC_WAYS + idx].used = false;
+    }
+    pthread_mutex_unlock(_vc_getLock(cache, set));
+  }
+}
@@ -0,0 +1,171 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Cache of verified signature segments. A signature segment that was once
+ * verified with a registered key does not need to be verified again as long
+ * as the key stays registered. The cache is keyed by the SKI and ASN of the
+ * signer, the message digest and the signature bytes. It has a fixed size,
+ * each entry can only be stored in one of VC_WAYS slots of its set. If the set
+ * is full the oldest stored entry is replaced.
+ *
+ * The cache can be used by multiple threads. Each set is protected by one of
+ * VC_NUM_LOCKS locks.
+ *
+ * @version 0.4.0.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ *  0.4.0.0 - 2026/10/18
+ *            * Created verify cache
+ */
+#ifndef VERIFY_CACHE_H
+#define VERIFY_CACHE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include "../srx/srxcryptoapi.h"
+
+/** The number of sets (2^n) */
+#define VC_NUM_SETS       4096
+/** The number of entries per set */
+#define VC_WAYS           8
+/** The number of locks (2^n), each lock protects VC_NUM_SETS/VC_NUM_LOCKS
+ * sets */
+#define VC_NUM_LOCKS      64
+/** The length of the SHA256 message digest */
+#define VC_DIGEST_LENGTH  32
+/** The maximum length of a signature that will be cached. A DER encoded 
+ * ECDSA P-256 signature has at most 72 bytes. */
+#define VC_MAX_SIG_LENGTH 80
+
+/**
+ * A verified signature segment.
+ */
+typedef struct
+{
+  /** Indicates if the entry is used. */
+  bool      used;
+  /** The ASN of the signer in network format. */
+  u_int32_t asn;
+  /** The SKI of the signer key. */
+  u_int8_t  ski[SKI_LENGTH];
+  /** The message digest the signature was verified for. */
+  u_int8_t  digest[VC_DIGEST_LENGTH];
+  /** The length of the signature. */
+  u_int16_t sigLength;
+  /** The signature. */
+  u_int8_t  signature[VC_MAX_SIG_LENGTH];
+} VC_Entry;
+
+typedef struct
+{
+  /** All entries, VC_WAYS consecutive entries form one set. */
+  VC_Entry*       entries;
+  /** The next entry to be replaced in each set. */
+  u_int8_t*       victim;
+  /** The locks protecting the sets. */
+  pthread_mutex_t locks[VC_NUM_LOCKS];
+  /** Incremented each time keys are removed. An entry is only stored if the 
+   * generation did not change since the key was retrieved. */
+  u_int32_t       generation;
+  /** The number of successful lookups. */
+  u_int64_t       hits;
+  /** The number of failed lookups. */
+  u_int64_t       misses;
+} VerifyCache;
+
+/**
+ * Initialize the verify cache.
+ * 
+ * @param cache The cache to be initialized.
+ * 
+ * @return true if the cache could be initialized.
+ */
+bool vc_init(VerifyCache* cache);
+
+/**
+ * Remove all entries and free the allocated memory.
+ * 
+ * @param cache The cache to be released.
+ */
+void vc_release(VerifyCache* cache);
+
+/**
+ * Return the current generation of the cache. This value must be retrieved
+ * BEFORE the key used for the verification is retrieved from the key storage
+ * and passed to vc_store.
+ * 
+ * @param cache The cache.
+ * 
+ * @return The current generation.
+ */
+u_int32_t vc_getGeneration(VerifyCache* cache);
+
+/**
+ * Determine if the signature segment was verified already.
+ * 
+ * @param cache The cache.
+ * @param ski The SKI of the signer (SKI_LENGTH).
+ * @param asn The ASN of the signer in network format.
+ * @param digest The message digest (VC_DIGEST_LENGTH).
+ * @param signature The signature.
+ * @param sigLength The length of the signature.
+ * 
+ * @return true if the signature segment is known to be valid.
+ */
+bool vc_lookup(VerifyCache* cache, u_int8_t* ski, u_int32_t asn, 
+               u_int8_t* digest, u_int8_t* signature, u_int16_t sigLength);
+
+/**
+ * Store a verified signature segment. The entry is not stored if keys were
+ * removed since the given generation was retrieved.
+ * 
+ * @param cache The cache.
+ * @param ski The SKI of the signer (SKI_LENGTH).
+ * @param asn The ASN of the signer in network format.
+ * @param digest The message digest (VC_DIGEST_LENGTH).
+ * @param signature The signature.
+ * @param sigLength The length of the signature.
+ * @param generation The generation retrieved before the key was retrieved.
+ */
+void vc_store(VerifyCache* cache, u_int8_t* ski, u_int32_t asn, 
+              u_int8_t* digest, u_int8_t* signature, u_int16_t sigLength, 
+              u_int32_t generation);
+
+/**
+ * Remove all entries verified with the key of the given SKI and ASN.
+ * 
+ * @param cache The cache.
+ * @param ski The SKI of the key (SKI_LENGTH).
+ * @param asn The ASN of the key in network format.
+ */
+void vc_removeKey(VerifyCache* cache, u_int8_t* ski, u_int32_t asn);
+
+/**
+ * Remove all entries.
+ * 
+ * @param cache The cache.
+ */
+void vc_empty(VerifyCache* cache);
+
+#endif /* VERIFY_CACHE_H */
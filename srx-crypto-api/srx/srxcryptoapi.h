@@ -19,10 +19,13 @@
  * BGPSEC implementations. This library allows to switch the crypto 
  * implementation dynamically.
  *
- * @version 0.3.0.0
+ * @version 0.4.0.0
  * 
  * ChangeLog:
  * -----------------------------------------------------------------------------
+ *   0.4.0.0 - 2026/10/18
+ *             * Added the optional function validateBatch. This changes the 
+ *               size of SRxCryptoAPI, the library version is raised to 4.
  *   0.3.0.0 - 2018/11/29 - oborchert
  *             * Removed all "merged" comments to make future merging easier
  *           - 2017/09/13 - oborchert
@@ -777,6 +780,29 @@ typedef struct
    * @since 0.3.0.0
    */
   bool (*isAlgorithmSupported)(u_int8_t algoID);
+
+  /**
+   * Perform BGPsec path validation for multiple updates at once. (Optional)
+   * Each element is validated as specified for validate, this allows the 
+   * plug-in to share key lookups and hashing among the updates and to process
+   * them in parallel.
+   * 
+   * This function is optional, it is NULL in case the plug-in does not 
+   * provide it. The caller then has to use validate for each element.
+   * 
+   * @param count The number of elements in the given arrays.
+   * @param data Array containing the validation data objects. The status flag
+   *             of each object will contain more information.
+   * @param results Array that receives the validation result of each element.
+   *                Each result is one of the return values of validate.
+   * 
+   * @return API_SUCCESS or API_FAILURE if at least one element has an error
+   *         bit set in its status.
+   * 
+   * @since 0.4.0.0
+   */
+  int (*validateBatch)(int count, SCA_BGPSecValidationData** data, 
+                       int* results);
   
 } SRxCryptoAPI;
 
@@ -0,0 +1,547 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Benchmark of SRxCryptoAPI plug-ins. The same generated keys and signed paths
+ * are registered with and validated by each given plug-in library, one after
+ * the other. By default the EC_KEY based libSRxBGPSecOpenSSL is compared
+ * with the EVP based libSRxBGPSecOpenSSL3.
+ *
+ * Each path is validated once per plug-in instance, otherwise the verify cache
+ * of the plug-in would answer.
+ *
+ * @version 0.4.0.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ *   0.4.0.0 - 2026/10/18
+ *             * Created benchmark.
+ *             * Use the EVP functions to generate keys and sign, the EC_KEY
+ *               and ECDSA functions are deprecated with OpenSSL 3.
+ */
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+#include <openssl/x509.h>
+#include "srx/srxcryptoapi.h"
+
+/* error conditions */
+#define LOG_ERR     3
+
+/** The default number of keys */
+#define DEF_NO_KEYS     1000
+/** The default number of paths */
+#define DEF_NO_PATHS    2000
+/** The default number of signature segments per path */
+#define DEF_NO_SEGMENTS 4
+/** The number of paths handed to validateBatch at once */
+#define BATCH_SIZE      64
+/** The size of the hash message of the origin segment. Each further segment
+ * adds the size of a secure path and signature segment. */
+#define ORIGIN_MSG_LEN  48
+#define SEGMENT_MSG_LEN 102
+/** The maximum length of a DER encoded ECDSA P-256 signature */
+#define MAX_SIG_LEN     72
+/** The AS the paths are validated for */
+#define MY_ASN          65000
+/** The key source */
+#define BENCH_KEY_SOURCE 1
+
+/** The plug-in libraries compared by default */
+static char* DEF_LIBRARIES[] = { "libSRxBGPSecOpenSSL.so",
+                                 "libSRxBGPSecOpenSSL3.so" };
+
+/** A generated key */
+typedef struct {
+  /** The key registered with the plug-in */
+  BGPSecKey key;
+  /** The private key used to sign the paths */
+  EVP_PKEY* privKey;
+} BenchKey;
+
+/** A generated signed path */
+typedef struct {
+  SCA_BGPSecValidationData data;
+  SCA_HashMessage          hashMessage;
+  SCA_HashMessagePtr*      segments;
+  SCA_HashMessagePtr**     segmentPtr;
+  u_int8_t*                buffer;
+} BenchPath;
+
+/** The plug-in functions used by the benchmark */
+typedef struct {
+  int (*init)(const char* value, int logLevel, sca_status_t* status);
+  int (*release)(sca_status_t* status);
+  int (*validate)(SCA_BGPSecValidationData* data);
+  int (*validateBatch)(int count, SCA_BGPSecValidationData** data,
+                       int* results);
+  u_int8_t (*registerPublicKey)(BGPSecKey* key, sca_key_source_t source,
+                                sca_status_t* status);
+} BenchPlugin;
+
+static int   st_noKeys     = DEF_NO_KEYS;
+static int   st_noPaths    = DEF_NO_PATHS;
+static int   st_noSegments = DEF_NO_SEGMENTS;
+static char* st_initValue  = "";
+
+static SCA_Prefix st_nlri;
+
+/**
+ * Return the current time in seconds.
+ *
+ * @return the time of the monotonic clock.
+ */
+static double _now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+/**
+ * Print the syntax of this program.
+ */
+static void __syntax()
+{
+  printf ("Syntax: srx_crypto_bench [options] [library ...]\n");
+  printf ("  Options:\n");
+  printf ("    -?               This screen!\n");
+  printf ("    -k <keys>        The number of keys (%d).\n", DEF_NO_KEYS);
+  printf ("    -p <paths>       The number of paths (%d).\n", DEF_NO_PATHS);
+  printf ("    -s <segments>    The signature segments per path (%d).\n",
+          DEF_NO_SEGMENTS);
+  printf ("    -i <init_value>  The init value of the plug-ins, e.g. "
+          "THREADS:4.\n");
+  printf ("  The libraries default to %s and %s.\n", DEF_LIBRARIES[0],
+          DEF_LIBRARIES[1]);
+  printf ("\n");
+  printf ("2026 NIST (itrg-contact@nist.list.gov)\n");
+}
+
+/**
+ * Generate the keys used to sign the paths.
+ *
+ * @param keys The array of st_noKeys keys to be filled.
+ *
+ * @return true if all keys could be generated.
+ */
+static bool _generateKeys(BenchKey* keys)
+{
+  int  idx = 0;
+  bool ok  = false;
+  EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+
+  if (ctx != NULL)
+  {
+    ok =    (EVP_PKEY_keygen_init(ctx) > 0)
+         && (EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx, 
+                                                    NID_X9_62_prime256v1) > 0);
+  }
+
+  for (; ok && (idx < st_noKeys); idx++)
+  {
+    u_int8_t* der = NULL;
+    int       len = 0;
+
+    if (EVP_PKEY_keygen(ctx, &keys[idx].privKey) <= 0)
+    {
+      ok = false;
+      break;
+    }
+    len = i2d_PUBKEY(keys[idx].privKey, &der);
+    if (len <= 0)
+    {
+      ok = false;
+      break;
+    }
+    keys[idx].key.algoID    = SCA_ECDSA_ALGORITHM;
+    keys[idx].key.asn       = htonl(idx + 1);
+    memset(keys[idx].key.ski, 0, SKI_LENGTH);
+    memcpy(keys[idx].key.ski, &idx, sizeof(int));
+    // The key data MUST be malloc'ed
+    keys[idx].key.keyLength = (u_int16_t)len;
+    keys[idx].key.keyData   = malloc(len);
+    memcpy(keys[idx].key.keyData, der, len);
+    OPENSSL_free(der);
+  }
+  EVP_PKEY_CTX_free(ctx);
+
+  return ok;
+}
+
+/**
+ * Generate a signed path. The hash message of each segment is filled with
+ * random data, only the ASN of the signer is placed where the plug-in expects
+ * it.
+ *
+ * @param path The path to be filled.
+ * @param keys The keys.
+ *
+ * @return true if the path could be generated.
+ */
+static bool _generatePath(BenchPath* path, BenchKey* keys)
+{
+  int       idx    = 0;
+  int       pos    = 0;
+  u_int32_t size   = 0;
+  u_int8_t* msg    = NULL;
+  BenchKey* signer = NULL;
+  size_t    sigLen = 0;
+  bool      isSigned = false;
+  EVP_MD_CTX* ctx  = EVP_MD_CTX_new();
+
+  for (idx = 0; idx < st_noSegments; idx++)
+  {
+    size += ORIGIN_MSG_LEN + (SEGMENT_MSG_LEN * (st_noSegments - idx - 1))
+            + LEN_SIGSEGMENT_HDR + MAX_SIG_LEN;
+  }
+
+  memset(path, 0, sizeof(BenchPath));
+  path->buffer     = malloc(size);
+  path->segments   = malloc(sizeof(SCA_HashMessagePtr)  * st_noSegments);
+  path->segmentPtr = malloc(sizeof(SCA_HashMessagePtr*) * st_noSegments);
+  if (   path->buffer == NULL || path->segments == NULL 
+      || path->segmentPtr == NULL || ctx == NULL)
+  {
+    EVP_MD_CTX_free(ctx);
+    return false;
+  }
+  for (idx = 0; idx < size; idx++)
+  {
+    path->buffer[idx] = (u_int8_t)rand();
+  }
+
+  // Layout the segments, segment 0 is the last signer.
+  for (idx = 0; idx < st_noSegments; idx++)
+  {
+    path->segmentPtr[idx] = &path->segments[idx];
+    path->segments[idx].hashMessagePtr    = path->buffer + pos;
+    path->segments[idx].hashMessageLength = ORIGIN_MSG_LEN
+                            + (SEGMENT_MSG_LEN * (st_noSegments - idx - 1));
+    pos += path->segments[idx].hashMessageLength;
+    path->segments[idx].signaturePtr = path->buffer + pos;
+    pos += LEN_SIGSEGMENT_HDR + MAX_SIG_LEN;
+  }
+
+  // The target AS of segment 0, the other targets are the signers.
+  *((u_int32_t*)path->segments[0].hashMessagePtr) = htonl(MY_ASN);
+  for (idx = 0; idx < st_noSegments; idx++)
+  {
+    signer = &keys[rand() % st_noKeys];
+    if (idx + 1 < st_noSegments)
+    {
+      msg = path->segments[idx+1].hashMessagePtr;
+    }
+    else
+    {
+      msg = path->segments[idx].hashMessagePtr + LEN_SECPATHSEGMENT;
+    }
+    memcpy(msg, &signer->key.asn, sizeof(u_int32_t));
+    memcpy(path->segments[idx].signaturePtr, signer->key.ski, SKI_LENGTH);
+  }
+
+  // Sign from the origin on, each message might contain the next signer.
+  for (idx = st_noSegments - 1; idx >= 0; idx--)
+  {
+    SCA_BGPSEC_SignatureSegment* sigSeg =
+                (SCA_BGPSEC_SignatureSegment*)path->segments[idx].signaturePtr;
+    signer = &keys[ntohl(*(u_int32_t*)((idx + 1 < st_noSegments)
+                      ? path->segments[idx+1].hashMessagePtr
+                      : path->segments[idx].hashMessagePtr
+                        + LEN_SECPATHSEGMENT)) - 1];
+    // ECDSA over the SHA256 digest of the hash message
+    sigLen = MAX_SIG_LEN;
+    isSigned =    (EVP_DigestSignInit(ctx, NULL, EVP_sha256(), NULL,
+                                      signer->privKey) > 0)
+               && (EVP_DigestSign(ctx, 
+                         path->segments[idx].signaturePtr + LEN_SIGSEGMENT_HDR,
+                         &sigLen, path->segments[idx].hashMessagePtr,
+                         path->segments[idx].hashMessageLength) > 0);
+    EVP_MD_CTX_reset(ctx);
+    if (!isSigned)
+    {
+      EVP_MD_CTX_free(ctx);
+      return false;
+    }
+    sigSeg->siglen = htons((u_int16_t)sigLen);
+  }
+  EVP_MD_CTX_free(ctx);
+
+  path->hashMessage.ownedByAPI        = false;
+  path->hashMessage.bufferSize        = size;
+  path->hashMessage.buffer            = path->buffer;
+  path->hashMessage.segmentCount      = st_noSegments;
+  path->hashMessage.hashMessageValPtr = path->segmentPtr;
+
+  path->data.myAS             = htonl(MY_ASN);
+  path->data.status           = API_STATUS_OK;
+  // Not read, the hash message is provided.
+  path->data.bgpsec_path_attr = path->buffer;
+  path->data.nlri             = &st_nlri;
+  path->data.hashMessage[0]   = &path->hashMessage;
+
+  return true;
+}
+
+/**
+ * Load the plug-in functions used by the benchmark.
+ *
+ * @param handle The handle of the library.
+ * @param plugin The plug-in to be filled.
+ *
+ * @return true if all required functions are found.
+ */
+static bool _loadPlugin(void* handle, BenchPlugin* plugin)
+{
+  plugin->init              = dlsym(handle, "init");
+  plugin->release           = dlsym(handle, "release");
+  plugin->validate          = dlsym(handle, "validate");
+  plugin->registerPublicKey = dlsym(handle, "registerPublicKey");
+  // Optional
+  plugin->validateBatch     = dlsym(handle, "validateBatch");
+
+  return    plugin->init != NULL && plugin->release != NULL
+         && plugin->validate != NULL && plugin->registerPublicKey != NULL;
+}
+
+/**
+ * Initialize the plug-in and register all keys.
+ *
+ * @param plugin The plug-in
+ * @param keys The keys to be registered.
+ *
+ * @return the time needed to register the keys or -1 on error.
+ */
+static double _startPlugin(BenchPlugin* plugin, BenchKey* keys)
+{
+  sca_status_t status = API_STATUS_OK;
+  double       start  = 0;
+  int          idx    = 0;
+
+  if (plugin->init(st_initValue, (int)sca_getCurrentLogLevel(), &status)
+      != API_SUCCESS)
+  {
+    printf ("ERROR: Could not initialize the plug-in (0x%08X)!\n", status);
+    return -1;
+  }
+
+  start = _now();
+  for (; idx < st_noKeys; idx++)
+  {
+    status = API_STATUS_OK;
+    if (plugin->registerPublicKey(&keys[idx].key, BENCH_KEY_SOURCE, &status)
+        != API_SUCCESS)
+    {
+      printf ("ERROR: Could not register key %d (0x%08X)!\n", idx, status);
+      return -1;
+    }
+  }
+
+  return _now() - start;
+}
+
+/**
+ * Run the benchmark for one library.
+ *
+ * @param library The name of the library.
+ * @param keys The keys.
+ * @param paths The paths.
+ *
+ * @return true if all paths validated as valid.
+ */
+static bool _runLibrary(char* library, BenchKey* keys, BenchPath* paths)
+{
+  BenchPlugin  plugin;
+  sca_status_t status   = API_STATUS_OK;
+  void*        handle   = dlopen(library, RTLD_NOW | RTLD_LOCAL);
+  double       regTime  = 0;
+  double       start    = 0;
+  double       valTime  = 0;
+  int          valid    = 0;
+  int          idx      = 0;
+  int          num      = 0;
+  int          noSigs   = st_noPaths * st_noSegments;
+  int          results[BATCH_SIZE];
+  SCA_BGPSecValidationData* batch[BATCH_SIZE];
+
+  printf ("\n%s\n", library);
+  if (handle == NULL)
+  {
+    printf ("ERROR: %s\n", dlerror());
+    return false;
+  }
+  if (!_loadPlugin(handle, &plugin))
+  {
+    printf ("ERROR: The library is not an SRxCryptoAPI plug-in!\n");
+    dlclose(handle);
+    return false;
+  }
+
+  // validate
+  regTime = _startPlugin(&plugin, keys);
+  if (regTime >= 0)
+  {
+    start = _now();
+    for (idx = 0; idx < st_noPaths; idx++)
+    {
+      paths[idx].data.status = API_STATUS_OK;
+      valid += plugin.validate(&paths[idx].data) == API_VALRESULT_VALID;
+    }
+    valTime = _now() - start;
+    printf ("  register      : %8.2f us per key\n", regTime * 1e6 / st_noKeys);
+    printf ("  validate      : %8.2f us per signature, %8.0f paths/s "
+            "(%d of %d valid)\n", valTime * 1e6 / noSigs,
+            st_noPaths / valTime, valid, st_noPaths);
+  }
+  plugin.release(&status);
+
+  // validateBatch, re-initialized to start with an empty verify cache.
+  if (regTime >= 0 && plugin.validateBatch != NULL)
+  {
+    regTime = _startPlugin(&plugin, keys);
+    if (regTime >= 0)
+    {
+      valid = 0;
+      start = _now();
+      for (idx = 0; idx < st_noPaths; idx += num)
+      {
+        for (num = 0; (num < BATCH_SIZE) && (idx + num < st_noPaths); num++)
+        {
+          paths[idx + num].data.status = API_STATUS_OK;
+          batch[num] = &paths[idx + num].data;
+        }
+        plugin.validateBatch(num, batch, results);
+        for (num = 0; (num < BATCH_SIZE) && (idx + num < st_noPaths); num++)
+        {
+          valid += results[num] == API_VALRESULT_VALID;
+        }
+      }
+      valTime = _now() - start;
+      printf ("  validateBatch : %8.2f us per signature, %8.0f paths/s "
+              "(%d of %d valid)\n", valTime * 1e6 / noSigs,
+              st_noPaths / valTime, valid, st_noPaths);
+    }
+    status = API_STATUS_OK;
+    plugin.release(&status);
+  }
+
+  dlclose(handle);
+  return (regTime >= 0) && (valid == st_noPaths);
+}
+
+/**
+ * Benchmark the given plug-in libraries.
+ *
+ * @param argc The number of arguments handed to the program
+ * @param argv The argument handed to the program
+ *
+ * @return 0 if all libraries validated all paths, otherwise 1
+ */
+int main(int argc, char** argv)
+{
+  int        retVal   = 0;
+  int        idx      = 1;
+  int        noLibs   = 0;
+  char**     libs     = NULL;
+  BenchKey*  keys     = NULL;
+  BenchPath* paths    = NULL;
+
+  for (; idx < argc && argv[idx][0] == '-'; idx++)
+  {
+    if (argv[idx][1] != '?' && idx + 1 >= argc)
+    {
+      __syntax();
+      return 1;
+    }
+    switch (argv[idx][1])
+    {
+      case 'k' : st_noKeys     = atoi(argv[++idx]); break;
+      case 'p' : st_noPaths    = atoi(argv[++idx]); break;
+      case 's' : st_noSegments = atoi(argv[++idx]); break;
+      case 'i' : st_initValue  = argv[++idx]; break;
+      default:
+        __syntax();
+        return 1;
+    }
+  }
+  if (st_noKeys <= 0 || st_noPaths <= 0 || st_noSegments <= 0)
+  {
+    __syntax();
+    return 1;
+  }
+
+  noLibs = (idx < argc) ? argc - idx : 2;
+  libs   = (idx < argc) ? &argv[idx] : DEF_LIBRARIES;
+
+  printf ("Generate %d keys and %d paths with %d signatures each.\n",
+          st_noKeys, st_noPaths, st_noSegments);
+  srand(1);
+  memset(&st_nlri, 0, sizeof(SCA_Prefix));
+  st_nlri.afi    = htons(1);
+  st_nlri.safi   = 1;
+  st_nlri.length = 24;
+  keys  = calloc(st_noKeys, sizeof(BenchKey));
+  paths = calloc(st_noPaths, sizeof(BenchPath));
+  if (keys == NULL || paths == NULL || !_generateKeys(keys))
+  {
+    printf ("ERROR: Could not generate the keys!\n");
+    return 1;
+  }
+  for (idx = 0; idx < st_noPaths; idx++)
+  {
+    if (!_generatePath(&paths[idx], keys))
+    {
+      printf ("ERROR: Could not generate the paths!\n");
+      return 1;
+    }
+  }
+
+  for (idx = 0; idx < noLibs; idx++)
+  {
+    if (!_runLibrary(libs[idx], keys, paths))
+    {
+      retVal = 1;
+    }
+  }
+
+  for (idx = 0; idx < st_noPaths; idx++)
+  {
+    free(paths[idx].buffer);
+    free(paths[idx].segments);
+    free(paths[idx].segmentPtr);
+  }
+  for (idx = 0; idx < st_noKeys; idx++)
+  {
+    EVP_PKEY_free(keys[idx].privKey);
+    free(keys[idx].key.keyData);
+  }
+  free(paths);
+  free(keys);
+
+  return retVal;
+}
@@ -25,10 +25,12 @@
  * that do generate the key files in the required form. See the tool sub
  * directory for more information.
  *
- * @version 0.3.0.3
+ * @version 0.4.0.0
  * 
  * ChangeLog:
  * -----------------------------------------------------------------------------
+ *  0.4.0.0 - 2026/10/18
+ *            * Added the mapping of the optional function validateBatch.
  *  0.3.0.3 - 2021/05/08 - oborchert
  *            * Renamed all instances of volt to vault
  *            * Added a deprecation of the incorrect key_volt to be backwards 
@@ -152,6 +154,7 @@
 
 #define SCA_SIGN                   "method_sign"
 #define SCA_VALIDATE               "method_validate"
+#define SCA_VALIDATE_BATCH         "method_validateBatch"
 
 #define SCA_REGISTER_PRIVATE_KEY   "method_registerPrivateKey"
 #define SCA_UNREGISTER_PRIVATE_KEY "method_unregisterPrivateKey"
@@ -177,6 +180,7 @@
 
 #define SCA_DEF_SIGN                   "sign"
 #define SCA_DEF_VALIDATE               "validate"
+#define SCA_DEF_VALIDATE_BATCH         "validateBatch"
 
 #define SCA_DEF_REGISTER_PRIVATE_KEY   "registerPrivateKey"
 #define SCA_DEF_UNREGISTER_PRIVATE_KEY "unregisterPrivateKey"
@@ -211,6 +215,7 @@ typedef struct {
   
   const char* str_method_sign;
   const char* str_method_validate;
+  const char* str_method_validateBatch;
 
   const char* str_method_registerPrivateKey;
   const char* str_method_unregisterPrivateKey;
@@ -777,6 +782,8 @@ static void _loadMapping(config_setting_t *set, SCA_Mappings* mappings)
   //////////////////////////////////////////////////////////////////////////////
   __readMapping(set, SCA_SIGN, &mappings->str_method_sign);
   __readMapping(set, SCA_VALIDATE, &mappings->str_method_validate);  
+  __readMapping(set, SCA_VALIDATE_BATCH, 
+                     &mappings->str_method_validateBatch);
   
   //////////////////////////////////////////////////////////////////////////////
   // KEY STORAGE
@@ -925,6 +932,9 @@ static int _mapAPI(SCA_Mappings* mappings, SRxCryptoAPI* api)
                     mappings->str_method_sign, SCA_DEF_SIGN);
     __doMapFunction(api->libHandle, (void**)&api->validate,
                     mappings->str_method_validate, SCA_DEF_VALIDATE);
+    __doMapFunction(api->libHandle, (void**)&api->validateBatch,
+                    mappings->str_method_validateBatch, 
+                    SCA_DEF_VALIDATE_BATCH);
     
     __doMapFunction(api->libHandle, (void**)&api->registerPublicKey,
                     mappings->str_method_registerPublicKey,
@@ -1020,6 +1030,8 @@ int srxCryptoInit(SRxCryptoAPI* api, sca_status_t* status)
   
   api->sign                 = wrap_sign;
   api->validate             = wrap_validate;
+  // Optional, stays NULL if the plug-in does not provide it.
+  api->validateBatch        = NULL;
 
   api->registerPublicKey    = wrap_registerPublicKey;
   api->unregisterPublicKey  = wrap_unregisterPublicKey;
@@ -43,10 +43,15 @@
  *
  * GET RID OFF SEND QUEUE ??
  *
- * Version 0.6.1.2
+ * Version 0.6.2.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Verify requests can be coalesced into batched verify request
+ *              PDUs. All sending is serialized with the batch mutex to keep
+ *              the order of the PDUs. Requests that could not be send
+ *              remain in the batch.
  * 0.6.1.2  - 2021/11/18 - kyehwanl
  *            * Fixed bug in LOG print.
  * 0.3.0.10 - 2015/11/10 - oborchert
@@ -68,6 +73,7 @@
 #include <signal.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <time.h>
 #include <netinet/tcp.h>
 #include "client/client_connection_handler.h"
 #include "shared/srx_packets.h"
@@ -141,6 +147,11 @@ ClientConnectionHandler* createClientConnectionHandler(SRxProxy* proxy)
     self->clSock.canBeClosed = true;
     
     self->srxProxy = proxy;
+
+    // Verify requests are not batched until configured.
+    memset(&self->verifyBatch, 0, sizeof(VerifyBatch));
+    initMutex(&self->verifyBatch.mutex);
+    initCond(&self->verifyBatch.cond);
   }
   
   return self;
@@ -401,16 +412,16 @@ inline bool connHandlerUnlock(ClientConnectionHandler* self)
 /**
  * Sends a packet to the server. If the TCP connection is down but the
  * application layer connection is established, the packet might be queued.
+ * The caller MUST hold the batch mutex.
  *
  * @param self Instance that should be used
  * @param data The proxySRX PDU to be send.
- * @param length Data size in bytes. This method does not read the header length
- *               field, it goes with the length provided. This can allow to
- *               send a stream of multiple pdu's at once.
+ * @param length Data size in bytes.
+ *
  * @return true = data sent successfully, false = sending failed
  *         (e.g. no connection)
  */
-bool sendPacketToServer(ClientConnectionHandler* self, void* data,
+static bool _sendPacket(ClientConnectionHandler* self, void* data,
                         uint32_t length)
 {
   if (isConnectedToServer(&self->clSock))
@@ -452,6 +463,323 @@ bool sendPacketToServer(ClientConnectionHandler* self, void* data,
   return true;
 }
 
+/**
+ * Send the collected verify requests. A single request is send as it is. If
+ * the requests could not be send they remain in the batch. The caller MUST
+ * hold the batch mutex.
+ *
+ * @param self The client connection handler.
+ *
+ * @return false if the batch could not be send.
+ *
+ * @since 0.6.2.0
+ */
+static bool _flushVerifyBatch(ClientConnectionHandler* self)
+{
+  VerifyBatch* batch   = &self->verifyBatch;
+  uint32_t     hdrSize = sizeof(SRXPROXY_VERIFY_BATCH_REQUEST);
+  SRXPROXY_VERIFY_BATCH_REQUEST* hdr = NULL;
+  bool         retVal  = true;
+
+  if (batch->count == 1)
+  {
+    retVal = _sendPacket(self, batch->buffer + hdrSize, batch->fill - hdrSize);
+  }
+  else if (batch->count > 1)
+  {
+    hdr = (SRXPROXY_VERIFY_BATCH_REQUEST*)batch->buffer;
+    hdr->type   = PDU_SRXPROXY_VERIFY_BATCH_REQUEST;
+    hdr->count  = htonl(batch->count);
+    hdr->length = htonl(batch->fill);
+    retVal = _sendPacket(self, batch->buffer, batch->fill);
+  }
+
+  if (retVal)
+  {
+    batch->count = 0;
+    batch->fill  = hdrSize;
+  }
+  else
+  {
+    LOG(LEVEL_ERROR, HDR "Could not send %u batched verify requests!",
+                     pthread_self(), batch->count);
+  }
+
+  return retVal;
+}
+
+/**
+ * Set the time the current batch has to be send at. The caller MUST hold the
+ * batch mutex.
+ *
+ * @param batch The verify batch.
+ *
+ * @since 0.6.2.0
+ */
+static void _setVerifyBatchDeadline(VerifyBatch* batch)
+{
+  clock_gettime(CLOCK_REALTIME, &batch->deadline);
+  batch->deadline.tv_sec  += batch->maxDelayMillis / 1000;
+  batch->deadline.tv_nsec += (batch->maxDelayMillis % 1000) * 1000000L;
+  if (batch->deadline.tv_nsec >= 1000000000L)
+  {
+    batch->deadline.tv_sec++;
+    batch->deadline.tv_nsec -= 1000000000L;
+  }
+}
+
+/**
+ * Send the batch once the oldest request waited the configured time.
+ *
+ * @param data The client connection handler.
+ *
+ * @return NULL
+ *
+ * @since 0.6.2.0
+ */
+static void* _verifyBatchThread(void* data)
+{
+  ClientConnectionHandler* self  = (ClientConnectionHandler*)data;
+  VerifyBatch*             batch = &self->verifyBatch;
+  struct timespec          now;
+
+  lockMutex(&batch->mutex);
+  while (batch->running)
+  {
+    if (batch->count == 0)
+    {
+      pthread_cond_wait(&batch->cond, &batch->mutex);
+      continue;
+    }
+    clock_gettime(CLOCK_REALTIME, &now);
+    if (   (now.tv_sec > batch->deadline.tv_sec)
+        || (   (now.tv_sec == batch->deadline.tv_sec)
+            && (now.tv_nsec >= batch->deadline.tv_nsec)))
+    {
+      if (!_flushVerifyBatch(self))
+      {
+        // Try again once the delay passed again.
+        _setVerifyBatchDeadline(batch);
+      }
+    }
+    else
+    {
+      pthread_cond_timedwait(&batch->cond, &batch->mutex, &batch->deadline);
+    }
+  }
+  unlockMutex(&batch->mutex);
+
+  return NULL;
+}
+
+/**
+ * Sends a packet to the server. If the TCP connection is down but the
+ * application layer connection is established, the packet might be queued.
+ * Collected verify requests are send first, if they could not be send the
+ * packet is not send either.
+ *
+ * @param self Instance that should be used
+ * @param data The proxySRX PDU to be send.
+ * @param length Data size in bytes. This method does not read the header length
+ *               field, it goes with the length provided. This can allow to
+ *               send a stream of multiple pdu's at once.
+ * @return true = data sent successfully, false = sending failed
+ *         (e.g. no connection)
+ */
+bool sendPacketToServer(ClientConnectionHandler* self, void* data,
+                        uint32_t length)
+{
+  bool retVal;
+
+  // The packet is not send ahead of the collected requests.
+  lockMutex(&self->verifyBatch.mutex);
+  retVal = _flushVerifyBatch(self) && _sendPacket(self, data, length);
+  unlockMutex(&self->verifyBatch.mutex);
+
+  return retVal;
+}
+
+/**
+ * Configure the coalescing of verify requests. Batching is disabled if
+ * maxRequests is less than 2. Pending requests are send before the
+ * configuration changes, requests that could not be send are kept.
+ *
+ * @param self The client connection handler.
+ * @param maxRequests The maximum number of requests in one batch.
+ * @param maxDelayMillis The maximum time in milliseconds a request is held
+ *                       back, 0 sends the batch only once it is full.
+ *
+ * @return false if the flush thread could not be started.
+ *
+ * @since 0.6.2.0
+ */
+bool configureVerifyBatch(ClientConnectionHandler* self, uint32_t maxRequests,
+                          uint32_t maxDelayMillis)
+{
+  VerifyBatch* batch     = &self->verifyBatch;
+  bool         retVal    = true;
+  bool         useThread = false;
+  bool         doJoin    = false;
+
+  lockMutex(&batch->mutex);
+  _flushVerifyBatch(self);
+
+  if ((maxRequests > 1) && (batch->buffer == NULL))
+  {
+    batch->buffer = malloc(VERIFY_BATCH_MAX_LENGTH);
+    if (batch->buffer == NULL)
+    {
+      RAISE_ERROR("Not enough memory to batch verify requests!");
+      maxRequests = 0;
+      retVal      = false;
+    }
+  }
+  batch->maxRequests    = maxRequests;
+  batch->maxDelayMillis = maxDelayMillis;
+  if (batch->count == 0)
+  {
+    batch->fill = sizeof(SRXPROXY_VERIFY_BATCH_REQUEST);
+  }
+
+  // The flush thread is only needed if requests are held back for a time.
+  useThread = (maxRequests > 1) && (maxDelayMillis > 0);
+  if (useThread && !batch->running)
+  {
+    batch->running = pthread_create(&batch->flushThread, NULL,
+                                    _verifyBatchThread, self) == 0;
+    if (!batch->running)
+    {
+      RAISE_ERROR("Could not start the verify batch thread!");
+      batch->maxRequests = 0;
+      retVal = false;
+    }
+  }
+  else if (!useThread && batch->running)
+  {
+    batch->running = false;
+    doJoin         = true;
+    signalCond(&batch->cond);
+  }
+  unlockMutex(&batch->mutex);
+
+  if (doJoin)
+  {
+    pthread_join(batch->flushThread, NULL);
+  }
+
+  return retVal;
+}
+
+/**
+ * Send the verify request to the server. With batching enabled the request is
+ * added to the current batch which is send once it is full. Otherwise this
+ * is the same as sendPacketToServer.
+ *
+ * @param self The client connection handler.
+ * @param pdu The verify request PDU (type 3 or 4).
+ * @param length The length of the PDU.
+ *
+ * @return true if the request is send or in the batch. false if the collected
+ *         requests ahead of it could not be send, the request is not added
+ *         then.
+ *
+ * @since 0.6.2.0
+ */
+bool queueVerifyRequest(ClientConnectionHandler* self, SRXPROXY_PDU* pdu,
+                        uint32_t length)
+{
+  VerifyBatch* batch  = &self->verifyBatch;
+  bool         retVal = true;
+
+  lockMutex(&batch->mutex);
+  if (   (batch->maxRequests < 2)
+      || (length > VERIFY_BATCH_MAX_LENGTH
+                   - sizeof(SRXPROXY_VERIFY_BATCH_REQUEST)))
+  {
+    retVal = _flushVerifyBatch(self) && _sendPacket(self, pdu, length);
+  }
+  else if (   (   (batch->count >= batch->maxRequests)
+               || ((batch->fill + length) > VERIFY_BATCH_MAX_LENGTH))
+           && !_flushVerifyBatch(self))
+  {
+    // The batch is still full, the caller might try again.
+    retVal = false;
+  }
+  else
+  {
+    memcpy(batch->buffer + batch->fill, pdu, length);
+    batch->fill += length;
+    batch->count++;
+
+    if (batch->count >= batch->maxRequests)
+    {
+      // A batch that could not be send is send with the next request.
+      _flushVerifyBatch(self);
+    }
+    else if ((batch->count == 1) && batch->running)
+    {
+      // The first request of a batch starts the timer of the flush thread.
+      _setVerifyBatchDeadline(batch);
+      signalCond(&batch->cond);
+    }
+  }
+  unlockMutex(&batch->mutex);
+
+  return retVal;
+}
+
+/**
+ * Send all collected verify requests right away.
+ *
+ * @param self The client connection handler.
+ *
+ * @return false if the batch could not be send.
+ *
+ * @since 0.6.2.0
+ */
+bool flushVerifyBatch(ClientConnectionHandler* self)
+{
+  bool retVal;
+
+  lockMutex(&self->verifyBatch.mutex);
+  retVal = _flushVerifyBatch(self);
+  unlockMutex(&self->verifyBatch.mutex);
+
+  return retVal;
+}
+
+/**
+ * Stop the flush thread and release the batch buffer. Pending requests are
+ * discarded.
+ *
+ * @param self The client connection handler.
+ *
+ * @since 0.6.2.0
+ */
+void releaseVerifyBatch(ClientConnectionHandler* self)
+{
+  VerifyBatch* batch  = &self->verifyBatch;
+  bool         doJoin = false;
+
+  lockMutex(&batch->mutex);
+  doJoin         = batch->running;
+  batch->running = false;
+  signalCond(&batch->cond);
+  unlockMutex(&batch->mutex);
+
+  if (doJoin)
+  {
+    pthread_join(batch->flushThread, NULL);
+  }
+
+  free(batch->buffer);
+  batch->buffer      = NULL;
+  batch->count       = 0;
+  batch->maxRequests = 0;
+  releaseMutex(&batch->mutex);
+  destroyCond(&batch->cond);
+}
+
 /**
  * Handler to catch the timeout alarm for handshake.
  * 
@@ -567,6 +895,7 @@ bool sendGoodbye(ClientConnectionHandler* self, uint16_t keepWindow)
   uint32_t length = sizeof(SRXPROXY_GOODBYE);
   uint8_t pdu[length];
   SRXPROXY_GOODBYE* hdr = (SRXPROXY_GOODBYE*)pdu;
+  bool retVal = false;
   memset(pdu, 0, length);
 
   LOG(LEVEL_DEBUG, HDR" send Goodbye! called", pthread_self());
@@ -574,16 +903,20 @@ bool sendGoodbye(ClientConnectionHandler* self, uint16_t keepWindow)
   hdr->keepWindow = htons(keepWindow);
   hdr->length     = htonl(length);
 
+  // Collected verify requests are send before the goodbye
+  lockMutex(&self->verifyBatch.mutex);
+  _flushVerifyBatch(self);
   if (isConnectedToServer(&self->clSock))
   {
     if (sendData(&self->clSock, &pdu, length))
     {
       self->established = false;
-      return true;
+      retVal = true;
     }
   }
+  unlockMutex(&self->verifyBatch.mutex);
 
-  return false;
+  return retVal;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
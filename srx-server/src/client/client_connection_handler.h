@@ -20,10 +20,13 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * Version 0.5.0.6
+ * Version 0.6.2.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Added VerifyBatch to coalesce verify requests into batched
+ *             verify request PDUs.
  * 0.5.0.6 - 2018/11/20 - oborchert
  *           * Removed "inline" keyword from functions - caused linker error 
  *             on Ubuntu 18
@@ -44,6 +47,7 @@
 #include <semaphore.h>
 #include "client/srx_api.h"
 #include "util/client_socket.h"
+#include "util/mutex.h"
 #include "util/packet.h"
 #include "util/rwlock.h"
 #include "util/slist.h"
@@ -62,6 +66,28 @@
 //typedef void (*SRxPacketHandler)(SRxProxyPDUType pduType, void* dataHeader,
 //                                 void* srxProxy);
 
+/** The maximum size of a batched verify request PDU in bytes. */
+#define VERIFY_BATCH_MAX_LENGTH 65536
+
+/**
+ * Collects verify requests and sends them as one batched verify request PDU
+ * once maxRequests are collected or the oldest request waited maxDelayMillis.
+ *
+ * @since 0.6.2.0
+ */
+typedef struct {
+  uint8_t*         buffer;        // Batch header followed by the requests.
+  uint32_t         fill;          // Bytes in the buffer including the header.
+  uint32_t         count;         // The number of requests in the buffer.
+  uint32_t         maxRequests;   // Requests per batch, < 2 = no batching.
+  uint32_t         maxDelayMillis;// Maximum time a request is held back.
+  struct timespec  deadline;      // Time the current batch must be send.
+  Mutex            mutex;         // Serializes all sending to the server.
+  Cond             cond;          // Wakes up the flush thread.
+  pthread_t        flushThread;   // Sends the batch once the deadline passed.
+  bool             running;       // Indicates if the flush thread runs.
+} VerifyBatch;
+
 /**
  * A single Client Connection Handler.
  */
@@ -102,6 +128,7 @@ typedef struct {
   SRxProxy*        srxProxy;      // A pointer to the SRX proxy instance.
                                   // Will be set using the method
                                   // initializeClientConnectionHandler.
+  VerifyBatch      verifyBatch;   // Coalesces verify requests.
 } ClientConnectionHandler;
 
 /**
@@ -201,6 +228,62 @@ bool connHandlerUnlock(ClientConnectionHandler* self);
 bool sendPacketToServer(ClientConnectionHandler* self, SRXPROXY_PDU* header,
                         uint32_t length);
 
+/**
+ * Configure the coalescing of verify requests. Batching is disabled if
+ * maxRequests is less than 2. Pending requests are send before the
+ * configuration changes.
+ *
+ * @param self The client connection handler.
+ * @param maxRequests The maximum number of requests in one batch.
+ * @param maxDelayMillis The maximum time in milliseconds a request is held
+ *                       back, 0 sends the batch only once it is full.
+ *
+ * @return false if the flush thread could not be started.
+ *
+ * @since 0.6.2.0
+ */
+bool configureVerifyBatch(ClientConnectionHandler* self, uint32_t maxRequests,
+                          uint32_t maxDelayMillis);
+
+/**
+ * Send the verify request to the server. With batching enabled the request is
+ * added to the current batch which is send once it is full. Otherwise this
+ * is the same as sendPacketToServer.
+ *
+ * @param self The client connection handler.
+ * @param pdu The verify request PDU (type 3 or 4).
+ * @param length The length of the PDU.
+ *
+ * @return true if the request is send or in the batch. false if the collected
+ *         requests ahead of it could not be send, the request is not added
+ *         then.
+ *
+ * @since 0.6.2.0
+ */
+bool queueVerifyRequest(ClientConnectionHandler* self, SRXPROXY_PDU* pdu,
+                        uint32_t length);
+
+/**
+ * Send all collected verify requests right away.
+ *
+ * @param self The client connection handler.
+ *
+ * @return false if the batch could not be send.
+ *
+ * @since 0.6.2.0
+ */
+bool flushVerifyBatch(ClientConnectionHandler* self);
+
+/**
+ * Stop the flush thread and release the batch buffer. Pending requests are
+ * discarded.
+ *
+ * @param self The client connection handler.
+ *
+ * @since 0.6.2.0
+ */
+void releaseVerifyBatch(ClientConnectionHandler* self);
+
 
 /*
  * Create the connection of application layer between srx and proxy
@@ -23,10 +23,15 @@
  * Secure Routing extension (SRx) client API - This API provides a fully
  * functional proxy client to the SRx server.
  *
- * Version: 0.6.0.0
+ * Version: 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Added setVerifyBatching and flushVerifyRequests. Verify requests
+ *              can be coalesced into batched verify request PDUs.
+ *            * Peer changes and update deletions are send using
+ *              sendPacketToServer to keep their order with batched requests.
  * 0.6.0.0  - 2021/04/06 - borchert
  *            * Added initialization of common header - reserved8
  *            * Assigned asType and asRelationShip to common header
@@ -207,6 +212,7 @@ void releaseSRxProxy(SRxProxy* proxy)
   {
     disconnectFromSRx(proxy, SRX_DEFAULT_KEEP_WINDOW);
     releaseSList(&proxy->peerAS);
+    releaseVerifyBatch((ClientConnectionHandler*)proxy->connHandler);
     free(proxy->connHandler);
     free(proxy);
   }
@@ -252,7 +258,7 @@ void addPeers(SRxProxy* proxy, uint32_t noPeers, uint32_t* peerAS)
     }
 
     // Send peerAS changes to SRx
-    sendData(&connHandler->clSock, &data, dataSize);
+    sendPacketToServer(connHandler, &data, dataSize);
   }
   else
   {
@@ -299,7 +305,7 @@ void removePeers(SRxProxy* proxy, uint32_t noPeers, uint32_t* peerAS)
       hdr->peerAS     = htonl(*peerAS);
       // Remove peerAS from list
       deleteFromSList(&proxy->peerAS, peerAS);
-      sendData(&connHandler->clSock, &data, dataSize);
+      sendPacketToServer(connHandler, &data, dataSize);
     }
   }
   else
@@ -340,7 +346,7 @@ void deleteUpdate(SRxProxy* proxy, uint16_t keep_window, SRxUpdateID updateID)
     hdr->length           = htonl(length);
     hdr->updateIdentifier = htonl(updateID);
 
-    sendData(&connHandler->clSock, hdr, length);
+    sendPacketToServer(connHandler, hdr, length);
 
     free(hdr);
   }
@@ -818,7 +824,7 @@ void verifyUpdate(SRxProxy* proxy, uint32_t localID,
   do
   {
     attempt++;
-    if(sendPacketToServer(connHandler, (SRXPROXY_PDU*)pdu, length))
+    if(queueVerifyRequest(connHandler, (SRXPROXY_PDU*)pdu, length))
     {
       // Leave the loop
       if (   proxy->socketConfig.resetSendErrors
@@ -907,6 +913,45 @@ void verifyUpdate(SRxProxy* proxy, uint32_t localID,
   }
 }
 
+/**
+ * Coalesce the verify requests of verifyUpdate into batched verify request
+ * PDUs. A batch is send once it contains maxRequests requests or its oldest
+ * request waited maxDelayMillis milliseconds. All other requests send to the
+ * SRx server send the pending batch first. The SRx server MUST support
+ * batched verify requests (0.6.2.0 and later).
+ *
+ * @param proxy The proxy instance
+ * @param maxRequests The maximum number of verify requests per batch. A value
+ *                    less than 2 disables batching (default).
+ * @param maxDelayMillis The maximum time in milliseconds a verify request is
+ *                    held back. With 0 a batch is only send once it is full
+ *                    or flushVerifyRequests is called.
+ *
+ * @return true if the configuration could be applied.
+ *
+ * @since 0.6.2.0
+ */
+bool setVerifyBatching(SRxProxy* proxy, uint32_t maxRequests,
+                       uint32_t maxDelayMillis)
+{
+  return configureVerifyBatch((ClientConnectionHandler*)proxy->connHandler,
+                              maxRequests, maxDelayMillis);
+}
+
+/**
+ * Send all verify requests that are held back for batching right away.
+ *
+ * @param proxy The proxy instance
+ *
+ * @return true if the pending requests could be send.
+ *
+ * @since 0.6.2.0
+ */
+bool flushVerifyRequests(SRxProxy* proxy)
+{
+  return flushVerifyBatch((ClientConnectionHandler*)proxy->connHandler);
+}
+
 /**
  * This method generates a signature request. The signature will be returned
  * using the signature notification callback.
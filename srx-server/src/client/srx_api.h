@@ -23,10 +23,12 @@
  * Secure Routing extension (SRx) client API - This API provides a fully 
  * functional proxy client to the SRx server.
  *
- * Version 0.6.0.0
+ * Version 0.6.2.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Added setVerifyBatching and flushVerifyRequests.
  * 0.6.0.0  - 2021/02/26 - kyehwanl
  *            * Added ASPA validation to verify request using the 
  *              SRx-Proxy_Protocol version 2.
@@ -443,6 +445,38 @@ void verifyUpdate(SRxProxy* proxy, uint32_t localID,
                   IPPrefix* prefix, uint32_t as32,
                   BGPSecData* bgpsec, SRxASPathList asPathList);
 
+/**
+ * Coalesce the verify requests of verifyUpdate into batched verify request
+ * PDUs. A batch is send once it contains maxRequests requests or its oldest
+ * request waited maxDelayMillis milliseconds. All other requests send to the
+ * SRx server send the pending batch first. The SRx server MUST support
+ * batched verify requests (0.6.2.0 and later).
+ *
+ * @param proxy The proxy instance
+ * @param maxRequests The maximum number of verify requests per batch. A value
+ *                    less than 2 disables batching (default).
+ * @param maxDelayMillis The maximum time in milliseconds a verify request is
+ *                    held back. With 0 a batch is only send once it is full
+ *                    or flushVerifyRequests is called.
+ *
+ * @return true if the configuration could be applied.
+ *
+ * @since 0.6.2.0
+ */
+bool setVerifyBatching(SRxProxy* proxy, uint32_t maxRequests,
+                       uint32_t maxDelayMillis);
+
+/**
+ * Send all verify requests that are held back for batching right away.
+ *
+ * @param proxy The proxy instance
+ *
+ * @return true if the pending requests could be send.
+ *
+ * @since 0.6.2.0
+ */
+bool flushVerifyRequests(SRxProxy* proxy);
+
 /**
  * This method generates a signature request. The signature will be returned
  * using the signature notification callback.
@@ -20,12 +20,33 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * This file contains the ASPA trie.
+ * This file contains the ASPA database. The ASPA objects are stored in an 
+ * open addressing hash table (linear probing) keyed on the customer ASN.
  *
- * Version 0.6.1.2
+ * The table is versioned. Lookups read the published version without any 
+ * lock inside an epoch read section. Writers modify a private copy (pending)
+ * which replaces the published version in publishAspaDB, usually called
+ * with the RTR End of Data. Objects that are replaced or removed are freed
+ * once no reader can still access the old version.
+ *
+ * Version 0.6.2.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Record the customer ASNs changed since the last publish. The End
+ *             of Data processing re-validates only the AS paths that contain
+ *             one of them, process_ASPA_EndOfData_main is called per path.
+ *           * Removed the write lock from findAspaObject. Lookups are lock
+ *             free now, changes are published as a new table version.
+ *           * Replaced the decimal string trie with an integer keyed hash 
+ *             table. This removes the sprintf of the customer ASN from each
+ *             lookup and fixes the string buffers that were too small for
+ *             ASNs with more than 6 digits.
+ *           * Provider ASNs are sorted in newASPAObject and searched using a 
+ *             binary search in ASPA_DB_lookup.
+ *           * Fixed releaseAspaDBManager which released the lock before 
+ *             emptying the database.
  * 0.6.1.2 - 2021/11/18 - kyehwanl
  *           * Moved static declaration statement from .h into .c file 
  *         - 2021/11/12 - kyehwanl
@@ -51,14 +72,17 @@
 #include "server/rpki_queue.h"
 #include "util/log.h"
 
-static uint32_t countTrieNode =0;
-static TrieNode* newAspaTrie(void);
-static TrieNode* make_trienode(char data, char* userData, ASPA_Object* );
-static void free_trienode(TrieNode* node);
-static int search_trie(TrieNode* root, char* word);
 static void emptyAspaDB(ASPA_DBManager* self);
-
-int process_ASPA_EndOfData_main(void* uc, void* handler, uint32_t uid, uint32_t pid, time_t ct);
+static ASPA_DBTable* _newAspaTable(uint32_t tableSize);
+static void _freeAspaTable(ASPA_DBTable* table);
+static ASPA_DBTable* _getPendingTable(ASPA_DBManager* self);
+static uint32_t _findSlot(ASPA_DBTable* table, uint32_t customerAsn);
+static bool _growAspaTable(ASPA_DBTable* table);
+static void _removeSlot(ASPA_DBTable* table, uint32_t slot);
+static bool _retireAspaObject(ASPA_DBTable* table, ASPA_Object* obj);
+static bool _recordChange(ASPA_DBTable* table, uint32_t customerAsn);
+
+int process_ASPA_EndOfData_main(void* uc, void* handler, uint32_t pid, time_t ct);
 extern RPKI_QUEUE* getRPKIQueue();
 extern uint8_t validateASPA (PATH_LIST* asPathList, uint8_t length, AS_TYPE asType, 
                     AS_REL_DIR direction, uint8_t afi, ASPA_DBManager* aspaDBManager);
@@ -67,29 +91,62 @@ extern uint8_t validateASPA (PATH_LIST* asPathList, uint8_t length, AS_TYPE asTy
 //
 bool initializeAspaDBManager(ASPA_DBManager* aspaDBManager, Configuration* config) 
 {
-   aspaDBManager->tableRoot = newAspaTrie();
-   aspaDBManager->countAspaObj = 0;
-   aspaDBManager->config = config;
+   aspaDBManager->table   = _newAspaTable(ASPA_DB_INIT_SIZE);
+   aspaDBManager->pending = NULL;
+   aspaDBManager->config  = config;
    aspaDBManager->cbProcessEndOfData = process_ASPA_EndOfData_main;
   
-   if (!createRWLock(&aspaDBManager->tableLock))
+   if (aspaDBManager->table == NULL)
+   {
+     RAISE_ERROR("Unable to allocate the aspa object db");
+     return false;
+   }
+
+   if (!initMutex(&aspaDBManager->writeMutex))
    {
-     RAISE_ERROR("Unable to setup the aspa object db r/w lock");
+     RAISE_ERROR("Unable to setup the aspa object db write mutex");
+     return false;
+   }
+
+   if (!initEpochDomain(&aspaDBManager->readers))
+   {
+     RAISE_ERROR("Unable to setup the aspa object db readers");
      return false;
    }
 
   return true;
 }
 
-// delete all db
+// delete all db, no reader must be active anymore
 //
 static void emptyAspaDB(ASPA_DBManager* self)
 {
-  acquireWriteLock(&self->tableLock);
-  free_trienode(self->tableRoot);
-  self->tableRoot = NULL;
-  self->countAspaObj = 0;
-  unlockWriteLock(&self->tableLock);
+  ASPA_DBTable* table = NULL;
+  uint32_t      idx   = 0;
+
+  lockMutex(&self->writeMutex);
+  if (self->pending != NULL)
+  {
+    // The pending version holds all objects that are still in use
+    table = self->table;
+    self->table   = self->pending;
+    self->pending = NULL;
+    _freeAspaTable(table);
+  }
+  table = self->table;
+  self->table = NULL;
+  if (table != NULL)
+  {
+    for (idx = 0; idx < table->tableSize; idx++)
+    {
+      if (table->table[idx].aspaObject != NULL)
+      {
+        deleteASPAObject(self, table->table[idx].aspaObject);
+      }
+    }
+    _freeAspaTable(table);
+  }
+  unlockMutex(&self->writeMutex);
 }
 
 
@@ -99,20 +156,204 @@ void releaseAspaDBManager(ASPA_DBManager* self)
 {
   if (self != NULL)
   {
-    releaseRWLock(&self->tableLock);
     emptyAspaDB(self);
+    releaseEpochDomain(&self->readers);
+    releaseMutex(&self->writeMutex);
+  }
+}
+
+// hash of the customer ASN into a slot index (multiplicative hashing)
+//
+static inline uint32_t _hashAsn(uint32_t customerAsn, uint32_t tableSize)
+{
+  uint32_t hash = customerAsn * 0x9E3779B1;
+  return (hash ^ (hash >> 16)) & (tableSize - 1);
+}
+
+// allocate an empty table of the given size (power of 2)
+//
+static ASPA_DBTable* _newAspaTable(uint32_t tableSize)
+{
+  ASPA_DBTable* table = (ASPA_DBTable*)calloc(1, sizeof(ASPA_DBTable));
+  if (table == NULL)
+  {
+    return NULL;
+  }
+  table->table = (ASPA_DBEntry*)calloc(tableSize, sizeof(ASPA_DBEntry));
+  if (table->table == NULL)
+  {
+    free(table);
+    return NULL;
+  }
+  table->tableSize = tableSize;
+  return table;
+}
+
+// free the table version and all retired objects, not the stored objects
+//
+static void _freeAspaTable(ASPA_DBTable* table)
+{
+  uint32_t idx = 0;
+
+  for (idx = 0; idx < table->retiredCount; idx++)
+  {
+    if (table->retired[idx]->providerAsns)
+    {
+      free(table->retired[idx]->providerAsns);
+    }
+    free(table->retired[idx]);
+  }
+  free(table->retired);
+  free(table->changed);
+  free(table->table);
+  free(table);
+}
+
+// return the pending version, create it as copy of the published version if
+// needed. The caller must hold the write mutex.
+//
+static ASPA_DBTable* _getPendingTable(ASPA_DBManager* self)
+{
+  ASPA_DBTable* pending = self->pending;
+
+  if (pending == NULL)
+  {
+    pending = _newAspaTable(self->table->tableSize);
+    if (pending != NULL)
+    {
+      memcpy(pending->table, self->table->table, 
+             self->table->tableSize * sizeof(ASPA_DBEntry));
+      pending->countAspaObj = self->table->countAspaObj;
+      self->pending = pending;
+    }
+  }
+
+  return pending;
+}
+
+// remember an object that must not be freed before the version is published
+//
+static bool _retireAspaObject(ASPA_DBTable* table, ASPA_Object* obj)
+{
+  ASPA_Object** retired = NULL;
+
+  if (table->retiredCount == table->retiredSize)
+  {
+    retired = (ASPA_Object**)realloc(table->retired, 
+                 (table->retiredSize + 64) * sizeof(ASPA_Object*));
+    if (retired == NULL)
+    {
+      return false;
+    }
+    table->retired      = retired;
+    table->retiredSize += 64;
   }
+  table->retired[table->retiredCount++] = obj;
+
+  return true;
 }
 
+// remember the customer ASN of a modified object for the End of Data
+// processing
+//
+static bool _recordChange(ASPA_DBTable* table, uint32_t customerAsn)
+{
+  uint32_t* changed = NULL;
+
+  if (table->changedCount == table->changedSize)
+  {
+    changed = (uint32_t*)realloc(table->changed, 
+                 (table->changedSize + 64) * sizeof(uint32_t));
+    if (changed == NULL)
+    {
+      return false;
+    }
+    table->changed      = changed;
+    table->changedSize += 64;
+  }
+  table->changed[table->changedCount++] = customerAsn;
 
-// generate trie node
+  return true;
+}
+
+// find the slot of the customer ASN or the empty slot where it has to be 
+// inserted.
 //
-static TrieNode* newAspaTrie(void) 
+static uint32_t _findSlot(ASPA_DBTable* table, uint32_t customerAsn)
 {
-  TrieNode *rootNode = make_trienode('\0', NULL, NULL);
-  return rootNode;
+  uint32_t mask = table->tableSize - 1;
+  uint32_t slot = _hashAsn(customerAsn, table->tableSize);
+
+  while (table->table[slot].aspaObject != NULL
+         && table->table[slot].customerAsn != customerAsn)
+  {
+    slot = (slot + 1) & mask;
+  }
+
+  return slot;
 }
 
+// double the size of the (private) table and re-insert all objects. 
+//
+static bool _growAspaTable(ASPA_DBTable* table)
+{
+  ASPA_DBEntry* oldTable = table->table;
+  uint32_t      oldSize  = table->tableSize;
+  uint32_t      idx      = 0;
+
+  table->table = (ASPA_DBEntry*)calloc(oldSize << 1, sizeof(ASPA_DBEntry));
+  if (table->table == NULL)
+  {
+    RAISE_ERROR("Unable to grow the aspa object db to %u slots", oldSize << 1);
+    table->table = oldTable;
+    return false;
+  }
+  table->tableSize = oldSize << 1;
+
+  for (idx = 0; idx < oldSize; idx++)
+  {
+    if (oldTable[idx].aspaObject != NULL)
+    {
+      table->table[_findSlot(table, oldTable[idx].customerAsn)] = oldTable[idx];
+    }
+  }
+  free(oldTable);
+
+  return true;
+}
+
+// remove the entry in the given slot and shift the following entries of the
+// probe sequence back to keep the table free of tombstones.
+//
+static void _removeSlot(ASPA_DBTable* table, uint32_t slot)
+{
+  uint32_t mask = table->tableSize - 1;
+  uint32_t next = (slot + 1) & mask;
+  uint32_t home = 0;
+
+  while (table->table[next].aspaObject != NULL)
+  {
+    home = _hashAsn(table->table[next].customerAsn, table->tableSize);
+    // Move the entry if its home slot is not in the cyclic range (slot, next]
+    if (((next - home) & mask) >= ((next - slot) & mask))
+    {
+      table->table[slot] = table->table[next];
+      slot = next;
+    }
+    next = (next + 1) & mask;
+  }
+  table->table[slot].aspaObject  = NULL;
+  table->table[slot].customerAsn = 0;
+}
+
+// comparator for sorting provider ASNs
+//
+static int _cmpAsn(const void* asn1, const void* asn2)
+{
+  uint32_t a = *(const uint32_t*)asn1;
+  uint32_t b = *(const uint32_t*)asn2;
+  return (a > b) - (a < b);
+}
 
 // external api for creating db object
 //
@@ -132,6 +373,8 @@ ASPA_Object* newASPAObject(uint32_t cusAsn, uint16_t pAsCount, uint32_t* provAsn
     {
       obj->providerAsns[idx] = provAsns[idx];
     }
+    // Keep the providers sorted, this allows a binary search during lookup
+    qsort(obj->providerAsns, pAsCount, sizeof(uint32_t), _cmpAsn);
   }
   obj->afi = afi;
 
@@ -150,57 +393,11 @@ bool deleteASPAObject(ASPA_DBManager* self, ASPA_Object *obj)
       free(obj->providerAsns);
     }
     free (obj);
-    self->countAspaObj--;
     return true;
   }
   return false;
 }
 
-
-// create trie node
-//
-static TrieNode* make_trienode(char data, char* userData, ASPA_Object* obj) 
-{
-  // Index for loops
-  int idx = 0;
-  
-  // Allocate memory for a TrieNode
-  TrieNode* node = (TrieNode*) calloc (1, sizeof(TrieNode));
-  if (!node)
-  {
-    return NULL;
-  }
-
-  for (idx = 0; idx < N; idx++)
-      node->children[idx] = NULL;
-  
-  node->is_leaf = 0;
-  node->data = data;
-  node->userData = NULL;
-  node->aspaObjects = NULL;
-  
-  return node;
-}
-
-// free node
-static void free_trienode(TrieNode* node) 
-{
-  // Free the trienode sequence
-  int idx = 0;
-  for(idx = 0; idx < N; idx++) 
-  {
-    if (node->children[idx] != NULL) 
-    {
-      free_trienode(node->children[idx]);
-    }
-    else 
-    {
-      continue;
-    }
-  }
-  free(node);
-}
-
 bool compareAspaObject(ASPA_Object *obj1, ASPA_Object *obj2)
 {
   if (!obj1 || !obj2)
@@ -226,377 +423,345 @@ bool compareAspaObject(ASPA_Object *obj1, ASPA_Object *obj2)
 }
 
 
-
-bool delete_TrieNode_AspaObj (ASPA_DBManager* self, char* word, ASPA_Object* obj)
+// remove the stored object if it equals the given one (withdrawal). The 
+// change becomes visible with the next publishAspaDB.
+//
+bool delete_TrieNode_AspaObj (ASPA_DBManager* self, ASPA_Object* obj)
 {
   bool bRet = false;
-  int idx = 0;
+  uint32_t slot = 0;
+  ASPA_DBTable* pending = NULL;
 
-  acquireWriteLock(&self->tableLock);
-  TrieNode* temp = self->tableRoot; 
-  TrieNode* parent = NULL;
-  int position = 0;
-
-  // finding
-  for(idx = 0; word[idx] != '\0'; idx++)
+  lockMutex(&self->writeMutex);
+  pending = _getPendingTable(self);
+  if (pending != NULL)
   {
-    position = word[idx] - '0';
-    if (temp->children[position] == NULL)
+    slot = _findSlot(pending, obj->customerAsn);
+
+    // info compare
+    if (pending->table[slot].aspaObject 
+        && compareAspaObject(pending->table[slot].aspaObject, obj)
+        && _recordChange(pending, obj->customerAsn)
+        && _retireAspaObject(pending, pending->table[slot].aspaObject))
     {
-      temp = NULL;
-      break;
+      _removeSlot(pending, slot);
+      pending->countAspaObj--;
+      bRet = true;
     }
-    parent = temp;
-    temp = temp->children[position];
-  }
-
-  // info compare
-  if (temp && temp->is_leaf == 1 && temp->aspaObjects 
-      && compareAspaObject(temp->aspaObjects, obj))
-  {
-    deleteASPAObject(self, temp->aspaObjects);
-    free_trienode(temp);
-    temp = NULL;
-    parent->children[position] = NULL;
-    bRet = true;
   }
 
-  unlockWriteLock(&self->tableLock);
+  unlockMutex(&self->writeMutex);
 
   return bRet;
 }
 
-//  new value insert or substitution according to draft
+//  new value insert or substitution according to draft. The change becomes 
+//  visible with the next publishAspaDB.
 //
-TrieNode* insertAspaObj (ASPA_DBManager* self, char* word, char* userData, 
-                         ASPA_Object* obj) 
+ASPA_Object* insertAspaObj (ASPA_DBManager* self, ASPA_Object* obj) 
 {
-  TrieNode* temp = self->tableRoot; // start with root node
-  acquireWriteLock(&self->tableLock);
-  int i;
-  
-  for (i=0; word[i] != '\0'; i++) 
+  uint32_t slot = 0;
+  ASPA_DBTable* pending = NULL;
+
+  lockMutex(&self->writeMutex);
+  pending = _getPendingTable(self);
+
+  // Keep the load factor at or below 1/2 to keep the probe sequences short
+  if (pending == NULL || ((pending->countAspaObj + 1) * 2 > pending->tableSize
+                          && !_growAspaTable(pending)))
   {
-    int idx = (int) word[i] - '0';
-    //printf("index: %02x(%d), word[%d]: %c  \n", idx, idx, i, word[i]);
-    if (temp->children[idx] == NULL) {
-        // If the corresponding child doesn't exist, simply create that child!
-        temp->children[idx] = make_trienode(word[i], userData, obj);
-    }
-    else {
-        // Do nothing. The node already exists
-    }
-    // Go down a level, to the child referenced by idx
-    temp = temp->children[idx];
+    unlockMutex(&self->writeMutex);
+    return NULL;
   }
 
-  if (temp)
+  slot = _findSlot(pending, obj->customerAsn);
+
+  if (!_recordChange(pending, obj->customerAsn))
   {
-    // At the end of the word, mark this node as the leaf node
-    temp->is_leaf = 1;
-    temp->userData =  userData;
+    unlockMutex(&self->writeMutex);
+    return NULL;
+  }
 
-    // substitution if exist
-    if (temp->aspaObjects && temp->aspaObjects != obj)
+  // substitution if exist
+  if (pending->table[slot].aspaObject == NULL)
+  {
+    pending->countAspaObj++;
+  }
+  else if (pending->table[slot].aspaObject != obj)
+  {
+    if (!_retireAspaObject(pending, pending->table[slot].aspaObject))
     {
-      deleteASPAObject(self, temp->aspaObjects);
-      countTrieNode--;
+      unlockMutex(&self->writeMutex);
+      return NULL;
     }
-    temp->aspaObjects = obj;
-    countTrieNode++;
-    self->countAspaObj++;
   }
+  pending->table[slot].customerAsn = obj->customerAsn;
+  pending->table[slot].aspaObject  = obj;
 
-  unlockWriteLock(&self->tableLock);
+  unlockMutex(&self->writeMutex);
 
-  return temp;
-}
-
-// get total count
-//
-uint32_t getCountTrieNode(void)
-{
-  return countTrieNode;
+  return obj;
 }
 
-// search method
+// make all changes visible to the readers. Returns false if there was 
+// nothing to publish. If changedAsns is not NULL it receives the distinct 
+// customer ASNs modified since the last publish (to be freed by the caller).
 //
-static int search_trie(TrieNode* root, char* word)
+bool publishAspaDB(ASPA_DBManager* self, uint32_t** changedAsns, 
+                   uint32_t* changedCount)
 {
-    // Searches for word in the Trie
-    TrieNode* temp = root;
-    int i=0;
-    for(i=0; word[i]!='\0'; i++)
-    {
-        int position = word[i] - '0';
-        if (temp->children[position] == NULL)
-            return 0;
-        temp = temp->children[position];
-    }
-    if (temp != NULL && temp->is_leaf == 1)
-        return 1;
-    return 0;
-}
+  ASPA_DBTable* oldTable = NULL;
+  ASPA_DBTable* newTable = NULL;
+  uint32_t      idx      = 0;
+  uint32_t      count    = 0;
 
-// external api for searching trie
-//
-ASPA_Object* findAspaObject(ASPA_DBManager* self, char* word)
-{
-    ASPA_Object *obj=NULL;
-  
-    acquireWriteLock(&self->tableLock);
-    TrieNode* temp = self->tableRoot; 
+  if (changedAsns != NULL)
+  {
+    *changedAsns  = NULL;
+    *changedCount = 0;
+  }
 
-    int i;
-    for(i=0; word[i]!='\0'; i++)
+  lockMutex(&self->writeMutex);
+  newTable = self->pending;
+  if (newTable != NULL)
+  {
+    oldTable = self->table;
+    __atomic_store_n(&self->table, newTable, __ATOMIC_SEQ_CST);
+    self->pending = NULL;
+
+    // Wait until no reader can access the old version anymore
+    synchronizeEpoch(&self->readers);
+
+    // Now the replaced objects can be freed as well
+    oldTable->retired      = newTable->retired;
+    oldTable->retiredCount = newTable->retiredCount;
+    newTable->retired      = NULL;
+    newTable->retiredCount = 0;
+    newTable->retiredSize  = 0;
+    _freeAspaTable(oldTable);
+
+    // Hand over the distinct customer ASNs that changed
+    if (changedAsns != NULL && newTable->changedCount > 0)
     {
-        int position = word[i] - '0';
-        if (temp->children[position] == NULL)
+      qsort(newTable->changed, newTable->changedCount, sizeof(uint32_t), 
+            _cmpAsn);
+      for (idx = 1, count = 1; idx < newTable->changedCount; idx++)
+      {
+        if (newTable->changed[idx] != newTable->changed[count-1])
         {
-          obj = NULL;
-          temp = NULL;
-          break;
+          newTable->changed[count++] = newTable->changed[idx];
         }
-        temp = temp->children[position];
+      }
+      *changedAsns  = newTable->changed;
+      *changedCount = count;
+      newTable->changed = NULL;
     }
+    free(newTable->changed);
+    newTable->changed      = NULL;
+    newTable->changedCount = 0;
+    newTable->changedSize  = 0;
 
-    if (temp != NULL && temp->is_leaf == 1)
-    {
-        obj = temp->aspaObjects;
-    }
-    unlockWriteLock(&self->tableLock);
+    LOG(LEVEL_INFO, "[db] Published ASPA DB with %u objects", 
+                    newTable->countAspaObj);
+  }
+  unlockMutex(&self->writeMutex);
 
-    return obj;
+  return newTable != NULL;
 }
 
+// external api for searching the db. The caller must be within an epoch read
+// section of the ASPA DB (readers) for as long as the object is used.
 //
-//  print all nodes
-//
-TrieNode* printAllLeafNode(TrieNode *node)
+ASPA_Object* findAspaObject(ASPA_DBManager* self, uint32_t customerAsn)
 {
-  TrieNode* leaf = NULL;
-  uint8_t count=0;
+    ASPA_DBTable* table = __atomic_load_n(&self->table, __ATOMIC_SEQ_CST);
 
-  if (node->is_leaf == 1)
-  {
-    leaf = node;
-    return leaf;
-  }
+    return table->table[_findSlot(table, customerAsn)].aspaObject;
+}
+
+//
+//  print all objects
+//
+void printAllAspaObjects(ASPA_DBManager* self)
+{
+  uint32_t count = 0;
+  uint32_t idx   = 0;
+  ASPA_DBTable* table = NULL;
 
-  int childIdx;
-  for (childIdx = 0; childIdx < N; childIdx++) 
+  enterEpoch(&self->readers);
+  table = __atomic_load_n(&self->table, __ATOMIC_SEQ_CST);
+  for (idx = 0; idx < table->tableSize; idx++)
   {
-    if(node->children[childIdx])
+    ASPA_Object *obj = table->table[idx].aspaObject;
+    if (obj)
     {
-      leaf = printAllLeafNode(node->children[childIdx]);
-      if (leaf)
+      printf("\n++ count: %u, ASPA object:%p \n", ++count, obj);
+      printf("++ customer ASN: %u\n", obj->customerAsn);
+      printf("++ providerAsCount : %d\n", obj->providerAsCount);
+      printf("++ Address: provider asns : %p\n", obj->providerAsns);
+      if (obj->providerAsns)
       {
-        //printf("++ count: %d i:%d digit: %c user data: %s\n", ++count, i, leaf->data, leaf->userData);
-        printf("\n++ count: %d, user data: %s, ASPA object:%p \n", 
-            ++count, leaf->userData, leaf->aspaObjects);
-
-        ASPA_Object *obj = leaf->aspaObjects;
-        if (obj)
-        {
-          printf("++ customer ASN: %d\n", obj->customerAsn);
-          printf("++ providerAsCount : %d\n", obj->providerAsCount);
-          printf("++ Address: provider asns : %p\n", obj->providerAsns);
-          if (obj->providerAsns)
-          {
-            int pIdx;
-            for(pIdx = 0; pIdx < obj->providerAsCount; pIdx++)
-              printf("++ providerAsns[%d]: %d\n", pIdx, obj->providerAsns[pIdx]);
-          }
-          printf("++ afi: %d\n", obj->afi);
-        }
+        int pIdx;
+        for(pIdx = 0; pIdx < obj->providerAsCount; pIdx++)
+          printf("++ providerAsns[%d]: %u\n", pIdx, obj->providerAsns[pIdx]);
       }
+      printf("++ afi: %d\n", obj->afi);
     }
   }
-
-  return NULL;
+  leaveEpoch(&self->readers);
 }
 
+// binary search within the sorted provider list
+//
+static bool _hasProvider(ASPA_Object* obj, uint32_t providerAsn)
+{
+  int low  = 0;
+  int high = obj->providerAsCount - 1;
+  int mid  = 0;
 
-
-void print_trie(TrieNode* root) {/*{{{*/
-    // Prints the nodes of the trie
-    if (!root)
-        return;
-    TrieNode* temp = root;
-    printf("%c -> ", temp->data);
-    int i=0;
-    for (i=0; i<N; i++) {
-        print_trie(temp->children[i]);
+  while (low <= high)
+  {
+    mid = low + ((high - low) >> 1);
+    if (obj->providerAsns[mid] == providerAsn)
+    {
+      return true;
+    }
+    if (obj->providerAsns[mid] < providerAsn)
+    {
+      low = mid + 1;
     }
-}
-
-void print_search(TrieNode* root, char* word) {
-    printf("Searching for %s: ", word);
-    if (search_trie(root, word) == 0)
-        printf("Not Found\n");
     else
-        printf("Found!\n");
-}/*}}}*/
+    {
+      high = mid - 1;
+    }
+  }
+
+  return false;
+}
 
 // 
 // external API for db loopkup
 //
-#define MAX_ASN_LENGTH 7
 ASPA_ValidationResult ASPA_DB_lookup(ASPA_DBManager* self, uint32_t customerAsn, 
                                      uint32_t providerAsn, uint8_t afi )
 {
   LOG(LEVEL_DEBUG, FILE_LINE_INFO " ASPA DB Lookup called");
 
-  char strCusAsn[MAX_ASN_LENGTH] = {};
-  sprintf(strCusAsn, "%d", customerAsn);  
+  ASPA_ValidationResult result = ASPA_RESULT_UNDEFINED;
 
-  ASPA_Object *obj = findAspaObject(self, strCusAsn);
+  enterEpoch(&self->readers);
+  ASPA_Object *obj = findAspaObject(self, customerAsn);
 
   if (!obj) // if there is no object item
   {
     LOG(LEVEL_INFO, "[db] No customer ASN exist -- Unknown");
-    return ASPA_RESULT_UNKNOWN;
+    result = ASPA_RESULT_UNKNOWN;
   }
   else // found object
   {
-    LOG(LEVEL_INFO, "[db] customer ASN: %d", obj->customerAsn);
+    LOG(LEVEL_INFO, "[db] customer ASN: %u", obj->customerAsn);
     LOG(LEVEL_INFO, "[db] providerAsCount : %d", obj->providerAsCount);
     LOG(LEVEL_INFO, "[db] Address: provider asns : %p", obj->providerAsns);
     LOG(LEVEL_INFO, "[db] afi: %d", obj->afi);
 
     if (obj->providerAsns)
     {
-      int idx = 0;
-      
-      for (idx = 0; idx < obj->providerAsCount; idx++)
+      if (obj->afi == afi && _hasProvider(obj, providerAsn))
       {
-        LOG(LEVEL_INFO, "[db] providerAsns[%d]: %d", idx, 
-                        obj->providerAsns[idx]);
-        if (obj->providerAsns[idx] == providerAsn && obj->afi == afi)
-        {
-          LOG(LEVEL_INFO, "[db] Matched -- Valid");
-          return ASPA_RESULT_VALID;
-        }
+        LOG(LEVEL_INFO, "[db] Matched -- Valid");
+        result = ASPA_RESULT_VALID;
+      }
+      else
+      {
+        LOG(LEVEL_INFO, "[db] No Matched -- Invalid");
+        result = ASPA_RESULT_INVALID;
       }
-  
-      LOG(LEVEL_INFO, "[db] No Matched -- Invalid");
-      return ASPA_RESULT_INVALID;
     }
   }
-  return ASPA_RESULT_UNDEFINED;
+  leaveEpoch(&self->readers);
 
+  return result;
 }
 
-int process_ASPA_EndOfData_main(void* uc, void* handler, uint32_t uid, 
-                                uint32_t pid, time_t ct)
+// re-validate the AS path with the given path ID against the published ASPA
+// DB and hand the result over to all updates that use this path. Called once 
+// per affected path after End of Data.
+//
+int process_ASPA_EndOfData_main(void* uc, void* handler, uint32_t pid, 
+                                time_t ct)
 {
   SRxResult        srxRes;
   SRxDefaultResult defaultRes;
-  time_t lastEndOfDataTime = ct;
 
   UpdateCache*  uCache      = (UpdateCache*)uc;
-  SRxUpdateID   updateID    = (SRxUpdateID) uid;
-  uint32_t      pathId      = 0;
+  SRxUpdateID   updateID    = 0;
+  SRxUpdateID*  updateIDs   = NULL;
+  uint32_t      count       = 0;
+  uint32_t      idx         = 0;
+  uint32_t      pathId      = pid;
   RPKIHandler*  rpkiHandler = (RPKIHandler*)handler;
+  RPKI_QUEUE*   rQueue      = getRPKIQueue();
 
   LOG(LEVEL_INFO, "=== main process_main_ASPA_EndOfData UpdateCache:%p rpkiHandler:%p ctime:%u", 
       (UpdateCache*)uCache, (RPKIHandler*)rpkiHandler, ct);
 
+  srxRes.aspaResult = SRx_RESULT_UNDEFINED;
+  AS_PATH_LIST *aspl = getAspathListFromAspathCache (rpkiHandler->aspathCache, pathId, &srxRes);
 
-  if (!getUpdateResult(uCache, &updateID, 0, NULL, &srxRes, &defaultRes, &pathId))
+  if (!aspl)
   {
-    LOG(LEVEL_WARNING, "Update ID: 0x%08X not found ", updateID);
+    LOG(LEVEL_WARNING, "AS Path List 0x%08X is not found!", pathId);
     return 0;
   }
-  else
-  {
-    ASPA_DBManager* aspaDBManager = rpkiHandler->aspaDBManager;
-    TrieNode *root = aspaDBManager->tableRoot;
-
-    LOG(LEVEL_INFO, "Update ID: 0x%08X  Path ID: 0x%08X", updateID, pathId);
-
-    uint8_t old_aspaResult = srxRes.aspaResult; // obtained from getUpdateResult above
-    AS_PATH_LIST *aspl = getAspathListFromAspathCache (rpkiHandler->aspathCache, pathId, &srxRes);
-
-    if (aspl)
-    {
-      uint8_t afi = aspl->afi;  
-      if (aspl->afi == 0 || aspl->afi > 2) // if more than 2 (AFI_IP6)
-        afi = AFI_IP;                      // set default
-
 
-      LOG(LEVEL_INFO, "Comparison End of Data time(%u) : AS cache entry updated time (%u)",
-          lastEndOfDataTime, aspl->lastModified);
-      // timestamp comparison
-      //
-      if (lastEndOfDataTime > aspl->lastModified)
-      {
-        // call ASPA validation
-        //
-        uint8_t valResult = validateASPA (aspl->asPathList, 
-            aspl->asPathLength, aspl->asType, aspl->asRelDir, afi, aspaDBManager);
+  uint8_t afi = aspl->afi;  
+  if (aspl->afi == 0 || aspl->afi > 2) // if more than 2 (AFI_IP6)
+    afi = AFI_IP;                      // set default
 
-        LOG(LEVEL_INFO, FILE_LINE_INFO "\033[92m"" Validation Result: %d "
-            "(0:v, 2:Iv, 3:Ud 4:DNU 5:Uk, 6:Uf)""\033[0m", valResult);
+  // call ASPA validation
+  //
+  uint8_t valResult = validateASPA (aspl->asPathList, 
+      aspl->asPathLength, aspl->asType, aspl->asRelDir, afi, 
+      rpkiHandler->aspaDBManager);
 
-        // update the last validation time regardless of changed or not
-        time_t cTime = time(NULL);
-        aspl->lastModified = cTime;
+  LOG(LEVEL_INFO, FILE_LINE_INFO "\033[92m"" Path ID: 0x%08X Validation Result: %d "
+      "(0:v, 2:Iv, 3:Ud 4:DNU 5:Uk, 6:Uf)""\033[0m", pathId, valResult);
 
-        // modify Aspath Cache with the validation result
-        modifyAspaValidationResultToAspathCache (rpkiHandler->aspathCache, pathId, valResult, aspl);
+  // update the last validation time regardless of changed or not
+  aspl->lastModified = ct;
 
-        // modify UpdateCache data and enqueue as well
-        if (valResult != aspl->aspaValResult)
-        {
-          aspl->aspaValResult = valResult;
-          srxRes.aspaResult = valResult;
-
-          // UpdateCache change
-          modifyUpdateCacheResultWithAspaVal(uCache, &updateID, &srxRes);
-
-          // if different values, queuing
-          RPKI_QUEUE*      rQueue = getRPKIQueue();
-          rq_queue(rQueue, RQ_ASPA, &updateID);
-          LOG(LEVEL_INFO, "rpki queuing for aspa validation [uID:0x%08X]", updateID);
-        }
-      }
-      //
-      // in case there is another update cache entry whose path id is same with the previous
-      // This prevents from doing ASPA validation repeatedly with the same AS path list
-      //
-      else /* if else time comparison */
-      {
-        // update cache entry with the new value 
-        if (old_aspaResult != aspl->aspaValResult)
-        {
-          LOG(LEVEL_INFO, FILE_LINE_INFO " ASPA validation result already set and "
-              " the existed validation result [%d] in UpdateCache is being updated with a new result[%d]", 
-              old_aspaResult, aspl->aspaValResult);
-          srxRes.aspaResult = aspl->aspaValResult;
-
-          // modify UpdateCache data as well
-          modifyUpdateCacheResultWithAspaVal(uCache, &updateID, &srxRes);
-
-          // if different values, queuing
-          RPKI_QUEUE*      rQueue = getRPKIQueue();
-          rq_queue(rQueue, RQ_ASPA, &updateID);
-          LOG(LEVEL_INFO, "rpki queuing for aspa validation [uID:0x%08X]", updateID);
-        }
-      }
+  // modify Aspath Cache with the validation result
+  modifyAspaValidationResultToAspathCache (rpkiHandler->aspathCache, pathId, valResult, aspl);
+  deleteAspathListEntry(aspl);
 
-    }
-    else /* no aspath list */
+  // modify the UpdateCache data of all updates with this path and enqueue 
+  // those that changed
+  count = getUpdateIDsOfPath(uCache, pathId, &updateIDs);
+  for (idx = 0; idx < count; idx++)
+  {
+    updateID = updateIDs[idx];
+    if (!getUpdateResult(uCache, &updateID, 0, NULL, &srxRes, &defaultRes, NULL))
     {
-      LOG(LEVEL_WARNING, "Update 0x%08X is registered for ASPA but the "
-          "AS Path List is not found!", updateID);
-    } // end of if aspl
+      LOG(LEVEL_WARNING, "Update ID: 0x%08X not found ", updateID);
+      continue;
+    }
 
-    if (aspl)
-      free (aspl);
+    if (srxRes.aspaResult != valResult)
+    {
+      srxRes.aspaResult = valResult;
 
-  }// end of else
+      // UpdateCache change
+      modifyUpdateCacheResultWithAspaVal(uCache, &updateID, &srxRes);
 
+      // if different values, queuing
+      rq_queue(rQueue, RQ_ASPA, &updateID);
+      LOG(LEVEL_INFO, "rpki queuing for aspa validation [uID:0x%08X]", updateID);
+    }
+  }
+  if (updateIDs)
+  {
+    free (updateIDs);
+  }
 
   return 1;
 }
@@ -20,12 +20,28 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * This file contains the ASPA trie header information.
+ * This file contains the ASPA database header information. Despite the file
+ * name the ASPA objects are no longer kept in a decimal trie but in an open 
+ * addressing hash table that is keyed directly on the 32 bit customer ASN.
+ * Lookups are lock free. Changes received via RTR are applied to a private 
+ * copy of the table which is published atomically with publishAspaDB.
  *
- * Version 0.6.1.2
+ * Version 0.6.2.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Added ASPA_DBTable and versioned the ASPA database. Readers 
+ *             use epoch based reclamation instead of the table lock.
+ *           * Added publishAspaDB.
+ *           * The customer ASNs modified since the last publishAspaDB are 
+ *             recorded and returned by publishAspaDB.
+ *           * cbProcessEndOfData processes one AS path instead of one update.
+ *           * Replaced the 10-ary decimal string trie with an integer keyed
+ *             hash table. Provider ASNs are kept sorted.
+ *           * Modified insertAspaObj, findAspaObject, delete_TrieNode_AspaObj
+ *             to use the customer ASN as key instead of a decimal string.
+ *           * Replaced printAllLeafNode with printAllAspaObjects.
  * 0.6.1.2 - 2021/11/18 - kyehwanl
  *           * Moved static declaration statement from .h into .c file 
  * 0.6.0.0  - 2021/02/26 - kyehwanl
@@ -37,53 +53,61 @@
 #include <stdint.h>
 #include "shared/srx_defs.h"
 #include "server/configuration.h"
+#include "util/epoch.h"
 #include "util/mutex.h"
-#include "util/rwlock.h"
 
-// The number of children for each node
-// We will construct a N-ary tree and make it a Trie
-#define N 10
+/** The initial number of slots of the ASPA table (must be a power of 2) */
+#define ASPA_DB_INIT_SIZE 1024
 
 typedef struct {
   uint32_t customerAsn; 
   uint16_t providerAsCount;
-  uint32_t *providerAsns;
+  uint32_t *providerAsns;  // Sorted in ascending order
   uint16_t afi;
 } ASPA_Object;
 
+/** A single slot of the ASPA table. The slot is empty if aspaObject is NULL */
+typedef struct {
+  uint32_t     customerAsn;
+  ASPA_Object* aspaObject;
+} ASPA_DBEntry;
 
-typedef struct TrieNode TrieNode;
-struct TrieNode {
-    // The Trie Node Structure
-    // Each node has N children, starting from the root
-    // and a flag to check if it's a leaf node
-    char data; // Storing for printing purposes only
-    TrieNode* children[N];
-    int is_leaf;
-    void *userData;
-    ASPA_Object *aspaObjects;
-};
-
+/** One version of the ASPA table. A published version is never modified. */
 typedef struct {
-  TrieNode*         tableRoot;
+  ASPA_DBEntry*     table;      // Open addressing, linear probing
+  uint32_t          tableSize;  // Number of slots, always a power of 2
   uint32_t          countAspaObj;
+  ASPA_Object**     retired;    // Objects replaced or removed in this version
+  uint32_t          retiredCount;
+  uint32_t          retiredSize;
+  uint32_t*         changed;    // Customer ASNs modified in this version
+  uint32_t          changedCount;
+  uint32_t          changedSize;
+} ASPA_DBTable;
+
+typedef struct {
+  ASPA_DBTable*     table;   // The published version, read lock free
+  ASPA_DBTable*     pending; // The version under construction, NULL if none
+  EpochDomain       readers; // Readers of the published version
   Configuration*    config;  // The system configuration
-  RWLock            tableLock;
+  Mutex             writeMutex; // Serializes all writers
+  // Re-validates one AS path and its updates after End of Data
   int (*cbProcessEndOfData)(void* uCache, void* rpkiHandler, 
-                            uint32_t uid, uint32_t pid, time_t ct);
+                            uint32_t pid, time_t ct);
 } ASPA_DBManager;
 
 
-TrieNode* insertAspaObj(ASPA_DBManager* self, char* word, char* userData, ASPA_Object* obj);
-void print_trie(TrieNode* root);
 bool initializeAspaDBManager(ASPA_DBManager* aspaDBManager, Configuration* config);
-ASPA_Object* findAspaObject(ASPA_DBManager* self, char* word);
-void print_search(TrieNode* root, char* word);
+void releaseAspaDBManager(ASPA_DBManager* self);
+ASPA_Object* insertAspaObj(ASPA_DBManager* self, ASPA_Object* obj);
+ASPA_Object* findAspaObject(ASPA_DBManager* self, uint32_t customerAsn);
 bool deleteASPAObject(ASPA_DBManager* self, ASPA_Object *obj);
 ASPA_Object* newASPAObject(uint32_t cusAsn, uint16_t pAsCount, uint32_t* provAsns, uint16_t afi);
 ASPA_ValidationResult ASPA_DB_lookup(ASPA_DBManager* self, uint32_t customerAsn, uint32_t providerAsn, uint8_t afi);
-TrieNode* printAllLeafNode(TrieNode *node);
-bool delete_TrieNode_AspaObj (ASPA_DBManager* self, char* word, ASPA_Object* obj);
+void printAllAspaObjects(ASPA_DBManager* self);
+bool delete_TrieNode_AspaObj (ASPA_DBManager* self, ASPA_Object* obj);
+bool publishAspaDB(ASPA_DBManager* self, uint32_t** changedAsns, 
+                   uint32_t* changedCount);
 
 
 
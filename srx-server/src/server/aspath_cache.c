@@ -22,10 +22,18 @@
  *
  * This file contains the AS-Path Cache.
  *
- * Version 0.6.1.0
+ * Version 0.6.2.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Added a reverse index from each AS number to the paths that
+ *             contain it and the function getAspathIdsOfAsns.
+ *           * makePathId hashes the binary AS path using CRC32C instead of
+ *             printing it as hex string first.
+ *           * Allocate cache entries, AS_PATH_LIST instances and AS path
+ *             lists from slab pools.
+ *           * deleteAspathCache releases the memory of the deleted entry.
  * 0.6.1.0 - 2021/08/27 - kyehwanl
  *           * Added additional error condition
  * 0.6.0.0 - 2021/03/31 - oborchert
@@ -35,9 +43,12 @@
  */
 #include <uthash.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 #include "server/aspath_cache.h"
 #include "shared/crc32.h"
 #include "util/log.h"
+#include "util/slab.h"
 
 #define HDR "([0x%08X] AspathCache): "
 
@@ -53,6 +64,22 @@ typedef struct {
   time_t            lastModified;
 } PathListCacheTable;
 
+// The paths an AS number is part of (reverse index)
+typedef struct {
+
+  UT_hash_handle    hh;            // The hash table where this entry is stored
+  uint32_t          asn;
+  uint32_t*         pathIds;
+  uint32_t          count;
+  uint32_t          size;
+} AsnPathIndex;
+
+// The pools of the cache entries and of the AS_PATH_LIST instances
+static SlabPool _entryPool = SLAB_POOL_INITIALIZER("aspath-cache-entry",
+                                                   sizeof(PathListCacheTable));
+static SlabPool _listPool  = SLAB_POOL_INITIALIZER("aspath-list",
+                                                   sizeof(AS_PATH_LIST));
+
 
 //
 // To let main call this function to generate UT hash
@@ -68,6 +95,7 @@ bool createAspathCache(AspathCache* self, ASPA_DBManager* aspaDBManager)
   // By default keep the hashtable null, it will be initialized with the first
   // element that will be added.
   self->aspathCacheTable = NULL;
+  self->asnIndex = NULL;
   self->aspaDBManager = aspaDBManager;
  
   return true;
@@ -87,17 +115,114 @@ void releaseAspathCache(AspathCache* self)
 
 void emptyAspathCache(AspathCache* self)
 {
+  AsnPathIndex *asnEntry, *tmp;
+
   acquireWriteLock(&self->tableLock);
   self->aspathCacheTable = NULL;
+  HASH_ITER(hh, (AsnPathIndex*)self->asnIndex, asnEntry, tmp)
+  {
+    HASH_DEL(*((AsnPathIndex**)&self->asnIndex), asnEntry);
+    free(asnEntry->pathIds);
+    free(asnEntry);
+  }
+  self->asnIndex = NULL;
   unlockWriteLock(&self->tableLock);
 
 }
 
+// register the path with each distinct AS number of the path. 
+// The caller must hold the write lock
+//
+static void index_AspathList (AspathCache *self, PathListCacheTable *cacheTable)
+{
+  AsnPathIndex *asnEntry;
+  uint32_t     *pathIds;
+  uint32_t     asn;
+  int idx, prev;
+
+  for (idx = 0; idx < cacheTable->data.hops; idx++)
+  {
+    asn = cacheTable->data.asPathList[idx];
+
+    // skip prepended or otherwise repeated AS numbers
+    for (prev = 0; prev < idx && cacheTable->data.asPathList[prev] != asn; prev++);
+    if (prev < idx)
+    {
+      continue;
+    }
+
+    HASH_FIND(hh, (AsnPathIndex*)self->asnIndex, &asn, sizeof(uint32_t), asnEntry);
+    if (!asnEntry)
+    {
+      asnEntry = (AsnPathIndex*) calloc(1, sizeof(AsnPathIndex));
+      if (!asnEntry)
+      {
+        RAISE_ERROR("memory allocation error for the AS path index");
+        return;
+      }
+      asnEntry->asn = asn;
+      HASH_ADD (hh, *((AsnPathIndex**)&self->asnIndex), asn, sizeof(uint32_t), asnEntry);
+    }
+
+    if (asnEntry->count == asnEntry->size)
+    {
+      pathIds = (uint32_t*) realloc(asnEntry->pathIds, 
+                                    (asnEntry->size + 8) * sizeof(uint32_t));
+      if (!pathIds)
+      {
+        RAISE_ERROR("memory allocation error for the AS path index");
+        return;
+      }
+      asnEntry->pathIds = pathIds;
+      asnEntry->size   += 8;
+    }
+    asnEntry->pathIds[asnEntry->count++] = cacheTable->pathId;
+  }
+}
+
+// remove the path from the index of each of its AS numbers. 
+// The caller must hold the write lock
+//
+static void unindex_AspathList (AspathCache *self, PathListCacheTable *cacheTable)
+{
+  AsnPathIndex *asnEntry;
+  uint32_t     asn;
+  int idx, pos;
+
+  for (idx = 0; idx < cacheTable->data.hops; idx++)
+  {
+    asn = cacheTable->data.asPathList[idx];
+    HASH_FIND(hh, (AsnPathIndex*)self->asnIndex, &asn, sizeof(uint32_t), asnEntry);
+    if (!asnEntry)
+    {
+      // repeated AS number, already removed
+      continue;
+    }
+
+    for (pos = 0; pos < asnEntry->count; pos++)
+    {
+      if (asnEntry->pathIds[pos] == cacheTable->pathId)
+      {
+        asnEntry->pathIds[pos] = asnEntry->pathIds[--asnEntry->count];
+        break;
+      }
+    }
+
+    if (asnEntry->count == 0)
+    {
+      HASH_DEL(*((AsnPathIndex**)&self->asnIndex), asnEntry);
+      free(asnEntry->pathIds);
+      free(asnEntry);
+    }
+  }
+}
+
 static void add_AspathList (AspathCache *self, PathListCacheTable *cacheTable)
 {
 
   acquireWriteLock(&self->tableLock);
   HASH_ADD (hh, *((PathListCacheTable**)&self->aspathCacheTable), pathId, sizeof(uint32_t), cacheTable);
+  index_AspathList(self, cacheTable);
   unlockWriteLock(&self->tableLock);
 
 }
@@ -112,14 +237,6 @@ static bool find_AspathList (AspathCache* self, uint32_t pathId, PathListCacheTa
 }
 
 
-static void del_AspathList (AspathCache* self, PathListCacheTable *cacheTable)
-{
-  acquireWriteLock(&self->tableLock);
-  HASH_DEL (*((PathListCacheTable**)&self->aspathCacheTable), cacheTable);
-  unlockWriteLock(&self->tableLock);
-}
-
-
 AS_PATH_LIST* newAspathListEntry (uint32_t length, uint32_t* pathData, uint32_t pathId, AS_TYPE asType, 
                                   AS_REL_DIR asRelDir, uint16_t afi, bool bBigEndian)
 {
@@ -130,10 +247,18 @@ AS_PATH_LIST* newAspathListEntry (uint32_t length, uint32_t* pathData, uint32_t
   }
 
   AS_PATH_LIST* pAspathList; 
-  pAspathList   = (AS_PATH_LIST*)calloc(1, sizeof(AS_PATH_LIST));
+  pAspathList   = (AS_PATH_LIST*)allocFromSlab(&_listPool);
+  if (!pAspathList)
+  {
+    LOG(LEVEL_ERROR, "memory allocation error");
+    return NULL;
+  }
+  memset(pAspathList, 0, sizeof(AS_PATH_LIST));
   pAspathList->pathID       = pathId;
   pAspathList->asPathLength = length;
-  pAspathList->asPathList   = (uint32_t*)calloc(length, sizeof(uint32_t));
+  // the list is released using asPathLength, keep both the same
+  length                    = pAspathList->asPathLength;
+  pAspathList->asPathList   = (uint32_t*)allocSlabData(length * sizeof(uint32_t));
   pAspathList->asType       = asType;
   pAspathList->asRelDir     = asRelDir;
   pAspathList->afi          = bBigEndian ? ntohs(afi): afi;
@@ -191,10 +316,10 @@ bool deleteAspathListEntry (AS_PATH_LIST* aspl)
 
   if (aspl->asPathList)
   {
-    free(aspl->asPathList);
+    freeSlabData(aspl->asPathList, aspl->asPathLength * sizeof(uint32_t));
   }
 
-  free(aspl);
+  freeToSlab(&_listPool, aspl);
 
   return true;
 }
@@ -250,7 +375,13 @@ int storeAspathList (AspathCache* self, SRxDefaultResult* srxRes,
   }
   else
   {
-    plCacheTable = (PathListCacheTable*) calloc(1, sizeof(PathListCacheTable));
+    plCacheTable = (PathListCacheTable*) allocFromSlab(&_entryPool);
+    if (!plCacheTable)
+    {
+      LOG(LEVEL_ERROR, "memory allocation error");
+      return -1;
+    }
+    memset(plCacheTable, 0, sizeof(PathListCacheTable));
     plCacheTable->pathId       = pathId;
     plCacheTable->asType       = asType;
     plCacheTable->asRelDir     = pathlistEntry->asRelDir;
@@ -265,7 +396,7 @@ int storeAspathList (AspathCache* self, SRxDefaultResult* srxRes,
     if ( length > 0 && pathlistEntry->asPathList)
     {
       int idx;
-      plCacheTable->data.asPathList = (PATH_LIST*) calloc(length, sizeof(PATH_LIST));
+      plCacheTable->data.asPathList = (PATH_LIST*) allocSlabData(length * sizeof(PATH_LIST));
       for (idx = 0; idx < length; idx++)
       {
         plCacheTable->data.asPathList[idx] = pathlistEntry->asPathList[idx];
@@ -286,24 +417,38 @@ int storeAspathList (AspathCache* self, SRxDefaultResult* srxRes,
 }
 
 
-// delete function for calling del_AspathList to remove the cache data
+// delete the cache entry of the path and release its memory. The entry is
+// searched and removed under one write lock, concurrent deletes of the same
+// path are therefore safe.
 //
 bool deleteAspathCache(AspathCache* self, uint32_t pathId, AS_PATH_LIST* pathlistEntry)
 {
-  bool bRet= false;
-  PathListCacheTable *plCacheTable;
-  
-  if (find_AspathList (self, pathId, &plCacheTable))
+  PathListCacheTable *plCacheTable = NULL;
+
+  acquireWriteLock(&self->tableLock);
+  HASH_FIND(hh, (PathListCacheTable*)self->aspathCacheTable, &pathId, sizeof(uint32_t), plCacheTable);
+  if (plCacheTable != NULL)
   {
-    LOG(LEVEL_INFO, FILE_LINE_INFO " Deleting PathList Cache Entry");
-    del_AspathList(self, plCacheTable);
-    bRet = true;
+    HASH_DEL (*((PathListCacheTable**)&self->aspathCacheTable), plCacheTable);
+    unindex_AspathList(self, plCacheTable);
   }
-  else
+  unlockWriteLock(&self->tableLock);
+
+  if (plCacheTable == NULL)
   {
     LOG(LEVEL_WARNING, " Attempted to find from AS path cache, But not found");
+    return false;
   }
-  return bRet;
+
+  LOG(LEVEL_INFO, FILE_LINE_INFO " Deleting PathList Cache Entry");
+  if (plCacheTable->data.asPathList != NULL)
+  {
+    freeSlabData(plCacheTable->data.asPathList,
+                 plCacheTable->data.hops * sizeof(PATH_LIST));
+  }
+  freeToSlab(&_entryPool, plCacheTable);
+
+  return true;
 }
 
 
@@ -323,7 +468,13 @@ AS_PATH_LIST* getAspathListFromAspathCache (AspathCache* self, uint32_t pathId,
   
   if (find_AspathList (self, pathId, &plCacheTable))
   {
-    aspl = (AS_PATH_LIST*)calloc(1, sizeof(AS_PATH_LIST));
+    aspl = (AS_PATH_LIST*)allocFromSlab(&_listPool);
+    if (!aspl)
+    {
+      LOG(LEVEL_ERROR, "memory allocation error");
+      return NULL;
+    }
+    memset(aspl, 0, sizeof(AS_PATH_LIST));
     aspl->pathID        = plCacheTable->pathId;
     aspl->asPathLength  = plCacheTable->data.hops;
     aspl->aspaValResult = plCacheTable->aspaResult;
@@ -333,7 +484,7 @@ AS_PATH_LIST* getAspathListFromAspathCache (AspathCache* self, uint32_t pathId,
     aspl->lastModified  = plCacheTable->lastModified;
 
     uint8_t length     = plCacheTable->data.hops;
-    aspl->asPathList   = (uint32_t*)calloc(length, sizeof(uint32_t));
+    aspl->asPathList   = (uint32_t*)allocSlabData(length * sizeof(uint32_t));
     if ( length > 0 && plCacheTable->data.asPathList)
     {
       int idx;
@@ -355,10 +506,88 @@ AS_PATH_LIST* getAspathListFromAspathCache (AspathCache* self, uint32_t pathId,
 }
 
 
+// comparator for sorting path IDs
+//
+static int cmpPathId(const void* id1, const void* id2)
+{
+  uint32_t a = *(const uint32_t*)id1;
+  uint32_t b = *(const uint32_t*)id2;
+  return (a > b) - (a < b);
+}
+
+// key : list of AS numbers, e.g. customer ASNs of changed ASPA objects
+// return: number of distinct path IDs of all cached paths that contain at 
+//         least one of the AS numbers. The list is allocated here and must
+//         be freed by the caller
+//
+uint32_t getAspathIdsOfAsns (AspathCache* self, uint32_t* asns, uint32_t asnCount, 
+                             uint32_t** pathIds)
+{
+  AsnPathIndex *asnEntry;
+  uint32_t     count = 0;
+  uint32_t     total = 0;
+  uint32_t     idx, pos;
+
+  *pathIds = NULL;
+
+  acquireReadLock(&self->tableLock);
+  for (idx = 0; idx < asnCount; idx++)
+  {
+    HASH_FIND(hh, (AsnPathIndex*)self->asnIndex, &asns[idx], sizeof(uint32_t), asnEntry);
+    if (asnEntry)
+    {
+      total += asnEntry->count;
+    }
+  }
+
+  if (total > 0)
+  {
+    *pathIds = (uint32_t*) malloc(total * sizeof(uint32_t));
+    if (*pathIds)
+    {
+      for (idx = 0; idx < asnCount; idx++)
+      {
+        HASH_FIND(hh, (AsnPathIndex*)self->asnIndex, &asns[idx], sizeof(uint32_t), asnEntry);
+        if (asnEntry)
+        {
+          memcpy(*pathIds + count, asnEntry->pathIds, asnEntry->count * sizeof(uint32_t));
+          count += asnEntry->count;
+        }
+      }
+    }
+    else
+    {
+      LOG(LEVEL_ERROR, "memory allocation error");
+    }
+  }
+  unlockReadLock(&self->tableLock);
+
+  // a path that contains more than one of the AS numbers is listed only once
+  if (count > 1)
+  {
+    qsort(*pathIds, count, sizeof(uint32_t), cmpPathId);
+    for (idx = 1, pos = 1; idx < count; idx++)
+    {
+      if ((*pathIds)[idx] != (*pathIds)[pos-1])
+      {
+        (*pathIds)[pos++] = (*pathIds)[idx];
+      }
+    }
+    count = pos;
+  }
+
+  return count;
+}
+
+
+// The path ID is the CRC32C of the AS numbers in network byte order followed 
+// by the AS type. The data is hashed as is, no string conversion
+//
 uint32_t makePathId (uint8_t asPathLength, PATH_LIST* asPathList, AS_TYPE asType, bool bBigEndian)
 {
   uint32_t pathId=0;
-  char* strBuf = NULL;
+  uint32_t asn;
+  uint8_t  type = (uint8_t)asType;
   int idx;
 
   if (!asPathList)
@@ -367,30 +596,21 @@ uint32_t makePathId (uint8_t asPathLength, PATH_LIST* asPathList, AS_TYPE asType
     return 0;
   }
 
-  int strSize = asPathLength * 4 *2 + 1 + 1;  //  Path length * 4 byte, *2: hex string, 1: AS type, 1: NULL
-  strBuf = (char*)calloc(strSize, sizeof(char));
-  if (!strBuf)
+  if (bBigEndian)
   {
-    LOG(LEVEL_ERROR, "memory allocation error");
-    return 0;
+    pathId = crc32c(pathId, asPathList, asPathLength * sizeof(PATH_LIST));
   }
-
-  for (idx=0; idx < asPathLength; idx++)
+  else
   {
-    if(bBigEndian)
-      sprintf(strBuf + (idx*4*2), "%08X", ntohl(asPathList[idx]));
-    else
-      sprintf(strBuf + (idx*4*2), "%08X", asPathList[idx]);
+    for (idx=0; idx < asPathLength; idx++)
+    {
+      asn    = htonl(asPathList[idx]);
+      pathId = crc32c(pathId, &asn, sizeof(uint32_t));
+    }
   }
-  sprintf(strBuf+strSize-2, "%X", asType);
+  pathId = crc32c(pathId, &type, 1);
 
-  pathId = crc32((uint8_t*)strBuf, strSize);
-  LOG(LEVEL_INFO, "PathID: %08X strings: %s", pathId, strBuf);
-
-  if (strBuf)
-  {
-    free(strBuf);
-  }
+  LOG(LEVEL_DEBUG, "PathID: %08X", pathId);
 
   return pathId;
 }
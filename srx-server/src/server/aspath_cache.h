@@ -22,10 +22,13 @@
  *
  * AS-Path Cache.
  *
- * Version 0.6.0.0
+ * Version 0.6.2.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *          - Added the AS number to path reverse index and getAspathIdsOfAsns
+ *          - Declared deleteAspathCache
  * 0.6.0.0  - 2021/02/26 - kyehwanl
  *          - Created source
  */
@@ -74,6 +77,7 @@ typedef struct {
 
   UpdateCache       *linkUpdateCache;
   void              *aspathCacheTable;
+  void              *asnIndex;        // AS number to path IDs (reverse index)
   RWLock            tableLock;
   ASPA_DBManager    *aspaDBManager;
 } AspathCache;
@@ -92,7 +96,10 @@ bool modifyAspaValidationResultToAspathCache(AspathCache *self, uint32_t pathId,
                       uint8_t modAspaResult, AS_PATH_LIST* pathlistEntry);
 
 bool deleteAspathListEntry (AS_PATH_LIST* aspl);
+bool deleteAspathCache(AspathCache* self, uint32_t pathId, AS_PATH_LIST* pathlistEntry);
 void printAllAsPathCache(AspathCache *self);
+uint32_t getAspathIdsOfAsns (AspathCache* self, uint32_t* asns, uint32_t asnCount, 
+                             uint32_t** pathIds);
 
 
 
@@ -21,10 +21,13 @@
  * by this software.
  *
  *
- * @version 0.5.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Added validateSignatures which hands multiple updates to the
+ *              validateBatch function of the SRxCryptoAPI plug-in.
  * 0.5.0.0  - 2017/07/08 - oborchert
  *            * Added some more memory housekeeping to validateSignature
  *          - 2017/07/05 - oborchert
@@ -40,6 +43,7 @@
  *            * Code created.
  */
 
+#include <sys/param.h>
 #include "server/bgpsec_handler.h"
 #include "server/main.h"
 #include "util/log.h"
@@ -66,6 +70,32 @@ bool loadPrivateKey(BGPSecHandler* self, const char* filename)
   return true;
 }
 
+/**
+ * Free the hash messages generated during the validation.
+ *
+ * @param self The BGPsec Handler itself
+ * @param valdata The validation data.
+ *
+ * @since 0.6.2.0
+ */
+static void _freeHashMessages(BGPSecHandler* self,
+                              SCA_BGPSecValidationData* valdata)
+{
+  int idx;
+
+  for (idx = 0; idx < 2; idx++)
+  {
+    if (valdata->hashMessage[idx] != NULL)
+    {
+      if (!self->srxCAPI->freeHashMessage(valdata->hashMessage[idx]))
+      {
+        free(valdata->hashMessage[idx]);
+      }
+      valdata->hashMessage[idx] = NULL;
+    }
+  }
+}
+
 /**
  * Validates the given bgpsec update data.
  *
@@ -79,39 +109,72 @@ bool loadPrivateKey(BGPSecHandler* self, const char* filename)
 uint8_t validateSignature(BGPSecHandler* self, UC_UpdateData* update)
 {
   u_int8_t retVal = SRx_RESULT_DONOTUSE;
-  
-  /* making Validation pdu */
-  SCA_BGPSecValidationData valdata;
-  memset(&valdata, 0, sizeof(SCA_BGPSecValidationData));
-  valdata.myAS             = update->myAS;
-  valdata.status           = API_STATUS_OK;
-  valdata.bgpsec_path_attr = (u_int8_t*)update->bgpsec_path;
-  valdata.nlri             = &update->nlri;
-
-  /* call API's validate call */
-  retVal = (self->srxCAPI->validate(&valdata) == API_VALRESULT_VALID)
-            ? SRx_RESULT_VALID
-            : SRx_RESULT_INVALID;
-
-  // Free possible generated hash data
-  if (valdata.hashMessage[0] != NULL)
+
+  validateSignatures(self, 1, &update, &retVal);
+
+  return retVal;
+}
+
+/**
+ * Validates the given bgpsec updates together. The updates are handed to the
+ * plug-in in batches of up to BGPSEC_VALIDATION_BATCH updates. Plug-ins that
+ * do not provide validateBatch validate one update after the other.
+ *
+ * @param self The BGPsec Handler itself
+ * @param count The number of updates
+ * @param updates The updates to be validated
+ * @param results OUT - SRx_RES_VALID or SRx_RES_INVALID for each update
+ *
+ * @since 0.6.2.0
+ */
+void validateSignatures(BGPSecHandler* self, int count, UC_UpdateData** updates,
+                        uint8_t* results)
+{
+  SCA_BGPSecValidationData  valdata[BGPSEC_VALIDATION_BATCH];
+  SCA_BGPSecValidationData* dataPtrs[BGPSEC_VALIDATION_BATCH];
+  int                       valResults[BGPSEC_VALIDATION_BATCH];
+  int                       start = 0;
+  int                       num   = 0;
+  int                       idx   = 0;
+
+  for (start = 0; start < count; start += num)
   {
-    if (!self->srxCAPI->freeHashMessage(valdata.hashMessage[0]))
+    num = MIN(count - start, BGPSEC_VALIDATION_BATCH);
+
+    /* making Validation pdu */
+    memset(valdata, 0, num * sizeof(SCA_BGPSecValidationData));
+    for (idx = 0; idx < num; idx++)
     {
-      free(valdata.hashMessage[0]);
+      valdata[idx].myAS             = updates[start+idx]->myAS;
+      valdata[idx].status           = API_STATUS_OK;
+      valdata[idx].bgpsec_path_attr = 
+                              (u_int8_t*)updates[start+idx]->bgpsec_path;
+      valdata[idx].nlri             = &updates[start+idx]->nlri;
+      dataPtrs[idx] = &valdata[idx];
     }
-    valdata.hashMessage[0] = NULL;
-  }
-  if (valdata.hashMessage[1] != NULL)
-  {
-    if (!self->srxCAPI->freeHashMessage(valdata.hashMessage[1]))
+
+    /* call API's validate call */
+    if ((num > 1) && (self->srxCAPI->validateBatch != NULL))
     {
-      free(valdata.hashMessage[1]);
+      self->srxCAPI->validateBatch(num, dataPtrs, valResults);
+    }
+    else
+    {
+      for (idx = 0; idx < num; idx++)
+      {
+        valResults[idx] = self->srxCAPI->validate(&valdata[idx]);
+      }
     }
-    valdata.hashMessage[1] = NULL;
-  }
 
-  return retVal;
+    for (idx = 0; idx < num; idx++)
+    {
+      results[start+idx] = (valResults[idx] == API_VALRESULT_VALID)
+                           ? SRx_RESULT_VALID
+                           : SRx_RESULT_INVALID;
+      // Free possible generated hash data
+      _freeHashMessages(self, &valdata[idx]);
+    }
+  }
 }
 
 bool createSignature(BGPSecHandler* self)
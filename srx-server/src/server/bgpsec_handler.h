@@ -19,10 +19,12 @@
  * other licenses. Please refer to the licenses of all libraries required
  * by this software.
  *
- * @version 0.5.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Added validateSignatures.
  * 0.5.0.0  - 2017/07/07 - oborchert
  *            * Moved validation into this handler (renamed validateSignature 
  *              into validateUpdate)
@@ -43,6 +45,9 @@
 #include "server/update_cache.h"
 #include "shared/srx_defs.h"
 
+/** The maximum number of updates handed to the plug-in at once. */
+#define BGPSEC_VALIDATION_BATCH 64
+
 /**
  * A single BGPSec Handler.
  */
@@ -91,6 +96,21 @@ bool loadPrivateKey(BGPSecHandler* self, const char* filename);
  */
 uint8_t validateSignature(BGPSecHandler* self, UC_UpdateData* update);
 
+/**
+ * Validates the given bgpsec updates together. The updates are handed to the
+ * plug-in in batches of up to BGPSEC_VALIDATION_BATCH updates. Plug-ins that
+ * do not provide validateBatch validate one update after the other.
+ *
+ * @param self The BGPsec Handler itself
+ * @param count The number of updates
+ * @param updates The updates to be validated
+ * @param results OUT - SRx_RES_VALID or SRx_RES_INVALID for each update
+ *
+ * @since 0.6.2.0
+ */
+void validateSignatures(BGPSecHandler* self, int count, UC_UpdateData** updates,
+                        uint8_t* results);
+
 /**
  * Creates a signature for a given Byte-stream.
  *
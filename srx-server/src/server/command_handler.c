@@ -25,10 +25,28 @@
  * queue is fed by the srx-proxy communication thread.
  *
  *
- * @version 0.6.1.2
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * The prefix for the origin validation is kept on the stack.
+ *           * broadcastResult collects the notifications of each client for
+ *             the configured notify delay. Added flushResults.
+ *           * A dispatcher thread distributes the commands to the worker
+ *             threads, each with its own queue. Commands of the same update
+ *             are processed in order by the same worker, session commands
+ *             by the first worker.
+ *           * Session commands are dispatched only once the workers processed
+ *             the update commands of the client dispatched before, to keep
+ *             them in order.
+ *           * The origin validation result is taken from the compiled ROA
+ *             table if it is current. The update is then added to the prefix
+ *             cache after the combined result is stored.
+ *           * Updates validated using the compiled ROA table are staged per
+ *             worker and added to the prefix cache together.
+ *           * The BGPsec validation uses the update data within a read 
+ *             section of the update cache.
  * 0.6.1.2 - 2021/11/10 - kyehwanl
  *           * Added a missing case of if-else clause to support the invalid case 
  *             which comes from the router.
@@ -70,6 +88,8 @@
  *            * Code Created.
  */
 #include <ctype.h>
+#include <time.h>
+#include <unistd.h>
 #include "server/command_handler.h"
 #include "shared/srx_defs.h"
 #include "shared/srx_identifier.h"
@@ -85,6 +105,8 @@
 
 // Forward declaration
 static void* handleCommands(void* arg);
+static void* _dispatchCommands(void* arg);
+static void* _notificationThread(void* arg);
 extern RPKI_QUEUE* getRPKIQueue();
 
 /**
@@ -116,8 +138,46 @@ bool initializeCommandHandler(CommandHandler* self, Configuration* cfg,
 
   // 'start' has not been called
   self->numThreads = 0;
+  memset(self->workers, 0, sizeof(self->workers));
 
-  return true; // Does not fail
+  // The flush thread is started with the command handler threads.
+  memset(&self->notifications, 0, sizeof(NotificationBatch));
+  self->notifications.delayMillis = cfg->notifyDelay > 0 ? cfg->notifyDelay
+                                                         : 0;
+  if (!initMutex(&self->notifications.mutex))
+  {
+    return false;
+  }
+  if (!initMutex(&self->notifications.sendMutex))
+  {
+    releaseMutex(&self->notifications.mutex);
+    return false;
+  }
+  if (!initCond(&self->notifications.cond))
+  {
+    releaseMutex(&self->notifications.sendMutex);
+    releaseMutex(&self->notifications.mutex);
+    return false;
+  }
+
+  self->barrierWaiting = 0;
+  if (!initMutex(&self->barrierMutex))
+  {
+    destroyCond(&self->notifications.cond);
+    releaseMutex(&self->notifications.sendMutex);
+    releaseMutex(&self->notifications.mutex);
+    return false;
+  }
+  if (!initCond(&self->barrierCond))
+  {
+    releaseMutex(&self->barrierMutex);
+    destroyCond(&self->notifications.cond);
+    releaseMutex(&self->notifications.sendMutex);
+    releaseMutex(&self->notifications.mutex);
+    return false;
+  }
+
+  return true;
 }
 
 /**
@@ -149,43 +209,126 @@ void releaseCommandHandler(CommandHandler* self)
     }
   }
 
+  int idx;
+  for (idx = 0; idx < MAX_PROXY_CLIENT_ELEMENTS; idx++)
+  {
+    free(self->notifications.buffer[idx]);
+    free(self->notifications.sendBuffer[idx]);
+  }
+  destroyCond(&self->notifications.cond);
+  releaseMutex(&self->notifications.sendMutex);
+  releaseMutex(&self->notifications.mutex);
+  destroyCond(&self->barrierCond);
+  releaseMutex(&self->barrierMutex);
+
   LOG(LEVEL_DEBUG, HDR "Command Handler released!", pthread_self());
-  // Do nothing
 }
 
-bool startProcessingCommands(CommandHandler* self, CommandQueue* cmdQueue)
+/**
+ * Stop the worker threads and release their queues. The workers process the
+ * commands queued before the shutdown.
+ *
+ * @param self The command handler
+ *
+ * @since 0.6.2.0
+ */
+static void _stopWorkers(CommandHandler* self)
 {
   int idx;
+  int s;
+
+  for (idx = 0; idx < self->numThreads; idx++)
+  {
+    queueCommand(&self->workers[idx].queue, COMMAND_TYPE_SHUTDOWN,
+                 NULL, NULL, 0, 0, NULL);
+  }
+  for (idx = 0; idx < self->numThreads; idx++)
+  {
+    s = pthread_join(self->workers[idx].thread, NULL);
+    if (s != 0)
+    {
+      RAISE_SYS_ERROR("Could not join command handler thread No %u (%d)", 
+                      idx, s);
+    }
+    releaseCommandQueue(&self->workers[idx].queue);
+  }
+  self->numThreads = 0;
+}
+
+bool startProcessingCommands(CommandHandler* self, CommandQueue* cmdQueue)
+{
+  int  idx;
+  long numCPU = sysconf(_SC_NPROCESSORS_ONLN);
+  CommandWorker* worker;
 
   self->queue = cmdQueue;
   LOG(LEVEL_DEBUG, HDR "Start Processing Commands...", pthread_self());
 
-  for (idx = 0; idx < NUM_COMMAND_HANDLER_THREADS; idx++)
+  if (numCPU > NUM_COMMAND_HANDLER_THREADS)
+  {
+    numCPU = NUM_COMMAND_HANDLER_THREADS;
+  }
+  if (numCPU < 1)
+  {
+    numCPU = 1;
+  }
+
+  for (idx = 0; idx < numCPU; idx++)
   {
     LOG (LEVEL_DEBUG, HDR "Create command handler Thread No %u", pthread_self(),
                       idx);
-    if (pthread_create(&self->threads[idx], NULL, handleCommands, self) > 0)
+    worker = &self->workers[idx];
+    memset(worker, 0, sizeof(CommandWorker));
+    worker->handler = self;
+    if (!initializeCommandQueue(&worker->queue))
     {
-      // Continue with less threads
-      if (idx > 0)
-      {
-        RAISE_ERROR("Failed to initiate a command handler thread "
-                    "- continuing with %d threads",
-                    self->numThreads);
-        break;
-
-        // No thread
-      }
-      else
-      {
-        RAISE_ERROR("Failed to initiate a command handler thread - stopping");
-        return false;
-      }
+      RAISE_ERROR("Failed to create the queue of command handler thread No %u",
+                  idx);
+      break;
+    }
+    if (pthread_create(&worker->thread, NULL, handleCommands, worker) > 0)
+    {
+      releaseCommandQueue(&worker->queue);
+      break;
     }
 
     self->numThreads++;
   }
 
+  // Continue with less threads
+  if (self->numThreads == 0)
+  {
+    RAISE_ERROR("Failed to initiate a command handler thread - stopping");
+    return false;
+  }
+  if (self->numThreads < numCPU)
+  {
+    RAISE_ERROR("Failed to initiate a command handler thread "
+                "- continuing with %d threads", self->numThreads);
+  }
+
+  if (pthread_create(&self->dispatcher, NULL, _dispatchCommands, self) != 0)
+  {
+    RAISE_ERROR("Failed to initiate the command dispatcher thread - stopping");
+    _stopWorkers(self);
+    return false;
+  }
+  LOG(LEVEL_DEBUG, HDR "Started %d command handler thread(s)", pthread_self(),
+                   self->numThreads);
+
+  // Collect the result notifications only if a delay is configured.
+  if ((self->notifications.delayMillis > 0) && !self->notifications.running)
+  {
+    self->notifications.running = true;
+    if (pthread_create(&self->notifications.flushThread, NULL,
+                       _notificationThread, self) != 0)
+    {
+      LOG(LEVEL_WARNING, HDR "Failed to initiate the notification thread "
+                         "- results are send right away", pthread_self());
+      self->notifications.running = false;
+    }
+  }
+
   return true;
 }
 
@@ -199,29 +342,45 @@ bool startProcessingCommands(CommandHandler* self, CommandQueue* cmdQueue)
  */
 void stopProcessingCommands(CommandHandler* self)
 {
-  if (self->queue)
+  if (self->notifications.running)
+  {
+    lockMutex(&self->notifications.mutex);
+    self->notifications.running = false;
+    signalCond(&self->notifications.cond);
+    unlockMutex(&self->notifications.mutex);
+    pthread_join(self->notifications.flushThread, NULL);
+    // Send what is left
+    flushResults(self);
+  }
+
+  if (self->queue && (self->numThreads > 0))
   {
     int idx;
     int s;
 
     // First remove all pending commands
     removeAllCommands(self->queue);
-
-    // Send SHUTDOWN to terminate the thread
-    // TODO: Revisit this - It might cause errors during shutdown
     for (idx = 0; idx < self->numThreads; idx++)
     {
-      queueCommand(self->queue, COMMAND_TYPE_SHUTDOWN,
-                   NULL, NULL, 0, 0, NULL);
+      removeAllCommands(&self->workers[idx].queue);
     }
 
+    // Send SHUTDOWN to terminate the dispatcher, it passes it to the workers.
+    // TODO: Revisit this - It might cause errors during shutdown
+    queueCommand(self->queue, COMMAND_TYPE_SHUTDOWN, NULL, NULL, 0, 0, NULL);
+
     // Wait until each thread terminated
+    s = pthread_join(self->dispatcher, NULL);
+    if (s != 0)
+      handle_error_en(s, "pthread_join");
     for (idx = 0; idx < self->numThreads; idx++)
     {
-      s = pthread_join(self->threads[idx], NULL);
+      s = pthread_join(self->workers[idx].thread, NULL);
       if (s != 0)
         handle_error_en(s, "pthread_join");
+      releaseCommandQueue(&self->workers[idx].queue);
     }
+    self->numThreads = 0;
   }
 }
 
@@ -637,6 +796,55 @@ Validation_Result:
 
 
 
+/**
+ * Add the updates staged by the worker to the prefix cache. All updates are 
+ * added while holding the write lock of the prefix cache only once.
+ *
+ * @param cmdHandler The command handler
+ * @param worker The worker whose staged updates are added.
+ *
+ * @since 0.6.2.0
+ */
+static void _addStagedUpdates(CommandHandler* cmdHandler, CommandWorker* worker)
+{
+  uint32_t failed = requestUpdateValidations(
+                                         cmdHandler->rpkiHandler->prefixCache,
+                                         worker->staged, worker->numStaged);
+  if (failed > 0)
+  {
+    RAISE_SYS_ERROR( HDR "%u of %u updates could not be added to the prefix "
+                         "cache!", pthread_self(), failed, worker->numStaged);
+  }
+  worker->numStaged = 0;
+}
+
+/**
+ * Stage the update to be added to the prefix cache. The staged updates are
+ * added once the worker's queue is empty or no more updates can be staged.
+ *
+ * @param cmdHandler The command handler
+ * @param worker The worker that validated the update.
+ * @param updateID The id of the update.
+ * @param prefix The prefix of the update.
+ * @param asn The origin AS of the update.
+ *
+ * @since 0.6.2.0
+ */
+static void _stageUpdate(CommandHandler* cmdHandler, CommandWorker* worker,
+                         SRxUpdateID updateID, IPPrefix* prefix, uint32_t asn)
+{
+  PC_ValidationRequest* request = &worker->staged[worker->numStaged++];
+
+  request->updateID = updateID;
+  request->prefix   = *prefix;
+  request->as       = asn;
+
+  if (worker->numStaged == COMMAND_WORKER_STAGE_SIZE)
+  {
+    _addStagedUpdates(cmdHandler, worker);
+  }
+}
+
 /**
  * This method is used to verify an update it is called by the command handlers
  * loop method that works through the command queue!
@@ -648,11 +856,13 @@ Validation_Result:
  * stored in the prefix cache.
  *
  * @param cmdHandler The command handler itself
+ * @param worker The worker processing the item.
  * @param item The command item that contains the information.
  *
  * @return false if the packet could not be processed.
  */
 static bool _processUpdateValidation(CommandHandler* cmdHandler,
+                                     CommandWorker* worker,
                                      CommandQueueItem* item)
 {
   bool processed = true;
@@ -698,10 +908,13 @@ static bool _processUpdateValidation(CommandHandler* cmdHandler,
   // Only do bgpdsec path validation if not already performed
   if (pathVal && (srxRes.bgpsecResult == SRx_RESULT_UNDEFINED))
   {
-    // Get the data needed for BGPsec validation
+    // Get the data needed for BGPsec validation, the garbage collector 
+    // keeps it until the validation is done.
+    enterUpdateCacheReader(cmdHandler->updCache);
     UC_UpdateData* uData = getUpdateData(cmdHandler->updCache, &item->dataID);
     if (uData == NULL)
     {  
+      leaveUpdateCacheReader(cmdHandler->updCache);
       RAISE_ERROR("Update Information for update [0x%08X] are not properly "
                    "stored in update cache!");
       return false;
@@ -709,13 +922,19 @@ static bool _processUpdateValidation(CommandHandler* cmdHandler,
     
     srxRes_mod.bgpsecResult = validateSignature(cmdHandler->bgpsecHandler, 
                                                 uData);
+    leaveUpdateCacheReader(cmdHandler->updCache);
   }
 
+  // Set if the origin validation result was taken from the compiled ROA 
+  // table, the update still needs to be added to the prefix cache.
+  bool       addToPrefixCache = false;
+  IPPrefix   reqPrefix;
+  IPPrefix*  prefix  = &reqPrefix;
+  uint32_t   asn     = 0;
+
   // Only do origin validation if not already performed
   if (originVal && (srxRes.roaResult == SRx_RESULT_UNDEFINED))
   {
-    IPPrefix*  prefix  = malloc(sizeof(IPPrefix));
-    uint32_t   asn;
     memset(prefix, 0, sizeof(IPPrefix));
 
     if (bhdr->type == PDU_SRXPROXY_VERIFY_V4_REQUEST)
@@ -735,15 +954,26 @@ static bool _processUpdateValidation(CommandHandler* cmdHandler,
       asn = ntohl(v6->originAS);
     }
 
-    if (!requestUpdateValidation(cmdHandler->rpkiHandler->prefixCache,
-                                 &updateID, prefix, asn))
+    // The compiled ROA table answers without locking the prefix cache. The 
+    // result is sent together with the other results of this update.
+    srxRes_mod.roaResult = getCompiledOriginStatus(
+                             cmdHandler->rpkiHandler->prefixCache, prefix, asn);
+    if (srxRes_mod.roaResult != SRx_RESULT_UNDEFINED)
+    {
+      addToPrefixCache = true;
+    }
+    else
     {
-      RAISE_SYS_ERROR( HDR "An error occurred during the validation for "
-                           "update [0x%08X] within the prefix cache!",
-                      pthread_self(), item->dataID);
-      processed = false;
+      srxRes_mod.roaResult = SRx_RESULT_DONOTUSE;
+      if (!requestUpdateValidation(cmdHandler->rpkiHandler->prefixCache,
+                                   &updateID, prefix, asn))
+      {
+        RAISE_SYS_ERROR( HDR "An error occurred during the validation for "
+                             "update [0x%08X] within the prefix cache!",
+                        pthread_self(), item->dataID);
+        processed = false;
+      }
     }
-    free(prefix);
   }
   
   //
@@ -765,7 +995,6 @@ static bool _processUpdateValidation(CommandHandler* cmdHandler,
     // ----------------------------------------------------------------
     RPKIHandler* handler = (RPKIHandler*)cmdHandler->rpkiHandler;
     ASPA_DBManager* aspaDBManager = handler->aspaDBManager;
-    TrieNode *root = aspaDBManager->tableRoot;
 
 
     // -------------------------------------------------------------------
@@ -875,6 +1104,15 @@ static bool _processUpdateValidation(CommandHandler* cmdHandler,
                       updateID);
     }    
   }
+
+  // Keep track of the update for ROA changes. The prefix cache determines the
+  // same result unless the ROAs changed in the meantime, only then a second
+  // notification is sent. The updates are staged to add them using a single
+  // write lock of the prefix cache.
+  if (addToPrefixCache)
+  {
+    _stageUpdate(cmdHandler, worker, updateID, prefix, asn);
+  }
   
   return processed;
 }
@@ -937,21 +1175,38 @@ static void _processPeerChange(CommandHandler* cmdHandler,
   LOG(LEVEL_WARNING, "Peer Changes are not supported prior Version 0.4.0!");
 }
 
+/**
+ * Return the slot the commands of the client are counted in.
+ *
+ * @param client The client of the command, might be NULL.
+ *
+ * @return the client slot.
+ *
+ * @since 0.6.2.0
+ */
+static inline uint32_t _clientSlot(ServerClient* client)
+{
+  // The client instances are allocated, the lower bits are the same.
+  return (uint32_t)((uintptr_t)client >> 4) & (COMMAND_CLIENT_SLOTS - 1);
+}
+
 /**
  * This method implements the command handler loop. Once commands are added into
  * the command queue this loop will receive them and process them. Commands
  * can be added by receiving a white list entry, BGPSEC entry, as well as a
  * request or action received from the SRx proxy.
  *
- * @param arg The Command Handler
+ * @param arg The Command Worker
  *
  */
 static void* handleCommands(void* arg)
 {
-  CommandHandler* cmdHandler = (CommandHandler*)arg;
+  CommandWorker*  worker     = (CommandWorker*)arg;
+  CommandHandler* cmdHandler = (CommandHandler*)worker->handler;
   CommandQueueItem* item;
   bool keepGoing = true;
   uint8_t clientID = 0; // only used in process handshake and goodbye
+  uint32_t slot;
 
   generalSignalProcess();
 
@@ -963,7 +1218,19 @@ static void* handleCommands(void* arg)
     // Block until the next command is available for this thread
     LOG(LEVEL_DEBUG, HDR "recvLock request ...%s", pthread_self(),__FUNCTION__);
 
-    item = fetchNextCommand(cmdHandler->queue);
+    // Add the staged updates before waiting for the next command.
+    if (   (worker->numStaged > 0) 
+        && (getUnprocessedQueueSize(&worker->queue) == 0))
+    {
+      _addStagedUpdates(cmdHandler, worker);
+    }
+
+    item = fetchNextCommand(&worker->queue);
+    if (item == NULL)
+    {
+      // The queue is released
+      break;
+    }
 
     switch (item->cmdType)
     {
@@ -1004,7 +1271,7 @@ static void* handleCommands(void* arg)
               break;
             case PDU_SRXPROXY_VERIFY_V4_REQUEST:
             case PDU_SRXPROXY_VERIFY_V6_REQUEST:
-              _processUpdateValidation(cmdHandler, item);
+              _processUpdateValidation(cmdHandler, worker, item);
               break;
             case PDU_SRXPROXY_SIGN_REQUEST:
               _processUpdateSigning(cmdHandler, item);
@@ -1057,17 +1324,18 @@ static void* handleCommands(void* arg)
       // Still keep going.
     }
 
-    if (cmdHandler->queue->nextItemNode != NULL)
+    // Now remove the item from command handler. it is processed.
+    slot = _clientSlot(item->client);
+    deleteCommand(&worker->queue, item);
+    __atomic_add_fetch(&worker->completed[slot], 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&cmdHandler->barrierWaiting, __ATOMIC_SEQ_CST) != 0)
     {
-      LOG(LEVEL_DEBUG, HDR "recv Unlock request ...%s", pthread_self(),
-                       __FUNCTION__);
-      //unlockMutex(&cmdHandler->queue->recvMutex);
-      //signalCond(&cmdHandler->queue->recvCond);
+      // The dispatcher might wait for this command.
+      lockMutex(&cmdHandler->barrierMutex);
+      signalCond(&cmdHandler->barrierCond);
+      unlockMutex(&cmdHandler->barrierMutex);
     }
 
-    // Now remove the item from command handler. it is processed.
-    deleteCommand(cmdHandler->queue, item);
-
   } /* end of while */
 
   LOG (LEVEL_DEBUG, "([0x%08X]) < Command Handler Thread stopped!",
@@ -1077,9 +1345,346 @@ static void* handleCommands(void* arg)
 }
 
 
+/**
+ * Select the worker for the given command. Validation, signing, and deletion
+ * of an update are processed by the worker of the update ID. All other 
+ * commands (handshake, goodbye, peer change, ...) are session commands, they
+ * are processed by the first worker while all other workers are idle. This 
+ * keeps them in order with the update commands of the client and serializes
+ * the changes of the proxy mapping.
+ *
+ * @param self The command handler
+ * @param item The command
+ *
+ * @return the index of the worker or -1 for a session command.
+ *
+ * @since 0.6.2.0
+ */
+static int _selectWorker(CommandHandler* self, CommandQueueItem* item)
+{
+  if (item->data != NULL)
+  {
+    switch (((SRXPROXY_BasicHeader*)item->data)->type)
+    {
+      case PDU_SRXPROXY_VERIFY_V4_REQUEST:
+      case PDU_SRXPROXY_VERIFY_V6_REQUEST:
+      case PDU_SRXPROXY_SIGN_REQUEST:
+      case PDU_SRXPROXY_DELTE_UPDATE:
+        // Spread the bits of the update ID (Fibonacci hashing)
+        return (int)(((uint64_t)(item->dataID * 2654435761U) 
+                      * self->numThreads) >> 32);
+      default:
+        break;
+    }
+  }
+
+  return -1;
+}
+
+/**
+ * Return if the workers processed all commands of the client slot dispatched
+ * to them.
+ *
+ * @param self The command handler
+ * @param slot The client slot
+ *
+ * @return true if no command of the slot is pending.
+ *
+ * @since 0.6.2.0
+ */
+static bool _isSlotDone(CommandHandler* self, uint32_t slot)
+{
+  int idx;
+
+  for (idx = 0; idx < self->numThreads; idx++)
+  {
+    if (__atomic_load_n(&self->workers[idx].completed[slot], __ATOMIC_SEQ_CST)
+        != self->workers[idx].dispatched[slot])
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Wait until the workers processed the commands of the client slot dispatched
+ * to them. The workers signal the barrier condition while the dispatcher 
+ * waits.
+ *
+ * @param self The command handler
+ * @param slot The client slot
+ *
+ * @since 0.6.2.0
+ */
+static void _waitForWorkers(CommandHandler* self, uint32_t slot)
+{
+  if (_isSlotDone(self, slot))
+  {
+    return;
+  }
+
+  lockMutex(&self->barrierMutex);
+  // Set before checking again, a worker that completes a command afterwards
+  // signals the condition.
+  __atomic_store_n(&self->barrierWaiting, 1, __ATOMIC_SEQ_CST);
+  while (!_isSlotDone(self, slot))
+  {
+    pthread_cond_wait(&self->barrierCond, &self->barrierMutex);
+  }
+  __atomic_store_n(&self->barrierWaiting, 0, __ATOMIC_SEQ_CST);
+  unlockMutex(&self->barrierMutex);
+}
+
+/**
+ * The dispatcher thread. It moves the commands from the command queue into
+ * the queue of the selected worker without copying the data. A shutdown is 
+ * passed to all workers.
+ *
+ * @param arg The Command Handler
+ *
+ * @return NULL
+ *
+ * @since 0.6.2.0
+ */
+static void* _dispatchCommands(void* arg)
+{
+  CommandHandler*   cmdHandler = (CommandHandler*)arg;
+  CommandQueueItem* item;
+  CommandWorker*    worker;
+  bool keepGoing = true;
+  bool sessionCmd;
+  int  idx;
+  uint32_t slot;
+
+  generalSignalProcess();
+
+  LOG(LEVEL_DEBUG, "([0x%08X]) > Command Dispatcher Thread started!", 
+                   pthread_self());
+
+  while (keepGoing)
+  {
+    item = fetchNextCommand(cmdHandler->queue);
+    if (item == NULL)
+    {
+      // The queue is released, stop the workers as well.
+      keepGoing = false;
+    }
+    else if (item->cmdType == COMMAND_TYPE_SHUTDOWN)
+    {
+      keepGoing = false;
+    }
+
+    if (keepGoing)
+    {
+      idx = _selectWorker(cmdHandler, item);
+      slot = _clientSlot(item->client);
+      sessionCmd = idx < 0;
+      if (sessionCmd)
+      {
+        // The commands of the client dispatched before must be processed.
+        _waitForWorkers(cmdHandler, slot);
+        idx = 0;
+      }
+      worker = &cmdHandler->workers[idx];
+      // The worker queue takes over the data
+      if (handoverCommand(&worker->queue, item->cmdType, item->serverSocket,
+                          item->client, item->dataID, item->dataLength, 
+                          item->data))
+      {
+        worker->dispatched[slot]++;
+        if (sessionCmd)
+        {
+          // The following commands of the client depend on this one.
+          _waitForWorkers(cmdHandler, slot);
+        }
+      }
+      else
+      {
+        RAISE_ERROR("Could not pass command to the command handler thread!");
+      }
+      item->data = NULL;
+    }
+    else
+    {
+      for (idx = 0; idx < cmdHandler->numThreads; idx++)
+      {
+        queueCommand(&cmdHandler->workers[idx].queue, COMMAND_TYPE_SHUTDOWN,
+                     NULL, NULL, 0, 0, NULL);
+      }
+    }
+
+    if (item != NULL)
+    {
+      deleteCommand(cmdHandler->queue, item);
+    }
+  }
+
+  LOG(LEVEL_DEBUG, "([0x%08X]) < Command Dispatcher Thread stopped!",
+                   pthread_self());
+
+  return NULL;
+}
+
+/**
+ * Send the result notifications collected for each client. Flushes are
+ * serialized by the sendMutex so the notifications of a client are send in the
+ * order they were collected.
+ *
+ * @param self Instance
+ *
+ * @since 0.6.2.0
+ */
+void flushResults(CommandHandler* self)
+{
+  NotificationBatch* batch = &self->notifications;
+  ProxyClientMapping* proxyMap = self->svrConnHandler->proxyMap;
+  uint32_t fill[MAX_PROXY_CLIENT_ELEMENTS];
+  uint8_t* buffer = NULL;
+  int idx;
+
+  lockMutex(&batch->sendMutex);
+
+  // Swap the buffers, this allows to collect new notifications while sending.
+  lockMutex(&batch->mutex);
+  for (idx = 0; idx < MAX_PROXY_CLIENT_ELEMENTS; idx++)
+  {
+    fill[idx] = batch->fill[idx];
+    if (fill[idx] > 0)
+    {
+      buffer                  = batch->sendBuffer[idx];
+      batch->sendBuffer[idx]  = batch->buffer[idx];
+      batch->buffer[idx]      = buffer;
+      batch->fill[idx]        = 0;
+    }
+  }
+  batch->count = 0;
+  unlockMutex(&batch->mutex);
+
+  for (idx = 0; idx < MAX_PROXY_CLIENT_ELEMENTS; idx++)
+  {
+    // If the mapping is inactive the proxy might be in reboot.
+    if ((fill[idx] > 0) && proxyMap[idx].isActive)
+    {
+      sendPacketToClient(&self->svrConnHandler->svrSock, proxyMap[idx].socket,
+                         batch->sendBuffer[idx], fill[idx]);
+    }
+  }
+
+  unlockMutex(&batch->sendMutex);
+}
+
+/**
+ * Add the notification to the ones collected for the client. In case the 
+ * buffer of the client is full all collected notifications will be send.
+ *
+ * @param self Instance
+ * @param clientID The client the notification is for.
+ * @param pdu The notification
+ * @param length The length of the notification.
+ *
+ * @return false if the notification could not be added.
+ *
+ * @since 0.6.2.0
+ */
+static bool _queueNotification(CommandHandler* self, uint8_t clientID,
+                               void* pdu, uint32_t length)
+{
+  NotificationBatch* batch = &self->notifications;
+
+  if (length > NOTIFICATION_BUFFER_SIZE)
+  {
+    RAISE_ERROR("Notification of %u bytes exceeds the buffer size!", length);
+    return false;
+  }
+
+  lockMutex(&batch->mutex);
+  // Other workers might refill the buffer between the flush and re-locking
+  // the mutex, therefore check again until the notification fits.
+  while (batch->fill[clientID] + length > NOTIFICATION_BUFFER_SIZE)
+  {
+    unlockMutex(&batch->mutex);
+    flushResults(self);
+    lockMutex(&batch->mutex);
+  }
+
+  if (batch->buffer[clientID] == NULL)
+  {
+    batch->buffer[clientID] = malloc(NOTIFICATION_BUFFER_SIZE);
+    if (batch->buffer[clientID] == NULL)
+    {
+      unlockMutex(&batch->mutex);
+      RAISE_SYS_ERROR("Not enough memory to collect result notifications!");
+      return false;
+    }
+  }
+
+  memcpy(batch->buffer[clientID] + batch->fill[clientID], pdu, length);
+  batch->fill[clientID] += length;
+
+  // The first notification starts the delay.
+  if (batch->count++ == 0)
+  {
+    clock_gettime(CLOCK_REALTIME, &batch->deadline);
+    batch->deadline.tv_nsec += (long)batch->delayMillis * 1000000L;
+    batch->deadline.tv_sec  += batch->deadline.tv_nsec / 1000000000L;
+    batch->deadline.tv_nsec %= 1000000000L;
+    signalCond(&batch->cond);
+  }
+  unlockMutex(&batch->mutex);
+
+  return true;
+}
+
+/**
+ * The thread that sends the collected result notifications once the delay
+ * of the first one expired.
+ *
+ * @param arg The command handler.
+ *
+ * @return NULL
+ *
+ * @since 0.6.2.0
+ */
+static void* _notificationThread(void* arg)
+{
+  CommandHandler*    self  = (CommandHandler*)arg;
+  NotificationBatch* batch = &self->notifications;
+  struct timespec    now;
+
+  lockMutex(&batch->mutex);
+  while (batch->running)
+  {
+    if (batch->count == 0)
+    {
+      pthread_cond_wait(&batch->cond, &batch->mutex);
+      continue;
+    }
+    clock_gettime(CLOCK_REALTIME, &now);
+    if (   (now.tv_sec > batch->deadline.tv_sec)
+        || (   (now.tv_sec == batch->deadline.tv_sec)
+            && (now.tv_nsec >= batch->deadline.tv_nsec)))
+    {
+      unlockMutex(&batch->mutex);
+      flushResults(self);
+      lockMutex(&batch->mutex);
+    }
+    else
+    {
+      pthread_cond_timedwait(&batch->cond, &batch->mutex, &batch->deadline);
+    }
+  }
+  unlockMutex(&batch->mutex);
+
+  return NULL;
+}
+
 /**
  * Sends a (new) result to all connected clients of the provided update.
- * The UpdateID is embedded in the SRxValidationResult data.
+ * The UpdateID is embedded in the SRxValidationResult data. If a notify delay
+ * is configured the result is collected and send together with the other
+ * results of the client within the delay.
  *
  * @param self Instance
  * @param valResult The validation result including the UpdateID the result
@@ -1089,9 +1694,10 @@ static void* handleCommands(void* arg)
  */
 bool broadcastResult(CommandHandler* self, SRxValidationResult* valResult)
 {
-  SRXPROXY_VERIFY_NOTIFICATION* pdu;
+  SRXPROXY_VERIFY_NOTIFICATION pdu;
   uint32_t pduLength = sizeof(SRXPROXY_VERIFY_NOTIFICATION);
   bool retVal = true;
+  bool queued = false;
   // Prepare the array of clients.
   uint8_t clientSize = self->updCache->minNumberOfClients;
   uint8_t clients[clientSize];
@@ -1112,16 +1718,15 @@ bool broadcastResult(CommandHandler* self, SRxValidationResult* valResult)
   // that have listeners / clients installed.
   if (clientCt > 0)
   {
-    pdu = malloc(pduLength);
-    memset(pdu,0,pduLength);
-    pdu->type         = PDU_SRXPROXY_VERI_NOTIFICATION;
-    pdu->resultType   = (valResult->valType & SRX_FLAG_ROA_BGPSEC_ASPA);
-    pdu->roaResult    = valResult->valResult.roaResult;
-    pdu->bgpsecResult = valResult->valResult.bgpsecResult;
-    pdu->aspaResult   = valResult->valResult.aspaResult;
+    memset(&pdu, 0, pduLength);
+    pdu.type         = PDU_SRXPROXY_VERI_NOTIFICATION;
+    pdu.resultType   = (valResult->valType & SRX_FLAG_ROA_BGPSEC_ASPA);
+    pdu.roaResult    = valResult->valResult.roaResult;
+    pdu.bgpsecResult = valResult->valResult.bgpsecResult;
+    pdu.aspaResult   = valResult->valResult.aspaResult;
 
-    pdu->length           = htonl(pduLength);
-    pdu->updateID = htonl(valResult->updateID);
+    pdu.length       = htonl(pduLength);
+    pdu.updateID     = htonl(valResult->updateID);
 
     /* extract a specific client to send packet */
     retVal = false;
@@ -1130,15 +1735,23 @@ bool broadcastResult(CommandHandler* self, SRxValidationResult* valResult)
       // work the clients array backwards - saves maintaining a counter variable
       if (self->svrConnHandler->proxyMap[clients[clientCt]].isActive)
       {
-        client = self->svrConnHandler->proxyMap[clients[clientCt]].socket;
+        queued = self->notifications.running
+                 && _queueNotification(self, clients[clientCt], &pdu,
+                                       pduLength);
+        if (queued)
+        {
+          retVal = true;
+        }
+        else
+        {
+          client = self->svrConnHandler->proxyMap[clients[clientCt]].socket;
 
-        retVal |= sendPacketToClient(&self->svrConnHandler->svrSock,
-                                     client , pdu, pduLength);
+          retVal |= sendPacketToClient(&self->svrConnHandler->svrSock,
+                                       client , &pdu, pduLength);
+        }
       }
       // If the mapping is inactive the proxy might be in reboot.
     }
-
-    free(pdu);
   }
 
   return retVal;
@@ -20,10 +20,19 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  * 
- * @version 0.6.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Added NotificationBatch to CommandHandler structure.
+ *            * Added flushResults.
+ *            * Added CommandWorker. The commands are dispatched to the workers
+ *              by update or client.
+ *            * Added the staged prefix cache updates to CommandWorker.
+ *            * Added the dispatched and completed counters to CommandWorker,
+ *              counted per client slot.
+ *            * Added the worker barrier to CommandHandler.
   * 0.6.0.0  - 2021/03/30 - oborchert
  *            * Added missing version control. Also moved modifications labeled 
  *              as version 0.5.2.0 to 0.6.0.0 (0.5.2.0 was skipped)
@@ -55,14 +64,88 @@
 #include "server/update_cache.h"
 #include "server/aspath_cache.h"
 #include "shared/srx_packets.h"
+#include "util/mutex.h"
 #include "util/packet.h"
 #include "util/server_socket.h"
 
 /**
- * Number of parallel threads.
+ * Maximum number of parallel threads. The number of online CPUs is used if it
+ * is less.
  */
-#define NUM_COMMAND_HANDLER_THREADS 1
-// #define NUM_COMMAND_HANDLER_THREADS 2
+#define NUM_COMMAND_HANDLER_THREADS 8
+
+/** 
+ * The size of the buffer that collects the result notifications of a proxy.
+ */
+#define NOTIFICATION_BUFFER_SIZE 16384
+
+/**
+ * The number of updates a worker collects before adding them to the prefix
+ * cache.
+ */
+#define COMMAND_WORKER_STAGE_SIZE 64
+
+/**
+ * The number of slots the commands of the clients are counted in. Clients
+ * sharing a slot wait for each other's commands. MUST be a power of 2.
+ */
+#define COMMAND_CLIENT_SLOTS 64
+
+/**
+ * Collects the result notifications of each proxy until they are send
+ * together.
+ * 
+ * @since 0.6.2.0
+ */
+typedef struct {
+  /** The notifications collected for each proxy (clientID). */
+  uint8_t*        buffer[MAX_PROXY_CLIENT_ELEMENTS];
+  /** The number of bytes used in each buffer. */
+  uint32_t        fill[MAX_PROXY_CLIENT_ELEMENTS];
+  /** The buffers that are send during a flush. Swapped with buffer. */
+  uint8_t*        sendBuffer[MAX_PROXY_CLIENT_ELEMENTS];
+  /** The number of notifications collected. */
+  uint32_t        count;
+  /** The time in milliseconds notifications are collected. */
+  uint32_t        delayMillis;
+  /** The time the collected notifications must be send. */
+  struct timespec deadline;
+  /** Protects the buffers. */
+  Mutex           mutex;
+  /** Keeps flushes in order, acquired before mutex. */
+  Mutex           sendMutex;
+  /** Signals the first notification of a batch to the flush thread. */
+  Cond            cond;
+  /** The flush thread. */
+  pthread_t       flushThread;
+  /** Indicates if notifications are collected. */
+  bool            running;
+} NotificationBatch;
+
+/**
+ * A command handler thread with its own queue. All commands of an update are
+ * processed by the same worker and therefore in the order they were received.
+ *
+ * @since 0.6.2.0
+ */
+typedef struct {
+  /** The commands dispatched to this worker. */
+  CommandQueue    queue;
+  /** The worker thread. */
+  pthread_t       thread;
+  /** The command handler the worker belongs to. */
+  void*           handler;
+  /** The updates validated using the compiled ROA table that still have to
+   * be added to the prefix cache. */
+  PC_ValidationRequest staged[COMMAND_WORKER_STAGE_SIZE];
+  /** The number of staged updates. */
+  uint32_t        numStaged;
+  /** The number of commands of each client slot passed to the worker
+   * (dispatcher only). */
+  uint64_t        dispatched[COMMAND_CLIENT_SLOTS];
+  /** The number of commands of each client slot the worker processed. */
+  uint64_t        completed[COMMAND_CLIENT_SLOTS];
+} CommandWorker;
 
 /**
  * A single Command Handler.
@@ -82,8 +165,18 @@ typedef struct {
   CommandQueue*             queue;
 
   // Internal
-  pthread_t                 threads[NUM_COMMAND_HANDLER_THREADS];
+  CommandWorker             workers[NUM_COMMAND_HANDLER_THREADS];
   int                       numThreads;
+  // Distributes the commands of the queue to the workers (since 0.6.2.0)
+  pthread_t                 dispatcher;
+  // The dispatcher waits for the workers to process the commands of a client
+  // (since 0.6.2.0)
+  Mutex                     barrierMutex;
+  Cond                      barrierCond;
+  int                       barrierWaiting;
+
+  // The collected result notifications (since 0.6.2.0)
+  NotificationBatch         notifications;
 } CommandHandler;
 
 /**
@@ -111,7 +204,9 @@ bool initializeCommandHandler(CommandHandler* self, Configuration* cfg,
 void releaseCommandHandler(CommandHandler* self);
 
 /**
- * Handles all commands in the given queue.
+ * Handles all commands in the given queue. A dispatcher thread distributes
+ * the commands to the worker threads by update ID (verify, sign, and delete).
+ * All other commands are processed by the first worker.
  * 
  * @note Spawns a threads, i.e. is non-blocking
  *
@@ -132,7 +227,9 @@ void stopProcessingCommands(CommandHandler* self);
 
 /**
  * Sends a (new) result to all connected clients of the provided update.
- * The UpdateID is embedded in the SRxValidationResult data.
+ * The UpdateID is embedded in the SRxValidationResult data. If a notify delay
+ * is configured the result is collected and send together with the other
+ * results of the client within the delay.
  *
  * @param self Instance
  * @param valResult The validation result including the UpdateID the result
@@ -142,6 +239,15 @@ void stopProcessingCommands(CommandHandler* self);
  */
 bool broadcastResult(CommandHandler* self, SRxValidationResult* valResult);
 
+/**
+ * Send all result notifications collected by broadcastResult right away.
+ *
+ * @param self Instance
+ *
+ * @since 0.6.2.0
+ */
+void flushResults(CommandHandler* self);
+
 bool _isSet(uint32_t bitmask, uint32_t bits);
 
 /**
@@ -20,10 +20,14 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.3.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ *   0.6.2.0 - 2026/10/18
+ *           * Replaced the list and its mutex with a bounded lock free ring
+ *             (sequence numbers per slot). The items are allocated from a slab
+ *             pool. Added handoverCommand and the queue statistics.
  *   0.3.0 - 2013/02/06 - oborchert
  *           * Added Version Control
  *           * Changed log level of output during shutdown
@@ -34,14 +38,35 @@
  * -----------------------------------------------------------------------------
  */
 
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
 #include "server/command_queue.h"
 #include "shared/srx_defs.h"
 #include "shared/srx_packets.h"
 #include "util/log.h"
 #include "util/math.h"
+#include "util/slab.h"
 
 #define HDR "([0x%08X] Command Queue): "
 
+/** The pool of the command queue items */
+static SlabPool _itemPool = SLAB_POOL_INITIALIZER("command-queue-item",
+                                                  sizeof(CommandQueueItem));
+
+/**
+ * Return the monotonic time in nanoseconds.
+ *
+ * @return the time in nanoseconds.
+ */
+static uint64_t _now()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
 /** 
  * Initializes and setup the command queue.
  *
@@ -51,32 +76,48 @@
  */
 bool initializeCommandQueue(CommandQueue* self)
 {
+  uint64_t pos;
+
   if (self->alive)
   {
     RAISE_ERROR("This command queue is already alive!!");  
     return false;
   }
   
-  // Create read and write Mutex
-  if (!initMutex(&self->cmdQueueMutex))
+  self->slots = malloc(sizeof(CommandQueueSlot) * COMMAND_QUEUE_SIZE);
+  if (self->slots == NULL)
   {
+    RAISE_SYS_ERROR("Not enough memory to create the command queue!");
     return false;
   }
+  // Slot i can be written for position i.
+  for (pos = 0; pos < COMMAND_QUEUE_SIZE; pos++)
+  {
+    self->slots[pos].seq  = pos;
+    self->slots[pos].item = NULL;
+  }
 
-  if(!initCond(&self->consumeCond))
+  if (sem_init(&self->usedSlots, 0, 0) != 0)
   {
-    releaseMutex(&self->cmdQueueMutex);
-    pthread_cond_destroy(&self->consumeCond);
+    free(self->slots);
+    self->slots = NULL;
+    return false;
+  }
+  if (sem_init(&self->freeSlots, 0, COMMAND_QUEUE_SIZE) != 0)
+  {
+    sem_destroy(&self->usedSlots);
+    free(self->slots);
+    self->slots = NULL;
     return false;
   }
 
-  // An empty list
-  self->totalItems = 0;
+  // An empty queue
+  self->head             = 0;
+  self->tail             = 0;
+  self->activeThreads    = 0;
+  self->totalItems       = 0;
   self->unprocessedItems = 0;
-  initSList(&self->queue);
-
-  // No item is available, i.e. block fetch
-  self->nextItemNode = NULL;
+  memset(&self->stats, 0, sizeof(CommandQueueStats));
 
   self->alive = true;
   
@@ -93,27 +134,147 @@ void releaseCommandQueue(CommandQueue* self)
   if (self != NULL)
   {
     LOG(LEVEL_DEBUG, HDR "Release Command Queue", pthread_self());    
-    lockMutex(&self->cmdQueueMutex);
     LOG(LEVEL_DEBUG, HDR "Set alive = false", pthread_self());    
-    self->alive = false;
+    __atomic_store_n(&self->alive, false, __ATOMIC_SEQ_CST);
     LOG(LEVEL_DEBUG, HDR "Signal consumer (fetch thread)", pthread_self());        
-    signalCond(&self->consumeCond);    
-    
-    unlockMutex(&self->cmdQueueMutex);
+    // Wake up the threads waiting for an item or a free slot until all of 
+    // them left the queue.
+    while (__atomic_load_n(&self->activeThreads, __ATOMIC_SEQ_CST) > 0)
+    {
+      sem_post(&self->usedSlots);
+      sem_post(&self->freeSlots);
+      usleep(1000);
+    }
     
     LOG(LEVEL_DEBUG, HDR "Now empty command queue", pthread_self());    
     removeAllCommands(self);
        
-    LOG(LEVEL_DEBUG, HDR "Release internal list and Mutex", pthread_self());    
-    // Release all items and the mutexes
-    releaseSList(&self->queue); 
-    releaseMutex(&self->cmdQueueMutex);
+    LOG(LEVEL_DEBUG, HDR "Release internal ring and semaphores", 
+                     pthread_self());    
+    sem_destroy(&self->usedSlots);
+    sem_destroy(&self->freeSlots);
+    free(self->slots);
+    self->slots = NULL;
   }
 }
 
 /**
- * Add a given command into the command queue. THe type of command is stored in 
- * the parameter cmdType.
+ * Write the item into the next slot of the ring. The caller MUST own a free 
+ * slot (freeSlots).
+ *
+ * @param self The command queue
+ * @param item The item
+ */
+static void _enqueueItem(CommandQueue* self, CommandQueueItem* item)
+{
+  CommandQueueSlot* slot;
+  uint64_t pos = __atomic_load_n(&self->head, __ATOMIC_RELAXED);
+  int64_t  diff;
+
+  while (true)
+  {
+    slot = &self->slots[pos & (COMMAND_QUEUE_SIZE - 1)];
+    diff = (int64_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+    if (diff == 0)
+    {
+      if (__atomic_compare_exchange_n(&self->head, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      {
+        break;
+      }
+    }
+    else
+    {
+      if (diff < 0)
+      {
+        // The consumer of this slot did not release it yet.
+        sched_yield();
+      }
+      pos = __atomic_load_n(&self->head, __ATOMIC_RELAXED);
+    }
+  }
+
+  slot->item = item;
+  __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Read the item of the next slot of the ring. The caller MUST own a used
+ * slot (usedSlots) unless the queue is not alive anymore.
+ *
+ * @param self The command queue
+ * @param wait Wait for the item, otherwise return NULL if the ring is empty.
+ *
+ * @return the item or NULL.
+ */
+static CommandQueueItem* _dequeueItem(CommandQueue* self, bool wait)
+{
+  CommandQueueSlot* slot;
+  CommandQueueItem* item;
+  uint64_t pos = __atomic_load_n(&self->tail, __ATOMIC_RELAXED);
+  int64_t  diff;
+
+  while (true)
+  {
+    slot = &self->slots[pos & (COMMAND_QUEUE_SIZE - 1)];
+    diff = (int64_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) 
+                     - (pos + 1));
+    if (diff == 0)
+    {
+      if (__atomic_compare_exchange_n(&self->tail, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      {
+        break;
+      }
+    }
+    else
+    {
+      if (diff < 0)
+      {
+        if (!wait && (__atomic_load_n(&self->head, __ATOMIC_ACQUIRE) == pos))
+        {
+          // The ring is empty.
+          return NULL;
+        }
+        // The producer of this slot did not publish the item yet.
+        sched_yield();
+      }
+      pos = __atomic_load_n(&self->tail, __ATOMIC_RELAXED);
+    }
+  }
+
+  item = slot->item;
+  __atomic_store_n(&slot->seq, pos + COMMAND_QUEUE_SIZE, __ATOMIC_RELEASE);
+
+  return item;
+}
+
+/**
+ * Update the statistics for the fetched item.
+ *
+ * @param self The command queue
+ * @param item The fetched item
+ */
+static void _countFetch(CommandQueue* self, CommandQueueItem* item)
+{
+  uint64_t waited = (_now() - item->queuedAt) / 1000;
+  uint64_t maxWait = __atomic_load_n(&self->stats.maxWaitMicros, 
+                                     __ATOMIC_RELAXED);
+
+  __atomic_sub_fetch(&self->unprocessedItems, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&self->stats.fetched, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&self->stats.waitMicros, waited, __ATOMIC_RELAXED);
+  while ((waited > maxWait)
+         && !__atomic_compare_exchange_n(&self->stats.maxWaitMicros, &maxWait,
+                                         waited, true, __ATOMIC_RELAXED,
+                                         __ATOMIC_RELAXED));
+}
+
+/**
+ * Add a given command into the command queue without copying the data. The
+ * queue takes ownership of the data, it MUST be allocated using malloc and 
+ * will be freed with the command. The data is freed as well if the command
+ * could not be added.
  *
  * @param self The command queue where the command has to be added to
  * @param cmdType The type of the command.
@@ -122,101 +283,126 @@ void releaseCommandQueue(CommandQueue* self)
  * @param dataID An identifier related to the data block. In case of SRX_PROXY
  *               this identifier contains either 0 or the update ID.
  * @param dataLength The length of the data attached to this command queue.
- * @param data The data package attached.
+ * @param data The data package attached (can be NULL).
  *
  * @return true if the command could be added to the queue.
+ *
+ * @since 0.6.2.0
  */
-bool queueCommand(CommandQueue* self, CommandQueueType cmdType,
-                  ServerSocket* svrSock, ServerClient* client, uint32_t dataID,
-                  uint32_t dataLength, uint8_t* data)
+bool handoverCommand(CommandQueue* self, CommandQueueType cmdType,
+                     ServerSocket* svrSock, ServerClient* client, 
+                     uint32_t dataID, uint32_t dataLength, uint8_t* data)
 {
-  // This method is changed in such that the wait mutex is synchronized with
-  // the fetchCommand method. The waitmutex is locked and a notify is called 
-  // once a command is placed and the counter is incresed. The mutex is released
-  // afterwards.
-  
-  if (!self->alive)
+  CommandQueueItem* newItem;
+  uint32_t depth;
+  uint32_t maxDepth;
+
+  // Register before checking alive, releaseCommandQueue waits for us.
+  __atomic_add_fetch(&self->activeThreads, 1, __ATOMIC_SEQ_CST);
+  if (!__atomic_load_n(&self->alive, __ATOMIC_SEQ_CST))
   {
-    LOG(LEVEL_DEBUG, HDR, "Command Queue is not alive anymore, cannot queue "
-                          "command type (%u)!", pthread_self(), cmdType);
+    LOG(LEVEL_DEBUG, HDR "Command Queue is not alive anymore, cannot queue "
+                         "command type (%u)!", pthread_self(), cmdType);
+    __atomic_sub_fetch(&self->activeThreads, 1, __ATOMIC_SEQ_CST);
+    free(data);
     return false;
   }
   
   LOG(LEVEL_DEBUG, HDR "queueComamnd type (%u)", pthread_self(), cmdType);
-  CommandQueueItem* newItem;    
 
-  // Try to add a new item - make sure no one modifies the queue
-  lockMutex(&self->cmdQueueMutex);  
-  newItem = (CommandQueueItem*)appendToSList(&self->queue, 
-                                             sizeof(CommandQueueItem));
-  newItem->consumed = false;
-  
-  // Set the new next node inside this mutex to make sure we -
-  // - get the new item
-  // - unlock only once
-  if (self->nextItemNode == NULL)
-  {
-    self->nextItemNode = getLastNodeOfSList(&self->queue);
-  }
-
-  // Failed to add an item
+  newItem = allocFromSlab(&_itemPool);
   if (newItem == NULL)
   {
-    unlockMutex(&self->cmdQueueMutex);
+    RAISE_SYS_ERROR("Not enough memory to add a command to the queue");
+    __atomic_sub_fetch(&self->activeThreads, 1, __ATOMIC_SEQ_CST);
+    free(data);
     return false;
   }
 
-  // 'NULL' packet
-  if (data == NULL)
-  {
-    newItem->data = NULL;
-  } 
-  else
+  newItem->serverSocket = svrSock;
+  newItem->client       = client;
+  newItem->cmdType      = cmdType;
+  newItem->dataID       = dataID;
+  newItem->consumed     = false;
+  newItem->dataLength   = dataLength;
+  newItem->data         = data;
+  newItem->queuedAt     = _now();
+
+  // Wait for a free slot, blocks as long as the queue is full.
+  if (sem_trywait(&self->freeSlots) != 0)
   {
-    // Try to copy the 'packet' into the command item
-    newItem->data = malloc(dataLength);
-    if (newItem->data == NULL)
+    __atomic_add_fetch(&self->stats.producerWaits, 1, __ATOMIC_RELAXED);
+    while ((sem_wait(&self->freeSlots) != 0) && (errno == EINTR));
+    if (!__atomic_load_n(&self->alive, __ATOMIC_SEQ_CST))
     {
-      RAISE_SYS_ERROR("Not enough memory to copy the data into the queue");
-      deleteFromSList(&self->queue, newItem);
-      
+      // Woken up by releaseCommandQueue
+      __atomic_sub_fetch(&self->activeThreads, 1, __ATOMIC_SEQ_CST);
+      freeToSlab(&_itemPool, newItem);
+      free(data);
       return false;
     }
+  }
+
+  __atomic_add_fetch(&self->totalItems, 1, __ATOMIC_RELAXED);
+  depth = __atomic_add_fetch(&self->unprocessedItems, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&self->stats.queued, 1, __ATOMIC_RELAXED);
+  maxDepth = __atomic_load_n(&self->stats.maxDepth, __ATOMIC_RELAXED);
+  while ((depth > maxDepth)
+         && !__atomic_compare_exchange_n(&self->stats.maxDepth, &maxDepth,
+                                         depth, true, __ATOMIC_RELAXED,
+                                         __ATOMIC_RELAXED));
+
+  _enqueueItem(self, newItem);
+  // Signal new data to consume
+  sem_post(&self->usedSlots);
+  __atomic_sub_fetch(&self->activeThreads, 1, __ATOMIC_SEQ_CST);
+
+  return true;
+}
+
+/**
+ * Add a given command into the command queue. THe type of command is stored in 
+ * the parameter cmdType.
+ *
+ * @param self The command queue where the command has to be added to
+ * @param cmdType The type of the command.
+ * @param svrSock The server socket
+ * @param client The server client
+ * @param dataID An identifier related to the data block. In case of SRX_PROXY
+ *               this identifier contains either 0 or the update ID.
+ * @param dataLength The length of the data attached to this command queue.
+ * @param data The data package attached.
+ *
+ * @return true if the command could be added to the queue.
+ */
+bool queueCommand(CommandQueue* self, CommandQueueType cmdType,
+                  ServerSocket* svrSock, ServerClient* client, uint32_t dataID,
+                  uint32_t dataLength, uint8_t* data)
+{
+  uint8_t* copy = NULL;
+
+  if (data != NULL)
+  {
     //TODO: BZ197 This might be revisited - Dirty BUG test
-    if (dataLength < 1000000) // dirty bug test - increased by factor 10
+    if (dataLength >= 1000000) // dirty bug test - increased by factor 10
     {
-      memcpy(newItem->data, data, dataLength); 
       // SEGV due to dataLength : 50529027 (0x03030303)
-    }
-    else
-    {
       RAISE_SYS_ERROR("Given datalength too big due to transmission error "
         "- Inform developers with reference code BZ197!");
-      deleteFromSList(&self->queue, newItem);
-      unlockMutex(&self->cmdQueueMutex);
       return false;
     }
+    // Try to copy the 'packet' into the command item
+    copy = malloc(dataLength);
+    if (copy == NULL)
+    {
+      RAISE_SYS_ERROR("Not enough memory to copy the data into the queue");
+      return false;
+    }
+    memcpy(copy, data, dataLength); 
   }
 
-  // Set the other item members
-  newItem->serverSocket = svrSock;
-  newItem->client       = client;
-  newItem->cmdType      = cmdType;
-  newItem->dataID       = dataID;
-  newItem->dataLength   = dataLength;
-    
-  self->totalItems++;
-  self->unprocessedItems++;
-  
-  LOG(LEVEL_DEBUG, HDR "Signale new data to consume...%s", pthread_self(),
-                   __FUNCTION__);
-  signalCond(&self->consumeCond);
-  
-  LOG(LEVEL_DEBUG, HDR "UNLOCK readWriteLock...%s", pthread_self(),
-                   __FUNCTION__);
-  unlockMutex(&self->cmdQueueMutex);
-
-  return true;
+  return handoverCommand(self, cmdType, svrSock, client, dataID, dataLength,
+                         copy);
 }
 
 /**
@@ -230,64 +416,51 @@ bool queueCommand(CommandQueue* self, CommandQueueType cmdType,
  *  */
 CommandQueueItem* fetchNextCommand(CommandQueue* self)
 {
-  // Changed the mutex management in this method. It will lock the wait mutex 
-  // and wait unti la command is in the queue. once a command is read from the 
-  // queue the wait mutesx will be unlocked and the command will be returned.
-  // This method plays the loc/unlock mutex game with queuecommand
-  
   CommandQueueItem* item;
   
   LOG(LEVEL_DEBUG, HDR "Fetch next command from command queue...", 
                    pthread_self());
 
-  if (!self->alive)
+  // Register before checking alive, releaseCommandQueue waits for us.
+  __atomic_add_fetch(&self->activeThreads, 1, __ATOMIC_SEQ_CST);
+  if (!__atomic_load_n(&self->alive, __ATOMIC_SEQ_CST))
   {
+    __atomic_sub_fetch(&self->activeThreads, 1, __ATOMIC_SEQ_CST);
     RAISE_ERROR ("Command queue is not alive anymore, fetching commands is not"
                  " possible!");
     return NULL;
   }
  
-  LOG(LEVEL_DEBUG, HDR "Request access lock to cmd Queue", pthread_self());
-  lockMutex(&self->cmdQueueMutex);
-
   // Wait until a new item is in the queue
-  while (self->alive && self->unprocessedItems == 0)
+  if (sem_trywait(&self->usedSlots) != 0)
   {
     LOG(LEVEL_DEBUG, HDR "No command in queue, wait until command arrives.", 
                      pthread_self());
     // Will be woken up by queueCommand
-    waitCond(&self->consumeCond, &self->cmdQueueMutex, 0);
+    while ((sem_wait(&self->usedSlots) != 0) && (errno == EINTR));
     LOG(LEVEL_DEBUG, HDR "Received notification of command arrival.", 
                      pthread_self());
   }
   
-  if (!self->alive)
+  if (!__atomic_load_n(&self->alive, __ATOMIC_SEQ_CST))
   {
+    __atomic_sub_fetch(&self->activeThreads, 1, __ATOMIC_SEQ_CST);
     LOG(LEVEL_INFO, HDR "Command queue is terminated during fetching command, "
                         "abort fetching!!!", pthread_self());
-    unlockMutex(&self->cmdQueueMutex);
     return NULL;
   }
   
-  // Retrieve the item and set the fetcher to the next one.
-  item = (CommandQueueItem*)self->nextItemNode->data;
-  self->unprocessedItems--;				// SEE also ./util/slist.c:106    
-  if (item == NULL)
-  {
-    RAISE_ERROR("Fatal CommandQueue encountered an empty command.");
-  }
+  // Retrieve the item and release its slot.
+  item = _dequeueItem(self, true);
   if (item->consumed)
   {
     RAISE_ERROR("Fetch an already consumed command!!");
   }
   // Indicate this item is consumed and can be deleted.
   item->consumed = true;
-  
-  //move to next item.
-  self->nextItemNode = getNextNodeOfSListNode(self->nextItemNode);
-  // TODO: Check what happens to the memory allocated to store the command!!!
-  // Unlock the write mutex
-  unlockMutex(&self->cmdQueueMutex);  
+  _countFetch(self, item);
+  sem_post(&self->freeSlots);
+  __atomic_sub_fetch(&self->activeThreads, 1, __ATOMIC_SEQ_CST);
 
   return item;
 }
@@ -302,16 +475,13 @@ CommandQueueItem* fetchNextCommand(CommandQueue* self)
 void deleteCommand(CommandQueue* self, CommandQueueItem* item)
 {
   LOG(LEVEL_DEBUG, HDR "Delete the given command queue item.", pthread_self());
-  lockMutex (&self->cmdQueueMutex);
   // Free The packet data within the item
   if(item != NULL) 
   {
     free(item->data);
+    freeToSlab(&_itemPool, item);
+    __atomic_sub_fetch(&self->totalItems, 1, __ATOMIC_RELAXED);
   }
-  self->totalItems--;
-  // The delete from list also frees the item.
-  deleteFromSList(&self->queue, item);
-  unlockMutex(&self->cmdQueueMutex);
 }
 
 /**
@@ -323,34 +493,33 @@ void removeAllCommands(CommandQueue* self)
 {
   LOG(LEVEL_DEBUG, HDR "Remove all commands from the command queue.",
                    pthread_self());
-  SListNode* currNode;
-
-  // No adding or single removing allowed
-  lockMutex(&self->cmdQueueMutex);
+  CommandQueueItem* item;
 
-  // Release all packets stored in the items
-  FOREACH_SLIST(&self->queue, currNode)
+  // Take the items that are not fetched yet. Once the queue is not alive
+  // anymore the semaphores are not used anymore.
+  while (true)
   {
-    void* p = ((CommandQueueItem*)getDataOfSListNode(currNode))->data;
-    if (p)
+    if (__atomic_load_n(&self->alive, __ATOMIC_SEQ_CST))
+    {
+      if (sem_trywait(&self->usedSlots) != 0)
+      {
+        break;
+      }
+      item = _dequeueItem(self, true);
+    }
+    else
     {
-      free(p);
+      item = _dequeueItem(self, false);
+      if (item == NULL)
+      {
+        break;
+      }
     }
+    item->consumed = true;
+    _countFetch(self, item);
+    sem_post(&self->freeSlots);
+    deleteCommand(self, item);
   }
-  // Now delete the items.
-  emptySList(&self->queue);
-
-  if (self->nextItemNode != NULL)
-  {
-    RAISE_SYS_ERROR("Queue[0x%08X] Removing of all commands without success!", 
-                    self);
-  };
-  
-  self->totalItems       = self->queue.size;
-  self->unprocessedItems = self->nextItemNode == NULL ? 0 : self->totalItems;
-  
-  // Grant write access again
-  unlockMutex(&self->cmdQueueMutex); 
 }
 
 /**
@@ -362,7 +531,7 @@ void removeAllCommands(CommandQueue* self)
  */
 inline int getTotalQueueSize(CommandQueue* self)
 {
-  return self->totalItems;
+  return __atomic_load_n(&self->totalItems, __ATOMIC_RELAXED);
 }
 
 /**
@@ -374,5 +543,32 @@ inline int getTotalQueueSize(CommandQueue* self)
  */
 inline int getUnprocessedQueueSize(CommandQueue* self)
 {
-  return self->unprocessedItems;
+  return __atomic_load_n(&self->unprocessedItems, __ATOMIC_RELAXED);
+}
+
+/**
+ * Fill the statistics of the command queue.
+ *
+ * @param self The command queue
+ * @param stats The statistics to be filled
+ *
+ * @since 0.6.2.0
+ */
+void getCommandQueueStatistics(CommandQueue* self, CommandQueueStats* stats)
+{
+  int unprocessed = getUnprocessedQueueSize(self);
+
+  stats->depth         = unprocessed > 0 ? (uint32_t)unprocessed : 0;
+  stats->totalItems    = (uint32_t)getTotalQueueSize(self);
+  stats->maxDepth      = __atomic_load_n(&self->stats.maxDepth, 
+                                         __ATOMIC_RELAXED);
+  stats->queued        = __atomic_load_n(&self->stats.queued, __ATOMIC_RELAXED);
+  stats->fetched       = __atomic_load_n(&self->stats.fetched, 
+                                         __ATOMIC_RELAXED);
+  stats->waitMicros    = __atomic_load_n(&self->stats.waitMicros, 
+                                         __ATOMIC_RELAXED);
+  stats->maxWaitMicros = __atomic_load_n(&self->stats.maxWaitMicros, 
+                                         __ATOMIC_RELAXED);
+  stats->producerWaits = __atomic_load_n(&self->stats.producerWaits, 
+                                         __ATOMIC_RELAXED);
 }
@@ -20,10 +20,16 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.5.0.6
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ *   0.6.2.0 - 2026/10/18
+ *             * The queue is a bounded lock free ring of items. Idle command
+ *               handler threads and producers of a full queue are parked on
+ *               semaphores.
+ *             * Added handoverCommand which takes ownership of the data.
+ *             * Added getCommandQueueStatistics.
  *   0.5.0.6 - 2018/11/20 - oborchert
  *             * Removed "inline" keyword from functions - caused linker error 
  *               on Ubuntu 18
@@ -39,12 +45,15 @@
 #ifndef __COMMAND_QUEUE_H__
 #define __COMMAND_QUEUE_H__
 
+#include <semaphore.h>
 #include "shared/srx_defs.h"
 #include "shared/srx_packets.h"
 #include "util/mutex.h"
 #include "util/packet.h"
 #include "util/server_socket.h"
-#include "util/slist.h"
+
+/** The number of items the command queue can hold, MUST be a power of 2. */
+#define COMMAND_QUEUE_SIZE 65536
 
 // Specifies the types of commands the queue can handle.
 typedef enum {
@@ -63,24 +72,57 @@ typedef struct {
   bool             consumed;     // Indicated if this element is already fetched
   uint32_t         dataLength;   // Length in Bytes of \c packet
   uint8_t*         data;         // The actual packet (= data)
+  uint64_t         queuedAt;     // The time the item was queued (nanoseconds)
 } CommandQueueItem;
 
+/**
+ * A slot of the ring. The sequence number tells producers and consumers if
+ * the slot can be written or read for a given position.
+ */
+typedef struct {
+  uint64_t          seq;
+  CommandQueueItem* item;
+} CommandQueueSlot;
+
+/**
+ * The statistics of the command queue.
+ */
+typedef struct {
+  /** Number of items queued and not yet fetched */
+  uint32_t depth;
+  /** The largest depth seen */
+  uint32_t maxDepth;
+  /** Number of items queued and not yet deleted */
+  uint32_t totalItems;
+  /** Number of items queued since start */
+  uint64_t queued;
+  /** Number of items fetched since start */
+  uint64_t fetched;
+  /** Accumulated time in microseconds items waited in the queue */
+  uint64_t waitMicros;
+  /** Longest time in microseconds an item waited in the queue */
+  uint64_t maxWaitMicros;
+  /** Number of times a producer had to wait for a free slot */
+  uint64_t producerWaits;
+} CommandQueueStats;
+
 /**
  * A single Command Queue.
  */
 typedef struct {
-  SList       queue;          // The list that actually represents the queue.
-  SListNode*  nextItemNode;   // The next node containing a CommandQueueItem to be 
-                              // fetched.
-  Mutex       cmdQueueMutex; // Used to safely access the queue in read and
-                              // write
-  Cond        consumeCond;    // The condition for consuming elements from the 
-                              // command queue
+  CommandQueueSlot* slots;    // The ring of COMMAND_QUEUE_SIZE slots
+  uint64_t    head;           // The next position to write
+  uint64_t    tail;           // The next position to read
+  sem_t       usedSlots;      // Number of items ready to be fetched
+  sem_t       freeSlots;      // Number of slots free to be written
+  int         activeThreads;  // Number of threads in queue or fetch
 
   int         totalItems;     // Total number of Items in the queue, unprocessed 
                               // and processed.
   int         unprocessedItems; // THe number of unprocessed Items.
   bool        alive;          // used to stop fetching commands
+
+  CommandQueueStats stats;    // The counters, updated atomically.
 } CommandQueue;
 
 /** 
@@ -118,6 +160,29 @@ bool queueCommand(CommandQueue* self, CommandQueueType cmdType,
                   ServerSocket* svrSock, ServerClient* client, uint32_t dataID,
                   uint32_t dataLength, uint8_t* data);
 
+/**
+ * Add a given command into the command queue without copying the data. The
+ * queue takes ownership of the data, it MUST be allocated using malloc and 
+ * will be freed with the command. The data is freed as well if the command
+ * could not be added.
+ *
+ * @param self The command queue where the command has to be added to
+ * @param cmdType The type of the command.
+ * @param svrSock The server socket
+ * @param client The server client
+ * @param dataID An identifier related to the data block. In case of SRX_PROXY
+ *               this identifier contains either 0 or the update ID.
+ * @param dataLength The length of the data attached to this command queue.
+ * @param data The data package attached (can be NULL).
+ *
+ * @return true if the command could be added to the queue.
+ *
+ * @since 0.6.2.0
+ */
+bool handoverCommand(CommandQueue* self, CommandQueueType cmdType,
+                     ServerSocket* svrSock, ServerClient* client, 
+                     uint32_t dataID, uint32_t dataLength, uint8_t* data);
+
 /** 
  * Returns the next item in the queue. The Item is NOT removed from the queue
  * until dequeueCommand is called. 
@@ -161,5 +226,15 @@ int getTotalQueueSize(CommandQueue* self);
  * @return the number of unprocessed items in the queue.
  */
 int getUnprocessedQueueSize(CommandQueue* self);
+
+/**
+ * Fill the statistics of the command queue.
+ *
+ * @param self The command queue
+ * @param stats The statistics to be filled
+ *
+ * @since 0.6.2.0
+ */
+void getCommandQueueStatistics(CommandQueue* self, CommandQueueStats* stats);
 #endif // !__COMMAND_QUEUE_H__
 
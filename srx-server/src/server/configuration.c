@@ -20,10 +20,14 @@
  * other licenses. Please refer to the licenses of all libraries required
  * by this software.
  *
- * @version 0.6.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Added parameter async_log / --async-log
+ *           * Added parameter mode.epoll / --mode.epoll
+ *           * Added parameter notify_delay / --notify-delay
  * 0.6.0.0 - 2021/02/16 - oborchert
  *           * Added RPKI-Router-Protocol Version 2
  * 0.5.1.1 - 2020/07/22 - oborchert
@@ -117,6 +121,12 @@
 #define CFG_PARAM_MODE_NO_SEND_QUEUE 10
 #define CFG_PARAM_MODE_NO_RCV_QUEUE  11
 
+#define CFG_PARAM_ASYNC_LOG 12
+
+#define CFG_PARAM_MODE_EPOLL 13
+
+#define CFG_PARAM_NOTIFY_DELAY 14
+
 #define HDR "([0x%08X] Configuration): "
 
 #ifndef SYSCONFDIR
@@ -150,9 +160,11 @@ static const struct option _LONG_OPTIONS[] = {
   { "log",          required_argument, NULL, 'l'},
 
   { "syslog",       no_argument, NULL, CFG_PARAM_SYSLOG},
+  { "async-log",    no_argument, NULL, CFG_PARAM_ASYNC_LOG},
 
   { "proxy-clients", required_argument, NULL, 'C'},
   { "keep-window", required_argument, NULL, 'k'},
+  { "notify-delay", required_argument, NULL, CFG_PARAM_NOTIFY_DELAY},
 
   { "port",             required_argument, NULL, 'p'},
   { "console.port",     required_argument, NULL, 'c'},
@@ -167,6 +179,7 @@ static const struct option _LONG_OPTIONS[] = {
 
   { "mode.no-sendqueue", no_argument, NULL, CFG_PARAM_MODE_NO_SEND_QUEUE},
   { "mode.no-receivequeue", no_argument, NULL, CFG_PARAM_MODE_NO_RCV_QUEUE},
+  { "mode.epoll",        no_argument, NULL, CFG_PARAM_MODE_EPOLL},
 
   { NULL, 0, NULL, 0}
 };
@@ -186,11 +199,16 @@ static const char* _USAGE_TEXT =
   "                               (6)=INFO, (7)=DEBUG\n"
   "  -l, --log <file>             Write all messages to a file\n"
   "      --syslog                 Send all messages to syslog\n"
+  "      --async-log              Write all messages from a background thread\n"
   "  -C  --proxy-clients          Minimum expected number of proxy clients\n"
   "  -s  --sync                   Send synchronization request each time a\n"
   "                               proxy connection is established!\n"
   "  -k  --keep-window <sec>      The default keepWindow in seconds. Zero\n"
   "                               deactivates this feature\n"
+  "      --notify-delay <ms>      Collect result changes for up to <ms>\n"
+  "                               milliseconds and send them to each proxy\n"
+  "                               together (def.: 5). Zero deactivates this\n"
+  "                               feature\n"
   "  -p, --port <no>              Use a different listening port (def.: 17900)\n"
   "  -c, --console.port <no>      Use a different console port (def.: 17901)\n"
   "  -P, --console.password <pwd> Password for remote shutdown\n"
@@ -206,6 +224,9 @@ static const char* _USAGE_TEXT =
   "      --mode.no-receivequeue   Disable the receive queue. This queue allows"
   "\n                               to push the processing of packets into\n"
   "                                its own thread. This is experimental.\n"
+  "      --mode.epoll             Serve all proxy connections using epoll and\n"
+  "                               a fixed pool of threads instead of one\n"
+  "                               thread per connection. This is experimental.\n"
 ;
 
 /**
@@ -227,6 +248,7 @@ void initConfiguration(Configuration* self)
   self->loglevel = LEVEL_ERROR;
   self->syncAfterConnEstablished = false;
   self->msgDest = MSG_DEST_STDERR;
+  self->asyncLog = false;
   self->msgDestFilename = NULL;
 
   self->server_port  = 17900;
@@ -244,8 +266,10 @@ void initConfiguration(Configuration* self)
 
   self->mode_no_sendqueue = false;
   self->mode_no_receivequeue = false;
+  self->mode_epoll = false;
 
   self->defaultKeepWindow = SRX_DEFAULT_KEEP_WINDOW; // from srx_defs.h
+  self->notifyDelay       = DEFAULT_NOTIFY_DELAY;
   memset(&self->mapping_routerID, 0, MAX_PROXY_MAPPINGS);
 }
 
@@ -376,6 +400,7 @@ int parseProgramArgs(Configuration* self, int argc, const char** argv,
         case 'l':
         case CFG_PARAM_LOGLEVEL:
         case CFG_PARAM_SYSLOG:
+        case CFG_PARAM_ASYNC_LOG:
         case 'p':
         case 'c':
         case 'P':
@@ -385,6 +410,8 @@ int parseProgramArgs(Configuration* self, int argc, const char** argv,
         case CFG_PARAM_CREDITS:
         case CFG_PARAM_MODE_NO_SEND_QUEUE:
         case CFG_PARAM_MODE_NO_RCV_QUEUE:
+        case CFG_PARAM_MODE_EPOLL:
+        case CFG_PARAM_NOTIFY_DELAY:
           optc = -1;
         default:
           printf("Use '-h' for help!\n");
@@ -421,6 +448,9 @@ int parseProgramArgs(Configuration* self, int argc, const char** argv,
       case 'C' :
         self->expectedProxies = (uint32_t)strtol(optarg, NULL, 10);
         break;
+      case CFG_PARAM_NOTIFY_DELAY:
+        self->notifyDelay = (int)strtol(optarg, NULL, 10);
+        break;
       case'k' :
         self->defaultKeepWindow = (uint16_t)strtol(optarg, NULL,
                                                    SRX_DEFAULT_KEEP_WINDOW);
@@ -456,6 +486,9 @@ int parseProgramArgs(Configuration* self, int argc, const char** argv,
       case CFG_PARAM_SYSLOG:
         self->msgDest = MSG_DEST_SYSLOG;
         break;
+      case CFG_PARAM_ASYNC_LOG:
+        self->asyncLog = true;
+        break;
       case 'p':
         if (optarg == NULL)
         {
@@ -570,6 +603,10 @@ int parseProgramArgs(Configuration* self, int argc, const char** argv,
         self->mode_no_receivequeue = true;
         printf("Turn off receive queue!\n");
         break;
+      case CFG_PARAM_MODE_EPOLL:
+        self->mode_epoll = true;
+        printf("Turn on epoll mode!\n");
+        break;
       default:
         RAISE_ERROR("Usage: %s %s", argv[0], _USAGE_TEXT);        
         return 0;
@@ -636,11 +673,17 @@ bool readConfigFile(Configuration* self, const char* filename)
 
   if ( config_lookup_int(&cfg, "keep-window", &intVal) == CONFIG_TRUE )
   { self->defaultKeepWindow = (int)intVal; }
+
+  if ( config_lookup_int(&cfg, "notify_delay", &intVal) == CONFIG_TRUE )
+  { self->notifyDelay = (int)intVal; }
   
   // Global - message destination
   if ( config_lookup_bool(&cfg, "syslog", (int*)&boolVal) == CONFIG_TRUE )
   { useSyslog = (bool)boolVal; }
 
+  if ( config_lookup_bool(&cfg, "async_log", (int*)&boolVal) == CONFIG_TRUE )
+  { self->asyncLog = (bool)boolVal; }
+
   if (config_lookup_int(&cfg, "loglevel", &intVal) == CONFIG_TRUE)
   {
     if ((intVal >= LEVEL_ERROR) && ((intVal <= LEVEL_COMM)))
@@ -783,6 +826,10 @@ bool readConfigFile(Configuration* self, const char* filename)
     if ( config_setting_lookup_bool(sett, "no-receivequeue", (int*)&boolVal) 
          == CONFIG_TRUE )
     { self->mode_no_receivequeue = (bool)boolVal; }
+
+    if ( config_setting_lookup_bool(sett, "epoll", (int*)&boolVal) 
+         == CONFIG_TRUE )
+    { self->mode_epoll = (bool)boolVal; }
   }
 
   // optional mapping configuration
@@ -840,6 +887,8 @@ bool isCompleteConfiguration(Configuration* self)
                 "The keep-window time can not be negative!");
   ERROR_IF_TRUE(self->defaultKeepWindow > 0xFFFF,
                 "The keep-window time more than 65535 seconds!");
+  ERROR_IF_TRUE(self->notifyDelay < 0,
+                "The notify-delay time can not be negative!");
 
   return true;
 }
@@ -20,10 +20,14 @@
  * other licenses. Please refer to the licenses of all libraries required
  * by this software.
  *
- * @version 0.6.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Added asyncLog to configuration
+ *            * Added mode_epoll to configuration
+ *            * Added notifyDelay to configuration
  * 0.6.0.0  - 2021/06/26 - kyehwanl
  *            * Added as_relationship_data to configuration
  * 0.5.0.0  - 2017/07/05 - oborchert
@@ -57,6 +61,10 @@
 
 #define MAX_PROXY_MAPPINGS 256
 
+/** The default time in milliseconds result changes are collected before they
+ * are send to the proxies. */
+#define DEFAULT_NOTIFY_DELAY 5
+
 // CONFIG_INT will be set to int for 64 bit platform during configure. See
 // configuration.ac - used for libconfig
 #ifndef LCONFIG_INT
@@ -86,10 +94,15 @@ typedef struct {
   int                   loglevel;
   /** Where should all messages go (default: MSG_DEST_STDERR) */
   MessagesDestination   msgDest;
+  /** Write the messages from a background thread (default: \c false) */
+  bool                  asyncLog;
   /** Send a synchronization request each time after a proxy connection is
    * established. This allows to process validation requests for updates
    * received by a router before a connection to SRx could be established. */
   bool                  syncAfterConnEstablished;
+  /** The time in milliseconds result changes are collected per proxy before
+   * they are send together. Zero sends each notification right away. */
+  int                   notifyDelay;
 
   /** Set only if \c msgDest is MSG_DEST_FILENAME */
   char*                 msgDestFilename;
@@ -126,6 +139,9 @@ typedef struct {
   bool                  mode_no_sendqueue;
   /** If set true, disable the receiver queue. */
   bool                  mode_no_receivequeue;
+  /** If set true, serve all proxy connections with an epoll based pool of
+   * worker threads instead of one thread per connection. */
+  bool                  mode_epoll;
 
   /** The configured default keep window. Zero = deactivate.*/
   int                   defaultKeepWindow;
@@ -20,10 +20,18 @@
  * other licenses. Please refer to the licenses of all libraries required
  * by this software.
  *
- * @version 0.6.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Use printAllAspaObjects for "show-aspa".
+ *           * Use getNumberOfUpdates, the update cache is sharded.
+ *           * Added command "show-memory" to display the slab pool statistics.
+ *           * Display the statistics of the command queue.
+ *           * Display the statistics of the update cache garbage collector
+ *             with "show-memory".
+ *           * Use findUpdate and numUpdates of the prefix cache.
  * 0.6.0.0 - 2021/02.26 - kyehwanl
  *           * Added CST_VERSION, CST_ASPATH, and CST_ASPA to ConsoleShowType.
  *           * Added commands "show-aspa" and "show-aspath".
@@ -98,6 +106,7 @@
 #include "util/log.h"
 #include "util/server_socket.h"
 #include "util/prefix.h"
+#include "util/slab.h"
 #include "util/slist.h"
 
 #define MIN_CONSOLE_BUFFER 1024
@@ -111,6 +120,7 @@
 #define CON_STDOUT   '-'
 
 #define INITIAL_BUFFER_SIZE 1
+#define MAX_SLAB_POOLS_TO_DISPLAY 32
 
 typedef enum {
   CST_UPDATES = 0,
@@ -149,6 +159,7 @@ static void doNumProxies(SRXConsole* self, char* cmd, char* param);
 static void doCommandQueue(SRXConsole* self, char* cmd, char* param);
 static void doDumpPCache(SRXConsole* self, char* cmd, char* param);
 static void doDumpUCache(SRXConsole* self, char* cmd, char* param);
+static void doShowMemory(SRXConsole* self, char* cmd, char* param);
 
 static uint32_t hexToInt(char[]);
 
@@ -236,6 +247,9 @@ char* CON_HELP_RESP= "\r\nAvailable commands are:\r\n"
                  "\r\n                       cache db \r\n"
                  " show-aspath           Show AS path list received from the"
                  "\r\n                       clients \r\n"
+                 " show-memory           Display the statistics of the slab"
+                 "\r\n                       memory pools and the update cache"
+                 "\r\n                       garbage collector\r\n"
                  "\r\n\r\n";
 
 char* CON_VERSION_CMD  = "show-version";
@@ -273,6 +287,8 @@ char* CON_DUMP_UCACHE_CMD = "dump-ucache";
 char* CON_SHASPATH_CMD = "show-aspath";
 char* CON_SHASPA_OBJ_CMD = "show-aspa";
 
+char* CON_SHMEM_CMD = "show-memory";
+
 char* CON_NOTSUPPORTED_CMD = "Command not supported yet!\r\n";
 char* CON_UNKNOWN_CMD = "I don\'t understand the command "
                                                     "- Use \'help\'!\r\n";
@@ -847,6 +863,12 @@ static bool doProcessCommand(SRXConsole* self)
   {
     doShow(self, cmd, param, CST_ASPA);
   }
+  // show the slab pool statistics
+  else if (    (cmdLen == strlen(CON_SHMEM_CMD))
+            && (strncmp(CON_SHMEM_CMD, cmd, cmdLen)==0))
+  {
+    doShowMemory(self, cmd, param);
+  }
 
   else
   {
@@ -915,8 +937,7 @@ static void doShowASPA(SRXConsole* self, char* cmd, char* param)
 
   RPKIHandler* handler = self->rpkiHandler;
   ASPA_DBManager* aspaDBManager = handler->aspaDBManager;
-  TrieNode *root = aspaDBManager->tableRoot;
-  printAllLeafNode(root);
+  printAllAspaObjects(aspaDBManager);
 
   sendToConsoleClient(self, out, true);
 }
@@ -1358,6 +1379,7 @@ static char* _showROACoverage_INVALID(char* msgPtr, uint8_t prefixLen,
  * @param noLines Determine how many distinct ROAs (max) should be displayed!
  */
 static void _showRoaCoverage(SRXConsole* self, SRxUpdateID updateID,
+                             IPPrefix* prefix,
                              SRxValidationResultVal roaResultType,
                              uint16_t noLines)
 {
@@ -1371,18 +1393,7 @@ static void _showRoaCoverage(SRXConsole* self, SRxUpdateID updateID,
 
   // Get the Update
   PrefixCache* pCache = self->rpkiHandler->prefixCache;
-  SListNode* node = pCache->updates.root;
-
-  // Not very efficient but to be changed in version 0.3
-  while ((node != NULL) && (pcUpdate == NULL))
-  {
-    pcUpdate = (PC_Update*)node->data;
-    if (pcUpdate->updateID != updateID)
-    {
-      node = node->next;
-      pcUpdate = NULL;
-    }
-  }
+  pcUpdate = findUpdate(pCache, &updateID, prefix);
   if (pcUpdate == NULL)
   {
     msgPtr += sprintf(msgPtr, "ERROR: No data found in prefix cache!\r\n");
@@ -1514,7 +1525,8 @@ static void doShowUpdateID(SRXConsole* self, SRxUpdateID* updateID,
                       getSRxResultSrcStr(stat.defResult.resSourceBGPSEC));
 
       sendToConsoleClient(self, msg, false);
-      _showRoaCoverage(self, uID, stat.result.roaResult, maxNumPrexix);
+      _showRoaCoverage(self, uID, &stat.prefix, stat.result.roaResult,
+                       maxNumPrexix);
     }
     else
     {
@@ -1823,10 +1835,10 @@ static void doNumUpdates(SRXConsole* self, char* cmd, char* param)
   // produce a \0 terminated string
   memset(str,'\0',256);
 
-  elements = self->commandHandler->updCache->allItems.size;
+  elements = getNumberOfUpdates(self->commandHandler->updCache);
   sprintf(str, "Update Cache: %u updates stored.\r\n", elements);
   sendToConsoleClient(self, str, false);
-  elements = self->commandHandler->rpkiHandler->prefixCache->updates.size;
+  elements = self->commandHandler->rpkiHandler->prefixCache->numUpdates;
   sprintf(str, "Prefix Cache: %u update shadows stored.\r\n", elements);
   sendToConsoleClient(self, str, true);
 }
@@ -1882,22 +1894,91 @@ static void doNumProxies(SRXConsole* self, char* cmd, char* param)
 static void doCommandQueue(SRXConsole* self, char* cmd, char* param)
 {
   LOG(LEVEL_DEBUG, CP1 CP2 "%s %s", self->clientSockFd, cmd, param);
-  char str[256];
-  int total = getTotalQueueSize(self->commandHandler->queue);
-  int unprocessed = getUnprocessedQueueSize(self->commandHandler->queue);
+  char str[512];
+  CommandQueueStats stats;
+  unsigned long long avgWait;
+
+  // Here it is for display only, synchronizing is not necessary
+  getCommandQueueStatistics(self->commandHandler->queue, &stats);
+  avgWait = stats.fetched > 0 ? stats.waitMicros / stats.fetched : 0;
   // produce a \0 terminated string
-  memset(str,'\0',256);
+  memset(str,'\0',512);
 
-  // Get the number of elements from the command queue. Here is is for display
-  // only, synchronizing is not necessary
-  sprintf(str, "Command handler:\r\n"
+  snprintf(str, 512, "Command handler:\r\n"
                "====================================\r\n"
                "Total commands........: %06u\r\n"
                "Unprocessed commands..: %06u\r\n"
-               "====================================\r\n", total, unprocessed);
+               "Max. queue depth......: %06u\r\n"
+               "Queued commands.......: %llu\r\n"
+               "Fetched commands......: %llu\r\n"
+               "Avg. wait (us)........: %llu\r\n"
+               "Max. wait (us)........: %llu\r\n"
+               "Producer waits........: %llu\r\n"
+               "====================================\r\n",
+               stats.totalItems, stats.depth, stats.maxDepth,
+               (unsigned long long)stats.queued,
+               (unsigned long long)stats.fetched, avgWait,
+               (unsigned long long)stats.maxWaitMicros,
+               (unsigned long long)stats.producerWaits);
   sendToConsoleClient(self, str, true);
 }
 
+/**
+ * Display the statistics of the slab pools, one line per pool, and of the
+ * update cache garbage collector.
+ *
+ * @param self Pointer to the console
+ * @param cmd The command
+ * @param param the parameters (empty)
+ *
+ * @since 0.6.2.0
+ */
+static void doShowMemory(SRXConsole* self, char* cmd, char* param)
+{
+  LOG(LEVEL_DEBUG, CP1 CP2 "%s %s", self->clientSockFd, cmd, param);
+  SlabStats stats[MAX_SLAB_POOLS_TO_DISPLAY];
+  char str[256];
+  int  numPools = getSlabStatistics(stats, MAX_SLAB_POOLS_TO_DISPLAY);
+  int  idx;
+
+  // produce a \0 terminated string
+  memset(str,'\0',256);
+  sprintf(str, "Slab pools:\r\n"
+               "%-20s %6s %6s %10s %10s %8s %12s %12s\r\n",
+               "pool", "size", "slabs", "capacity", "in use", "cached",
+               "allocs", "frees");
+  sendToConsoleClient(self, str, false);
+
+  if (numPools > MAX_SLAB_POOLS_TO_DISPLAY)
+  {
+    numPools = MAX_SLAB_POOLS_TO_DISPLAY;
+  }
+  for (idx = 0; idx < numPools; idx++)
+  {
+    snprintf(str, 256, "%-20s %6zu %6u %10llu %10llu %8llu %12llu %12llu\r\n",
+             stats[idx].name, stats[idx].slotSize, stats[idx].numSlabs,
+             (unsigned long long)stats[idx].capacity,
+             (unsigned long long)stats[idx].inUse,
+             (unsigned long long)stats[idx].cached,
+             (unsigned long long)stats[idx].allocs,
+             (unsigned long long)stats[idx].frees);
+    sendToConsoleClient(self, str, false);
+  }
+
+  UC_GCStats gcStats;
+  getUpdateCacheGCStats(self->commandHandler->updCache, &gcStats);
+  snprintf(str, 256, "\r\nUpdate cache garbage collector:\r\n"
+           "  scheduled updates: %u\r\n"
+           "  reclaimed updates: %llu (%llu bytes)\r\n"
+           "  release pending  : %u\r\n"
+           "  passes           : %llu\r\n",
+           gcStats.scheduled, (unsigned long long)gcStats.reclaimed,
+           (unsigned long long)gcStats.reclaimedBytes, gcStats.deferred,
+           (unsigned long long)gcStats.passes);
+  sendToConsoleClient(self, str, false);
+  sendToConsoleClient(self, "\r\n", true);
+}
+
 /**
  * Dump the prefix cache into a file/console on the server side.
  * Use parameter '-' to dump it on the console of the server.
@@ -1952,7 +2033,7 @@ static void doDumpUCache(SRXConsole* self, char* cmd, char* param)
   char* fileName = (ch == CON_STDOUT) ? "standard out" : param;
   // Get the number of elements from the command queue. Here is is for display
   // only, synchronizing is not necessary
-  elements = self->commandHandler->updCache->allItems.size;
+  elements = getNumberOfUpdates(self->commandHandler->updCache);
   sprintf(str, "Update Cache has %u items. Start export into %s!\r\n",
           elements, fileName);
   sendToConsoleClient(self, str, true);
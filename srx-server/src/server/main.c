@@ -25,7 +25,7 @@
  * In this version the SRX server only can connect to once RPKI VALIDATION CACHE
  * MULTI CACHE will be part of a later release.
  *
- * @version 0.6.0.0
+ * @version 0.6.2.0
  *
  * EXIT Values:
  *
@@ -39,6 +39,10 @@
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Start the asynchronous log mode if configured.
+ *            * Start the update cache garbage collector with the caches and
+ *              stop it before the caches are released.
  * 0.6.0.0  - 2021/03/30 - oborchert
  *            * Changed SRXPROXY_GOODBYE->zero to SRXPROXY_GOODBYE->zero32
  * 0.5.1.1  - 2020/07/22 - oborchert
@@ -145,7 +149,6 @@ static SKI_CACHE*    skiCache  = NULL;
 static RPKI_QUEUE*   rpkiQueue = NULL;
 
 static AspathCache  aspathCache;
-static TrieNode     aspaTrie;
 static ASPA_DBManager aspaDBManager;
 
 /** The cache that manages keys for bgpsec. 
@@ -315,6 +318,12 @@ static bool setupCaches()
   initializeAspaDBManager(&aspaDBManager, &config);    // ASPA: ASPA object DB
   createAspathCache(&aspathCache, &aspaDBManager); // ASPA: AS path DB 
 
+  if (!startUpdateCacheGC(&updCache, &prefixCache, &aspathCache))
+  {
+    // Not fatal, updates are just kept in the cache.
+    RAISE_ERROR("Failed to start the update cache garbage collector");
+  }
+
   LOG(LEVEL_INFO, "- SRx Caches and RPKI Queue created");
   return true;
 }
@@ -505,6 +514,11 @@ static void doCleanupHandlers(int handler)
  */
 static void doCleanupCaches(int cache)
 {
+  // The garbage collector uses the prefix and SKI cache.
+  if ((cache & SETUP_UPDATE_CACHE) > 0)
+  {
+    stopUpdateCacheGC(&updCache);
+  }
   if ((cache & SETUP_KEY_CACHE) > 0)
   {
     releaseKeyCache(&keyCache);
@@ -695,6 +709,11 @@ int main(int argc, const char* argv[])
           LOG(LEVEL_ERROR, "Could not set log file.");
       }
 
+      if (config.asyncLog && !startAsyncLog())
+      {
+        LOG(LEVEL_WARNING, "Could not start the asynchronous log mode.");
+      }
+
       LOG(LEVEL_DEBUG, "([0x%08X]) > Start Main SRx server thread.", 
                        pthread_self());
 
@@ -798,6 +817,8 @@ int main(int argc, const char* argv[])
 
       LOG(LEVEL_DEBUG, "([0x%08X]) < Stop Main SRx server thread.", 
                        pthread_self());
+      // Write all pending messages before the log file is closed.
+      stopAsyncLog();
       if (fp)
       {
         fclose(fp);
@@ -29,10 +29,37 @@
  *  - getOriginStatus: Triggered by the SRx - Router - proxy for each
  *                     validation request.
  *
- * @version 0.6.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Allocate the PC_Update instances from a slab pool.
+ *            * requestUpdateValidation keeps the write lock of the tree.
+ *            * The lock macros acquire the locks also if tracing is disabled,
+ *              before they did not lock at all. Release the tree lock when
+ *              addROAwl and delROAwl return early.
+ *            * Implemented removeUpdate and added findUpdate.
+ *            * Removed the list of all updates, the updates are released with
+ *              the valid and other lists of their prefix and are counted in
+ *              numUpdates.
+ *            * Added compileROATable and getCompiledOriginStatus. addROAwl,
+ *              delROAwl, and emptyCache increment roaVersion.
+ *            * ROA changes skip more specific prefixes without updates and
+ *              only flag them stale, their coverage is recalculated with
+ *              _refreshPrefix when needed. The children are visited directly
+ *              instead of being collected with getChildren.
+ *            * requestUpdateValidation handles tree nodes whose prefix was
+ *              removed and counts the roa_count of covering ROAs for new
+ *              prefixes.
+ *            * Added requestUpdateValidations.
+ *            * Added flushDeferredResults.
+ *            * Suppressed ROA result changes are kept per update in the
+ *              deferred results and stored with applyDeferredResults.
+ *            * removeUpdate keeps updates the update cache stored again and
+ *              requestUpdateValidation does not add an update twice.
+ *            * removeUpdate removes the tree node of a prefix without updates
+ *              and ROAs.
  * 0.6.0.0  - 2021/03/30 - oborchert
  *            * Added missing version control. Also moved modifications labeled 
  *              as version 0.5.2.0 to 0.6.0.0 (0.5.2.0 was skipped)
@@ -74,11 +101,32 @@
 #include "shared/srx_defs.h"
 #include "util/log.h"
 #include "util/math.h"
+#include "util/slab.h"
 #include "util/xml_out.h"
 #include "main.h"
 
 #define HDR "[PrefixCache [0x%08X]]: "
 
+/** The pool of all PC_Update instances */
+static SlabPool _updatePool = SLAB_POOL_INITIALIZER("prefix-cache-update",
+                                                    sizeof(PC_Update));
+
+/**
+ * A ROA validation result that is held back until the end of data.
+ */
+typedef struct {
+  /** The id of the update in the update cache. */
+  SRxUpdateID            updateID;
+  /** The latest ROA validation result of the update */
+  SRxValidationResultVal roaResult;
+  /** The hash table of the prefix cache this result is stored in. */
+  UT_hash_handle         hh;
+} PC_DeferredResult;
+
+/** The pool of all PC_DeferredResult instances */
+static SlabPool _deferredPool = SLAB_POOL_INITIALIZER("prefix-cache-deferred",
+                                                    sizeof(PC_DeferredResult));
+
 /*-----------------------------
  * R/W lock and mutex debugging
  */
@@ -155,14 +203,14 @@
     PRINT_LINE_VAR("Unlock mutex", VAR); \
     unlockMutex(VAR)
 #else
-  #define READ_LOCK(VAR)
-  #define WRITE_LOCK(VAR)
-  #define READ_TO_WRITE_LOCK(VAR)
-  #define WRITE_TO_READ_LOCK(VAR)
-  #define UNLOCK_READ_LOCK(VAR)
-  #define UNLOCK_WRITE_LOCK(VAR)
-  #define LOCK_MUTEX(VAR)
-  #define UNLOCK_MUTEX(VAR)
+  #define READ_LOCK(VAR)             acquireReadLock(VAR)
+  #define WRITE_LOCK(VAR)            acquireWriteLock(VAR)
+  #define READ_TO_WRITE_LOCK(VAR)    changeReadToWriteLock(VAR)
+  #define WRITE_TO_READ_LOCK(VAR)    changeWriteToReadLock(VAR)
+  #define UNLOCK_READ_LOCK(VAR)      unlockReadLock(VAR)
+  #define UNLOCK_WRITE_LOCK(VAR)     unlockWriteLock(VAR)
+  #define LOCK_MUTEX(VAR)            lockMutex(VAR)
+  #define UNLOCK_MUTEX(VAR)          unlockMutex(VAR)
 #endif
 
 /**
@@ -183,13 +231,7 @@ bool initializePrefixCache(PrefixCache* self, UpdateCache* updateCache)
     return false;
   }
 
-  // Create the mutex and locks
-  if (!initMutex(&self->updatesMutex))
-  {
-    RAISE_ERROR("Failed to initialize the updates mutex");
-    Destroy_Patricia(self->prefixTree, NULL);
-    return false;
-  }
+  // Create the locks
   int step = 0;
   if (CREATE_RW_LOCK(&self->treeLock))
   {
@@ -220,16 +262,77 @@ bool initializePrefixCache(PrefixCache* self, UpdateCache* updateCache)
     }
   }
 
+  // The ROA table is compiled with the first end of data
+  if (!initEpochDomain(&self->roaReaders))
+  {
+    RAISE_ERROR("Failed to initialize the ROA table readers");
+    releaseRWLock(&self->otherLock);
+    releaseRWLock(&self->validLock);
+    releaseRWLock(&self->asLock);
+    releaseRWLock(&self->treeLock);
+    Destroy_Patricia(self->prefixTree, NULL);
+    return false;
+  }
+  self->roaTable   = NULL;
+  self->roaVersion = 0;
+  self->deferredResults = NULL;
+
   // Misc.
   self->updateCache = updateCache;
-  initSList(&self->updates);
+  self->numUpdates  = 0;
   return true;
 }
 
 /**
- * This method only frees up the memory attached. No update counter or other
- * maintenance values are maintained here. This method should not be
- * called for other than a clean emptying of the cache.
+ * Remove the held back ROA result of the given update. Requires the write 
+ * lock of the prefix tree.
+ *
+ * @param self The prefix cache.
+ * @param updateID The id of the update.
+ *
+ * @since 0.6.2.0
+ */
+static void _dropDeferredResult(PrefixCache* self, SRxUpdateID* updateID)
+{
+  PC_DeferredResult* results  = (PC_DeferredResult*)self->deferredResults;
+  PC_DeferredResult* deferred = NULL;
+
+  HASH_FIND(hh, results, updateID, sizeof(SRxUpdateID), deferred);
+  if (deferred != NULL)
+  {
+    HASH_DEL(results, deferred);
+    self->deferredResults = results;
+    freeToSlab(&_deferredPool, deferred);
+  }
+}
+
+/**
+ * Remove all held back ROA results. Requires the write lock of the prefix 
+ * tree.
+ *
+ * @param self The prefix cache.
+ *
+ * @since 0.6.2.0
+ */
+static void _releaseDeferredResults(PrefixCache* self)
+{
+  PC_DeferredResult* results  = (PC_DeferredResult*)self->deferredResults;
+  PC_DeferredResult* deferred = NULL;
+  PC_DeferredResult* tmp      = NULL;
+
+  HASH_ITER(hh, results, deferred, tmp)
+  {
+    HASH_DEL(results, deferred);
+    freeToSlab(&_deferredPool, deferred);
+  }
+  self->deferredResults = NULL;
+}
+
+/**
+ * This method only frees up the memory attached including the updates of the
+ * prefix. No update counter or other maintenance values are maintained here.
+ * This method should not be called for other than a clean emptying of the
+ * cache.
  *
  * @param prefix the particular pc prefix to be released.
  */
@@ -237,9 +340,18 @@ static void releasePrefix(PC_Prefix* prefix)
 {
   SListNode* asListNode;
   SListNode* roaListNode;
+  SListNode* updListNode;
   PC_AS*  asNumber;
   PC_ROA* roa;
 
+  FOREACH_SLIST(&prefix->valid, updListNode)
+  {
+    freeToSlab(&_updatePool, updListNode->data);
+  }
+  FOREACH_SLIST(&prefix->other, updListNode)
+  {
+    freeToSlab(&_updatePool, updListNode->data);
+  }
   releaseSList(&prefix->valid);
   releaseSList(&prefix->other);
 
@@ -275,11 +387,9 @@ void releasePrefixCache(PrefixCache* self)
   if (self != NULL)
   {
     patricia_node_t*  treeNode;
-    SListNode*        listNode;
     PC_Prefix*        prefix;
-    PC_Update*        pc_update;
 
-    // Free all prefixes and node-data
+    // Free all prefixes, their updates and node-data
     WRITE_LOCK(&self->asLock);
     WRITE_LOCK(&self->validLock);
     WRITE_LOCK(&self->otherLock);
@@ -287,7 +397,11 @@ void releasePrefixCache(PrefixCache* self)
     PATRICIA_WALK(self->prefixTree->head, treeNode)
     {
       prefix = PATRICIA_DATA_GET(treeNode, PC_Prefix);
-      releasePrefix(prefix);
+      // The prefix of the node might be removed already (removeUpdate)
+      if (prefix != NULL)
+      {
+        releasePrefix(prefix);
+      }
     } PATRICIA_WALK_END;
     RAISE_ERROR("Check if the treeNode has to be released independent or if it gets released with the Destroy_Patricia!");
     Destroy_Patricia(self->prefixTree, NULL);
@@ -296,20 +410,16 @@ void releasePrefixCache(PrefixCache* self)
     // end of test. If it was freed before this should cause a SIGDEV!!!! (I HOPE SO)
 
 
+    _releaseDeferredResults(self);
+
     releaseRWLock(&self->otherLock);
     releaseRWLock(&self->validLock);
     releaseRWLock(&self->asLock);
     releaseRWLock(&self->treeLock);
 
-    // Free all updates
-    LOCK_MUTEX(&self->updatesMutex);
-    FOREACH_SLIST(&self->updates, listNode)
-    {
-      pc_update = (PC_Update*)getDataOfSListNode(listNode);
-      free(pc_update);
-    }
-    releaseSList(&self->updates);
-    releaseMutex(&self->updatesMutex);
+    freeROATable(self->roaTable);
+    self->roaTable = NULL;
+    releaseEpochDomain(&self->roaReaders);
   }
 }
 
@@ -328,13 +438,9 @@ void emptyCache(PrefixCache* self)
   if (self != NULL)
   {
     patricia_node_t*  treeNode;
-    SListNode*        listNode;
     PC_Prefix*        prefix;
-    PC_AS*            pc_as;
-    PC_ROA*           pc_roa;
-    PC_Update*        pc_update;
 
-    // Free all prefixes and node-data
+    // Free all prefixes, their updates and node-data
     WRITE_LOCK(&self->asLock);
     WRITE_LOCK(&self->validLock);
     WRITE_LOCK(&self->otherLock);
@@ -349,19 +455,9 @@ void emptyCache(PrefixCache* self)
       treeNode->data = NULL;
     } PATRICIA_WALK_END;
     Clear_Patricia(self->prefixTree, NULL);
-
-    // Free all updates
-    LOCK_MUTEX(&self->updatesMutex);
-    FOREACH_SLIST(&self->updates, listNode)
-    {
-      pc_update = (PC_Update*)listNode->data;
-      if (pc_update != NULL)
-      {
-        free(pc_update);
-      }
-    }
-    emptySList(&self->updates);
-    UNLOCK_MUTEX(&self->updatesMutex);
+    self->numUpdates = 0;
+    _releaseDeferredResults(self);
+    __atomic_add_fetch(&self->roaVersion, 1, __ATOMIC_SEQ_CST);
 
     UNLOCK_WRITE_LOCK(&self->asLock);
     UNLOCK_WRITE_LOCK(&self->validLock);
@@ -400,14 +496,15 @@ PC_Prefix* getParent(patricia_node_t* node)
 // FOREWARD DECLARATIONS
 ////////////////////////////////////////////////////////////////////////////////
 static prefix_t* ipPrefixToPrefix_t(IPPrefix* from);
-static void notifyUpdateCacheForROAChange(UpdateCache* updCache,
+static void notifyUpdateCacheForROAChange(PrefixCache* self,
                     SRxUpdateID* updateID, SRxValidationResultVal newROAResult,
                     bool suppressNotification);
-static void _ROAwl_changeStateOfOther(UpdateCache* updateCache,
+static void _ROAwl_changeStateOfOther(PrefixCache* self,
                                       PC_Prefix* pcPrefix,
                                       SRxValidationResultVal newState,
                                       bool suppressNotification);
 static void printXML(PrefixCache* self, char* methodName);
+static PC_Update* _findUpdateInList(SList* list, SRxUpdateID updateID);
 
 /**
  * Returns the requested AS attached to the given prefix. In case the AS does
@@ -507,6 +604,174 @@ static bool getChildren(SList* children, patricia_node_t* node)
   return children->size > 0;
 }
 
+/**
+ * Add the given value to the update counter of the prefix and all less 
+ * specific prefixes.
+ *
+ * @param pcPrefix The prefix the update is attached to.
+ * @param delta +1 for an added update, -1 for a removed update.
+ *
+ * @since 0.6.2.0
+ */
+static void _countSubtreeUpdates(PC_Prefix* pcPrefix, int delta)
+{
+  while (pcPrefix != NULL)
+  {
+    pcPrefix->subtree_updates += delta;
+    pcPrefix = getParent(pcPrefix->treeNode);
+  }
+}
+
+/**
+ * Return the number of updates attached to the more specific prefixes of the 
+ * given patricia tree node. Used when a prefix is inserted above existing 
+ * prefixes.
+ *
+ * @param node The patricia tree node.
+ *
+ * @return The number of updates.
+ *
+ * @since 0.6.2.0
+ */
+static uint32_t _getChildrenUpdates(patricia_node_t* node)
+{
+  patricia_node_t* children[2] = { node->l, node->r };
+  uint32_t         count = 0;
+  int              idx;
+
+  for (idx = 0; idx < 2; idx++)
+  {
+    if (children[idx] != NULL)
+    {
+      if (children[idx]->data != NULL)
+      {
+        count += ((PC_Prefix*)children[idx]->data)->subtree_updates;
+      }
+      else
+      {
+        count += _getChildrenUpdates(children[idx]);
+      }
+    }
+  }
+
+  return count;
+}
+
+/**
+ * Flag the next more specific prefixes of the patricia tree node as stale.
+ *
+ * @param node The patricia tree node.
+ *
+ * @since 0.6.2.0
+ */
+static void _markChildrenStale(patricia_node_t* node)
+{
+  patricia_node_t* children[2] = { node->l, node->r };
+  int              idx;
+
+  for (idx = 0; idx < 2; idx++)
+  {
+    if (children[idx] != NULL)
+    {
+      if (children[idx]->data != NULL)
+      {
+        ((PC_Prefix*)children[idx]->data)->stale = true;
+      }
+      else
+      {
+        _markChildrenStale(children[idx]);
+      }
+    }
+  }
+}
+
+/**
+ * Calculate roa_coverage and state_of_other of the prefix from its own ROAs
+ * and the ROAs of the less specific prefixes. The less specific prefixes
+ * MUST be current.
+ *
+ * @param pcPrefix The prefix to be calculated.
+ * @param parent The next less specific prefix or NULL.
+ *
+ * @since 0.6.2.0
+ */
+static void _calcCoverage(PC_Prefix* pcPrefix, PC_Prefix* parent)
+{
+  uint16_t   bitlen  = pcPrefix->treeNode->prefix->bitlen;
+  PC_Prefix* current = pcPrefix;
+  bool       hasROA  = false;
+  SListNode* asListNode;
+  SListNode* roaListNode;
+  PC_AS*     pcAS;
+  PC_ROA*    pcROA;
+
+  pcPrefix->roa_coverage = 0;
+  // Less specific prefixes that are not covered have no ROAs above them.
+  while (current != NULL)
+  {
+    FOREACH_SLIST(&current->asn, asListNode)
+    {
+      pcAS = (PC_AS*)asListNode->data;
+      FOREACH_SLIST(&pcAS->roas, roaListNode)
+      {
+        pcROA = (PC_ROA*)roaListNode->data;
+        hasROA = hasROA || (current == pcPrefix);
+        if (pcROA->max_len >= bitlen)
+        {
+          pcPrefix->roa_coverage += pcROA->roa_count;
+        }
+      }
+    }
+    current = current == pcPrefix ? parent : getParent(current->treeNode);
+    if ((current != NULL) && (current->state_of_other == SRx_RESULT_NOTFOUND))
+    {
+      current = NULL;
+    }
+  }
+
+  pcPrefix->state_of_other = 
+          (hasROA || ((parent != NULL) 
+                      && (parent->state_of_other == SRx_RESULT_INVALID)))
+          ? SRx_RESULT_INVALID : SRx_RESULT_NOTFOUND;
+}
+
+/**
+ * Make roa_coverage and state_of_other of the prefix and all its less 
+ * specific prefixes current. Starting at the least specific stale prefix the 
+ * values are recalculated down to the given prefix, the stale flag is moved 
+ * to the prefixes next to this path. MUST be called before the values of a 
+ * prefix that might not have any updates are used.
+ *
+ * @param pcPrefix The prefix.
+ *
+ * @since 0.6.2.0
+ */
+static void _refreshPrefix(PC_Prefix* pcPrefix)
+{
+  PC_Prefix* path[PATRICIA_MAXBITS + 1];
+  PC_Prefix* current = pcPrefix;
+  int        depth   = 0;
+  int        top     = -1;
+  int        idx;
+
+  while ((current != NULL) && (depth <= PATRICIA_MAXBITS))
+  {
+    if (current->stale)
+    {
+      top = depth;
+    }
+    path[depth++] = current;
+    current = getParent(current->treeNode);
+  }
+
+  for (idx = top; idx >= 0; idx--)
+  {
+    _calcCoverage(path[idx], idx + 1 < depth ? path[idx + 1] : NULL);
+    _markChildrenStale(path[idx]->treeNode);
+    path[idx]->stale = false;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Request Validation
 ////////////////////////////////////////////////////////////////////////////////
@@ -518,11 +783,8 @@ static bool _performUpdateValidationKnownPrefix(PrefixCache* self,
                                                 bool isNew);
 
 /**
- * Request the validation for an update received. During the process of
- * validating of adding the update it will be added to the cache, the validation
- * is done by using the data within the prefix cache. Each update MUST be added
- * only once! Once added, changes of the validation state are signaled to the
- * update cache and with this to the registered clients.
+ * Add the update to the prefix cache and validate it. The write lock of the 
+ * tree MUST be held by the caller.
  *
  * @param self The prefix cache
  * @param updateID the id of the update itself
@@ -530,9 +792,11 @@ static bool _performUpdateValidationKnownPrefix(PrefixCache* self,
  * @param as The AS number of the update
  *
  * @return false indicates an error, most likely memory related! (fatal)
+ *
+ * @since 0.6.2.0
  */
-bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
-                                IPPrefix* prefix, uint32_t as)
+static bool _requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
+                                     IPPrefix* prefix, uint32_t as)
 {
   // the node within the prefix tree. the data of it is the PC_prefix
   // information.
@@ -542,27 +806,24 @@ bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
   // This is the prefix the algorithm runs on.
   PC_Prefix*       pcPrefix = NULL;
   // The update itself
-  PC_Update*       pcUpdate = malloc(sizeof(PC_Update));
+  PC_Update*       pcUpdate = allocFromSlab(&_updatePool);
   // The AS instance
   PC_AS*           pcAS = NULL;
   // The update id. I know it is so=illy but the structure might change.
   SRxUpdateID      updID = *updateID;
 
-  WRITE_LOCK(&self->treeLock);
-
-  pcUpdate->roa_match = 0;
-  pcUpdate->updateID  = updID;
-  pcUpdate->as = as;
-  if (!appendDataToSList(&self->updates, pcUpdate))
+  if (pcUpdate == NULL)
   {
-    RAISE_SYS_ERROR( HDR "Could not add update [0x%08X] to prefix cache!",
-                     pthread_self(), updID);
-    free(pcUpdate);
+    RAISE_SYS_ERROR( HDR "Not enough memory to add update [0x%08X] to prefix "
+                     "cache!", pthread_self(), updID);
     free(lookupPrefix);
-    UNLOCK_WRITE_LOCK(&self->treeLock);
     return false;
   }
 
+  pcUpdate->roa_match = 0;
+  pcUpdate->updateID  = updID;
+  pcUpdate->as = as;
+
   // Create or get the existing prefix node
   // Return the prefix tree element for the prefix in question. This lookup will
   // insert the requested prefix in the tree if it doesn't exist already.
@@ -572,10 +833,8 @@ bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
   if (treeNode == NULL)
   {
     RAISE_ERROR("Failed to append a prefix to the prefix tree");
-    deleteFromSList(&self->updates, pcUpdate);
-    free(pcUpdate);
+    freeToSlab(&_updatePool, pcUpdate);
     free(lookupPrefix);
-    UNLOCK_WRITE_LOCK(&self->treeLock);
     return false;
   }
   else
@@ -583,17 +842,21 @@ bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
     pcUpdate->treeNode = treeNode;
   }
 
-// Maybe keep the write lock!
-  WRITE_TO_READ_LOCK(&self->treeLock);
   bool retVal = true;
 
-  // Already existed - need to free given prefix
-  if (lookupPrefix->ref_count > 0) // If the prefix would have been existed
-  {                     // already this instance would not have been referenced.
+  // If the prefix would have been existed already this instance would not have 
+  // been referenced.
+  if (lookupPrefix->ref_count == 0)
+  {
+    // The prefix already existed in the tree, free the newly created one.
+    free(lookupPrefix);
+  }
+
+  // The tree node can also remain after its prefix got removed.
+  if (treeNode->data == NULL)
+  {
     // (Does P exist ? NO)
     retVal = _performUpdateValidationNewPrefix(self, pcUpdate, as);
-    UNLOCK_READ_LOCK(&self->treeLock);
-
     // printXML(self, "requestUpdateValidation");
 
     return retVal;
@@ -601,17 +864,31 @@ bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
   else
   {
     // (Does P exist ? Yes)
-    // The prefix already existed in the tree, free the newly created one.
-    free(lookupPrefix);
-
     pcPrefix = (PC_Prefix*)treeNode->data;
+    _refreshPrefix(pcPrefix);
+
+    // An update that expired in the update cache and was stored again before
+    // the garbage collector removed it from here is still in the prefix cache.
+    if (_findUpdateInList(&pcPrefix->valid, updID) != NULL)
+    {
+      freeToSlab(&_updatePool, pcUpdate);
+      notifyUpdateCacheForROAChange(self, &updID, SRx_RESULT_VALID,
+                                    PC_DONT_SUPPRESS);
+      return true;
+    }
+    if (_findUpdateInList(&pcPrefix->other, updID) != NULL)
+    {
+      freeToSlab(&_updatePool, pcUpdate);
+      notifyUpdateCacheForROAChange(self, &updID,
+                              (SRxValidationResultVal)pcPrefix->state_of_other,
+                               PC_DONT_SUPPRESS);
+      return true;
+    }
 
     if (pcPrefix->roa_coverage > 0)
     {
       // (P::ROA_Count == 0 ? No)                           //false = ! NEW P
       retVal = _performUpdateValidationKnownPrefix(self, pcUpdate, as, false);
-
-      UNLOCK_READ_LOCK(&self->treeLock);
       return retVal;
     }
     else
@@ -622,9 +899,7 @@ bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
         RAISE_SYS_ERROR( HDR "Could not add update [0x%08X] to P::other!",
                          pthread_self(), updateID);
         // remove update only, other updates for this prefix do exist!
-        deleteFromSList(&self->updates, pcUpdate);
-        free(pcUpdate);
-        UNLOCK_READ_LOCK(&self->treeLock);
+        freeToSlab(&_updatePool, pcUpdate);
         return false;
       }
 
@@ -636,29 +911,93 @@ bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
                              " required AS to prefix!",
                          pthread_self(), updateID);
         deleteFromSList(&pcPrefix->other, pcUpdate);
-        deleteFromSList(&self->updates, pcUpdate);
-        free(pcUpdate);
-        UNLOCK_READ_LOCK(&self->treeLock);
+        freeToSlab(&_updatePool, pcUpdate);
         return false;
       }
 
       pcAS->update_count++;
+      self->numUpdates++;
+      _countSubtreeUpdates(pcPrefix, 1);
 
       //BUG #18 - missing notification of update cache
-      notifyUpdateCacheForROAChange(self->updateCache, &pcUpdate->updateID,
+      notifyUpdateCacheForROAChange(self, &pcUpdate->updateID,
                               (SRxValidationResultVal)pcPrefix->state_of_other,
                                PC_DONT_SUPPRESS);
       // End BUG#18
     }
 
-    UNLOCK_READ_LOCK(&self->treeLock);
-
     //printXML(self, "requestUpdateValidation");
 
     return true;
   }
 }
 
+/**
+ * Request the validation for an update received. During the process of
+ * validating of adding the update it will be added to the cache, the validation
+ * is done by using the data within the prefix cache. Each update MUST be added
+ * only once! Once added, changes of the validation state are signaled to the
+ * update cache and with this to the registered clients.
+ *
+ * @param self The prefix cache
+ * @param updateID the id of the update itself
+ * @param prefix The prefix of the update
+ * @param as The AS number of the update
+ *
+ * @return false indicates an error, most likely memory related! (fatal)
+ */
+bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
+                                IPPrefix* prefix, uint32_t as)
+{
+  bool retVal;
+
+  // Keep the write lock, the lists of the prefix are not synchronized and
+  // the updates of a prefix can be validated by parallel threads.
+  WRITE_LOCK(&self->treeLock);
+  retVal = _requestUpdateValidation(self, updateID, prefix, as);
+  UNLOCK_WRITE_LOCK(&self->treeLock);
+
+  return retVal;
+}
+
+/**
+ * Add the given updates to the prefix cache while holding the write lock of
+ * the tree only once. Each update is validated as in requestUpdateValidation.
+ *
+ * @param self The prefix cache
+ * @param requests The updates to be added.
+ * @param count The number of updates.
+ *
+ * @return the number of updates that could not be added.
+ *
+ * @since 0.6.2.0
+ */
+uint32_t requestUpdateValidations(PrefixCache* self,
+                                  PC_ValidationRequest* requests,
+                                  uint32_t count)
+{
+  uint32_t failed = 0;
+  uint32_t idx;
+
+  if (count == 0)
+  {
+    return 0;
+  }
+
+  WRITE_LOCK(&self->treeLock);
+  for (idx = 0; idx < count; idx++)
+  {
+    if (!_requestUpdateValidation(self, &requests[idx].updateID,
+                                  &requests[idx].prefix, requests[idx].as))
+    {
+      failed++;
+    }
+  }
+  UNLOCK_WRITE_LOCK(&self->treeLock);
+
+  return failed;
+}
+
 /**
  * This method prepares the prefix for the final update validation request.
  *
@@ -685,11 +1024,14 @@ static bool _performUpdateValidationNewPrefix(PrefixCache* self,
   initSList(&pcPrefix->asn);
   initSList(&pcPrefix->other);
   initSList(&pcPrefix->valid);
-  pcPrefix->roa_coverage = 0;
+  pcPrefix->roa_coverage    = 0;
+  pcPrefix->subtree_updates = _getChildrenUpdates(pcPrefix->treeNode);
+  pcPrefix->stale           = false;
 
   PC_Prefix* parent_pcPrefix = getParent(pcUpdate->treeNode);
   if (parent_pcPrefix != NULL)
   {
+    _refreshPrefix(parent_pcPrefix);
     pcPrefix->state_of_other = parent_pcPrefix->state_of_other;
   }
   else
@@ -697,182 +1039,642 @@ static bool _performUpdateValidationNewPrefix(PrefixCache* self,
     pcPrefix->state_of_other = SRx_RESULT_NOTFOUND;
   }
 
-  return _performUpdateValidationKnownPrefix(self, pcUpdate, as, true);
+  return _performUpdateValidationKnownPrefix(self, pcUpdate, as, true);
+}
+
+/*
+ * This is a subroutine of performUpdateValidation used to notify the update
+ * cache of the validation result.
+ *
+ * @param self Instance of the prefix cache
+ * @param pcPrefix the prefix itself
+ *
+ * @return false only in case of an internal error
+ */
+static bool _performUpdateValidation_PrefixNotCovered(PrefixCache* self,
+                                                      PC_Prefix* pcPrefix,
+                                                      PC_Update* pcUpdate)
+{
+  bool retVal = true;
+  // (P::State_of_Other == UNKNOWN) => Yes
+  if (pcUpdate->roa_match == 0)
+  {
+    // (U::ROA_Count == 0) => Yes
+    if (appendDataToSList(&pcPrefix->other, pcUpdate))
+    {
+      self->numUpdates++;
+      _countSubtreeUpdates(pcPrefix, 1);
+      notifyUpdateCacheForROAChange(self, &pcUpdate->updateID,
+                              (SRxValidationResultVal)pcPrefix->state_of_other,
+                              PC_DONT_SUPPRESS);
+    }
+    else
+    {
+      RAISE_SYS_ERROR( HDR "Could not add the update [0x%08X] to the list "
+                           "P::other!", pthread_self(), pcUpdate->updateID);
+      retVal = false;
+    }
+  }
+  else
+  {
+    // (U::ROA_Count == 0) => No
+    if (appendDataToSList(&pcPrefix->valid, pcUpdate))
+    {
+      self->numUpdates++;
+      _countSubtreeUpdates(pcPrefix, 1);
+      notifyUpdateCacheForROAChange(self, &pcUpdate->updateID,
+                                    SRx_RESULT_VALID, PC_DONT_SUPPRESS);
+    }
+    else
+    {
+      RAISE_SYS_ERROR( HDR "Could not add the update [0x%08X] to the list "
+                           "P::valid!", pthread_self(), pcUpdate->updateID);
+      retVal = false;
+    }
+  }
+
+  return retVal;
+}
+
+/**
+ * This is a subroutine of performUpdateValidation used determine which ROAs
+ * might cover the update.
+ *
+ * @param pcPrefix_Po The original prefix cache prefix (Po)
+ * @param pcPrefix The current prefix to be checked
+ * @param pcUpdate The update to be validated
+ * @param as The AS number of the update.
+ * @param isNew Indicates if the prefix of this update was newly installed in
+ *              the prefix cache tree.
+ *
+ * @return false in case an internal error occurred.
+ */
+static void _performUpdateValidation_PrefixIsCovereByAROA (
+                                   PC_Prefix* pcPrefix_Po, PC_Prefix* pcPrefix,
+                                   PC_Update* pcUpdate, uint32_t as, bool isNew)
+{
+  SListNode* asListNode;
+  SListNode* roaListNode;
+
+  PC_AS*  pcAS;
+  PC_ROA* pcROA;
+
+  FOREACH_SLIST(&pcPrefix->asn, asListNode)
+  {
+    pcAS = (PC_AS*)asListNode->data;
+
+    // Could be added for optimization, leave it out at this point.
+    // if (!isNew && pcAS->asn != as)
+    // {
+    //   continue;
+    // }
+
+    // AS number matches, does prefix also cover this one?
+    FOREACH_SLIST(&pcAS->roas, roaListNode)
+    {
+      pcROA = (PC_ROA*)roaListNode->data;
+
+      // Does ROA cover PO
+      if (pcPrefix_Po->treeNode->prefix->bitlen <= pcROA->max_len)
+      {
+        // prefix covers update
+        if (isNew)
+        {
+          // NEW prefix, increase the Po coverage. Otherwise it is increased
+          // by ROA management itself.
+          pcPrefix_Po->roa_coverage += pcROA->roa_count;
+        }
+        if (pcAS->asn == as)
+        {
+          pcROA->update_count++;
+          pcUpdate->roa_match += pcROA->roa_count;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * This is the subroutine of requestUpdateValidation that adds and validates
+ * the update.
+ *
+ * @param self The instance of the prefix cache
+ * @param pcUpdate The prefix cache update
+ * @param as The as number of the update
+ * @param isNew Indicates if the prefix was added to the prefix tree during this
+ *        validation request.
+ * @return false in case of an internal error.
+ */
+static bool _performUpdateValidationKnownPrefix(PrefixCache* self,
+                                                PC_Update* pcUpdate,
+                                                uint32_t as, bool isNew)
+{
+  PC_Prefix* pcPrefix = (PC_Prefix*)pcUpdate->treeNode->data;
+  PC_Prefix* pcPrefix_Po = pcPrefix;
+  PC_AS*     pcAS = getASFromPrefix(pcPrefix, as);
+  pcAS->update_count++;
+
+  // P might be covered by a ROA (we don't know if NEW prefix).
+  while (   ( isNew && (pcPrefix->state_of_other == SRx_RESULT_INVALID))
+         || (!isNew && (pcPrefix->roa_coverage > 0)))
+  {
+    _performUpdateValidation_PrefixIsCovereByAROA(pcPrefix_Po, pcPrefix,
+                                                  pcUpdate, as, isNew);
+
+    // (Exist less specific P' ?) => yes
+    // P := P'
+    pcPrefix = getParent(pcPrefix->treeNode);
+
+    if (pcPrefix == NULL)
+    {
+      // (Exist less specific P' ?) => No
+      break;
+    }
+  }
+  return _performUpdateValidation_PrefixNotCovered(self, pcPrefix_Po,
+                                                  pcUpdate);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// REMOVE AN UPDATE
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Find the update in the given list of updates.
+ *
+ * @param list The valid or other list of a prefix.
+ * @param updateID The id of the update.
+ *
+ * @return The update or NULL if not found.
+ *
+ * @since 0.6.2.0
+ */
+static PC_Update* _findUpdateInList(SList* list, SRxUpdateID updateID)
+{
+  SListNode* listNode;
+  PC_Update* pcUpdate;
+
+  FOREACH_SLIST(list, listNode)
+  {
+    pcUpdate = (PC_Update*)listNode->data;
+    if (pcUpdate->updateID == updateID)
+    {
+      return pcUpdate;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * Determine if the update cache stores an update with the given id.
+ *
+ * @param self The prefix cache.
+ * @param updateID The id of the update.
+ *
+ * @return true if the update is stored in the update cache.
+ *
+ * @since 0.6.2.0
+ */
+static bool _isStoredInUpdateCache(PrefixCache* self, SRxUpdateID* updateID)
+{
+  SRxResult        srxRes;
+  SRxDefaultResult defRes;
+
+  return    (self->updateCache != NULL)
+         && getUpdateResult(self->updateCache, updateID, 0, NULL, &srxRes,
+                            &defRes, NULL);
+}
+
+/**
+ * This method will remove the given update from the prefix cache. The update
+ * counters of the ROAs that cover the update and of its origin AS are
+ * decremented, the AS and the prefix are removed if they are not used anymore.
+ * The update is kept if the update cache stores an update with this id, the
+ * update was stored again after it got removed from the update cache.
+ *
+ * @param self The prefix cache.
+ * @param updateID The id of the update that has to be removed.
+ * @param prefix The prefix of the update.
+ * @param as The AS number of the update.
+ *
+ * @return true if the update could be removed, false if the update is not
+ *         stored in the prefix cache (e.g. it was never validated) or is stored
+ *         in the update cache again.
+ */
+bool removeUpdate(PrefixCache* self, SRxUpdateID* updateID, IPPrefix* prefix,
+                  uint32_t as)
+{
+  patricia_node_t* treeNode     = NULL;
+  prefix_t*        lookupPrefix = ipPrefixToPrefix_t(prefix);
+  PC_Prefix*       pcPrefix     = NULL;
+  PC_Prefix*       pcPrefix_Po  = NULL;
+  PC_Update*       pcUpdate     = NULL;
+  PC_AS*           pcAS         = NULL;
+  PC_ROA*          pcROA        = NULL;
+  SListNode*       asListNode   = NULL;
+  SListNode*       roaListNode  = NULL;
+  bool             isValid      = false;
+
+  if (lookupPrefix == NULL)
+  {
+    RAISE_SYS_ERROR( HDR "Not enough memory to remove update [0x%08X]!",
+                     pthread_self(), *updateID);
+    return false;
+  }
+
+  WRITE_LOCK(&self->treeLock);
+
+  treeNode = patricia_search_exact(self->prefixTree, lookupPrefix);
+  free(lookupPrefix);
+  pcPrefix_Po = treeNode != NULL ? (PC_Prefix*)treeNode->data : NULL;
+  if (pcPrefix_Po == NULL)
+  {
+    UNLOCK_WRITE_LOCK(&self->treeLock);
+    return false;
+  }
+
+  pcUpdate = _findUpdateInList(&pcPrefix_Po->valid, *updateID);
+  isValid  = pcUpdate != NULL;
+  if (!isValid)
+  {
+    pcUpdate = _findUpdateInList(&pcPrefix_Po->other, *updateID);
+    if (pcUpdate == NULL)
+    {
+      UNLOCK_WRITE_LOCK(&self->treeLock);
+      return false;
+    }
+  }
+
+  // The update expired and was stored again meanwhile. The update cache
+  // stores an update before it requests its validation, which requires the
+  // write lock held here.
+  if (_isStoredInUpdateCache(self, updateID))
+  {
+    UNLOCK_WRITE_LOCK(&self->treeLock);
+    return false;
+  }
+
+  // Only valid updates are counted by the ROAs that cover them, these are the
+  // ROAs of the origin AS on the prefix or a less specific one.
+  for (pcPrefix = isValid ? pcPrefix_Po : NULL; pcPrefix != NULL;
+       pcPrefix = getParent(pcPrefix->treeNode))
+  {
+    FOREACH_SLIST(&pcPrefix->asn, asListNode)
+    {
+      pcAS = (PC_AS*)asListNode->data;
+      if (pcAS->asn != as)
+      {
+        continue;
+      }
+      FOREACH_SLIST(&pcAS->roas, roaListNode)
+      {
+        pcROA = (PC_ROA*)roaListNode->data;
+        if (   (pcPrefix_Po->treeNode->prefix->bitlen <= pcROA->max_len)
+            && (pcROA->update_count > 0))
+        {
+          pcROA->update_count--;
+        }
+      }
+    }
+  }
+
+  deleteFromSList(isValid ? &pcPrefix_Po->valid : &pcPrefix_Po->other,
+                  pcUpdate);
+  freeToSlab(&_updatePool, pcUpdate);
+  self->numUpdates--;
+  _countSubtreeUpdates(pcPrefix_Po, -1);
+  _dropDeferredResult(self, updateID);
+
+  // Decrement the update count of the origin AS of the prefix
+  FOREACH_SLIST(&pcPrefix_Po->asn, asListNode)
+  {
+    pcAS = (PC_AS*)asListNode->data;
+    if (pcAS->asn == as)
+    {
+      if (pcAS->update_count > 0)
+      {
+        pcAS->update_count--;
+      }
+      if ((pcAS->update_count == 0) && (pcAS->roas.size == 0))
+      {
+        deleteFromSList(&pcPrefix_Po->asn, pcAS);
+        releaseSList(&pcAS->roas);
+        free(pcAS);
+      }
+      break;
+    }
+  }
+
+  if (   (pcPrefix_Po->asn.size == 0) && (pcPrefix_Po->valid.size == 0)
+      && (pcPrefix_Po->other.size == 0))
+  {
+    // The more specific prefixes take over a pending recalculation. The
+    // update counters of the less specific prefixes do not change, the
+    // prefix has no updates anymore.
+    if (pcPrefix_Po->stale)
+    {
+      _markChildrenStale(treeNode);
+    }
+    releaseSList(&pcPrefix_Po->valid);
+    releaseSList(&pcPrefix_Po->other);
+    releaseSList(&pcPrefix_Po->asn);
+    treeNode->data = NULL;
+    free(pcPrefix_Po);
+    patricia_remove(self->prefixTree, treeNode);
+  }
+
+  UNLOCK_WRITE_LOCK(&self->treeLock);
+
+  return true;
+}
+
+/**
+ * Return the prefix cache update with the given id. The update is only valid
+ * as long as it is not removed from the prefix cache, it is meant for display
+ * purpose.
+ *
+ * @param self The prefix cache.
+ * @param updateID The id of the update.
+ * @param prefix The prefix of the update.
+ *
+ * @return The update or NULL if it is not stored in the prefix cache.
+ *
+ * @since 0.6.2.0
+ */
+PC_Update* findUpdate(PrefixCache* self, SRxUpdateID* updateID,
+                      IPPrefix* prefix)
+{
+  prefix_t*        lookupPrefix = ipPrefixToPrefix_t(prefix);
+  patricia_node_t* treeNode     = NULL;
+  PC_Prefix*       pcPrefix     = NULL;
+  PC_Update*       pcUpdate     = NULL;
+
+  if (lookupPrefix == NULL)
+  {
+    return NULL;
+  }
+
+  READ_LOCK(&self->treeLock);
+  treeNode = patricia_search_exact(self->prefixTree, lookupPrefix);
+  pcPrefix = treeNode != NULL ? (PC_Prefix*)treeNode->data : NULL;
+  if (pcPrefix != NULL)
+  {
+    pcUpdate = _findUpdateInList(&pcPrefix->valid, *updateID);
+    if (pcUpdate == NULL)
+    {
+      pcUpdate = _findUpdateInList(&pcPrefix->other, *updateID);
+    }
+  }
+  UNLOCK_READ_LOCK(&self->treeLock);
+  free(lookupPrefix);
+
+  return pcUpdate;
 }
 
-/*
- * This is a subroutine of performUpdateValidation used to notify the update
- * cache of the validation result.
+////////////////////////////////////////////////////////////////////////////////
+// COMPILED ROA TABLE
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Convert the patricia tree prefix into an IPPrefix.
  *
- * @param self Instance of the prefix cache
- * @param pcPrefix the prefix itself
+ * @param from The patricia tree prefix.
+ * @param to The IPPrefix to be filled.
  *
- * @return false only in case of an internal error
+ * @since 0.6.2.0
  */
-static bool _performUpdateValidation_PrefixNotCovered(PrefixCache* self,
-                                                      PC_Prefix* pcPrefix,
-                                                      PC_Update* pcUpdate)
+static void _prefix_tToIPPrefix(prefix_t* from, IPPrefix* to)
 {
-  bool retVal = true;
-  // (P::State_of_Other == UNKNOWN) => Yes
-  if (pcUpdate->roa_match == 0)
+  memset(to, 0, sizeof(IPPrefix));
+  to->length = (uint8_t)from->bitlen;
+  if (from->family == AF_INET)
   {
-    // (U::ROA_Count == 0) => Yes
-    if (appendDataToSList(&pcPrefix->other, pcUpdate))
-    {
-      notifyUpdateCacheForROAChange(self->updateCache, &pcUpdate->updateID,
-                              (SRxValidationResultVal)pcPrefix->state_of_other,
-                              PC_DONT_SUPPRESS);
-    }
-    else
-    {
-      RAISE_SYS_ERROR( HDR "Could not add the update [0x%08X] to the list "
-                           "P::other!", pthread_self(), pcUpdate->updateID);
-      retVal = false;
-    }
+    to->ip.version     = 4;
+    to->ip.addr.v4.u32 = from->add.sin.s_addr;
   }
   else
   {
-    // (U::ROA_Count == 0) => No
-    if (appendDataToSList(&pcPrefix->valid, pcUpdate))
-    {
-      notifyUpdateCacheForROAChange(self->updateCache, &pcUpdate->updateID,
-                                    SRx_RESULT_VALID, PC_DONT_SUPPRESS);
-    }
-    else
-    {
-      RAISE_SYS_ERROR( HDR "Could not add the update [0x%08X] to the list "
-                           "P::valid!", pthread_self(), pcUpdate->updateID);
-      retVal = false;
-    }
+    to->ip.version = 6;
+    memcpy(&to->ip.addr.v6.in_addr, &from->add.sin6, sizeof(IPv6Address));
   }
-
-  return retVal;
 }
 
 /**
- * This is a subroutine of performUpdateValidation used determine which ROAs
- * might cover the update.
+ * Compile the ROA white-list entries of the prefix cache into a new ROA table
+ * and publish it for lock free lookups. Called at the end of data, MUST NOT be
+ * called by multiple threads at the same time.
  *
- * @param pcPrefix_Po The original prefix cache prefix (Po)
- * @param pcPrefix The current prefix to be checked
- * @param pcUpdate The update to be validated
- * @param as The AS number of the update.
- * @param isNew Indicates if the prefix of this update was newly installed in
- *              the prefix cache tree.
+ * @param self The prefix cache.
  *
- * @return false in case an internal error occurred.
+ * @return false if the table could not be compiled, the previous table is
+ *         then kept but not used anymore.
+ *
+ * @since 0.6.2.0
  */
-static void _performUpdateValidation_PrefixIsCovereByAROA (
-                                   PC_Prefix* pcPrefix_Po, PC_Prefix* pcPrefix,
-                                   PC_Update* pcUpdate, uint32_t as, bool isNew)
+bool compileROATable(PrefixCache* self)
 {
-  SListNode* asListNode;
-  SListNode* roaListNode;
-
-  PC_AS*  pcAS;
-  PC_ROA* pcROA;
+  ROA_Table*       table    = newROATable();
+  ROA_Table*       oldTable = NULL;
+  patricia_node_t* treeNode = NULL;
+  PC_Prefix*       pcPrefix = NULL;
+  PC_AS*           pcAS     = NULL;
+  PC_ROA*          pcROA    = NULL;
+  SListNode*       asListNode;
+  SListNode*       roaListNode;
+  IPPrefix         prefix;
+  bool             retVal   = table != NULL;
 
-  FOREACH_SLIST(&pcPrefix->asn, asListNode)
+  if (!retVal)
   {
-    pcAS = (PC_AS*)asListNode->data;
-
-    // Could be added for optimization, leave it out at this point.
-    // if (!isNew && pcAS->asn != as)
-    // {
-    //   continue;
-    // }
+    return false;
+  }
 
-    // AS number matches, does prefix also cover this one?
-    FOREACH_SLIST(&pcAS->roas, roaListNode)
+  // Only collect the entries while holding the lock, the table is sorted
+  // afterwards. ROA changes in the meantime increment roaVersion, which
+  // keeps the table from being used.
+  READ_LOCK(&self->treeLock);
+  table->version = self->roaVersion;
+  PATRICIA_WALK(self->prefixTree->head, treeNode)
+  {
+    pcPrefix = (PC_Prefix*)treeNode->data;
+    if (retVal && (pcPrefix != NULL))
     {
-      pcROA = (PC_ROA*)roaListNode->data;
-
-      // Does ROA cover PO
-      if (pcPrefix_Po->treeNode->prefix->bitlen <= pcROA->max_len)
+      _prefix_tToIPPrefix(treeNode->prefix, &prefix);
+      FOREACH_SLIST(&pcPrefix->asn, asListNode)
       {
-        // prefix covers update
-        if (isNew)
-        {
-          // NEW prefix, increase the Po coverage. Otherwise it is increased
-          // by ROA management itself.
-          pcPrefix_Po->roa_coverage++;
-        }
-        if (pcAS->asn == as)
+        pcAS = (PC_AS*)asListNode->data;
+        FOREACH_SLIST(&pcAS->roas, roaListNode)
         {
-          pcROA->update_count++;
-          pcUpdate->roa_match += pcROA->roa_count;
+          pcROA = (PC_ROA*)roaListNode->data;
+          if (retVal && (pcROA->roa_count > 0))
+          {
+            retVal = addROATableEntry(table, &prefix, pcROA->max_len,
+                                      pcAS->asn);
+          }
         }
       }
     }
+  } PATRICIA_WALK_END;
+  UNLOCK_READ_LOCK(&self->treeLock);
+
+  if (!retVal)
+  {
+    RAISE_ERROR("Failed to compile the ROA table!");
+    freeROATable(table);
+    return false;
   }
+
+  finishROATable(table);
+  oldTable = self->roaTable;
+  __atomic_store_n(&self->roaTable, table, __ATOMIC_SEQ_CST);
+
+  // Wait until no reader can access the old table anymore
+  synchronizeEpoch(&self->roaReaders);
+  freeROATable(oldTable);
+
+  LOG(LEVEL_INFO, HDR "Compiled ROA table with %u IPv4 and %u IPv6 entries",
+                  pthread_self(), getROATableSize(table, 4),
+                  getROATableSize(table, 6));
+
+  return true;
 }
 
 /**
- * This is the subroutine of requestUpdateValidation that adds and validates
- * the update.
+ * Determine the origin validation result using the compiled ROA table. This
+ * does not acquire any lock and does not add the update to the prefix cache,
+ * requestUpdateValidation still has to be called for the update.
  *
- * @param self The instance of the prefix cache
- * @param pcUpdate The prefix cache update
- * @param as The as number of the update
- * @param isNew Indicates if the prefix was added to the prefix tree during this
- *        validation request.
- * @return false in case of an internal error.
+ * @param self The prefix cache.
+ * @param prefix The prefix of the update.
+ * @param as The origin AS of the update.
+ *
+ * @return The validation result or SRx_RESULT_UNDEFINED if the ROA white-list
+ *         changed since the table was compiled.
+ *
+ * @since 0.6.2.0
  */
-static bool _performUpdateValidationKnownPrefix(PrefixCache* self,
-                                                PC_Update* pcUpdate,
-                                                uint32_t as, bool isNew)
+SRxValidationResultVal getCompiledOriginStatus(PrefixCache* self,
+                                               IPPrefix* prefix, uint32_t as)
 {
-  PC_Prefix* pcPrefix = (PC_Prefix*)pcUpdate->treeNode->data;
-  PC_Prefix* pcPrefix_Po = pcPrefix;
-  PC_AS*     pcAS = getASFromPrefix(pcPrefix, as);
-  pcAS->update_count++;
+  SRxValidationResultVal result  = SRx_RESULT_UNDEFINED;
+  uint32_t               version = 0;
+  ROA_Table*             table   = NULL;
 
-  // P might be covered by a ROA (we don't know if NEW prefix).
-  while (   ( isNew && (pcPrefix->state_of_other == SRx_RESULT_INVALID))
-         || (!isNew && (pcPrefix->roa_coverage > 0)))
+  enterEpoch(&self->roaReaders);
+  version = __atomic_load_n(&self->roaVersion, __ATOMIC_SEQ_CST);
+  table   = __atomic_load_n(&self->roaTable, __ATOMIC_SEQ_CST);
+  if ((table != NULL) && (table->version == version))
   {
-    _performUpdateValidation_PrefixIsCovereByAROA(pcPrefix_Po, pcPrefix,
-                                                  pcUpdate, as, isNew);
+    result = lookupROATable(table, prefix, as);
+  }
+  leaveEpoch(&self->roaReaders);
 
-    // (Exist less specific P' ?) => yes
-    // P := P'
-    pcPrefix = getParent(pcPrefix->treeNode);
+  return result;
+}
 
-    if (pcPrefix == NULL)
+/**
+ * Store the ROA results that were held back during the synchronization with
+ * the RPKI cache in the update cache. Updates whose result flapped back to the
+ * stored result are skipped.
+ *
+ * @param self The prefix cache.
+ * @param useQueue If true the changed updates are added to the RPKI queue,
+ *                 otherwise the clients are notified right away.
+ *
+ * @return The number of updates whose ROA result changed.
+ *
+ * @since 0.6.2.0
+ */
+static uint32_t _applyDeferredResults(PrefixCache* self, bool useQueue)
+{
+  PC_DeferredResult* results  = NULL;
+  PC_DeferredResult* deferred = NULL;
+  PC_DeferredResult* tmp      = NULL;
+  SRxResult          srxRes;
+  SRxDefaultResult   defaultRes;
+  uint32_t           numDeferred = 0;
+  uint32_t           numChanged  = 0;
+
+  WRITE_LOCK(&self->treeLock);
+
+  results = (PC_DeferredResult*)self->deferredResults;
+  HASH_ITER(hh, results, deferred, tmp)
+  {
+    numDeferred++;
+    // The update might have been removed by the garbage collector meanwhile
+    if (getUpdateResult(self->updateCache, &deferred->updateID, 0, NULL,
+                        &srxRes, &defaultRes, NULL))
     {
-      // (Exist less specific P' ?) => No
-      break;
+      if (srxRes.roaResult != deferred->roaResult)
+      {
+        srxRes.roaResult    = deferred->roaResult;
+        srxRes.bgpsecResult = SRx_RESULT_DONOTUSE;
+        srxRes.aspaResult   = SRx_RESULT_DONOTUSE;
+        // The clients are notified when the RPKI queue is processed.
+        if (modifyUpdateResult(self->updateCache, &deferred->updateID, 
+                               &srxRes, useQueue))
+        {
+          if (useQueue)
+          {
+            rq_queue(getRPKIQueue(), RQ_ROA, &deferred->updateID);
+          }
+          numChanged++;
+        }
+      }
+    }
+    else
+    {
+      LOG(LEVEL_DEBUG, HDR "Deferred ROA result for the removed update "
+                       "[0x%08X] dropped!", pthread_self(), 
+                       deferred->updateID);
     }
+    HASH_DEL(results, deferred);
+    freeToSlab(&_deferredPool, deferred);
   }
-  return _performUpdateValidation_PrefixNotCovered(self, pcPrefix_Po,
-                                                  pcUpdate);
+  self->deferredResults = NULL;
 
-  return true;
-}
+  UNLOCK_WRITE_LOCK(&self->treeLock);
 
-////////////////////////////////////////////////////////////////////////////////
-// REMOVE AN UPDATE
-////////////////////////////////////////////////////////////////////////////////
+  LOG(LEVEL_INFO, HDR "Applied %u of %u deferred ROA result(s)", 
+                  pthread_self(), numChanged, numDeferred);
+
+  return numChanged;
+}
 
 /**
- * This method will remove the given update from the prefix cache.
+ * Store the ROA results that were held back during the synchronization with
+ * the RPKI cache in the update cache. Updates whose result flapped back to the
+ * stored result are skipped, all others are added to the RPKI queue once to
+ * notify the clients with the processing of the end of data.
+ *
+ * @param self The prefix cache.
  *
- * NOT IMPLEMENTED PRIOR VERSION 0.5.1
+ * @return The number of updates whose ROA result changed.
+ *
+ * @since 0.6.2.0
+ */
+uint32_t applyDeferredResults(PrefixCache* self)
+{
+  return _applyDeferredResults(self, true);
+}
+
+/**
+ * Store the ROA results that were held back during the synchronization with
+ * the RPKI cache in the update cache and notify the clients right away. Used
+ * if the synchronization ends without an end of data.
  *
  * @param self The prefix cache.
- * @param updateID The id of the update that has to be removed.
- * @param prefix The prefix of the update.
- * @param as The AS number of the update.
  *
- * @return true if the update could be removed.
+ * @return The number of updates whose ROA result changed.
+ *
+ * @since 0.6.2.0
  */
-bool removeUpdate(PrefixCache* self, SRxUpdateID* updateID, IPPrefix* prefix,
-                  uint32_t as)
+uint32_t flushDeferredResults(PrefixCache* self)
 {
-  //TODO: Implement for 0.5.x
-  RAISE_ERROR("IMPLEMENTATION EXPECTED FOR VERSION 0.5.1");
-  return true;
+  return _applyDeferredResults(self, false);
 }
 
 /**
@@ -899,7 +1701,9 @@ static void _addROAwl_CheckCoverage(PrefixCache* self, uint8_t prefixLen,
                                   PC_Prefix* pcPrefix, PC_Prefix* parentPrefix);
 static void _addROAwl_verifyUpdates(PrefixCache* self, PC_Prefix* pcPrefix,
                                     PC_ROA* pcROA, bool suppressNotification);
-static void _addROAwl_moveMatchedUpdatesToValid(UpdateCache* updateCache,
+static void _addROAwl_verifyChildren(PrefixCache* self, patricia_node_t* node,
+                                     PC_ROA* pcROA, bool suppressNotification);
+static void _addROAwl_moveMatchedUpdatesToValid(PrefixCache* self,
                                                SList* validList,
                                                SList* otherList, PC_ROA* pcROA,
                                                bool suppressNotification);
@@ -980,7 +1784,9 @@ bool addROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
     initSList(&pcPrefix->asn);
     initSList(&pcPrefix->other);
     initSList(&pcPrefix->valid);
-    pcPrefix->roa_coverage = 0;
+    pcPrefix->roa_coverage    = 0;
+    pcPrefix->subtree_updates = _getChildrenUpdates(treeNode);
+    pcPrefix->stale           = false;
 
     // Exist less Specific P'
     PC_Prefix* pcParent = getParent(pcPrefix->treeNode);
@@ -993,6 +1799,7 @@ bool addROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
     {
       // (Exist less specific P') => Yes - if other is unknown no further roas
       // do exist up the tree.
+      _refreshPrefix(pcParent);
       pcPrefix->state_of_other = pcParent->state_of_other;
       if (pcPrefix->state_of_other != SRx_RESULT_NOTFOUND)
       {
@@ -1005,6 +1812,7 @@ bool addROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
   {
     // free(lookupPrefix); // prefix already existed. This instance is not used.
     pcPrefix = (PC_Prefix*)treeNode->data;
+    _refreshPrefix(pcPrefix);
   }
 
   if(pcPrefix!=NULL)
@@ -1024,6 +1832,7 @@ bool addROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
       }
   } else{
       RAISE_ERROR(" exist! --> patricia tree fetch error");
+      UNLOCK_WRITE_LOCK(&self->treeLock);
       RAISE_ERROR(" STOP this point -- press any key");
       getchar();
       return false;
@@ -1074,6 +1883,7 @@ bool addROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
   {
     pcROA->roa_count++;
   }
+  __atomic_add_fetch(&self->roaVersion, 1, __ATOMIC_SEQ_CST);
   _addROAwl_verifyUpdates(self, pcPrefix, pcROA, suppressNotification);
   UNLOCK_WRITE_LOCK(&self->treeLock);
 
@@ -1179,14 +1989,14 @@ static void _addROAwl_verifyUpdates(PrefixCache* self, PC_Prefix* pcPrefix,
     }
 
     // Move all matches from Other to Valid.
-    _addROAwl_moveMatchedUpdatesToValid(self->updateCache, &pcPrefix->valid,
+    _addROAwl_moveMatchedUpdatesToValid(self, &pcPrefix->valid,
                                         &pcPrefix->other, pcROA, 
                                         suppressNotification);
 
     // For Each Update in Other
     if (pcPrefix->state_of_other == SRx_RESULT_NOTFOUND)
     {
-      _ROAwl_changeStateOfOther(self->updateCache, pcPrefix,
+      _ROAwl_changeStateOfOther(self, pcPrefix,
                                 SRx_RESULT_INVALID, suppressNotification);
     }
 
@@ -1197,7 +2007,7 @@ static void _addROAwl_verifyUpdates(PrefixCache* self, PC_Prefix* pcPrefix,
     // (Does R cover P ? ) => No
     if (pcPrefix->state_of_other == SRx_RESULT_NOTFOUND)
     {
-      _ROAwl_changeStateOfOther(self->updateCache, pcPrefix,
+      _ROAwl_changeStateOfOther(self, pcPrefix,
                                 SRx_RESULT_INVALID, suppressNotification);
 
       checkChildren = true;
@@ -1206,18 +2016,49 @@ static void _addROAwl_verifyUpdates(PrefixCache* self, PC_Prefix* pcPrefix,
 
   if (checkChildren)
   {
-    SList childrenList;
-    SListNode* childrenListNode = NULL;
-    initSList(&childrenList);
+    _addROAwl_verifyChildren(self, pcPrefix->treeNode, pcROA,
+                             suppressNotification);
+  }
+}
+
+/**
+ * Continue _addROAwl_verifyUpdates with the next more specific prefixes of the
+ * given patricia tree node. Prefixes without updates in their subtree are not
+ * visited, they are flagged stale instead.
+ *
+ * @param self Instance of the prefix cache.
+ * @param node The patricia tree node whose children are examined.
+ * @param pcROA The roa to be added.
+ * @param suppressNotification Allows to suppress update modification callback
+ *
+ * @since 0.6.2.0
+ */
+static void _addROAwl_verifyChildren(PrefixCache* self, patricia_node_t* node,
+                                     PC_ROA* pcROA, bool suppressNotification)
+{
+  patricia_node_t* children[2] = { node->l, node->r };
+  PC_Prefix*       pcPrefix    = NULL;
+  int              idx;
 
-    if (getChildren(&childrenList, pcPrefix->treeNode))
+  for (idx = 0; idx < 2; idx++)
+  {
+    if (children[idx] == NULL)
     {
-      FOREACH_SLIST(&childrenList, childrenListNode)
-      {
-        pcPrefix = (PC_Prefix*)childrenListNode->data;
-        _addROAwl_verifyUpdates(self, pcPrefix, pcROA, suppressNotification);
-      }
-      releaseSList(&childrenList);
+      continue;
+    }
+    pcPrefix = (PC_Prefix*)children[idx]->data;
+    if (pcPrefix == NULL)
+    {
+      _addROAwl_verifyChildren(self, children[idx], pcROA,
+                               suppressNotification);
+    }
+    else if (pcPrefix->subtree_updates == 0)
+    {
+      pcPrefix->stale = true;
+    }
+    else
+    {
+      _addROAwl_verifyUpdates(self, pcPrefix, pcROA, suppressNotification);
     }
   }
 }
@@ -1226,13 +2067,13 @@ static void _addROAwl_verifyUpdates(PrefixCache* self, PC_Prefix* pcPrefix,
  * Change the P::State_of_Other to the given new state and notify all updates
  * stored in the "other" list.
  *
- * @param updateCache The update cache
+ * @param self The prefix cache
  * @param pcPrefix The prefix whose updates have to be changed.
  * @param newState The new validation state.
  * @param suppressNotification Allows to suppress the callback call for update
  *                             changes
  */
-static void _ROAwl_changeStateOfOther(UpdateCache* updateCache,
+static void _ROAwl_changeStateOfOther(PrefixCache* self,
                                       PC_Prefix* pcPrefix,
                                       SRxValidationResultVal newState,
                                       bool suppressNotification)
@@ -1245,7 +2086,7 @@ static void _ROAwl_changeStateOfOther(UpdateCache* updateCache,
   FOREACH_SLIST(&pcPrefix->other, otherListNode)
   {
     pcUpdate = (PC_Update*)otherListNode->data;
-    notifyUpdateCacheForROAChange(updateCache, &pcUpdate->updateID, newState, 
+    notifyUpdateCacheForROAChange(self, &pcUpdate->updateID, newState, 
                                   suppressNotification);
   }
 }
@@ -1253,7 +2094,7 @@ static void _ROAwl_changeStateOfOther(UpdateCache* updateCache,
 /**
  * Moves the list nodes from otherList to validList.
  *
- * @param updateCache The cache containing the updates that are affected.
+ * @param self The prefix cache containing the updates that are affected.
  * @param validList the list of valid updates.
  * @param otherList the list of not valid updates.
  * @param pcROA the ROA that is used to match updates.
@@ -1261,7 +2102,7 @@ static void _ROAwl_changeStateOfOther(UpdateCache* updateCache,
  *             modification callback function.
  * 
  */
-static void _addROAwl_moveMatchedUpdatesToValid(UpdateCache* updateCache,
+static void _addROAwl_moveMatchedUpdatesToValid(PrefixCache* self,
                                                 SList* validList,
                                                 SList* otherList, PC_ROA* pcROA,
                                                 bool suppressNotification)
@@ -1280,7 +2121,7 @@ static void _addROAwl_moveMatchedUpdatesToValid(UpdateCache* updateCache,
       nodeToMove = currNode;
       pcUpdate->roa_match++;
       pcROA->update_count++;
-      notifyUpdateCacheForROAChange(updateCache, &pcUpdate->updateID,
+      notifyUpdateCacheForROAChange(self, &pcUpdate->updateID,
                                     SRx_RESULT_VALID, suppressNotification);
     }
     else
@@ -1336,7 +2177,11 @@ static void _delROAwl_validateUpdates(PrefixCache* self, PC_Prefix* pcPrefix,
                       PC_ROA* pcROA, SRxValidationResultVal parentStateOfOther,
                       bool suppressNotification);
 
-static void _delROAwl_moveToOther(UpdateCache* updateCache, PC_Prefix* pcPrefix,
+static void _delROAwl_validateChildren(PrefixCache* self, patricia_node_t* node,
+                     PC_ROA* pcROA, SRxValidationResultVal stateOfOther,
+                     bool suppressNotification);
+
+static void _delROAwl_moveToOther(PrefixCache* self, PC_Prefix* pcPrefix,
                                   PC_ROA* pcROA, bool suppressNotification);
 
 /**
@@ -1406,6 +2251,7 @@ bool delROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
       LOG(LEVEL_NOTICE, "Received white-list entry withdrawal for reserved AS"
               "number %u from validation cache %u - As expected entry not "
               "found!", originAS, valCacheID);
+      UNLOCK_WRITE_LOCK(&self->treeLock);
       return false;
     }
     else
@@ -1421,6 +2267,7 @@ bool delROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
   {
   //  free(lookupPrefix); // prefix already existed. This instance is not used.
     pcPrefix = (PC_Prefix*)treeNode->data;
+    _refreshPrefix(pcPrefix);
   }
 
   if(pcPrefix!=NULL)
@@ -1502,6 +2349,7 @@ bool delROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
                               suppressNotification);
   }
 
+  __atomic_add_fetch(&self->roaVersion, 1, __ATOMIC_SEQ_CST);
   pcROA->roa_count--;
   if (pcROA->roa_count < 0)
   {
@@ -1566,11 +2414,11 @@ static void _delROAwl_validateUpdates(PrefixCache* self, PC_Prefix* pcPrefix,
     {
       if (pcPrefix->roa_coverage == 0)
       {
-        _ROAwl_changeStateOfOther(self->updateCache, pcPrefix,
+        _ROAwl_changeStateOfOther(self, pcPrefix,
                                   SRx_RESULT_NOTFOUND, suppressNotification);
       }
     }
-    _delROAwl_moveToOther(self->updateCache, pcPrefix, pcROA, 
+    _delROAwl_moveToOther(self, pcPrefix, pcROA, 
                           suppressNotification);
     checkForChildren = true;
   }
@@ -1581,7 +2429,7 @@ static void _delROAwl_validateUpdates(PrefixCache* self, PC_Prefix* pcPrefix,
     {
       if (parentStateOfOther == SRx_RESULT_NOTFOUND)
       {
-        _ROAwl_changeStateOfOther(self->updateCache, pcPrefix,
+        _ROAwl_changeStateOfOther(self, pcPrefix,
                                   SRx_RESULT_NOTFOUND, suppressNotification);
         checkForChildren = true;
       }
@@ -1590,35 +2438,67 @@ static void _delROAwl_validateUpdates(PrefixCache* self, PC_Prefix* pcPrefix,
 
   if (checkForChildren)
   {
-    SList childrenList;
-    SListNode* childrenListNode = NULL;
-    PC_Prefix* childPrefix = NULL;
-    initSList(&childrenList);
+    _delROAwl_validateChildren(self, pcPrefix->treeNode, pcROA,
+                               pcPrefix->state_of_other, suppressNotification);
+  }
+}
+
+/**
+ * Continue _delROAwl_validateUpdates with the next more specific prefixes of 
+ * the given patricia tree node. Prefixes without updates in their subtree are
+ * not visited, they are flagged stale instead.
+ *
+ * @param self The prefix cache
+ * @param node The patricia tree node whose children are examined.
+ * @param pcROA The ROA
+ * @param stateOfOther the Other state of the prefix of the node.
+ * @param suppressNotification Allow to suppress calling the update 
+ *                  modification callback function.
+ *
+ * @since 0.6.2.0
+ */
+static void _delROAwl_validateChildren(PrefixCache* self, patricia_node_t* node,
+                     PC_ROA* pcROA, SRxValidationResultVal stateOfOther,
+                     bool suppressNotification)
+{
+  patricia_node_t* children[2] = { node->l, node->r };
+  PC_Prefix*       pcPrefix    = NULL;
+  int              idx;
 
-    if (getChildren(&childrenList, pcPrefix->treeNode))
+  for (idx = 0; idx < 2; idx++)
+  {
+    if (children[idx] == NULL)
     {
-      FOREACH_SLIST(&childrenList, childrenListNode)
-      {
-        childPrefix = (PC_Prefix*)childrenListNode->data;
-        _delROAwl_validateUpdates(self, childPrefix, pcROA,
-                                  pcPrefix->state_of_other, 
-                                  suppressNotification);
-      }
-      releaseSList(&childrenList);
+      continue;
+    }
+    pcPrefix = (PC_Prefix*)children[idx]->data;
+    if (pcPrefix == NULL)
+    {
+      _delROAwl_validateChildren(self, children[idx], pcROA, stateOfOther,
+                                 suppressNotification);
+    }
+    else if (pcPrefix->subtree_updates == 0)
+    {
+      pcPrefix->stale = true;
+    }
+    else
+    {
+      _delROAwl_validateUpdates(self, pcPrefix, pcROA, stateOfOther, 
+                                suppressNotification);
     }
   }
 }
 
 /**
  * Move all possible matches from valid into other
- * @param updateCache The update cache to be informed in case an update changes
- *                    validation state.
+ * @param self The prefix cache whose update cache is informed in case an 
+ *             update changes validation state.
  * @param pcPrefix The prefix under investigation
  * @param pcROA the ROA that is removed
  * @param suppressNotification Allows to suppress calling the update
  *                             modification callback function.
  */
-static void _delROAwl_moveToOther(UpdateCache* updateCache, PC_Prefix* pcPrefix,
+static void _delROAwl_moveToOther(PrefixCache* self, PC_Prefix* pcPrefix,
                                   PC_ROA* pcROA, bool suppressNotification)
 {
   SListNode* nodeToMove = NULL;
@@ -1649,7 +2529,7 @@ static void _delROAwl_moveToOther(UpdateCache* updateCache, PC_Prefix* pcPrefix,
       if (pcUpdate->roa_match == 0)
       {
         nodeToMove = currNode;
-        notifyUpdateCacheForROAChange(updateCache, &pcUpdate->updateID,
+        notifyUpdateCacheForROAChange(self, &pcUpdate->updateID,
                                       pcPrefix->state_of_other, 
                                       suppressNotification);
       }
@@ -1850,6 +2730,11 @@ static void outputPrefix(XMLOut* out, patricia_node_t* treeNode)
     addStrAttrib(out, "ip", ipOfPrefix_tToStr(treeNode->prefix));
     addIntAttrib(out, "length", treeNode->prefix->bitlen);
     addIntAttrib(out, "roa-coverage", pcPrefix->roa_coverage);
+    addU32Attrib(out, "subtree-updates", pcPrefix->subtree_updates);
+    if (pcPrefix->stale)
+    {
+      addBoolAttrib(out, "stale", true);
+    }
     addIntAttrib(out, "no-valid-updates", pcPrefix->valid.size);
     addIntAttrib(out, "no-other-updates", pcPrefix->other.size);
     addStrAttrib(out, "state-of-other",
@@ -1931,9 +2816,13 @@ static void outputPrefix(XMLOut* out, patricia_node_t* treeNode)
  */
 void outputPrefixCacheAsXML(PrefixCache* self, FILE* stream)
 {
-  XMLOut      out;
-  SListNode*  updateListNode;
-  PC_Update*  pcUpdate;
+  XMLOut           out;
+  SListNode*       updateListNode;
+  PC_Update*       pcUpdate;
+  patricia_node_t* treeNode;
+  PC_Prefix*       pcPrefix;
+  SList*           lists[2];
+  int              lIdx;
 
   initXMLOut(&out, stream);
   openTag(&out, "prefix-cache");
@@ -1944,28 +2833,30 @@ void outputPrefixCacheAsXML(PrefixCache* self, FILE* stream)
     outputPrefix(&out, self->prefixTree->head);
   }
 
-  // Updates
-  if (sizeOfSList(&self->updates))
+  // Updates, taken from the valid and other lists of all prefixes
+  openTag(&out, "updates");
+  PATRICIA_WALK(self->prefixTree->head, treeNode)
   {
-    openTag(&out, "updates");
-    FOREACH_SLIST(&self->updates, updateListNode)
+    pcPrefix = (PC_Prefix*)treeNode->data;
+    lists[0] = pcPrefix != NULL ? &pcPrefix->valid : NULL;
+    lists[1] = pcPrefix != NULL ? &pcPrefix->other : NULL;
+    for (lIdx = 0; lIdx < 2 && lists[lIdx] != NULL; lIdx++)
     {
-      pcUpdate = (PC_Update*)getDataOfSListNode(updateListNode);
-      openTag(&out, "update");
-        addH32Attrib(&out, "update-id", pcUpdate->updateID);
-        addU32Attrib(&out, "origin-as", pcUpdate->as);
-        addAttrib(&out, "prefix", "%s/%hhu",
-                  ipOfPrefix_tToStr(pcUpdate->treeNode->prefix),
-                  pcUpdate->treeNode->prefix->bitlen);
-        addU32Attrib(&out, "roa-count", pcUpdate->roa_match);
-        if (pcUpdate->roa_match > 0)
-        {
-          addStrAttrib(&out, "val-state", "VALID");
-        }
-        else
-        {
-          if (((PC_Prefix*)pcUpdate->treeNode->data)->state_of_other
-              == SRx_RESULT_NOTFOUND)
+      FOREACH_SLIST(lists[lIdx], updateListNode)
+      {
+        pcUpdate = (PC_Update*)getDataOfSListNode(updateListNode);
+        openTag(&out, "update");
+          addH32Attrib(&out, "update-id", pcUpdate->updateID);
+          addU32Attrib(&out, "origin-as", pcUpdate->as);
+          addAttrib(&out, "prefix", "%s/%hhu",
+                    ipOfPrefix_tToStr(pcUpdate->treeNode->prefix),
+                    pcUpdate->treeNode->prefix->bitlen);
+          addU32Attrib(&out, "roa-count", pcUpdate->roa_match);
+          if (pcUpdate->roa_match > 0)
+          {
+            addStrAttrib(&out, "val-state", "VALID");
+          }
+          else if (pcPrefix->state_of_other == SRx_RESULT_NOTFOUND)
           {
             addStrAttrib(&out, "val-state", "NOTFOUND");
           }
@@ -1973,11 +2864,11 @@ void outputPrefixCacheAsXML(PrefixCache* self, FILE* stream)
           {
             addStrAttrib(&out, "val-state", "INVALID");
           }
-        }
-      closeTag(&out);
+        closeTag(&out);
+      }
     }
-    closeTag(&out);
-  }
+  } PATRICIA_WALK_END;
+  closeTag(&out);
 
   closeTag(&out);
   releaseXMLOut(&out);
@@ -1993,19 +2884,54 @@ void outputPrefixCacheAsXML(PrefixCache* self, FILE* stream)
  * expected that the update exists within the update cache, otherwise an error
  * log will be generated.
  *
- * @param updCache Update Cache instance, not NULL
+ * Suppressed changes are the result of an RPKI Cache update. They are held
+ * back in the deferred results of the prefix cache until applyDeferredResults
+ * is called with the end of data, a later change of the same update replaces
+ * the held back result. This method MUST be called with the write lock of the
+ * prefix tree.
+ *
+ * @param self The prefix cache, not NULL
  * @param updateID IF of the update whose validation state changed.
  * @param newROAResult The new validation state.
- * @param suppressNotification it true, do add a note to the RPKI queue, 
- *              otherwise call the updateChange callback method. Should only be
- *              set to true if the change is the result of an RPKI Cache update.
+ * @param suppressNotification if true, defer the change until the end of
+ *              data, otherwise store the result and call the updateChange 
+ *              callback method. Should only be set to true if the change is 
+ *              the result of an RPKI Cache update.
  */
-static void notifyUpdateCacheForROAChange(UpdateCache* updCache,
+static void notifyUpdateCacheForROAChange(PrefixCache* self,
                      SRxUpdateID* updateID, SRxValidationResultVal newROAResult,
                      bool suppressNotification)
 {
-  if (updCache != NULL)
+  PC_DeferredResult* deferred = NULL;
+  PC_DeferredResult* results  = (PC_DeferredResult*)self->deferredResults;
+
+  if (self->updateCache != NULL)
   {
+    if (suppressNotification)
+    {
+      HASH_FIND(hh, results, updateID, sizeof(SRxUpdateID), deferred);
+      if (deferred == NULL)
+      {
+        deferred = (PC_DeferredResult*)allocFromSlab(&_deferredPool);
+        if (deferred == NULL)
+        {
+          RAISE_SYS_ERROR("Not enough memory to defer the ROA result of "
+                          "update [0x%08X]!", *updateID);
+          return;
+        }
+        deferred->updateID = *updateID;
+        HASH_ADD(hh, results, updateID, sizeof(SRxUpdateID), deferred);
+        self->deferredResults = results;
+      }
+      LOG(LEVEL_DEBUG, HDR "Defer new ROA result[0x%02X] for update [0x%08X]",
+                       pthread_self(), newROAResult, *updateID);
+      deferred->roaResult = newROAResult;
+      return;
+    }
+
+    // The result is stored right away, a held back one is outdated.
+    _dropDeferredResult(self, updateID);
+
     SRxResult srxRes;
     srxRes.roaResult    = newROAResult;
     srxRes.bgpsecResult = SRx_RESULT_DONOTUSE; // Indicates this
@@ -2014,17 +2940,7 @@ static void notifyUpdateCacheForROAChange(UpdateCache* updCache,
 
     LOG(LEVEL_DEBUG, HDR "Store new ROA result[0x%02X] for update [0x%08X]",
                      pthread_self(), newROAResult, *updateID);
-    // Modify the result but DO NOT send the notification to the clients.
-    if (modifyUpdateResult(updCache, updateID, &srxRes, suppressNotification))
-    {
-      if (suppressNotification)
-      {
-        // To prevent churn we suppressed the notification for the update result
-        // modification and just add a notification into the rpki queue
-        rq_queue(getRPKIQueue(), RQ_ROA, updateID);
-      }
-    }
-    else
+    if (!modifyUpdateResult(self->updateCache, updateID, &srxRes, false))
     {
       RAISE_SYS_ERROR("A validation result for a non existing update [0x%08X]!",
                       *updateID);
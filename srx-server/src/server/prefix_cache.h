@@ -22,10 +22,21 @@
  *
  * Prefix Cache.
  *
- * @version 0.6.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Removed the list of all updates and its mutex, added
+ *              numUpdates and findUpdate.
+ *            * Implemented removeUpdate.
+ *            * Added the compiled ROA table with compileROATable and
+ *              getCompiledOriginStatus.
+ *            * Added subtree_updates and stale to PC_Prefix.
+ *            * Added PC_ValidationRequest and requestUpdateValidations.
+ *            * Added flushDeferredResults.
+ *            * Suppressed ROA result changes are deferred until
+ *              applyDeferredResults is called, added deferredResults.
  * 0.6.0.0  - 2021/02/26 - kyehwanl
  *            * Added ASPA_DBManager and AspaCache to RPKIHandler. 
  * 0.5.0.0  - 2017/07/06 - oborchert
@@ -60,8 +71,10 @@
 #define HAVE_IPV6
 #include <patricia.h>
  
+#include "server/roa_table.h"
 #include "server/update_cache.h"
 #include "shared/srx_defs.h"
+#include "util/epoch.h"
 #include "util/mutex.h"
 #include "util/prefix.h"
 #include "util/rwlock.h"
@@ -69,7 +82,8 @@
 
 /** Do call the update change callback */
 #define PC_DONT_SUPPRESS false
-/** Do not call the update change callback */
+/** Do not call the update change callback, defer the result change until
+ * applyDeferredResults is called */
 #define PC_DO_SUPPRESS   true
 
 /**
@@ -78,11 +92,18 @@
 typedef struct {
   UpdateCache*      updateCache;
   patricia_tree_t*  prefixTree;
-  // This list is not really needed!
-  SList             updates;
- 
+  /** The number of updates stored in the valid and other lists (treeLock) */
+  uint32_t          numUpdates;
+  /** The ROA table compiled at the last end of data, read lock free */
+  ROA_Table*        roaTable;
+  /** Readers of the compiled ROA table */
+  EpochDomain       roaReaders;
+  /** Incremented with each change of the ROA white-list (treeLock) */
+  uint32_t          roaVersion;
+  /** The ROA results held back until the end of data (treeLock) */
+  void*             deferredResults;
+
   // Access control variables
-  Mutex             updatesMutex;
   RWLock            treeLock;
   RWLock            otherLock;
   RWLock            validLock;
@@ -121,6 +142,13 @@ typedef struct {
   /** Contains all ASN's attached to this prefix either through ROA.s or 
    * updates or both. Each AS (PC_AS) is listed only once. */
   SList    asn;
+  /** Number of updates of this prefix and all more specific prefixes. ROA 
+   * changes do not descend into more specific prefixes without updates. */
+  uint32_t subtree_updates;
+  /** Indicates that roa_coverage and state_of_other of this prefix and all 
+   * more specific prefixes were not maintained during ROA changes. They are 
+   * recalculated before they are used the next time. */
+  bool     stale;
 } PC_Prefix;
 
 /**
@@ -160,6 +188,21 @@ typedef struct {
   uint32_t update_count;
 } PC_ROA;
 
+/**
+ * An update that has to be added to the prefix cache, used to add multiple
+ * updates at once.
+ *
+ * @since 0.6.2.0
+ */
+typedef struct {
+  /** The id of the update. */
+  SRxUpdateID updateID;
+  /** The prefix of the update. */
+  IPPrefix    prefix;
+  /** The origin AS of the update. */
+  uint32_t    as;
+} PC_ValidationRequest;
+
 /**
  * Initializes an empty cache and creates a link to an existing Update Cache.
  *
@@ -190,20 +233,115 @@ bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
                              IPPrefix* prefix, uint32_t as);
 
 /**
- * This method will remove the given update from the prefix cache.
- * 
- * NOT IMPLEMENTED PRIOR VERSION 0.3
+ * Add the given updates to the prefix cache while holding the write lock of
+ * the tree only once. Each update is validated as in requestUpdateValidation.
+ *
+ * @param self The prefix cache
+ * @param requests The updates to be added.
+ * @param count The number of updates.
+ *
+ * @return the number of updates that could not be added.
+ *
+ * @since 0.6.2.0
+ */
+uint32_t requestUpdateValidations(PrefixCache* self,
+                                  PC_ValidationRequest* requests,
+                                  uint32_t count);
+
+/**
+ * This method will remove the given update from the prefix cache. The update
+ * counters of the ROAs that cover the update and of its origin AS are
+ * decremented, the AS and the prefix are removed if they are not used anymore.
+ * The update is kept if the update cache stores an update with this id, the
+ * update was stored again after it got removed from the update cache.
  * 
  * @param self The prefix cache.
  * @param updateID The id of the update that has to be removed.
  * @param prefix The prefix of the update.
  * @param as The AS number of the update.
  * 
- * @return true if the update could be removed.
+ * @return true if the update could be removed, false if the update is not
+ *         stored in the prefix cache (e.g. it was never validated) or is stored
+ *         in the update cache again.
  */
 bool removeUpdate(PrefixCache* self, SRxUpdateID* updateID, IPPrefix* prefix,
                   uint32_t as);
 
+/**
+ * Return the prefix cache update with the given id. The update is only valid
+ * as long as it is not removed from the prefix cache, it is meant for display
+ * purpose.
+ *
+ * @param self The prefix cache.
+ * @param updateID The id of the update.
+ * @param prefix The prefix of the update.
+ *
+ * @return The update or NULL if it is not stored in the prefix cache.
+ *
+ * @since 0.6.2.0
+ */
+PC_Update* findUpdate(PrefixCache* self, SRxUpdateID* updateID,
+                      IPPrefix* prefix);
+
+/**
+ * Compile the ROA white-list entries of the prefix cache into a new ROA table
+ * and publish it for lock free lookups. Called at the end of data, MUST NOT be
+ * called by multiple threads at the same time.
+ *
+ * @param self The prefix cache.
+ *
+ * @return false if the table could not be compiled, the previous table is
+ *         then kept but not used anymore.
+ *
+ * @since 0.6.2.0
+ */
+bool compileROATable(PrefixCache* self);
+
+/**
+ * Determine the origin validation result using the compiled ROA table. This
+ * does not acquire any lock and does not add the update to the prefix cache,
+ * requestUpdateValidation still has to be called for the update.
+ *
+ * @param self The prefix cache.
+ * @param prefix The prefix of the update.
+ * @param as The origin AS of the update.
+ *
+ * @return The validation result or SRx_RESULT_UNDEFINED if the ROA white-list
+ *         changed since the table was compiled.
+ *
+ * @since 0.6.2.0
+ */
+SRxValidationResultVal getCompiledOriginStatus(PrefixCache* self,
+                                               IPPrefix* prefix, uint32_t as);
+
+/**
+ * Store the ROA results that were held back during the synchronization with
+ * the RPKI cache in the update cache. Each update whose result changed is added
+ * once to the RPKI queue, updates whose result flapped back are skipped. Called
+ * at the end of data before the RPKI queue is processed.
+ *
+ * @param self The prefix cache.
+ *
+ * @return The number of updates whose ROA result changed.
+ *
+ * @since 0.6.2.0
+ */
+uint32_t applyDeferredResults(PrefixCache* self);
+
+/**
+ * Store the ROA results that were held back during the synchronization with
+ * the RPKI cache in the update cache and notify the clients right away. Used
+ * if the synchronization ends without an end of data (cache reset or lost
+ * connection).
+ *
+ * @param self The prefix cache.
+ *
+ * @return The number of updates whose ROA result changed.
+ *
+ * @since 0.6.2.0
+ */
+uint32_t flushDeferredResults(PrefixCache* self);
+
 /**
  * Add the given ROA white-list entry provided by the specified validation cache
  * with the given session id.
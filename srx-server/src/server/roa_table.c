@@ -0,0 +1,334 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ *
+ * The compiled ROA table.
+ *
+ * @version 0.6.2.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Code created.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include "server/roa_table.h"
+#include "util/log.h"
+
+/** The initial number of entries per address family */
+#define ROA_TABLE_INIT_SIZE 1024
+
+/**
+ * Return the address family index of the IP version.
+ *
+ * @param version The IP version (4 or 6)
+ *
+ * @return 0 for IPv4, 1 for IPv6
+ */
+static inline int _afiIdx(uint8_t version)
+{
+  return version == 4 ? 0 : 1;
+}
+
+/**
+ * Convert the prefix into the two 64 bit words used by the table. The bits
+ * beyond the given length are cleared.
+ *
+ * @param prefix The prefix.
+ * @param length The number of bits to keep.
+ * @param hi OUT the upper 64 bits.
+ * @param lo OUT the lower 64 bits.
+ */
+static void _toWords(IPPrefix* prefix, uint8_t length, uint64_t* hi,
+                     uint64_t* lo)
+{
+  int idx;
+
+  *hi = 0;
+  *lo = 0;
+  if (prefix->ip.version == 4)
+  {
+    *hi = (uint64_t)ntohl(prefix->ip.addr.v4.u32) << 32;
+  }
+  else
+  {
+    for (idx = 0; idx < 8; idx++)
+    {
+      *hi = (*hi << 8) | prefix->ip.addr.v6.u8[idx];
+      *lo = (*lo << 8) | prefix->ip.addr.v6.u8[idx + 8];
+    }
+  }
+
+  if (length == 0)
+  {
+    *hi = 0;
+    *lo = 0;
+  }
+  else if (length <= 64)
+  {
+    *hi &= ~0ULL << (64 - length);
+    *lo  = 0;
+  }
+  else if (length < 128)
+  {
+    *lo &= ~0ULL << (128 - length);
+  }
+}
+
+/**
+ * Compare two entries by length, prefix, AS, and max length.
+ *
+ * @param a The first entry.
+ * @param b The second entry.
+ *
+ * @return <0, 0, >0 like memcmp
+ */
+static int _cmpEntry(const void* a, const void* b)
+{
+  const ROA_TableEntry* e1 = (const ROA_TableEntry*)a;
+  const ROA_TableEntry* e2 = (const ROA_TableEntry*)b;
+
+  if (e1->length != e2->length)
+  {
+    return e1->length < e2->length ? -1 : 1;
+  }
+  if (e1->hi != e2->hi)
+  {
+    return e1->hi < e2->hi ? -1 : 1;
+  }
+  if (e1->lo != e2->lo)
+  {
+    return e1->lo < e2->lo ? -1 : 1;
+  }
+  if (e1->asn != e2->asn)
+  {
+    return e1->asn < e2->asn ? -1 : 1;
+  }
+  if (e1->maxLen != e2->maxLen)
+  {
+    return e1->maxLen < e2->maxLen ? -1 : 1;
+  }
+  return 0;
+}
+
+/**
+ * Create a new and empty ROA table.
+ *
+ * @return The table or NULL if not enough memory is available.
+ */
+ROA_Table* newROATable()
+{
+  ROA_Table* self = calloc(1, sizeof(ROA_Table));
+
+  if (self == NULL)
+  {
+    RAISE_ERROR("Not enough memory for the ROA table!");
+  }
+
+  return self;
+}
+
+/**
+ * Free the table and all its entries.
+ *
+ * @param self The table, can be NULL.
+ */
+void freeROATable(ROA_Table* self)
+{
+  if (self != NULL)
+  {
+    free(self->afi[0].entries);
+    free(self->afi[1].entries);
+    free(self);
+  }
+}
+
+/**
+ * Add the ROA white-list entry to the table. Can only be called before
+ * finishROATable.
+ *
+ * @param self The table.
+ * @param prefix The prefix of the ROA white-list entry.
+ * @param maxLen The max length of the ROA white-list entry.
+ * @param asn The origin AS of the ROA white-list entry.
+ *
+ * @return false if not enough memory is available.
+ */
+bool addROATableEntry(ROA_Table* self, IPPrefix* prefix, uint8_t maxLen,
+                      uint32_t asn)
+{
+  ROA_TableAFI*   afi     = &self->afi[_afiIdx(prefix->ip.version)];
+  ROA_TableEntry* entries = NULL;
+  ROA_TableEntry* entry   = NULL;
+  uint32_t        size    = 0;
+
+  if (afi->count == afi->size)
+  {
+    size    = afi->size == 0 ? ROA_TABLE_INIT_SIZE : afi->size * 2;
+    entries = realloc(afi->entries, size * sizeof(ROA_TableEntry));
+    if (entries == NULL)
+    {
+      RAISE_ERROR("Not enough memory to add an entry to the ROA table!");
+      return false;
+    }
+    afi->entries = entries;
+    afi->size    = size;
+  }
+
+  entry = &afi->entries[afi->count++];
+  _toWords(prefix, prefix->length, &entry->hi, &entry->lo);
+  entry->asn    = asn;
+  entry->length = prefix->length;
+  entry->maxLen = maxLen;
+
+  return true;
+}
+
+/**
+ * Sort the entries, remove duplicates and build the levels. Afterwards the
+ * table MUST NOT be modified anymore.
+ *
+ * @param self The table.
+ */
+void finishROATable(ROA_Table* self)
+{
+  ROA_TableAFI* afi   = NULL;
+  uint32_t      idx   = 0;
+  uint32_t      count = 0;
+  int           aIdx;
+
+  for (aIdx = 0; aIdx < 2; aIdx++)
+  {
+    afi = &self->afi[aIdx];
+    afi->numLevels = 0;
+    if (afi->count == 0)
+    {
+      continue;
+    }
+
+    qsort(afi->entries, afi->count, sizeof(ROA_TableEntry), _cmpEntry);
+
+    // Identical ROAs of multiple validation caches are kept once
+    for (idx = 1, count = 1; idx < afi->count; idx++)
+    {
+      if (_cmpEntry(&afi->entries[idx], &afi->entries[count-1]) != 0)
+      {
+        afi->entries[count++] = afi->entries[idx];
+      }
+    }
+    afi->count = count;
+
+    for (idx = 0; idx < afi->count; idx++)
+    {
+      if (   (afi->numLevels == 0)
+          || (afi->levels[afi->numLevels-1].length
+              != afi->entries[idx].length))
+      {
+        afi->levels[afi->numLevels].length = afi->entries[idx].length;
+        afi->levels[afi->numLevels].first  = idx;
+        afi->levels[afi->numLevels].count  = 0;
+        afi->numLevels++;
+      }
+      afi->levels[afi->numLevels-1].count++;
+    }
+  }
+}
+
+/**
+ * Return the number of entries of the given IP version.
+ *
+ * @param self The table.
+ * @param version The IP version (4 or 6).
+ *
+ * @return The number of entries.
+ */
+uint32_t getROATableSize(ROA_Table* self, uint8_t version)
+{
+  return self->afi[_afiIdx(version)].count;
+}
+
+/**
+ * Determine the origin validation result of the given prefix and origin.
+ *
+ * @param self The finished table.
+ * @param prefix The prefix of the update.
+ * @param asn The origin AS of the update.
+ *
+ * @return SRx_RESULT_VALID, SRx_RESULT_INVALID, or SRx_RESULT_NOTFOUND
+ */
+SRxValidationResultVal lookupROATable(ROA_Table* self, IPPrefix* prefix,
+                                      uint32_t asn)
+{
+  ROA_TableAFI*   afi     = &self->afi[_afiIdx(prefix->ip.version)];
+  ROA_TableLevel* level   = NULL;
+  ROA_TableEntry* entry   = NULL;
+  bool            covered = false;
+  uint64_t        hi, lo;
+  uint32_t        low, high, mid;
+  int             lIdx;
+
+  for (lIdx = 0; lIdx < afi->numLevels; lIdx++)
+  {
+    level = &afi->levels[lIdx];
+    if (level->length > prefix->length)
+    {
+      // Only less or equal specific ROAs cover the prefix
+      break;
+    }
+    _toWords(prefix, level->length, &hi, &lo);
+
+    // Find the first entry of the level that is not less than the prefix
+    low  = level->first;
+    high = level->first + level->count;
+    while (low < high)
+    {
+      mid   = low + ((high - low) >> 1);
+      entry = &afi->entries[mid];
+      if ((entry->hi < hi) || ((entry->hi == hi) && (entry->lo < lo)))
+      {
+        low = mid + 1;
+      }
+      else
+      {
+        high = mid;
+      }
+    }
+
+    // All ROAs of this prefix cover the update
+    for (; low < level->first + level->count; low++)
+    {
+      entry = &afi->entries[low];
+      if ((entry->hi != hi) || (entry->lo != lo))
+      {
+        break;
+      }
+      covered = true;
+      if ((entry->asn == asn) && (prefix->length <= entry->maxLen))
+      {
+        return SRx_RESULT_VALID;
+      }
+    }
+  }
+
+  return covered ? SRx_RESULT_INVALID : SRx_RESULT_NOTFOUND;
+}
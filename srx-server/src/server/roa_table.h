@@ -0,0 +1,153 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ *
+ * The ROA table is a compiled, read only copy of the ROA white-list entries
+ * of the prefix cache. The entries of each address family are kept in one
+ * array, sorted by prefix length and prefix. Each prefix length that is used
+ * by at least one entry forms a level. A lookup masks the requested prefix
+ * once per level and performs a binary search within the level.
+ *
+ * A table is filled once with addROATableEntry, finished with
+ * finishROATable and not modified afterwards. This allows any number of
+ * threads to perform lookups without any locking.
+ *
+ * @version 0.6.2.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Code created.
+ */
+#ifndef __ROA_TABLE_H__
+#define __ROA_TABLE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "shared/srx_defs.h"
+#include "util/prefix.h"
+
+/** A single ROA white-list entry */
+typedef struct {
+  /** The upper 64 bit of the prefix in host byte order (IPv4 uses the upper
+   * 32 bit of it) */
+  uint64_t hi;
+  /** The lower 64 bit of the prefix in host byte order (IPv6 only) */
+  uint64_t lo;
+  /** The origin AS */
+  uint32_t asn;
+  /** The prefix length */
+  uint8_t  length;
+  /** The max length */
+  uint8_t  maxLen;
+} ROA_TableEntry;
+
+/** All entries of one prefix length */
+typedef struct {
+  /** The prefix length of the entries */
+  uint8_t  length;
+  /** The position of the first entry of the level */
+  uint32_t first;
+  /** The number of entries of this level */
+  uint32_t count;
+} ROA_TableLevel;
+
+/** The entries of one address family */
+typedef struct {
+  /** The entries, sorted by length, prefix, and AS */
+  ROA_TableEntry* entries;
+  /** The number of entries */
+  uint32_t        count;
+  /** The allocated number of entries */
+  uint32_t        size;
+  /** The levels in ascending order of the prefix length */
+  ROA_TableLevel  levels[MAX_PREFIX_LEN_v6 + 1];
+  /** The number of levels */
+  uint8_t         numLevels;
+} ROA_TableAFI;
+
+/** The ROA table */
+typedef struct {
+  /** [0] contains the IPv4 entries, [1] the IPv6 entries */
+  ROA_TableAFI afi[2];
+  /** The version of the ROA white-list the table was compiled from */
+  uint32_t     version;
+} ROA_Table;
+
+/**
+ * Create a new and empty ROA table.
+ *
+ * @return The table or NULL if not enough memory is available.
+ */
+ROA_Table* newROATable();
+
+/**
+ * Free the table and all its entries.
+ *
+ * @param self The table, can be NULL.
+ */
+void freeROATable(ROA_Table* self);
+
+/**
+ * Add the ROA white-list entry to the table. Can only be called before
+ * finishROATable.
+ *
+ * @param self The table.
+ * @param prefix The prefix of the ROA white-list entry.
+ * @param maxLen The max length of the ROA white-list entry.
+ * @param asn The origin AS of the ROA white-list entry.
+ *
+ * @return false if not enough memory is available.
+ */
+bool addROATableEntry(ROA_Table* self, IPPrefix* prefix, uint8_t maxLen,
+                      uint32_t asn);
+
+/**
+ * Sort the entries, remove duplicates and build the levels. Afterwards the
+ * table MUST NOT be modified anymore.
+ *
+ * @param self The table.
+ */
+void finishROATable(ROA_Table* self);
+
+/**
+ * Return the number of entries of the given IP version.
+ *
+ * @param self The table.
+ * @param version The IP version (4 or 6).
+ *
+ * @return The number of entries.
+ */
+uint32_t getROATableSize(ROA_Table* self, uint8_t version);
+
+/**
+ * Determine the origin validation result of the given prefix and origin.
+ *
+ * @param self The finished table.
+ * @param prefix The prefix of the update.
+ * @param asn The origin AS of the update.
+ *
+ * @return SRx_RESULT_VALID, SRx_RESULT_INVALID, or SRx_RESULT_NOTFOUND
+ */
+SRxValidationResultVal lookupROATable(ROA_Table* self, IPPrefix* prefix,
+                                      uint32_t asn);
+
+#endif // !__ROA_TABLE_H__
@@ -22,10 +22,26 @@
  *
  * This handler processes ROA validation
  *
- * @version 0.6.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * handleEndOfData compiles the ROA table of the prefix cache.
+ *            * handleEndOfData applies the ROA results the prefix cache 
+ *              deferred during the synchronization.
+ *            * handleReset and handleConnection store the deferred ROA
+ *              results of an interrupted synchronization.
+ *            * The RPKI queue batches use the update data within a read 
+ *              section of the update cache and skip reclaimed updates.
+ *            * handleEndOfData publishes the ASPA DB and re-validates only the
+ *              AS paths that contain a customer ASN whose ASPA object changed.
+ *            * handleEndOfData takes the RPKI queue elements in batches.
+ *            * The RPKI queue is drained by the RPKI handler thread together
+ *              with up to MAX_EOD_THREADS - 1 worker threads. The results of a
+ *              batch are handed to the result changed callback together.
+ *            * The BGPsec paths of a batch are validated together using
+ *              validateSignatures.
  * 0.6.0.0  - 2021/03/30 - oborchert
  *            * Added missing version control. Also moved modifications labeled 
  *              as version 0.5.2.0 to 0.6.0.0 (0.5.2.0 was skipped)
@@ -74,6 +90,7 @@
  * -----------------------------------------------------------------------------
  */
 
+#include <unistd.h>
 #include <srx/srxcryptoapi.h>
 #include "server/main.h"
 #include "server/rpki_handler.h"
@@ -96,6 +113,39 @@
 
 #define HDR "([0x%08X] RPKI Handler): "
 
+/** Number of RPKI queue elements taken at once during the end of data */
+#define RQ_BATCH_SIZE   256
+/** Maximum number of threads processing the RPKI queue, including the RPKI
+ * handler thread itself. */
+#define MAX_EOD_THREADS 8
+
+/**
+ * The worker threads that help the RPKI handler thread draining the RPKI queue
+ * during the end of data processing.
+ *
+ * @since 0.6.2.0
+ */
+typedef struct {
+  /** The handler the workers belong to */
+  RPKIHandler* handler;
+  /** The worker threads */
+  pthread_t    threads[MAX_EOD_THREADS];
+  /** The number of worker threads */
+  int          numThreads;
+  /** Protects the remaining members */
+  Mutex        mutex;
+  /** Signals the start of a round or the stop of the workers */
+  Cond         startCond;
+  /** Signals that the last worker finished the round */
+  Cond         doneCond;
+  /** Incremented with each end of data that uses the workers */
+  uint32_t     round;
+  /** The number of workers still processing the current round */
+  int          active;
+  /** Tells the workers to terminate */
+  bool         stop;
+} EodWorkers;
+
 ////////////////////////////////////////////////////////////////////////////////
 // forward declaration
 ////////////////////////////////////////////////////////////////////////////////
@@ -114,6 +164,9 @@ static void handleEndOfData (uint32_t valCacheID, uint16_t session_id,
 int handleAspaPdu(void* rpkiHandler, uint32_t customerAsn, 
                     uint16_t providerAsCount, uint32_t* providerAsns, 
                     uint8_t addrFamilyType, uint8_t announce);
+static void _processRPKIQueue(RPKIHandler* handler);
+static EodWorkers* _startEodWorkers(RPKIHandler* handler);
+static void _stopEodWorkers(EodWorkers* workers);
 
 /**
  * Configure the RPKI Handler and create an RPKIRouter client.
@@ -150,9 +203,14 @@ bool createRPKIHandler (RPKIHandler* handler, PrefixCache* prefixCache,
   handler->rrclParams.serverPort         = serverPort;
   handler->rrclParams.version            = rpki_version;
 
+  // If not available the RPKI handler thread processes the queue alone.
+  handler->eodWorkers = _startEodWorkers(handler);
+
   if (!createRPKIRouterClient(&handler->rrclInstance, &handler->rrclParams,
                                handler))
   {
+    _stopEodWorkers((EodWorkers*)handler->eodWorkers);
+    handler->eodWorkers = NULL;
     return false;
   }
 
@@ -169,6 +227,144 @@ void releaseRPKIHandler(RPKIHandler* handler)
   if (handler != NULL)
   {
     releaseRPKIRouterClient(&handler->rrclInstance);
+    _stopEodWorkers((EodWorkers*)handler->eodWorkers);
+    handler->eodWorkers = NULL;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// End of data worker threads
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The loop of a worker thread. Each round the worker drains the RPKI queue 
+ * together with the RPKI handler thread.
+ *
+ * @param data The EodWorkers instance.
+ *
+ * @return NULL
+ *
+ * @since 0.6.2.0
+ */
+static void* _eodWorkerLoop(void* data)
+{
+  EodWorkers* workers = (EodWorkers*)data;
+  uint32_t    round   = 0;
+
+  // Rounds started before this thread got here are also processed.
+  lockMutex(&workers->mutex);
+  while (!workers->stop)
+  {
+    if (round == workers->round)
+    {
+      pthread_cond_wait(&workers->startCond, &workers->mutex);
+      continue;
+    }
+    round = workers->round;
+    unlockMutex(&workers->mutex);
+
+    _processRPKIQueue(workers->handler);
+
+    lockMutex(&workers->mutex);
+    if (--workers->active == 0)
+    {
+      pthread_cond_signal(&workers->doneCond);
+    }
+  }
+  unlockMutex(&workers->mutex);
+
+  return NULL;
+}
+
+/**
+ * Start the worker threads, one less than the number of CPUs but at most 
+ * MAX_EOD_THREADS - 1.
+ *
+ * @param handler The RPKI handler
+ *
+ * @return The workers or NULL if no worker thread is used.
+ *
+ * @since 0.6.2.0
+ */
+static EodWorkers* _startEodWorkers(RPKIHandler* handler)
+{
+  long        numCPU  = sysconf(_SC_NPROCESSORS_ONLN);
+  EodWorkers* workers = NULL;
+  int         idx;
+
+  if (numCPU > MAX_EOD_THREADS)
+  {
+    numCPU = MAX_EOD_THREADS;
+  }
+  if (numCPU < 2)
+  {
+    return NULL;
+  }
+
+  workers = calloc(1, sizeof(EodWorkers));
+  if (workers == NULL)
+  {
+    RAISE_ERROR("Not enough memory for the end of data worker threads");
+    return NULL;
+  }
+  workers->handler = handler;
+  initMutex(&workers->mutex);
+  initCond(&workers->startCond);
+  initCond(&workers->doneCond);
+
+  for (idx = 0; idx < numCPU - 1; idx++)
+  {
+    if (pthread_create(&workers->threads[idx], NULL, _eodWorkerLoop, 
+                       workers) != 0)
+    {
+      RAISE_ERROR("Failed to start an end of data worker thread - continuing "
+                  "with %d worker threads", workers->numThreads);
+      break;
+    }
+    workers->numThreads++;
+  }
+
+  if (workers->numThreads == 0)
+  {
+    _stopEodWorkers(workers);
+    workers = NULL;
+  }
+  else
+  {
+    LOG(LEVEL_DEBUG, HDR "Started %d end of data worker thread(s)", 
+                     pthread_self(), workers->numThreads);
+  }
+
+  return workers;
+}
+
+/**
+ * Stop the worker threads and release the workers instance.
+ *
+ * @param workers The workers, can be NULL.
+ *
+ * @since 0.6.2.0
+ */
+static void _stopEodWorkers(EodWorkers* workers)
+{
+  int idx;
+
+  if (workers != NULL)
+  {
+    lockMutex(&workers->mutex);
+    workers->stop = true;
+    pthread_cond_broadcast(&workers->startCond);
+    unlockMutex(&workers->mutex);
+
+    for (idx = 0; idx < workers->numThreads; idx++)
+    {
+      pthread_join(workers->threads[idx], NULL);
+    }
+
+    destroyCond(&workers->startCond);
+    destroyCond(&workers->doneCond);
+    releaseMutex(&workers->mutex);
+    free(workers);
   }
 }
 
@@ -227,9 +423,11 @@ static void handleReset (uint32_t valCacheID, void* rpkiHandler)
 {
   LOG(LEVEL_DEBUG, HDR "Prefix: Reset", pthread_self());
   RPKIHandler* handler = (RPKIHandler*)rpkiHandler;
+  // The synchronization before the reset does not end with an end of data,
+  // store the ROA results deferred so far.
+  flushDeferredResults(handler->prefixCache);
   RAISE_ERROR("Handle Reset not implemented yet! - doDo: remove or flag all "
               "ROAS from the given validation Cache");
-  handler = NULL; // just to suppress the compiler warning. Must be removed later
   // @TODO: Remove or flag all ROAS from the given validation Cache
   // It makes sense to flag all ROAS from the given validation cache. Then 
   // request a refresh and for each ROA that is received, remove the flag. Once
@@ -252,96 +450,210 @@ static void handleEndOfData (uint32_t valCacheID, uint16_t session_id,
 {
   RPKIHandler*     handler = (RPKIHandler*)rpkiHandler;
   RPKI_QUEUE*      rQueue = getRPKIQueue();
-  RPKI_QUEUE_ELEM  queueElem;
-  SRxResult        srxRes;
-  SRxDefaultResult defaultRes;
-  
-  SRxValidationResult valRes;
-
   UpdateCache*     uCache = handler->prefixCache->updateCache;
-  SRxUpdateID*     uID = NULL;
+  EodWorkers*      workers = (EodWorkers*)handler->eodWorkers;
+
+  uint32_t*        changedAsns  = NULL;
+  uint32_t         changedCount = 0;
+  uint32_t*        pathIds      = NULL;
+  uint32_t         pathCount    = 0;
+  uint32_t         idx          = 0;
+  time_t           now          = time(NULL);
     
   LOG(LEVEL_INFO, "Received an end of data, process RPKI Queue:\n");
 
-  process_ASPA_EndOfData(uCache, handler->aspaDBManager->cbProcessEndOfData, handler);
+  // The ROA white-list is complete, provide it for lock free origin 
+  // validation.
+  compileROATable(handler->prefixCache);
 
-  while (rq_dequeue(rQueue, &queueElem))
+  // Store the final ROA result of each update that changed during the 
+  // synchronization, this queues each changed update only once.
+  applyDeferredResults(handler->prefixCache);
+
+  // Make the ASPA objects received since the last end of data visible to the
+  // validation.
+  publishAspaDB(handler->aspaDBManager, &changedAsns, &changedCount);
+
+  // Re-validate only the AS paths that contain a customer ASN whose ASPA 
+  // object changed.
+  if (changedCount > 0)
   {
-    uID = &queueElem.updateID;
-    valRes.updateID = queueElem.updateID;
-    valRes.valType  = VRT_NONE;
-    valRes.valResult.roaResult    = SRx_RESULT_DONOTUSE;
-    valRes.valResult.bgpsecResult = SRx_RESULT_DONOTUSE;
-    valRes.valResult.aspaResult   = SRx_RESULT_DONOTUSE;
-    
-    if ((queueElem.reason & RQ_ROA) == RQ_ROA)
+    pathCount = getAspathIdsOfAsns(handler->aspathCache, changedAsns, 
+                                   changedCount, &pathIds);
+    LOG(LEVEL_DEBUG, "%u ASPA object(s) changed, re-validate %u AS path(s)",
+                     changedCount, pathCount);
+    for (idx = 0; idx < pathCount; idx++)
     {
-      if (getUpdateResult(uCache, uID, 0, NULL, &srxRes, &defaultRes, NULL))
-      {
-        valRes.valType |= VRT_ROA;
-        valRes.valResult.roaResult = srxRes.roaResult;
-      }
-      else
-      {
-        LOG(LEVEL_WARNING, "Update 0x%08X not found during de-queuing of RPKI "
-                           "QUEUE!", queueElem.updateID);
-      }
+      handler->aspaDBManager->cbProcessEndOfData(uCache, handler, pathIds[idx],
+                                                 now);
     }
-    // Now check for BGPSEC path Validation
-    if ((queueElem.reason & RQ_KEY) == RQ_KEY)
+    free(pathIds);
+    free(changedAsns);
+  }
+
+  if (uCache->resChangedCallback == NULL)
+  {
+    RAISE_ERROR("No resChangedCallback function registered!\n"
+                "Cannot propagate the changes of the validation result!\n"
+                "Abort operation!");
+    rq_empty(rQueue);
+    return;
+  }
+
+  // Only use the worker threads if more than a single batch is queued.
+  if ((workers != NULL) && (rq_size(rQueue) > RQ_BATCH_SIZE))
+  {
+    lockMutex(&workers->mutex);
+    workers->active = workers->numThreads;
+    workers->round++;
+    pthread_cond_broadcast(&workers->startCond);
+    unlockMutex(&workers->mutex);
+
+    _processRPKIQueue(handler);
+
+    lockMutex(&workers->mutex);
+    while (workers->active > 0)
     {
-      UC_UpdateData* updateData = getUpdateData(uCache, uID);
-      SCA_BGP_PathAttribute* bgpsec_path = updateData->bgpsec_path;
-      if (bgpsec_path != NULL)
+      pthread_cond_wait(&workers->doneCond, &workers->mutex);
+    }
+    unlockMutex(&workers->mutex);
+  }
+  else
+  {
+    _processRPKIQueue(handler);
+  }
+}
+
+/**
+ * Drain the RPKI queue. The elements are taken in batches, the validation 
+ * results of a batch are determined first and then handed to the result 
+ * changed callback together. Multiple threads can process the queue at the 
+ * same time.
+ *
+ * @param handler The RPKI handler
+ *
+ * @since 0.6.2.0
+ */
+static void _processRPKIQueue(RPKIHandler* handler)
+{
+  RPKI_QUEUE*      rQueue = getRPKIQueue();
+  RPKI_QUEUE_ELEM  queueElems[RQ_BATCH_SIZE];
+  SRxValidationResult valResults[RQ_BATCH_SIZE];
+  UC_UpdateData*   bgpsecUpdates[RQ_BATCH_SIZE];
+  uint8_t          bgpsecResults[RQ_BATCH_SIZE];
+  int              bgpsecPos[RQ_BATCH_SIZE];
+  int              bgpsecCount = 0;
+  SRxValidationResult* valRes = NULL;
+  RPKI_QUEUE_ELEM* queueElem = NULL;
+  SRxResult        srxRes;
+  SRxDefaultResult defaultRes;
+  UpdateCache*     uCache = handler->prefixCache->updateCache;
+  SRxUpdateID*     uID = NULL;
+  BGPSecHandler*   bgpsecHandler = NULL;
+  int              count = 0;
+  int              pos   = 0;
+
+  // Take the elements in batches, this keeps the queue unlocked while the 
+  // results are processed.
+  while ((count = rq_dequeueBatch(rQueue, queueElems, RQ_BATCH_SIZE)) > 0)
+  {
+    // The update data of the batch is used until the batch is validated, 
+    // keep the garbage collector from releasing it.
+    enterUpdateCacheReader(uCache);
+    bgpsecCount = 0;
+    for (pos = 0; pos < count; pos++)
+    {
+      queueElem = &queueElems[pos];
+      valRes    = &valResults[pos];
+      uID = &queueElem->updateID;
+      valRes->updateID = queueElem->updateID;
+      valRes->valType  = VRT_NONE;
+      valRes->valResult.roaResult    = SRx_RESULT_DONOTUSE;
+      valRes->valResult.bgpsecResult = SRx_RESULT_DONOTUSE;
+      valRes->valResult.aspaResult   = SRx_RESULT_DONOTUSE;
+    
+      if ((queueElem->reason & RQ_ROA) == RQ_ROA)
       {
-        BGPSecHandler* bgpsecHandler = getBGPsecHandler();
-        if (bgpsecHandler != NULL)
+        if (getUpdateResult(uCache, uID, 0, NULL, &srxRes, &defaultRes, NULL))
         {
-          valRes.valType |= VRT_BGPSEC;
-          valRes.valResult.bgpsecResult = validateSignature(bgpsecHandler, 
-                                                            updateData);
+          valRes->valType |= VRT_ROA;
+          valRes->valResult.roaResult = srxRes.roaResult;
         }
         else
         {
-          RAISE_ERROR("BGPSecHAndler could not be retrieved!!");
+          LOG(LEVEL_WARNING, "Update 0x%08X not found during de-queuing of "
+                             "RPKI QUEUE!", queueElem->updateID);
         }
       }
-      else
+      // Now check for BGPSEC path Validation
+      if ((queueElem->reason & RQ_KEY) == RQ_KEY)
       {
-        LOG(LEVEL_ERROR, "Update 0x%08X is registered for BGPsec but the "
-                         "BGPsec_PATH attribute is not stored!", *uID);
+        UC_UpdateData* updateData = getUpdateData(uCache, uID);
+        SCA_BGP_PathAttribute* bgpsec_path = NULL;
+        if (updateData == NULL)
+        {
+          // The garbage collector removed the update meanwhile.
+          LOG(LEVEL_WARNING, "Update 0x%08X not found during de-queuing of "
+                             "RPKI QUEUE!", queueElem->updateID);
+        }
+        else if ((bgpsec_path = updateData->bgpsec_path) != NULL)
+        {
+          bgpsecHandler = getBGPsecHandler();
+          if (bgpsecHandler != NULL)
+          {
+            // The paths of the batch are validated together further below.
+            valRes->valType |= VRT_BGPSEC;
+            bgpsecUpdates[bgpsecCount] = updateData;
+            bgpsecPos[bgpsecCount++]   = pos;
+          }
+          else
+          {
+            RAISE_ERROR("BGPSecHAndler could not be retrieved!!");
+          }
+        }
+        else
+        {
+          LOG(LEVEL_ERROR, "Update 0x%08X is registered for BGPsec but the "
+                           "BGPsec_PATH attribute is not stored!", *uID);
+        }
       }
-    }
     
-    // Here check for ASPA Validation which was registered 
-    if ((queueElem.reason & RQ_ASPA) == RQ_ASPA)
-    {
-      LOG(LEVEL_INFO, FILE_LINE_INFO " called for ASPA dequeue [uID: %08X] ", *uID);
-      uint32_t pathId= 0;
-      if (getUpdateResult(uCache, uID, 0, NULL, &srxRes, &defaultRes, &pathId))
+      // Here check for ASPA Validation which was registered 
+      if ((queueElem->reason & RQ_ASPA) == RQ_ASPA)
       {
-        valRes.valType |= VRT_ASPA;
-        valRes.valResult.aspaResult = srxRes.aspaResult;
-      }
-      else
-      {
-        LOG(LEVEL_WARNING, "Update 0x%08X not found during de-queuing of RPKI "
-            "QUEUE!", queueElem.updateID);
+        LOG(LEVEL_INFO, FILE_LINE_INFO " called for ASPA dequeue [uID: %08X] ", 
+                        *uID);
+        uint32_t pathId= 0;
+        if (getUpdateResult(uCache, uID, 0, NULL, &srxRes, &defaultRes, 
+                            &pathId))
+        {
+          valRes->valType |= VRT_ASPA;
+          valRes->valResult.aspaResult = srxRes.aspaResult;
+        }
+        else
+        {
+          LOG(LEVEL_WARNING, "Update 0x%08X not found during de-queuing of "
+                             "RPKI QUEUE!", queueElem->updateID);
+        }
       }
     }
-    
-    if (uCache->resChangedCallback != NULL)
+
+    if (bgpsecCount > 0)
     {
-      // Notify of the change of validation result. (call handleUpdateResultChange)
-      uCache->resChangedCallback(&valRes);     
+      validateSignatures(bgpsecHandler, bgpsecCount, bgpsecUpdates, 
+                         bgpsecResults);
+      for (pos = 0; pos < bgpsecCount; pos++)
+      {
+        valResults[bgpsecPos[pos]].valResult.bgpsecResult = bgpsecResults[pos];
+      }
     }
-    else
+    leaveUpdateCacheReader(uCache);
+
+    // Notify of the change of validation results of the whole batch. 
+    // (call handleUpdateResultChange)
+    for (pos = 0; pos < count; pos++)
     {
-      RAISE_ERROR("No resChangedCallback function registered!\n"
-                  "Cannot propagate the changes of the validation result!\n"
-                  "Abort operation!");
-      rq_empty(rQueue);
-      break;
+      uCache->resChangedCallback(&valResults[pos]);
     }
   }
 }
@@ -369,8 +681,13 @@ static bool handleError (uint16_t errNo, const char* msg, void* user)
  */
 static int handleConnection (void* user)
 {
+  RPKIHandler* handler = (RPKIHandler*)user;
+
   LOG(LEVEL_INFO, "Connection to RPKI/Router protocol server lost "
                   "- reconnecting after %dsec", RECONNECT_DELAY);
+  // No end of data will be received for an interrupted synchronization, store 
+  // the ROA results deferred so far.
+  flushDeferredResults(handler->prefixCache);
   return RECONNECT_DELAY;
 }
 
@@ -519,29 +836,33 @@ int handleAspaPdu(void* rpkiHandler, uint32_t customerAsn,
     return retVal;
   }
 
-  TrieNode *node = NULL;
   ASPA_Object *aspaObj = NULL;
   aspaObj = newASPAObject(customerAsn, providerAsCount, providerAsns, afi);
 
-  char strWord[6];
-  sprintf(strWord, "%d", customerAsn);
-  
-
   if (announce == 1) // 1 == announce, 0 == withdraw
   {
-    LOG(LEVEL_INFO, "[Announce] ASPA object, search key in DB: %s", strWord);
-    node = insertAspaObj(aspaDBManager, strWord, strWord, aspaObj);
-    if (node)
+    LOG(LEVEL_INFO, "[Announce] ASPA object, search key in DB: %u", customerAsn);
+    if (insertAspaObj(aspaDBManager, aspaObj))
     {
       retVal = 1; // success
     }
+    else
+    {
+      LOG(LEVEL_WARNING, "[Announce] Failed to store the ASPA object");
+      if (aspaObj->providerAsns)
+      {
+        free(aspaObj->providerAsns);
+      }
+      free (aspaObj);
+      aspaObj = NULL;
+    }
   }
   else if (announce == 0) // withdraw
   {
     // XXX: Draft didn't mention about withdraw clearly
   //
-    LOG(LEVEL_INFO, "[Withdraw] ASPA object, search key in DB: %s", strWord);
-    bool resWithdraw = delete_TrieNode_AspaObj (aspaDBManager, strWord, aspaObj);
+    LOG(LEVEL_INFO, "[Withdraw] ASPA object, search key in DB: %u", customerAsn);
+    bool resWithdraw = delete_TrieNode_AspaObj (aspaDBManager, aspaObj);
 
     if (resWithdraw)
     {
@@ -20,10 +20,13 @@
  * other licenses. Please refer to the licenses of all libraries required
  * by this software.
  *
- * @version 0.5.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Added eodWorkers, the threads helping to drain the RPKI queue
+ *              during the end of data processing.
  * 0.5.0.0  - 2017/07/09 - oborchert
  *            * Removed define PUB_KEY_OCTET and replaced it with define 
  *              ECDSA_PUB_KEY_DER_LENGTH from srxcryptoapi.h
@@ -59,6 +62,7 @@ typedef struct {
   RPKIRouterClient        rrclInstance;
   ASPA_DBManager*         aspaDBManager;
   AspathCache*            aspathCache;
+  void*                   eodWorkers;   // Threads draining the RPKI queue
 } RPKIHandler;
 
 /**
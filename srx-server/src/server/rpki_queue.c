@@ -20,18 +20,30 @@
  * by this software.
  *
  *  
- * This file implements the RPKI Queue, a thread safe queue with semaphore
- * controlled single access.
+ * This file implements the RPKI Queue, a thread safe queue that holds each
+ * update ID only once.
+ *
+ * The queue consists of a FIFO ring of update IDs and an open addressing hash
+ * set (linear probing) that maps each queued update ID to its reasons. Adding
+ * an update ID and removing the next one are O(1), adding an update ID that
+ * is already queued only merges the reasons. Both structures grow together,
+ * the hash set is kept at most half full.
  *
  * NOTE:
  * Functions starting with underscore are only to be called from within this
  * file. Therefore no additional checking is needed is some provided values
  * are NULL. entry functions specified in the header file do take cate of that.
  * 
- * @version 0.5.0.1
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Replaced the linked list which was scanned on each insert with
+ *              a FIFO ring and a hash set.
+ *            * Reasons of the same update are merged bit wise.
+ *            * Replaced the semaphore with a mutex.
+ *            * Added rq_dequeueBatch.
  * 0.5.0.1  - 2017/08/25 - oborchert
  *            * BZ1224: Function __rq_createQueueElem did not return the 
  *              generated object. (fixed)
@@ -40,33 +52,42 @@
  */
 #include <malloc.h>
 #include <string.h>
-#include <semaphore.h>
 #include "srx/srxcryptoapi.h"
 #include "server/rpki_queue.h"
 #include "shared/srx_identifier.h"
 #include "util/log.h"
+#include "util/mutex.h"
+
+/** The initial capacity of the queue, MUST be a power of 2 */
+#define RQ_INITIAL_CAPACITY 1024
 
-/** The Queue element */
-typedef struct _rpki_queue_list_elem {
-  /** Pointer to the next element */
-  struct _rpki_queue_list_elem* next;
-  /** The element to be queued. */
-  RPKI_QUEUE_ELEM elem;
-} _RPKI_QUEUE_LIST_ELEM;
+/** An entry of the hash set. */
+typedef struct {
+  /** The ID of the queued update */
+  SRxUpdateID updateID;
+  /** The reasons, 0 if the entry is unused. */
+  uint8_t     reason;
+} _RPKI_QUEUE_SLOT;
 
 /** The RPKI queue - This queue will have each element only once. Each new 
  * element will be added to the tail end - if not in the queue already. */
 typedef struct {
-  /** The queues head element */
-  _RPKI_QUEUE_LIST_ELEM* head;
+  /** The update IDs in the order they were queued (ring buffer) */
+  SRxUpdateID*      fifo;
+  /** The position of the next update ID to be de-queued */
+  uint32_t          head;
+  /** The number of update IDs the queue can hold (power of 2) */
+  uint32_t          capacity;
+  /** The hash set, twice the size of the capacity */
+  _RPKI_QUEUE_SLOT* slots;
   /** Count the number of elements in the queue. */
-  u_int32_t size;
+  uint32_t          size;
   /** For thread safety */
-  sem_t semaphore;
+  Mutex             mutex;
 } _RPKI_QUEUE;
 
 /**
- * Set the Semaphore lock
+ * Lock the queue
  * 
  * @param rQueue the queue whose access is locked.
  * 
@@ -76,63 +97,136 @@ static bool _rq_lock(_RPKI_QUEUE* rQueue)
 {
   if (rQueue != NULL)
   {
-    // Maybe use the sem_wait_wrapper which expires after some time
-    sem_wait(&rQueue->semaphore);
-    // or sem_timedwait(...)
+    lockMutex(&rQueue->mutex);
   }
   
   return rQueue != NULL;
 }
 
 /**
- * Set the Semaphore lock
+ * Unlock the queue
  * 
  * @param rQueue the queue whose access will be unlocked.
- * 
- * @return false if an error occurred
  */
-static bool _rq_unlock(_RPKI_QUEUE* rQueue)
+static void _rq_unlock(_RPKI_QUEUE* rQueue)
 {
-  bool retVal = false;
-  
   // The caller assures that rQueue is not NULL  
-  int lockVal;
-  sem_getvalue(&rQueue->semaphore, &lockVal);
-  // This checks the binary semaphore (0|1)
-  if (lockVal == 0)
+  unlockMutex(&rQueue->mutex);
+}
+
+/**
+ * Return the home position of the update ID in a hash set of the given size.
+ *
+ * @param updateID The update ID
+ * @param mask The number of slots of the hash set minus one.
+ *
+ * @return The home position.
+ */
+static inline uint32_t _rq_hash(SRxUpdateID* updateID, uint32_t mask)
+{
+  uint32_t hash = *updateID * 0x9E3779B1;
+  return (hash ^ (hash >> 16)) & mask;
+}
+
+/**
+ * Return the slot of the update ID or the unused slot where it would be stored.
+ *
+ * @param slots The hash set
+ * @param mask The number of slots minus one
+ * @param updateID The update ID
+ *
+ * @return The slot.
+ */
+static _RPKI_QUEUE_SLOT* _rq_findSlot(_RPKI_QUEUE_SLOT* slots, uint32_t mask,
+                                      SRxUpdateID* updateID)
+{
+  uint32_t pos = _rq_hash(updateID, mask);
+
+  while (slots[pos].reason != 0
+         && compareSrxUpdateID(&slots[pos].updateID, updateID, SRX_UID_BOTH)
+            != 0)
   {
-    // Maybe use the sem_wait_wrapper which expires after some time
-    sem_post(&rQueue->semaphore);
-    retVal = true;
+    pos = (pos + 1) & mask;
   }
-  else 
+
+  return &slots[pos];
+}
+
+/**
+ * Remove the slot from the hash set. Following entries are shifted back so
+ * that no lookup is interrupted by the now unused slot.
+ *
+ * @param rQueue The _RPKI queue.
+ * @param slot The slot to be removed.
+ */
+static void _rq_removeSlot(_RPKI_QUEUE* rQueue, _RPKI_QUEUE_SLOT* slot)
+{
+  uint32_t mask = (rQueue->capacity * 2) - 1;
+  uint32_t hole = (uint32_t)(slot - rQueue->slots);
+  uint32_t pos  = hole;
+  uint32_t home;
+
+  while (true)
   {
-    LOG(LEVEL_ERROR, "%s called without a previously aquired lock.", 
-                     __func__);
+    pos = (pos + 1) & mask;
+    if (rQueue->slots[pos].reason == 0)
+    {
+      break;
+    }
+    home = _rq_hash(&rQueue->slots[pos].updateID, mask);
+    // Move the entry only if its home position is not within (hole, pos]
+    if ((hole <= pos) ? ((hole < home) && (home <= pos))
+                      : ((hole < home) || (home <= pos)))
+    {
+      continue;
+    }
+    rQueue->slots[hole] = rQueue->slots[pos];
+    hole = pos;
   }
-  
-  return retVal;
+  rQueue->slots[hole].reason = 0;
 }
 
 /**
- * Create a list element
- * 
- * @param reason The reason information
- * @param updateID The SRx Update ID
- * 
- * @return The instance of the element
+ * Allocate the ring and the hash set with the given capacity and move the 
+ * queued elements into them.
+ *
+ * @param rQueue The _RPKI queue.
+ * @param capacity The new capacity, a power of 2 not smaller than the size.
+ *
+ * @return false if not enough memory is available, the queue is unchanged.
  */
-static _RPKI_QUEUE_LIST_ELEM* __rq_createQueueElem(e_RPKI_QUEUE_REASON reason, 
-                                                   SRxUpdateID* updateID)
+static bool _rq_resize(_RPKI_QUEUE* rQueue, uint32_t capacity)
 {
-  _RPKI_QUEUE_LIST_ELEM* listElem = malloc(sizeof(_RPKI_QUEUE_LIST_ELEM));
-  memset (listElem, 0, sizeof(_RPKI_QUEUE_LIST_ELEM));
-  
-  listElem->elem.reason   = reason;
-  memcpy(&listElem->elem.updateID, updateID, LEN_SRxUpdateID);
-  listElem->next = NULL;
-  
-  return listElem;
+  SRxUpdateID*      fifo  = malloc(capacity * sizeof(SRxUpdateID));
+  _RPKI_QUEUE_SLOT* slots = calloc(capacity * 2, sizeof(_RPKI_QUEUE_SLOT));
+  _RPKI_QUEUE_SLOT* slot  = NULL;
+  uint32_t          idx;
+
+  if (fifo == NULL || slots == NULL)
+  {
+    free(fifo);
+    free(slots);
+    RAISE_ERROR("Not enough memory to resize the RPKI Queue to %u elements.",
+                capacity);
+    return false;
+  }
+
+  for (idx = 0; idx < rQueue->size; idx++)
+  {
+    fifo[idx] = rQueue->fifo[(rQueue->head + idx) & (rQueue->capacity - 1)];
+    slot  = _rq_findSlot(slots, (capacity * 2) - 1, &fifo[idx]);
+    *slot = *_rq_findSlot(rQueue->slots, (rQueue->capacity * 2) - 1, 
+                          &fifo[idx]);
+  }
+
+  free(rQueue->fifo);
+  free(rQueue->slots);
+  rQueue->fifo     = fifo;
+  rQueue->slots    = slots;
+  rQueue->capacity = capacity;
+  rQueue->head     = 0;
+
+  return true;
 }
 
 /**
@@ -141,7 +235,7 @@ static _RPKI_QUEUE_LIST_ELEM* __rq_createQueueElem(e_RPKI_QUEUE_REASON reason,
  * If no element resides in the queue, the given element will NOT be touched and
  * the call returns 'false'
  * 
- * THIS FUNCTION DOES NOT USE SEMAPHORE - USED BY rq_dequeue and rq_empty
+ * THIS FUNCTION DOES NOT LOCK - USED BY rq_dequeue and rq_dequeueBatch
  * 
  * @param rQueue The _RPKI queue.
  * @param elem The element to be filled with the next element.
@@ -154,24 +248,29 @@ static _RPKI_QUEUE_LIST_ELEM* __rq_createQueueElem(e_RPKI_QUEUE_REASON reason,
 static bool _rq_dequeue(_RPKI_QUEUE* rQueue, RPKI_QUEUE_ELEM* elem)
 {
   bool retVal = false;
+  _RPKI_QUEUE_SLOT* slot = NULL;
   
   // The caller assures that rQueue is not NULL
   
-  int size = sizeof(RPKI_QUEUE_ELEM);
   if (rQueue->size != 0)
   {
-    // remove the list element from the top of the queue
-    _RPKI_QUEUE_LIST_ELEM* listElem = rQueue->head;
-    rQueue->head = listElem->next;
-    rQueue->size--;
+    // remove the update ID from the top of the queue
+    elem->updateID = rQueue->fifo[rQueue->head];
+    rQueue->head   = (rQueue->head + 1) & (rQueue->capacity - 1);
+    __atomic_store_n(&rQueue->size, rQueue->size - 1, __ATOMIC_RELAXED);
 
-    // copy the queue element into the return value
-    memcpy(elem, &listElem->elem, size);
+    // and its reasons from the hash set
+    slot = _rq_findSlot(rQueue->slots, (rQueue->capacity * 2) - 1, 
+                        &elem->updateID);
+    elem->reason = (e_RPKI_QUEUE_REASON)slot->reason;
+    _rq_removeSlot(rQueue, slot);
     retVal = true;
 
-    // clean up the list elements
-    memset(listElem, 0, size);
-    free(listElem);
+    // Give the memory of a large burst back once the queue is drained.
+    if ((rQueue->size == 0) && (rQueue->capacity > RQ_INITIAL_CAPACITY))
+    {
+      _rq_resize(rQueue, RQ_INITIAL_CAPACITY);
+    }
   }
   
   return retVal;
@@ -193,13 +292,23 @@ RPKI_QUEUE* rq_createQueue()
   _RPKI_QUEUE* rQueue = malloc(sizeof(_RPKI_QUEUE));
   memset(rQueue, 0, sizeof(_RPKI_QUEUE));
  
-  // Initialize the Semaphore - no shared fork, value 0
-  if (sem_init(&rQueue->semaphore, 0, 1) != 0)
+  if (!initMutex(&rQueue->mutex))
   {
     free(rQueue);
-    LOG(LEVEL_ERROR, "Could not initialize the RPKI Queue Semaphore.");
+    LOG(LEVEL_ERROR, "Could not initialize the RPKI Queue Mutex.");
     rQueue=NULL;
   }
+  else
+  {
+    // capacity 1 allows to use the resize with an empty queue.
+    rQueue->capacity = 1;
+    if (!_rq_resize(rQueue, RQ_INITIAL_CAPACITY))
+    {
+      releaseMutex(&rQueue->mutex);
+      free(rQueue);
+      rQueue=NULL;
+    }
+  }
   
   return (RPKI_QUEUE*)rQueue;
 }
@@ -217,15 +326,17 @@ void rq_releaseQueue(RPKI_QUEUE* queue)
   {    
     _RPKI_QUEUE* rQueue = (_RPKI_QUEUE*)queue;
     rq_empty(rQueue);
-    sem_destroy(&rQueue->semaphore);
+    releaseMutex(&rQueue->mutex);
+    free(rQueue->fifo);
+    free(rQueue->slots);
     memset(rQueue, 0, sizeof(_RPKI_QUEUE));
     free(rQueue);    
   }
 }
 
 /** 
- * Do add the update id to the RPKI queue. The queue might combine multiple 
- * reasons of the same update into one. 
+ * Do add the update id to the RPKI queue. The queue combines multiple reasons
+ * of the same update into one (bit wise or).
  * 
  * @param queue The RPKI queue.
  * @param reason Explains what happened and might affect the update
@@ -236,56 +347,40 @@ void rq_releaseQueue(RPKI_QUEUE* queue)
 void rq_queue(RPKI_QUEUE* queue, 
               e_RPKI_QUEUE_REASON reason, SRxUpdateID* updateID)
 {
-  // Each update id is listed only once. New elements will be added to the end 
-  // of the list. While walking through the list to the end, each element will 
-  // be compared to the new element and possibly updated. 
-  // this means if none is found the end will be reached and the update will be 
-  // added.
+  // Each update id is listed only once. A queued update id only gets the 
+  // additional reason, otherwise it is added to the end of the queue.
   if (queue != NULL)
   {
-    _RPKI_QUEUE* rQueue = (RPKI_QUEUE*)queue;
+    _RPKI_QUEUE* rQueue = (_RPKI_QUEUE*)queue;
     
     if (_rq_lock(rQueue))
     {
-      _RPKI_QUEUE_LIST_ELEM* listElem = rQueue->head;
-      bool added = false;
-
-      if (listElem != NULL)
-      {    
-        while (!added)
-        {
-          if (compareSrxUpdateID(&listElem->elem.updateID, updateID, SRX_UID_BOTH) 
-              != 0)
-          {
-            // Not the same, move on
-            if (listElem->next != NULL)
-            {
-              listElem = listElem->next;
-            }
-            else
-            {
-              listElem->next = __rq_createQueueElem(reason, updateID);
-              added = true;
-              rQueue->size++;
-            }
-          }
-          else
-          {
-            // already added, maybe the reason myst be updated
-            added = true;
-            if (listElem->elem.reason != reason)
-            {
-              // Set it to both if the reason is different. If in the future more
-              // reasons are added then this needs to be modified.
-              listElem->elem.reason = RQ_ALL;
-            }
-          }
-        }
+      _RPKI_QUEUE_SLOT* slot = _rq_findSlot(rQueue->slots, 
+                                            (rQueue->capacity * 2) - 1, 
+                                            updateID);
+      if (slot->reason != 0)
+      {
+        // already added, maybe the reason must be updated
+        slot->reason |= (uint8_t)reason;
       }
       else
       {
-        rQueue->head = __rq_createQueueElem(reason, updateID);
-        rQueue->size++;
+        if (rQueue->size == rQueue->capacity)
+        {
+          // The resize moves the hash set, look up the unused slot again.
+          slot = _rq_resize(rQueue, rQueue->capacity * 2)
+                 ? _rq_findSlot(rQueue->slots, (rQueue->capacity * 2) - 1, 
+                                updateID)
+                 : NULL;
+        }
+        if (slot != NULL)
+        {
+          slot->updateID = *updateID;
+          slot->reason   = (uint8_t)reason;
+          rQueue->fifo[(rQueue->head + rQueue->size) 
+                       & (rQueue->capacity - 1)] = *updateID;
+          __atomic_store_n(&rQueue->size, rQueue->size + 1, __ATOMIC_RELAXED);
+        }
       }
 
       _rq_unlock(rQueue);
@@ -315,9 +410,9 @@ bool rq_dequeue(RPKI_QUEUE* queue, RPKI_QUEUE_ELEM* elem)
 {
   bool retVal = false;
   
-  if (queue != NULL)
+  if (queue != NULL && elem != NULL)
   {
-    _RPKI_QUEUE* rQueue = (RPKI_QUEUE*)queue;
+    _RPKI_QUEUE* rQueue = (_RPKI_QUEUE*)queue;
     if (_rq_lock(rQueue))
     {
       retVal = _rq_dequeue(rQueue, elem);      
@@ -332,6 +427,43 @@ bool rq_dequeue(RPKI_QUEUE* queue, RPKI_QUEUE_ELEM* elem)
   return retVal;
 }
 
+/**
+ * Fills the given array with up to maxElems elements from the top of the queue
+ * and removes them from the queue. The queue is locked only once per call, 
+ * therefore multiple threads can drain the queue in batches.
+ * 
+ * @param queue The RPKI queue.
+ * @param elems The array to be filled.
+ * @param maxElems The number of elements the array can hold.
+ * 
+ * @return The number of elements filled in, 0 if the queue is empty.
+ * 
+ * @since 0.6.2.0
+ */
+int rq_dequeueBatch(RPKI_QUEUE* queue, RPKI_QUEUE_ELEM* elems, int maxElems)
+{
+  int count = 0;
+  
+  if (queue != NULL && elems != NULL)
+  {
+    _RPKI_QUEUE* rQueue = (_RPKI_QUEUE*)queue;
+    if (_rq_lock(rQueue))
+    {
+      while (count < maxElems && _rq_dequeue(rQueue, &elems[count]))
+      {
+        count++;
+      }
+      _rq_unlock(rQueue);
+    }
+    else
+    {
+      LOG(LEVEL_ERROR, "Could not aquire lock for RPKI QUEUE");
+    }
+  }
+  
+  return count;
+}
+
 /**
  * Empty the RPKI queue
  * 
@@ -341,11 +473,17 @@ void rq_empty(RPKI_QUEUE* queue)
 {
   if (queue != NULL)
   {
-    _RPKI_QUEUE* rQueue = (RPKI_QUEUE*)queue;
+    _RPKI_QUEUE* rQueue = (_RPKI_QUEUE*)queue;
     if (_rq_lock(rQueue))
     {
-      RPKI_QUEUE_ELEM elem;
-      while (_rq_dequeue(rQueue, &elem)) {}
+      __atomic_store_n(&rQueue->size, 0, __ATOMIC_RELAXED);
+      rQueue->head = 0;
+      if (rQueue->capacity > RQ_INITIAL_CAPACITY)
+      {
+        _rq_resize(rQueue, RQ_INITIAL_CAPACITY);
+      }
+      memset(rQueue->slots, 0, 
+             rQueue->capacity * 2 * sizeof(_RPKI_QUEUE_SLOT));
       _rq_unlock(rQueue);    
     }
     else
@@ -372,7 +510,7 @@ int rq_size(RPKI_QUEUE* queue)
   if (queue != NULL)
   {
     _RPKI_QUEUE* rQueue = (_RPKI_QUEUE*)queue;
-    size = rQueue->size;
+    size = (int)__atomic_load_n(&rQueue->size, __ATOMIC_RELAXED);
   }
   
   return size;
@@ -23,10 +23,14 @@
  * This Header file specifies RPKI queuing structures. A queue implementation 
  * might follow later on.
  *
- * @version 0.5.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *            * Added rq_dequeueBatch.
+ *            * The reasons of an update queued multiple times are combined
+ *              bit wise.
  * 0.5.0.0 - 2017/07/08 - oborchert
  *            * Added values to enumeration e_RPKI_QUEUE_REASON to allow 
  *              bit encoding.
@@ -85,8 +89,8 @@ RPKI_QUEUE* rq_createQueue();
 void rq_releaseQueue(RPKI_QUEUE* queue);
 
 /** 
- * Do add the update id to the RPKI queue. The queue might combine multiple 
- * reasons of the same update into one. 
+ * Do add the update id to the RPKI queue. The queue combines multiple reasons
+ * of the same update into one (bit wise or).
  * 
  * @param queue The RPKI queue.
  * @param reason Explains what happened and might affect the update
@@ -112,6 +116,21 @@ void rq_queue(RPKI_QUEUE* queue,
  */
 bool rq_dequeue(RPKI_QUEUE* queue, RPKI_QUEUE_ELEM* elem);
 
+/**
+ * Fills the given array with up to maxElems elements from the top of the queue
+ * and removes them from the queue. The queue is locked only once per call, 
+ * therefore multiple threads can drain the queue in batches.
+ * 
+ * @param queue The RPKI queue.
+ * @param elems The array to be filled.
+ * @param maxElems The number of elements the array can hold.
+ * 
+ * @return The number of elements filled in, 0 if the queue is empty.
+ * 
+ * @since 0.6.2.0
+ */
+int rq_dequeueBatch(RPKI_QUEUE* queue, RPKI_QUEUE_ELEM* elems, int maxElems);
+
 /**
  * Empty the RPKI queue
  * 
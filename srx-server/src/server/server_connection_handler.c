@@ -20,10 +20,22 @@
  * other licenses. Please refer to the licenses of all libraries required
  * by this software.
  *
- * @version 0.6.1.2
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Pass the 64 bit update identifier to the collision detection
+ *              and the update cache.
+ *            * The prefix of a verify request is kept on the stack.
+ *            * Serve the proxy connections in MODE_EPOLL_CLIENTS if mode_epoll
+ *              is configured.
+ *            * Added processing of batched verify requests.
+ *            * Release the send queue of a client once it disconnects.
+ *            * PDUs of the receiver queue are handed over to the command queue
+ *              without copying them.
+ *            * Reserve the AS path of a new update with the update cache 
+ *              before the AS path cache is consulted.
  * 0.6.1.2  - 2021/11/15 - kyehwanl
  *            * Exchange the conditions to determine between sibling and lateral 
  *              peer.
@@ -116,7 +128,8 @@ typedef struct {
 SCH_ReceiverQueueElement* fetchSCHReceiverPacket(SCH_ReceiverQueue* queue);
 void stopSCHReceiverQueue(SCH_ReceiverQueue* queue);
 void _handlePacket(ServerSocket* svrSock, ServerClient* client,
-                   void* packet, PacketLength length, void* srvConHandler);
+                   void* packet, PacketLength length, void* srvConHandler,
+                   bool* owned);
 
 /**
  * Create the sender queue including the thread that manages the queue.
@@ -216,15 +229,21 @@ void* schReceiverQueueThreadLoop(void* thisQueue)
   else
   {
     SCH_ReceiverQueueElement* packet = NULL;
+    bool owned;
     LOG(LEVEL_DEBUG, "Enter loop of Server Connection Handler Receiver Queue.");
     while (queue->running)
     {
       packet = fetchSCHReceiverPacket(queue);
       if (packet != NULL)
       {
+        // The PDU might be handed over to the command queue.
+        owned = true;
         _handlePacket(packet->svrSock, packet->client, packet->pdu,
-                      packet->size, queue->svrConnHandler);
-        free(packet->pdu);
+                      packet->size, queue->svrConnHandler, &owned);
+        if (owned)
+        {
+          free(packet->pdu);
+        }
         free(packet);
       }
     }
@@ -530,6 +549,40 @@ void releaseServerConnectionHandler(ServerConnectionHandler* self)
   memset(self->proxyMap, 0, (sizeof(ProxyClientMapping)*256));
 }
 
+/**
+ * Add the PDU to the command queue. In case the caller owns the PDU it is
+ * handed over to the command queue, otherwise the command queue copies it.
+ *
+ * @param self The server connection handler.
+ * @param svrSock The server socket
+ * @param client The client instance where the packet was received on
+ * @param dataID The data ID of the command (0 or the update ID)
+ * @param length The length of the PDU
+ * @param pdu The PDU
+ * @param owned Indicates if the PDU is allocated with malloc and owned by the
+ *              caller (can be NULL). It will be set to false once the PDU is
+ *              handed over.
+ *
+ * @return true if the command could be added to the queue.
+ *
+ * @since 0.6.2.0
+ */
+static bool _queuePDU(ServerConnectionHandler* self, ServerSocket* svrSock,
+                      ServerClient* client, uint32_t dataID, uint32_t length,
+                      uint8_t* pdu, bool* owned)
+{
+  if ((owned != NULL) && *owned)
+  {
+    // The command queue frees the PDU, even if it can not be queued.
+    *owned = false;
+    return handoverCommand(self->cmdQueue, COMMAND_TYPE_SRX_PROXY, svrSock,
+                           client, dataID, length, pdu);
+  }
+
+  return queueCommand(self->cmdQueue, COMMAND_TYPE_SRX_PROXY, svrSock, client,
+                      dataID, length, pdu);
+}
+
 /**
  * This method processes the validation result request. This method is called by
  * the packet handler and if necessary the request will be added to the command
@@ -541,12 +594,15 @@ void releaseServerConnectionHandler(ServerConnectionHandler* self)
  * @param client The client instance where the packet was received on
  * @param updateCache The instance of the update cache
  * @param hdr The validation request header
+ * @param owned Indicates if the request can be handed over to the command 
+ *              queue (can be NULL), see _queuePDU.
  *
  * @return false if an internal (fatal) error occurred, otherwise true.
  */
 bool processValidationRequest(ServerConnectionHandler* self,
                               ServerSocket* svrSock, ClientThread* client,
-                              SRXRPOXY_BasicHeader_VerifyRequest* hdr)
+                              SRXRPOXY_BasicHeader_VerifyRequest* hdr,
+                              bool* owned)
 {
   LOG(LEVEL_DEBUG, HDR "Enter processValidationRequest", pthread_self());
 
@@ -574,15 +630,17 @@ bool processValidationRequest(ServerConnectionHandler* self,
                                   : DONOTUSE_REQUEST_TOKEN;
   uint32_t originAS = 0;
   SRxUpdateID collisionID = 0;
+  uint64_t    digest      = 0;
   SRxUpdateID updateID = 0;
 
   bool doStoreUpdate = false;
-  IPPrefix* prefix = NULL;
+  // The prefix is only needed while processing the request.
+  IPPrefix  reqPrefix;
+  IPPrefix* prefix = &reqPrefix;
   // Specify the client id as a receiver only when validation is requested.
   uint8_t clientID = (doOriginVal || doPathVal || doAspaVal) ? client->routerID : 0;
 
   // 1. Prepare for and generate the ID of the update
-  prefix = malloc(sizeof(IPPrefix));
   memset(prefix, 0, sizeof(IPPrefix));
   prefix->length     = hdr->prefixLen;
   BGPSecData bgpData;
@@ -645,10 +703,11 @@ bool processValidationRequest(ServerConnectionHandler* self,
 
   // 2. Generate the CRC based updateID
   updateID = generateIdentifier(originAS, prefix, &bgpData);
+  digest   = generateIdentifier64(originAS, prefix, &bgpData);
   // test for collision and attempt to resolve
   collisionID = updateID;
   while(detectCollision(self->updateCache, &updateID, prefix, originAS, 
-                        &bgpData))
+                        &bgpData, digest))
   {
     updateID++;
   }
@@ -705,6 +764,13 @@ bool processValidationRequest(ServerConnectionHandler* self,
     pathId = makePathId(bgpData.numberHops, bgpData.asPath, asType, true);
     LOG(LEVEL_INFO, FILE_LINE_INFO " generated Path ID : %08X ", pathId);
 
+    // Keep the garbage collector from removing the AS path until the update
+    // is stored.
+    if (doStoreUpdate)
+    {
+      reserveUpdatePath(self->updateCache, pathId);
+    }
+
     // to see if there is already exist or not in AS path Cache with path id
     aspl = getAspathListFromAspathCache (self->aspathCache, pathId, &srxRes_aspa);
     
@@ -787,12 +853,12 @@ bool processValidationRequest(ServerConnectionHandler* self,
 
 
     if (!storeUpdate(self->updateCache, clientID, clientMapping,
-              &updateID, prefix, originAS, &defResInfo, &bgpData, pathId))
+              &updateID, prefix, originAS, &defResInfo, &bgpData, pathId,
+              digest))
     {
       RAISE_SYS_ERROR("Could not store update [0x%08X]!!", updateID);
       // Maybe check for ID conflict, if not then get result again - or just
       // quit here!
-      free(prefix);
       return false;
     }
 
@@ -800,7 +866,6 @@ bool processValidationRequest(ServerConnectionHandler* self,
     srxRes.roaResult    = defResInfo.result.roaResult;
     srxRes.bgpsecResult = defResInfo.result.bgpsecResult;
   }
-  free(prefix);
   prefix = NULL;
 
   if (modifyUpdateCacheWithAspaValue)
@@ -861,8 +926,8 @@ bool processValidationRequest(ServerConnectionHandler* self,
     hdr->flags = sendFlags & SRX_FLAG_ROA_BGPSEC_ASPA;
 
     // create the validation command!
-    if (!queueCommand(self->cmdQueue, COMMAND_TYPE_SRX_PROXY, svrSock, client,
-                      updateID, ntohl(hdr->length), (uint8_t*)hdr))
+    if (!_queuePDU(self, svrSock, (ServerClient*)client, updateID, 
+                   ntohl(hdr->length), (uint8_t*)hdr, owned))
     {
       RAISE_ERROR("Could not add validation request to command queue!");
       retVal = false;
@@ -884,13 +949,15 @@ bool processValidationRequest(ServerConnectionHandler* self,
  * @param client The client instance where the packet was received on
  * @param updateCache The instance of the update cache
  * @param hdr The signature request header
+ * @param owned Indicates if the request can be handed over to the command 
+ *              queue (can be NULL), see _queuePDU.
  *
  * @return false if an internal (fatal) error occurred, otherwise true.
  */
 static bool processSignatureRequest(ServerConnectionHandler* self,
                                     ServerSocket* svrSock, ServerClient* client,
                                     SRxUpdateID updateID,
-                                    SRXPROXY_SIGN_REQUEST* hdr)
+                                    SRXPROXY_SIGN_REQUEST* hdr, bool* owned)
 {
   LOG(LEVEL_DEBUG, HDR "Enter processSignatureRequest", pthread_self());
   UpdSigResult* signResult = malloc(sizeof(UpdSigResult));
@@ -926,9 +993,8 @@ static bool processSignatureRequest(ServerConnectionHandler* self,
   }
   else // No data was available, add request to command handler for signing
   {
-    if (!queueCommand(self->cmdQueue, COMMAND_TYPE_SRX_PROXY, svrSock, client,
-                                      updateID, ntohl(hdr->length),
-                                      (uint8_t*)hdr))
+    if (!_queuePDU(self, svrSock, client, updateID, ntohl(hdr->length),
+                   (uint8_t*)hdr, owned))
     {
       RAISE_ERROR("Could not add validation request to command queue!");
       retVal = false;
@@ -940,6 +1006,110 @@ static bool processSignatureRequest(ServerConnectionHandler* self,
   return retVal;
 }
 
+/**
+ * Verify that the batched verify request only contains complete verify
+ * requests.
+ *
+ * @param hdr The batched verify request
+ * @param length The length of the packet received
+ *
+ * @return true if the batch is well formed.
+ *
+ * @since 0.6.2.0
+ */
+static bool isValidVerifyBatch(SRXPROXY_VERIFY_BATCH_REQUEST* hdr,
+                               PacketLength length)
+{
+  uint32_t count  = ntohl(hdr->count);
+  uint8_t* reqPtr = (uint8_t*)hdr + sizeof(SRXPROXY_VERIFY_BATCH_REQUEST);
+  uint32_t remain = 0;
+  uint32_t reqLen = 0;
+  SRXRPOXY_BasicHeader_VerifyRequest* reqHdr = NULL;
+
+  if (   (length < sizeof(SRXPROXY_VERIFY_BATCH_REQUEST))
+      || (ntohl(hdr->length) != length))
+  {
+    return false;
+  }
+
+  remain = length - sizeof(SRXPROXY_VERIFY_BATCH_REQUEST);
+  for (; count > 0; count--)
+  {
+    if (remain < sizeof(SRXRPOXY_BasicHeader_VerifyRequest))
+    {
+      return false;
+    }
+    reqHdr = (SRXRPOXY_BasicHeader_VerifyRequest*)reqPtr;
+    reqLen = ntohl(reqHdr->length);
+    switch (reqHdr->type)
+    {
+      case PDU_SRXPROXY_VERIFY_V4_REQUEST:
+        if (reqLen < sizeof(SRXPROXY_VERIFY_V4_REQUEST))
+        {
+          return false;
+        }
+        break;
+      case PDU_SRXPROXY_VERIFY_V6_REQUEST:
+        if (reqLen < sizeof(SRXPROXY_VERIFY_V6_REQUEST))
+        {
+          return false;
+        }
+        break;
+      default:
+        return false;
+    }
+    if (reqLen > remain)
+    {
+      return false;
+    }
+    reqPtr += reqLen;
+    remain -= reqLen;
+  }
+
+  // No trailing data allowed.
+  return remain == 0;
+}
+
+/**
+ * Process each verify request contained in the batched verify request the
+ * same way a single verify request is processed. The batch MUST be validated
+ * using isValidVerifyBatch prior to calling this function.
+ *
+ * @param self The server connection handler.
+ * @param svrSock The server socket used to send a possible validation request
+ *                receipt
+ * @param client The client instance where the packet was received on
+ * @param hdr The batched verify request
+ *
+ * @return false if an internal (fatal) error occurred, otherwise true.
+ *
+ * @since 0.6.2.0
+ */
+static bool processVerifyBatchRequest(ServerConnectionHandler* self,
+                                      ServerSocket* svrSock,
+                                      ClientThread* client,
+                                      SRXPROXY_VERIFY_BATCH_REQUEST* hdr)
+{
+  uint32_t count  = ntohl(hdr->count);
+  uint8_t* reqPtr = (uint8_t*)hdr + sizeof(SRXPROXY_VERIFY_BATCH_REQUEST);
+  SRXRPOXY_BasicHeader_VerifyRequest* reqHdr = NULL;
+  bool retVal = true;
+
+  LOG(LEVEL_DEBUG, HDR "Received batch of %u validation requests from "
+                   "proxy[0x%08X]", pthread_self(), count, client);
+
+  for (; retVal && (count > 0); count--)
+  {
+    reqHdr  = (SRXRPOXY_BasicHeader_VerifyRequest*)reqPtr;
+    // Read the length first, processValidationRequest modifies the flags
+    reqPtr += ntohl(reqHdr->length);
+    // The requests are part of the batch, the command queue copies them.
+    retVal  = processValidationRequest(self, svrSock, client, reqHdr, NULL);
+  }
+
+  return retVal;
+}
+
 /**
  * SRx receives a packet from one of the proxy clients. This method is called
  * before the command handler will see the request. This will be decided in this
@@ -958,10 +1128,13 @@ static bool processSignatureRequest(ServerConnectionHandler* self,
  * @param packet  The packet itself
  * @param length  length The length of the packet received
  * @param srvConHandler The pointer to the sever connection handler.
+ * @param owned Indicates if the packet is allocated with malloc and can be 
+ *              handed over to the command queue (can be NULL). It is set to 
+ *              false if the packet was handed over.
  */
 void _handlePacket(ServerSocket* svrSock, ServerClient* client,
                          void* packet, PacketLength length,
-                         void* srvConHandler)
+                         void* srvConHandler, bool* owned)
 {
   LOG(LEVEL_DEBUG, HDR "Enter handlePacket", pthread_self());
   ServerConnectionHandler* self  = (ServerConnectionHandler*)srvConHandler;
@@ -1013,7 +1186,8 @@ void _handlePacket(ServerSocket* svrSock, ServerClient* client,
           // This is done because within this process SRx calculates already the
           // UpdateID and adds it to the command item.
           if (!processValidationRequest(self, svrSock, clientThread,
-                                   (SRXRPOXY_BasicHeader_VerifyRequest*)packet))
+                                   (SRXRPOXY_BasicHeader_VerifyRequest*)packet,
+                                   owned))
           {
             sendError(SRXERR_INTERNAL_ERROR, svrSock, client, false);
             sendGoodbye(svrSock, client, false);
@@ -1023,6 +1197,30 @@ void _handlePacket(ServerSocket* svrSock, ServerClient* client,
         }
 //#endif
         break;
+      case PDU_SRXPROXY_VERIFY_BATCH_REQUEST:
+        if (!clientThread->initialized)
+        {
+          // A handshake was not performed, otherwise the clientThread would be
+          // initialized!!!
+          RAISE_SYS_ERROR("Connection not initialized yet - "
+                          "Handshake missing!!!");
+          sendError(SRXERR_INTERNAL_ERROR, svrSock, client, false);
+          sendGoodbye(svrSock, client, false);
+        }
+        else if (!isValidVerifyBatch((SRXPROXY_VERIFY_BATCH_REQUEST*)packet,
+                                     length))
+        {
+          RAISE_ERROR("Invalid batched verify request received!");
+          sendError(SRXERR_INVALID_PACKET, svrSock, client, false);
+          sendGoodbye(svrSock, client, false);
+        }
+        else if (!processVerifyBatchRequest(self, svrSock, clientThread,
+                                       (SRXPROXY_VERIFY_BATCH_REQUEST*)packet))
+        {
+          sendError(SRXERR_INTERNAL_ERROR, svrSock, client, false);
+          sendGoodbye(svrSock, client, false);
+        }
+        break;
       case PDU_SRXPROXY_SIGN_REQUEST:
         if (!clientThread->initialized)
         {
@@ -1043,7 +1241,8 @@ void _handlePacket(ServerSocket* svrSock, ServerClient* client,
           LOG(LEVEL_DEBUG, HDR "Received signature request fore update [0x%08X]",
                            pthread_self(), ntohl(srHdr->updateIdentifier));
           if (!processSignatureRequest(self, svrSock, client,
-                                       ntohl(srHdr->updateIdentifier), srHdr))
+                                       ntohl(srHdr->updateIdentifier), srHdr,
+                                       owned))
           {
             sendError(SRXERR_INTERNAL_ERROR, svrSock, client, false);
             sendGoodbye(svrSock, client, false);
@@ -1123,8 +1322,8 @@ void _handlePacket(ServerSocket* svrSock, ServerClient* client,
     {
       // Whatever SRX packet except validation and signature request. It will
       // be added to the command queue for further processing.
-      queueCommand(self->cmdQueue, COMMAND_TYPE_SRX_PROXY, svrSock, client,
-                   dataID, length, (uint8_t*)packet);
+      _queuePDU(self, svrSock, client, dataID, length, (uint8_t*)packet,
+                owned);
     }
   }
   LOG(LEVEL_DEBUG, HDR "Exit handlePacket", pthread_self());
@@ -1157,7 +1356,8 @@ void handlePacket(ServerSocket* svrSock, ServerClient* client,
   SCH_ReceiverQueue* queue = (SCH_ReceiverQueue*)handler->receiverQueue;
   if (queue == NULL)
   {
-    _handlePacket(svrSock, client, packet, length, srvConHandler);
+    // The packet belongs to the socket, the command queue copies it.
+    _handlePacket(svrSock, client, packet, length, srvConHandler, NULL);
   }
   else
   {
@@ -1209,6 +1409,8 @@ static bool handleStatusChange(ServerSocket* svrSock, ServerClient* client,
     }
 
     deleteFromSList(&self->clients, client);
+    // Drop what is left to be send to this client.
+    releaseClientSendQueue(client);
 
     bool crashed = !(self->inShutdown || clientThread->goodByeReceived);
     deactivateConnectionMapping(self, clientThread->routerID, crashed,
@@ -1235,8 +1437,10 @@ void startProcessingRequests(ServerConnectionHandler* self,
 {
   LOG(LEVEL_DEBUG, HDR "Enter startProcessingRequests", pthread_self());
   self->cmdQueue = cmdQueue;
-  runServerLoop(&self->svrSock, MODE_SINGLE_CLIENT, handlePacket,
-                handleStatusChange, self);
+  runServerLoop(&self->svrSock,
+                self->sysConfig->mode_epoll ? MODE_EPOLL_CLIENTS
+                                            : MODE_SINGLE_CLIENT,
+                handlePacket, handleStatusChange, self);
   LOG(LEVEL_DEBUG, HDR "Exit startProcessingRequests", pthread_self());
 }
 
@@ -22,11 +22,18 @@
  *
  * This file contains the functions to send srx-proxy packets.
  * 
- * @version 0.3.0.10
+ * @version 0.6.2.0
  *
  * Changelog:
  * 
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * The send queue keeps a bounded output ring per client instead
+ *              of a list of copied packets. The queue thread sends all queued
+ *              packets of a client with one scatter-gather write and skips
+ *              clients that can not take data. A full ring blocks the sender
+ *              until space is available.
+ *            * Added releaseClientSendQueue
  * 0.3.0.10 - 2015/11/10 - oborchert
  *            * Fixed assignment bug in stopSendQueue
  *            * Added return value (NULL) to sendQueueThreadLoop
@@ -41,32 +48,50 @@
  */
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "server/srx_packet_sender.h"
 #include "shared/srx_packets.h"
 #include "util/log.h"
 #include "util/mutex.h"
 #include "util/server_socket.h"
 
-typedef struct {
-  // The pdu to be send
-  uint8_t*      pdu;    
-  // The size of the pdu
-  size_t        size;
-  // The server socket to send from
-  ServerSocket* srcSock;
+/**
+ * The output ring of a single client. Each PDU is stored in one piece, if it
+ * does not fit at the end of the buffer it is stored at the beginning and the
+ * end of the data before the wrap is marked with wrapEnd.
+ */
+typedef struct _ClientSendQueue {
   // The client to send to
   ServerClient* client;
-  // The next packet in the queue
-  void*         next; 
-} SendPacket;
+  // The server socket to send from
+  ServerSocket* srcSock;
+  // The ring buffer of SEND_RING_SIZE bytes
+  uint8_t*      buffer;
+  // The position of the first PDU not send yet
+  uint32_t      head;
+  // The position the next PDU is stored
+  uint32_t      tail;
+  // The end of the data in front of the wrap
+  uint32_t      wrapEnd;
+  // Indicates that tail wrapped to the beginning of the buffer
+  bool          wrapped;
+  // The number of bytes queued
+  uint32_t      used;
+  // Indicates that the queue thread is sending from the buffer
+  bool          busy;
+  // The number of times a PDU had to wait because the ring was full
+  uint32_t      stalled;
+  // The next client queue
+  struct _ClientSendQueue* next;
+} ClientSendQueue;
 
 typedef struct {
-  // the head element of the queue
-  SendPacket* head;
-  // the tail element of the queue
-  SendPacket* tail;
-  // the size of the queue
-  int        size;
+  // The list of client queues
+  ClientSendQueue* clients;
+  // the number of bytes queued in all client queues
+  uint32_t    size;
   // the queue handler itself
   pthread_t handler;
   // indicates if the queue is running.
@@ -74,7 +99,8 @@ typedef struct {
   // Mutex and Condition for thread handling
   Mutex       mutex;
   Cond        condition;
-  
+  // Signals that data of a client queue was send
+  Cond        sentCond;
 } SendPacketQueue;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -83,13 +109,16 @@ typedef struct {
 
 // wait until notify or 1 s timeout - this is just to allow a wakeup
 #define SEND_QUEUE_WAIT_MS 1000
+// The time to wait before sending to clients that could not take data again.
+#define SEND_QUEUE_RETRY_US 1000
+// The size of the output ring of each client
+#define SEND_RING_SIZE 65536
+// The maximum number of PDUs send using one write
+#define SEND_QUEUE_MAX_PDUS 256
 
 // The send queue 
 static SendPacketQueue* SEND_QUEUE = NULL;
 
-// Forward declaration
-SendPacket* fetchSendPacket();
-
 /**
  * Create the sender queue including the thread that manages the queue.
  * 
@@ -102,8 +131,7 @@ bool createSendQueue()
   SendPacketQueue* queue = malloc(sizeof(SendPacketQueue));
   if (queue != NULL)
   {
-    queue->head    = NULL;
-    queue->tail    = NULL;
+    queue->clients = NULL;
     queue->size    = 0;
     queue->running = false;
     
@@ -115,6 +143,13 @@ bool createSendQueue()
         free(queue);
         queue = NULL;
       }
+      else if (!initCond(&queue->sentCond))
+      {
+        destroyCond(&queue->condition);
+        releaseMutex(&queue->mutex);
+        free(queue);
+        queue = NULL;
+      }
     }
     else
     {
@@ -144,12 +179,21 @@ void releaseSendQueue()
       // Stops and cleans the queue
       stopSendQueue(SEND_QUEUE);
     }
-    if (SEND_QUEUE->head != NULL)
+    if (SEND_QUEUE->size != 0)
     {
       RAISE_SYS_ERROR("Queue should be already empty!");
     }
+    ClientSendQueue* cQueue = NULL;
+    while (SEND_QUEUE->clients != NULL)
+    {
+      cQueue = SEND_QUEUE->clients;
+      SEND_QUEUE->clients = cQueue->next;
+      free(cQueue->buffer);
+      free(cQueue);
+    }
     releaseMutex(&SEND_QUEUE->mutex);
     destroyCond(&SEND_QUEUE->condition);
+    destroyCond(&SEND_QUEUE->sentCond);
     free (SEND_QUEUE);
     SEND_QUEUE = NULL;
     
@@ -157,8 +201,127 @@ void releaseSendQueue()
   }  
 }
 
+/**
+ * Remove the given number of bytes from the head of the client queue. The
+ * queue mutex must be held.
+ *
+ * @param queue The send queue
+ * @param cQueue The client queue
+ * @param length The number of bytes, it must end with a complete PDU.
+ *
+ * @since 0.6.2.0
+ */
+static void _consumeClientQueue(SendPacketQueue* queue, ClientSendQueue* cQueue,
+                                uint32_t length)
+{
+  cQueue->used -= length;
+  queue->size  -= length;
+
+  if (cQueue->wrapped && (cQueue->head + length >= cQueue->wrapEnd))
+  {
+    // Continue with the data at the beginning of the ring.
+    length          -= cQueue->wrapEnd - cQueue->head;
+    cQueue->head    = 0;
+    cQueue->wrapped = false;
+  }
+  cQueue->head += length;
+
+  if (cQueue->used == 0)
+  {
+    cQueue->head    = 0;
+    cQueue->tail    = 0;
+    cQueue->wrapped = false;
+  }
+}
+
+/**
+ * Fill the PDU array with the PDUs queued for the client starting at head.
+ * The queue mutex must be held.
+ *
+ * @param cQueue The client queue
+ * @param pdus The array of at least SEND_QUEUE_MAX_PDUS elements.
+ *
+ * @return The number of PDUs
+ *
+ * @since 0.6.2.0
+ */
+static int _fetchClientPDUs(ClientSendQueue* cQueue, struct iovec* pdus)
+{
+  int      count = 0;
+  uint32_t pos   = cQueue->head;
+  uint32_t end   = cQueue->wrapped ? cQueue->wrapEnd : cQueue->tail;
+  uint32_t length;
+  bool     second = cQueue->wrapped;
+
+  while (count < SEND_QUEUE_MAX_PDUS)
+  {
+    if (pos == end)
+    {
+      if (!second)
+      {
+        break;
+      }
+      // Continue with the data at the beginning of the ring.
+      pos    = 0;
+      end    = cQueue->tail;
+      second = false;
+      continue;
+    }
+    length = ntohl(((SRXPROXY_BasicHeader*)(cQueue->buffer + pos))->length);
+    pdus[count].iov_base = cQueue->buffer + pos;
+    pdus[count].iov_len  = length;
+    pos += length;
+    count++;
+  }
+
+  return count;
+}
+
+/**
+ * Send the queued PDUs of the client as far as possible without blocking.
+ * The queue mutex must be held, it is released while sending.
+ *
+ * @param queue The send queue
+ * @param cQueue The client queue
+ *
+ * @return The number of bytes send.
+ *
+ * @since 0.6.2.0
+ */
+static uint32_t _sendClientQueue(SendPacketQueue* queue, 
+                                 ClientSendQueue* cQueue)
+{
+  struct iovec pdus[SEND_QUEUE_MAX_PDUS];
+  int          count = _fetchClientPDUs(cQueue, pdus);
+  ssize_t      sent;
+
+  // New PDUs can be added while sending, they do not touch the fetched ones.
+  cQueue->busy = true;
+  unlockMutex(&queue->mutex);
+  sent = sendPacketsToClient(cQueue->srcSock, cQueue->client, pdus, count);
+  lockMutex(&queue->mutex);
+  cQueue->busy = false;
+
+  if (sent < 0)
+  {
+    RAISE_ERROR("Could not send %u bytes of queued packets!", cQueue->used);
+    // Drop the PDUs of the lost connection.
+    sent = cQueue->used;
+  }
+  if (sent > 0)
+  {
+    _consumeClientQueue(queue, cQueue, (uint32_t)sent);
+  }
+  // Wake up the ones waiting for space or the end of sending.
+  pthread_cond_broadcast(&queue->sentCond);
+
+  return (uint32_t)sent;
+}
+
 /** 
- * The thread loop of the queue. To stop the queue call stopSendQueue()
+ * The thread loop of the queue. To stop the queue call stopSendQueue(). Each
+ * loop sends the packets of each client with queued packets using one write.
+ * A client that can not take data does not delay the others.
  * 
  * @param notused - Not Used
  * 
@@ -175,23 +338,37 @@ void* sendQueueThreadLoop(void* notused)
   }
   else
   {
-    SendPacket* packet = NULL;
+    ClientSendQueue* cQueue = NULL;
+    uint32_t sent = 0;
     LOG(LEVEL_DEBUG, "Enter sendqueue loop.");
+    lockMutex(&queue->mutex);
     while (queue->running)
     {
-      packet = fetchSendPacket(queue);
-      if (packet != NULL)
+      if (queue->size == 0)
+      {
+        // wait until notify is called or after a timeout.      
+        waitCond(&queue->condition, &queue->mutex, SEND_QUEUE_WAIT_MS);
+        continue;
+      }
+
+      sent = 0;
+      for (cQueue = queue->clients; cQueue != NULL; cQueue = cQueue->next)
       {
-        if (!sendPacketToClient(packet->srcSock, packet->client, packet->pdu, 
-                                packet->size))
+        if (cQueue->used > 0)
         {
-          SRXPROXY_BasicHeader* bhdr = (SRXPROXY_BasicHeader*)packet->pdu;
-          RAISE_ERROR("Could not send packet of type [%u]!", bhdr->type);
+          sent += _sendClientQueue(queue, cQueue);
         }
-        free(packet->pdu);
-        free(packet);
+      }
+
+      if (sent == 0)
+      {
+        // None of the clients could take data, give them time.
+        unlockMutex(&queue->mutex);
+        usleep(SEND_QUEUE_RETRY_US);
+        lockMutex(&queue->mutex);
       }
     }
+    unlockMutex(&queue->mutex);
     LOG(LEVEL_DEBUG, "Exit send queue loop!");
   }
   
@@ -257,79 +434,134 @@ void stopSendQueue()
       // Stop the queue by waking it up
       LOG(LEVEL_INFO, "StopSendQueue: send notification...");
       signalCond(&queue->condition);
+      // Wake up the ones waiting for space in a client queue.
+      pthread_cond_broadcast(&queue->sentCond);
     }
     unlockMutex(&queue->mutex);
-    // Give the queue thread a chance to process the notify or run into a
-    // wait timeout.   
-    LOG(LEVEL_INFO, "StopSendQueue: sleep for %u ms", SEND_QUEUE_WAIT_MS * 2);
-    usleep(SEND_QUEUE_WAIT_MS * 2);
     
-    lockMutex(&queue->mutex);
     // Free the remainder of the queue.
     LOG(LEVEL_INFO, "StopSendQueue: wait for queue thread to join...");
     pthread_join(queue->handler, NULL);
     LOG(LEVEL_INFO, "SendQueueThrealLoop STOPPED. Empty remainder of queue!");
-    SendPacket* packet = NULL;
-    while (queue->head != NULL)
+    lockMutex(&queue->mutex);
+    ClientSendQueue* cQueue = NULL;
+    for (cQueue = queue->clients; cQueue != NULL; cQueue = cQueue->next)
     {
-      packet = queue->head;
-      queue->head = (SendPacket*)packet->next;
-      // Free the allocated memory
-      free(packet->pdu);
-      free(packet);
-      queue->size--;
+      if (cQueue->used > 0)
+      {
+        _consumeClientQueue(queue, cQueue, cQueue->used);
+      }
     }
-    queue->tail = NULL;
     unlockMutex(&queue->mutex);
   }
 }
 
 /**
- * Retrieve the next packet from the queue as long as the queue is running. 
- * in case the queue is not running this method returns NULL.
- * 
- * @return  the next packet of NULL if the queue is empty.
- * 
- * @since 0.3.0
+ * Return the queue of the client. The queue mutex must be held.
+ *
+ * @param queue The send queue
+ * @param srvSoc The server socket to be used for sending
+ * @param client The client to send to
+ * @param create Create the queue if it does not exist yet.
+ *
+ * @return The client queue or NULL if not found or not enough memory is 
+ *         available.
+ *
+ * @since 0.6.2.0
  */
-SendPacket* fetchSendPacket() 
+static ClientSendQueue* _getClientQueue(SendPacketQueue* queue, 
+                                        ServerSocket* srvSoc,
+                                        ServerClient* client, bool create)
 {
-  SendPacketQueue* queue = SEND_QUEUE;
-  SendPacket* packet = NULL;
-  
-  if (queue != NULL)
+  ClientSendQueue* cQueue = queue->clients;
+
+  while ((cQueue != NULL) && (cQueue->client != client))
   {
-    lockMutex(&queue->mutex);
-    while (queue->size == 0 && queue->running)
+    cQueue = cQueue->next;
+  }
+
+  if ((cQueue == NULL) && create)
+  {
+    cQueue = malloc(sizeof(ClientSendQueue));
+    if (cQueue != NULL)
     {
-      // wait until notify is called or after a timeout.      
-      waitCond(&queue->condition, &queue->mutex, SEND_QUEUE_WAIT_MS);
-      if(!queue->running)
+      memset(cQueue, 0, sizeof(ClientSendQueue));
+      cQueue->buffer = malloc(SEND_RING_SIZE);
+      if (cQueue->buffer == NULL)
       {
-        LOG(LEVEL_INFO, "Sending queue received shutdown!");
+        free(cQueue);
+        cQueue = NULL;
+      }
+      else
+      {
+        cQueue->client  = client;
+        cQueue->next    = queue->clients;
+        queue->clients  = cQueue;
       }
     }
+  }
+  if (cQueue != NULL)
+  {
+    cQueue->srcSock = srvSoc;
+  }
+
+  return cQueue;
+}
+
+/**
+ * Reserve the space for a PDU in the client queue. The queue mutex must be
+ * held.
+ *
+ * @param cQueue The client queue
+ * @param size The size of the PDU
+ *
+ * @return The position of the PDU within the buffer or NULL if the queue
+ *         is full.
+ *
+ * @since 0.6.2.0
+ */
+static uint8_t* _reserveClientQueue(ClientSendQueue* cQueue, uint32_t size)
+{
+  uint8_t* pos = NULL;
 
-    // If queue is still running and a packet is available take it
-    if (queue->running && queue->head != NULL)
+  if (!cQueue->wrapped)
+  {
+    if (SEND_RING_SIZE - cQueue->tail >= size)
     {
-      packet = queue->head;
-      queue->size--;
-      queue->head = (SendPacket*)packet->next;
-      packet->next = NULL;   
+      pos = cQueue->buffer + cQueue->tail;
+    }
+    else if ((cQueue->used > 0) && (cQueue->head >= size))
+    {
+      // Store it at the beginning
+      cQueue->wrapEnd = cQueue->tail;
+      cQueue->wrapped = true;
+      cQueue->tail    = 0;
+      pos = cQueue->buffer;
     }
-    unlockMutex(&queue->mutex);
   }
-  return packet;
+  else if (cQueue->head - cQueue->tail >= size)
+  {
+    pos = cQueue->buffer + cQueue->tail;
+  }
+
+  if (pos != NULL)
+  {
+    cQueue->tail += size;
+    cQueue->used += size;
+  }
+
+  return pos;
 }
 
 /**
- * Queue a copy of the the packet and return the size of the queue. The copy of 
- * the packet will be free'd by the queue handler thread itself.
+ * Copy the packet into the output ring of the client. If the ring is full the
+ * caller waits until the queue thread did send enough data (backpressure) or
+ * the queue of the client is released.
  * 
  * @param pdu The PDU to be added to the queue.
  * @param srvSoc The server socket to be used for sending
  * @param client The client to send to
+ * @param size The size of the PDU
  * 
  * @return true if the packet was queued, otherwise false.
  * 
@@ -339,50 +571,119 @@ bool addToSendQueue(uint8_t* pdu, ServerSocket* srvSoc, ServerClient* client,
                     size_t size)
 {
   SendPacketQueue* queue = SEND_QUEUE;
-  
-  SendPacket* packet = malloc(sizeof(SendPacket));
+  ClientSendQueue* cQueue = NULL;
+  uint8_t* pos = NULL;
   bool retVal = false;
   
+  if (size > SEND_RING_SIZE)
+  {
+    RAISE_ERROR("The packet of %u bytes is too large for the send queue!",
+                size);
+    return false;
+  }
+
   lockMutex(&queue->mutex);
-  if (packet != NULL)
+  cQueue = _getClientQueue(queue, srvSoc, client, true);
+  if (cQueue == NULL)
   {
-    memset(packet, 0, sizeof(SendPacket));
-    packet->pdu = malloc(size);
-    if (packet->pdu == NULL)
-    {
-      free(packet);
-    }
-    else
+    RAISE_SYS_ERROR("Not enough memory to queue packets in send queue!");
+  }
+  else
+  {
+    pos = _reserveClientQueue(cQueue, (uint32_t)size);
+    if ((pos == NULL) && queue->running)
     {
-      retVal = true;
-      packet->srcSock  = srvSoc;
-      packet->client   = client;
-      packet->next     = NULL;
-      packet->size     = size;
-      memcpy(packet->pdu, pdu, size);  
-      if (queue->size == 0)
+      // Report the first and then every 1000th time.
+      if ((cQueue->stalled++ % 1000) == 0)
       {
-        queue->head = packet;
-        queue->tail = packet;
+        LOG(LEVEL_NOTICE, "Send queue of client [0x%08X] is full with %u bytes "
+                          "(%u times), wait for the client!", client, 
+                          cQueue->used, cQueue->stalled);
       }
-      else
+      while ((pos == NULL) && queue->running)
       {
-        queue->tail->next = packet;
-        queue->tail = packet;
+        pthread_cond_wait(&queue->sentCond, &queue->mutex);
+        // The client might be gone while waiting, its packets are dropped.
+        cQueue = _getClientQueue(queue, srvSoc, client, false);
+        if (cQueue == NULL)
+        {
+          LOG(LEVEL_DEBUG, "Client [0x%08X] is gone, packet dropped!", client);
+          break;
+        }
+        pos = _reserveClientQueue(cQueue, (uint32_t)size);
       }
-      queue->size++;
+    }
+
+    if (pos != NULL)
+    {
+      memcpy(pos, pdu, size);
+      queue->size += size;
+      retVal = true;
       // Signal a new packet is in the queue
       signalCond(&queue->condition);
     }
   }
   unlockMutex(&queue->mutex);
   
-  if (!retVal)
+  return retVal;
+}
+
+/**
+ * Remove the queue of the client and drop its packets. This is called once the
+ * connection to the client is closed.
+ *
+ * @param client The client
+ *
+ * @since 0.6.2.0
+ */
+void releaseClientSendQueue(ServerClient* client)
+{
+  SendPacketQueue* queue = SEND_QUEUE;
+  ClientSendQueue* cQueue = NULL;
+  ClientSendQueue* prev   = NULL;
+
+  if (queue != NULL)
   {
-    RAISE_SYS_ERROR("Not enough memory to queue packets in send queue!");
+    lockMutex(&queue->mutex);
+    for (cQueue = queue->clients; cQueue != NULL; cQueue = cQueue->next)
+    {
+      if (cQueue->client == client)
+      {
+        break;
+      }
+      prev = cQueue;
+    }
+    if (cQueue != NULL)
+    {
+      // The queue thread might be sending from the buffer.
+      while (cQueue->busy)
+      {
+        pthread_cond_wait(&queue->sentCond, &queue->mutex);
+      }
+      // Re-locate the predecessor, the list might have changed while waiting.
+      prev = NULL;
+      ClientSendQueue* walk = queue->clients;
+      while (walk != cQueue)
+      {
+        prev = walk;
+        walk = walk->next;
+      }
+      if (prev == NULL)
+      {
+        queue->clients = cQueue->next;
+      }
+      else
+      {
+        prev->next = cQueue->next;
+      }
+      queue->size -= cQueue->used;
+      free(cQueue->buffer);
+      free(cQueue);
+      // Wake up the ones waiting for space of this client.
+      pthread_cond_broadcast(&queue->sentCond);
+    }
+    unlockMutex(&queue->mutex);
   }
-  
-  return retVal;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
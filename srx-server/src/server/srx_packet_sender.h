@@ -22,11 +22,13 @@
  *
  * This file contains the functions to send srx-proxy packets.
  * 
- * @version 0.3.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * 
  * -----------------------------------------------------------------------------
+ *   0.6.2.0 - 2026/10/18
+ *   * Added releaseClientSendQueue.
  *   0.3.0 - 2013/01/02 - oborchert
  *   * Added changelog.
  *   * Added sending queue to prevent buffer overflows in the receiver socket 
@@ -75,6 +77,16 @@ void stopSendQueue();
  */
 void releaseSendQueue();
 
+/**
+ * Remove the queue of the client and drop its packets. This is called once the
+ * connection to the client is closed.
+ *
+ * @param client The client
+ *
+ * @since 0.6.2.0
+ */
+void releaseClientSendQueue(ServerClient* client);
+
 /**
  * Send a hello response to the client. This method does not use the send queue
  *
@@ -20,15 +20,57 @@
  * other licenses. Please refer to the licenses of all libraries required
  * by this software.
  *
- * The update cache holds the updates in two separate structures, one is the
- * update cache, a hash table with the update id as key and the update as
- * value. The other is a list, that allows to scan through all updates. Both
- * MUST be maintained the same.
+ * The update cache holds the updates in a hash table with the update id as
+ * key and the update as value.
  *
- * @version 0.5.0.0
+ * Updates without clients are kept in a timing wheel by their deletion time.
+ * With each pass the garbage collector takes the expired updates from the
+ * wheel, verifies under the locks of the shard that they are still unused,
+ * and removes them from the hash table, the path index, the prefix cache, the
+ * AS path cache and the SKI cache. Other threads might still use an update
+ * they found just before. Each access to a cache entry outside of the shard 
+ * locks is enclosed in a read section of gcReaders, the memory is released 
+ * with the next pass once all read sections that could see the update ended.
+ *
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Added an index from the AS path cache ID to the updates that
+ *              share the AS path and the function getUpdateIDsOfPath.
+ *            * Removed process_ASPA_EndOfData, the End of Data processing does
+ *              not scan the whole update cache anymore.
+ *            * Store the 64 bit identifier (digest) with each update. The 
+ *              function detectCollision compares the digests first and does 
+ *              not compare the update data of different updates anymore.
+ *            * Fixed the prefix comparison in detectCollision.
+ *            * Partitioned the update cache into UC_NUM_SHARDS shards, each
+ *              with its own table, path index, item list and locks. Walks
+ *              over the whole cache process one shard at a time.
+ *            * getUpdateResult registers the client under the item mutex.
+ *            * Fixed the size of lockedClients.
+ *            * Allocate cache entries from a slab pool and the AS path, the
+ *              BGPsec path and the client list from the slab size classes.
+ *            * Release the client list and the path data of deleted updates,
+ *              also when emptying the cache.
+ *            * Added the garbage collector thread. Updates without clients
+ *              are scheduled in a timing wheel and reclaimed when their keep
+ *              time passed. Replaced gcTestAndDeleteUpdate.
+ *            * Removed the item list of the shards, walks over the cache
+ *              iterate the hash table of each shard.
+ *            * The GC flag holds a 32 bit deletion time, unregisterClientID
+ *              converts the keep time into a deletion time.
+ *            * The SKI cache registration of an update is removed when the
+ *              update is reclaimed, not with the deletion of each client.
+ *            * The GC flag is also reset if the client list had to be
+ *              extended.
+ *            * The garbage collector releases removed updates only after the
+ *              read sections (gcReaders) that could still use them ended.
+ *              Added enterUpdateCacheReader and leaveUpdateCacheReader.
+ *            * Added reserveUpdatePath. The garbage collector removes an
+ *              unused AS path from the AS path cache under the lock of the
+ *              path index and keeps reserved AS paths.
  * 0.5.0.0  - 2017/07/11 - kyehwanl
  *            * Fixed BZ1190 - added missing initialization for cEntry->pathData
  *          - 2017/07/08 - oborchert
@@ -75,12 +117,14 @@
 
 #include <uthash.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <malloc.h>
 #include <time.h>
 #include <srx/srxcryptoapi.h>
 #include "server/update_cache.h"
 #include "server/server_connection_handler.h"
+#include "server/aspath_cache.h"
 #include "server/prefix_cache.h"
 #include "server/ski_cache.h"
 #include "shared/srx_defs.h"
@@ -89,18 +133,15 @@
 #include "util/prefix.h"
 #include "util/xml_out.h"
 #include "util/mutex.h"
+#include "util/slab.h"
 #include "main.h"
 
-/* Number of preallocated result slots */
-//#define NUM_PREALLOC  20
-#define NUM_PREALLOC  1
-
 #define HDR "([0x%08X] UpdateCache): "
 
 /**
  * A single update result.
  */
-typedef struct {
+typedef struct _CacheEntry {
   uint8_t* clients;           // clients with value 0 are unused.
   uint8_t  noPossibleClients; // maximum number of clients in list without
                               // extending
@@ -116,17 +157,40 @@ typedef struct {
                                   // request.
   uint32_t         roaRefCount;   // the number of ROA's that cover this update
 
-  uint16_t         gcFlag;        // Indicates when this entry can be deleted
-                                  // by the garbage collector.
+  uint32_t         gcFlag;        // The time (getGCTime) this entry can be
+                                  // deleted by the garbage collector, 0 if
+                                  // the entry is in use.
+  TW_Timer         gcTimer;       // Schedules the entry with the GC (gcMutex)
+  bool             gcReclaimed;   // Removed by the garbage collector
+  struct _CacheEntry* gcNext;     // List of the garbage collector
 
   UC_UpdateData    pathData;      // This element replaces the blob.
   uint32_t         aspathCacheID; // aspath cache key ID
+  uint64_t         digest;        // The 64 bit identifier of the update data
 } CacheEntry;
 
+/**
+ * The updates that share the same AS path. Allows to find all updates
+ * affected by a changed ASPA validation result of an AS path.
+ */
+typedef struct {
+  UT_hash_handle   hh;         // The hash table where this entry is stored in
+  uint32_t         pathId;     // aspath cache key ID
+  SRxUpdateID*     updateIDs;  // The updates using this AS path
+  uint32_t         count;      // Number of updates in the list
+  uint32_t         size;       // Number of allocated list elements
+  uint32_t         pending;    // Updates about to be stored with the path
+} PathUpdates;
+
+/** The pool of all cache entries */
+static SlabPool _entryPool = SLAB_POOL_INITIALIZER("update-cache-entry",
+                                                   sizeof(CacheEntry));
+
 // Forward declarations
 bool _addClientReference(UpdateCache* self, CacheEntry* cEntry,
                          uint8_t clientID, ProxyClientMapping* clientMapping);
-uint16_t getGCTime(uint16_t keepTime);
+uint32_t getGCTime(uint32_t keepTime);
+void setGCFlag(UpdateCache* self, CacheEntry* cEntry, uint32_t timeOfDeletion);
 
 /**
  * Clean up the cache data element.
@@ -141,15 +205,30 @@ static void _cleanCachPathData(CacheEntry* cEntry)
 
   if (data->asn_path != NULL)
   {
-    free(data->asn_path);
+    freeSlabData(data->asn_path, data->hops * 4);
   }
   if (data->bgpsec_path != NULL)
   {
-    free(data->bgpsec_path);
+    freeSlabData(data->bgpsec_path, data->length);
   }
   memset(data, 0, sizeof(UC_UpdateData));
 }
 
+/**
+ * Release the cache entry including its path data and client list. The entry
+ * MUST NOT be referenced by the hash table or the timing wheel anymore.
+ *
+ * @param cEntry The cache entry.
+ *
+ * @since 0.6.2.0
+ */
+static void _releaseCacheEntry(CacheEntry* cEntry)
+{
+  _cleanCachPathData(cEntry);
+  freeSlabData(cEntry->clients, cEntry->noPossibleClients);
+  freeToSlab(&_entryPool, cEntry);
+}
+
 /**
  * This function selects the data from bgpsecData that is used for ID generation
  * - see srx_identifier::generateIdentifier and stores it in the cache entry.
@@ -206,7 +285,7 @@ bool storeCacheEntryBlob(CacheEntry* cEntry, BGPSecData* bgpData,
       {
         data->hops = bgpData->numberHops;
         dataLen = bgpData->numberHops * 4;
-        data->asn_path = malloc(dataLen);
+        data->asn_path = allocSlabData(dataLen);
         memcpy(data->asn_path, bgpData->asPath, dataLen);
       }
 
@@ -214,7 +293,7 @@ bool storeCacheEntryBlob(CacheEntry* cEntry, BGPSecData* bgpData,
       if (bgpData->attr_length != 0)
       {
         data->length      = bgpData->attr_length;
-        data->bgpsec_path = malloc(bgpData->attr_length);
+        data->bgpsec_path = allocSlabData(bgpData->attr_length);
         memcpy(data->bgpsec_path, bgpData->bgpsec_path_attr,
                bgpData->attr_length);
       }
@@ -229,9 +308,26 @@ bool storeCacheEntryBlob(CacheEntry* cEntry, BGPSecData* bgpData,
  *
  * @note Uses R/W lock
  */
+/**
+ * Return the shard of the update cache the given key belongs to. The key is
+ * either an update ID or an AS path ID (path index).
+ *
+ * @param self The update cache.
+ * @param key The update ID or path ID.
+ *
+ * @return The shard.
+ *
+ * @since 0.6.2.0
+ */
+static inline UC_Shard* _getShard(UpdateCache* self, uint32_t key)
+{
+  return &self->shards[(key ^ (key >> 16)) & (UC_NUM_SHARDS - 1)];
+}
+
 /**
  * This method searches the cache for the update with the given update id.
- * if found the result is written into the out pointer.
+ * if found the result is written into the out pointer. The caller MUST be 
+ * within a read section of gcReaders as long as it uses the entry.
  *
  * @param self The reference for the update cache
  * @param updateID The update ID to search for.
@@ -241,14 +337,47 @@ bool storeCacheEntryBlob(CacheEntry* cEntry, BGPSecData* bgpData,
  */
 static bool tableFind(UpdateCache* self, SRxUpdateID updateID, CacheEntry** out)
 {
-  acquireReadLock(&self->tableLock);
-  HASH_FIND(hh, (CacheEntry*)self->table, &updateID, sizeof(SRxUpdateID),
+  UC_Shard* shard = _getShard(self, updateID);
+
+  acquireReadLock(&shard->tableLock);
+  HASH_FIND(hh, (CacheEntry*)shard->table, &updateID, sizeof(SRxUpdateID),
             (*out));
-  unlockReadLock(&self->tableLock);
+  unlockReadLock(&shard->tableLock);
 
   return (*out != NULL);
 }
 
+/**
+ * Return the path index entry of the AS path, the entry is created if it does 
+ * not exist yet. The caller MUST hold the write lock of the shard.
+ *
+ * @param shard The shard of the path ID.
+ * @param pathId The AS path cache key ID.
+ *
+ * @return The path index entry or NULL if not enough memory is available.
+ *
+ * @since 0.6.2.0
+ */
+static PathUpdates* _pathIndexGet(UC_Shard* shard, uint32_t pathId)
+{
+  PathUpdates* pUpdates = NULL;
+
+  HASH_FIND(hh, (PathUpdates*)shard->pathIndex, &pathId, sizeof(uint32_t),
+            pUpdates);
+  if (pUpdates == NULL)
+  {
+    pUpdates = calloc(1, sizeof(PathUpdates));
+    if (pUpdates != NULL)
+    {
+      pUpdates->pathId = pathId;
+      HASH_ADD(hh, *((PathUpdates**)&shard->pathIndex), pathId,
+               sizeof(uint32_t), pUpdates);
+    }
+  }
+
+  return pUpdates;
+}
+
 /**
  * Add the update encapsulated in the cache entry element into the cache. The
  * key is the updateID and the value is the cache entry containing the update
@@ -259,24 +388,156 @@ static bool tableFind(UpdateCache* self, SRxUpdateID updateID, CacheEntry** out)
  */
 static void tableAdd(UpdateCache* self, CacheEntry* cEntry)
 {
-  acquireWriteLock(&self->tableLock);
-  HASH_ADD(hh, *((CacheEntry**)&self->table), updateID, sizeof(SRxUpdateID),
+  UC_Shard*    shard     = _getShard(self, cEntry->updateID);
+  PathUpdates* pUpdates  = NULL;
+  SRxUpdateID* updateIDs = NULL;
+
+  acquireWriteLock(&shard->tableLock);
+  HASH_ADD(hh, *((CacheEntry**)&shard->table), updateID, sizeof(SRxUpdateID),
            cEntry);
-  unlockWriteLock(&self->tableLock);
+  unlockWriteLock(&shard->tableLock);
+
+  // Register the update with its AS path, this replaces the reservation.
+  if (cEntry->aspathCacheID != 0)
+  {
+    shard = _getShard(self, cEntry->aspathCacheID);
+    acquireWriteLock(&shard->tableLock);
+    pUpdates = _pathIndexGet(shard, cEntry->aspathCacheID);
+    if (pUpdates != NULL && pUpdates->pending > 0)
+    {
+      pUpdates->pending--;
+    }
+    if (pUpdates != NULL && pUpdates->count == pUpdates->size)
+    {
+      updateIDs = realloc(pUpdates->updateIDs,
+                          (pUpdates->size + 4) * sizeof(SRxUpdateID));
+      if (updateIDs != NULL)
+      {
+        pUpdates->updateIDs = updateIDs;
+        pUpdates->size     += 4;
+      }
+    }
+    if (pUpdates != NULL && pUpdates->count < pUpdates->size)
+    {
+      pUpdates->updateIDs[pUpdates->count++] = cEntry->updateID;
+    }
+    else
+    {
+      RAISE_ERROR("Not enough memory to register update [0x%08X] with the AS "
+                  "path [0x%08X]", cEntry->updateID, cEntry->aspathCacheID);
+    }
+    unlockWriteLock(&shard->tableLock);
+  }
 }
 
 /**
- * Remove the update entry from the update cache. This method does NOT release
- * the memory attached to the cache entry!!!
+ * Remove the update from the path index. If no other update uses or is about 
+ * to use the AS path, the path is also removed from the AS path cache. Both 
+ * happen under the write lock of the shard, reserveUpdatePath can therefore 
+ * not find the AS path in between. The caller MUST NOT hold the lock of the 
+ * shard.
  *
  * @param self The update cache.
  * @param cEntry the entry containing the update information.
+ *
+ * @return true if no other update uses the AS path of the update.
+ *
+ * @since 0.6.2.0
+ */
+static bool pathIndexDel(UpdateCache* self, CacheEntry* cEntry)
+{
+  UC_Shard*    shard    = _getShard(self, cEntry->aspathCacheID);
+  PathUpdates* pUpdates = NULL;
+  uint32_t     idx      = 0;
+  bool         unused   = true;
+
+  acquireWriteLock(&shard->tableLock);
+  HASH_FIND(hh, (PathUpdates*)shard->pathIndex, &cEntry->aspathCacheID,
+            sizeof(uint32_t), pUpdates);
+  if (pUpdates != NULL)
+  {
+    for (idx = 0; idx < pUpdates->count; idx++)
+    {
+      if (pUpdates->updateIDs[idx] == cEntry->updateID)
+      {
+        pUpdates->updateIDs[idx] = pUpdates->updateIDs[--pUpdates->count];
+        break;
+      }
+    }
+    if ((pUpdates->count == 0) && (pUpdates->pending == 0))
+    {
+      HASH_DEL(*((PathUpdates**)&shard->pathIndex), pUpdates);
+      free(pUpdates->updateIDs);
+      free(pUpdates);
+    }
+    else
+    {
+      unused = false;
+    }
+  }
+  if (unused && (self->aspathCache != NULL))
+  {
+    deleteAspathCache((AspathCache*)self->aspathCache, cEntry->aspathCacheID,
+                      NULL);
+  }
+  unlockWriteLock(&shard->tableLock);
+
+  return unused;
+}
+
+/**
+ * Remove the reservation of the AS path made with reserveUpdatePath for an
+ * update that was not stored. The caller MUST NOT hold the lock of the shard.
+ *
+ * @param self The update cache.
+ * @param pathId The AS path cache key ID.
+ *
+ * @since 0.6.2.0
+ */
+static void _releaseUpdatePath(UpdateCache* self, uint32_t pathId)
+{
+  UC_Shard*    shard    = _getShard(self, pathId);
+  PathUpdates* pUpdates = NULL;
+
+  if (pathId == 0)
+  {
+    return;
+  }
+
+  acquireWriteLock(&shard->tableLock);
+  HASH_FIND(hh, (PathUpdates*)shard->pathIndex, &pathId, sizeof(uint32_t),
+            pUpdates);
+  if ((pUpdates != NULL) && (pUpdates->pending > 0))
+  {
+    pUpdates->pending--;
+    if ((pUpdates->count == 0) && (pUpdates->pending == 0))
+    {
+      HASH_DEL(*((PathUpdates**)&shard->pathIndex), pUpdates);
+      free(pUpdates->updateIDs);
+      free(pUpdates);
+    }
+  }
+  unlockWriteLock(&shard->tableLock);
+}
+
+/**
+ * Remove all entries from the path index of the shard. The caller MUST hold 
+ * the write lock of the shard.
+ *
+ * @param shard The update cache shard.
  */
-static void tableDel(UpdateCache* self, CacheEntry* cEntry)
+static void _emptyPathIndex(UC_Shard* shard)
 {
-  acquireWriteLock(&self->tableLock);
-  HASH_DEL(*((CacheEntry**)&self->table), cEntry);
-  unlockWriteLock(&self->tableLock);
+  PathUpdates* pUpdates = NULL;
+  PathUpdates* tmp      = NULL;
+
+  HASH_ITER(hh, (PathUpdates*)shard->pathIndex, pUpdates, tmp)
+  {
+    HASH_DEL(*((PathUpdates**)&shard->pathIndex), pUpdates);
+    free(pUpdates->updateIDs);
+    free(pUpdates);
+  }
+  shard->pathIndex = NULL;
 }
 
 /*--------
@@ -297,31 +558,57 @@ static void tableDel(UpdateCache* self, CacheEntry* cEntry)
 bool createUpdateCache(UpdateCache* self, UpdateResultChanged chCallback,
                        uint8_t minNumberOfClients, Configuration* sysConfig)
 {
-  if (!initMutex(&self->itemMutex))
+  UC_Shard* shard = NULL;
+  int idx;
+
+  if (!initMutex(&self->clientMutex))
+  {
+    RAISE_ERROR("Unable to setup the client Mutex");
+    return false;
+  }
+
+  for (idx = 0; idx < UC_NUM_SHARDS; idx++)
+  {
+    shard = &self->shards[idx];
+    if (!initMutex(&shard->itemMutex))
+    {
+      RAISE_ERROR("Unable to setup the item Mutex");
+      return false;
+    }
+    if (!createRWLock(&shard->tableLock))
+    {
+      RAISE_ERROR("Unable to setup the hash table r/w lock");
+      releaseMutex(&shard->itemMutex);
+      return false;
+    }
+    // By default keep the hashtable null, it will be initialized with the 
+    // first element that will be added.
+    shard->table     = NULL;
+    shard->pathIndex = NULL;
+  }
+
+  if (!initMutex(&self->gcMutex) || !initCond(&self->gcCond))
   {
-    RAISE_ERROR("Unable to setup the item Mutex");
+    RAISE_ERROR("Unable to setup the garbage collector Mutex");
     return false;
   }
-  if (!createRWLock(&self->tableLock))
+  if (!initEpochDomain(&self->gcReaders))
   {
-    RAISE_ERROR("Unable to setup the hash table r/w lock");
-    releaseMutex(&self->itemMutex);
+    RAISE_ERROR("Unable to setup the garbage collector readers");
     return false;
   }
+  initTimerWheel(&self->gcWheel, getGCTime(0));
+  memset(&self->gcStats, 0, sizeof(UC_GCStats));
+  self->gcRunning   = false;
+  self->prefixCache = NULL;
+  self->aspathCache = NULL;
 
   self->resChangedCallback = chCallback;
-  // By default keep the hashtable null, it will be initialized with the first
-  // element that will be added.
-  self->table = NULL;
-  self->itemsUsed = NUM_PREALLOC;
   self->minNumberOfClients = minNumberOfClients;
-  self->lockedClients = malloc(MAX_PROXY_CLIENT_ELEMENTS);
-  memset(self->lockedClients, false, MAX_PROXY_CLIENT_ELEMENTS);
+  self->lockedClients = calloc(MAX_PROXY_CLIENT_ELEMENTS, sizeof(uint32_t));
 
   self->sysConfig = sysConfig;
 
-  initSList(&self->allItems);
-
   return true;
 }
 
@@ -329,15 +616,24 @@ bool createUpdateCache(UpdateCache* self, UpdateResultChanged chCallback,
 void releaseUpdateCache(UpdateCache* self)
 {
   RAISE_ERROR("Release Update Cache also should empty the cache first!");
+  int idx;
+
   if (self != NULL)
   {
-    releaseRWLock(&self->tableLock);
-    releaseMutex(&self->itemMutex);
-
-    // Empty cache first
+    // Stop the garbage collector and empty cache first
+    stopUpdateCacheGC(self);
     emptyUpdateCache(self);
     free(self->lockedClients);
-    releaseSList(&self->allItems);
+    releaseMutex(&self->clientMutex);
+
+    for (idx = 0; idx < UC_NUM_SHARDS; idx++)
+    {
+      releaseRWLock(&self->shards[idx].tableLock);
+      releaseMutex(&self->shards[idx].itemMutex);
+    }
+    destroyCond(&self->gcCond);
+    releaseMutex(&self->gcMutex);
+    releaseEpochDomain(&self->gcReaders);
   }
 }
 
@@ -375,8 +671,26 @@ bool getUpdateResult(UpdateCache* self, SRxUpdateID* updateID,
   // but store it as value only. See documentation for SRxUpdateID for more info
   SRxUpdateID updID = *updateID;
 
-  // Look for the update
-  if (tableFind(self, updID, &cEntry))
+  // Look for the update and register the update with the client. An update
+  // that was reclaimed by the garbage collector meanwhile is not found.
+  enterEpoch(&self->gcReaders);
+  if (tableFind(self, updID, &cEntry) && (clientID > 0))
+  {
+    UC_Shard* shard = _getShard(self, updID);
+    lockMutex(&shard->itemMutex);
+    if (cEntry->gcReclaimed)
+    {
+      cEntry = NULL;
+    }
+    else
+    {
+      _addClientReference(self, cEntry, clientID,
+                          (ProxyClientMapping*)clientMapping);
+    }
+    unlockMutex(&shard->itemMutex);
+  }
+
+  if (cEntry != NULL)
   {
     // Prefix Origin values
     srxRes->roaResult               = cEntry->srxResult.roaResult;
@@ -396,13 +710,6 @@ bool getUpdateResult(UpdateCache* self, SRxUpdateID* updateID,
     if (pathId != NULL)
       *pathId = cEntry->aspathCacheID; 
 
-    if (clientID > 0)
-    {
-      // Register the update with the client!
-      _addClientReference(self, cEntry, clientID,
-                          (ProxyClientMapping*)clientMapping);
-    }
-
     retVal = true;
   }
   else
@@ -421,6 +728,7 @@ bool getUpdateResult(UpdateCache* self, SRxUpdateID* updateID,
     defaultRes->resSourceASPA     = SRxRS_DONOTUSE;
     defaultRes->result.aspaResult = SRx_RESULT_DONOTUSE;
   }
+  leaveEpoch(&self->gcReaders);
 
   return retVal;
 }
@@ -452,8 +760,6 @@ bool _addClientReference(UpdateCache* self, CacheEntry* cEntry,
     if (cEntry->clients[idx]==0)
     {
       cEntry->clients[idx] = clientID;
-      //TODO: depending on the final GC implementation if the GC uses a delete
-      //      list, remove this cEntry from there in case gcFlag > 0
       // Increase the update count of this client
       clientMapping->updateCount++;
       added = true;
@@ -466,11 +772,7 @@ bool _addClientReference(UpdateCache* self, CacheEntry* cEntry,
     }
   }
 
-  if (added)
-  {
-    cEntry->gcFlag       = 0; // Reset the GC flag
-  }
-  else
+  if (!added)
   { // run out of memory, increase the array list
     // TODO: Maybe set a counter flag in UpdateCahce. this flag
     // could be used to automatically increase the minimum number of clients
@@ -478,14 +780,27 @@ bool _addClientReference(UpdateCache* self, CacheEntry* cEntry,
     // be 1000 extensions or even configured?
 
     int newSize = cEntry->noPossibleClients + self->minNumberOfClients;
-    cEntry->clients = realloc(cEntry->clients, newSize);
+    uint8_t* clients = NULL;
+    // noPossibleClients is stored in one byte and also gives the size of the
+    // memory when releasing it.
+    if (newSize > UINT8_MAX)
+    {
+      newSize = UINT8_MAX;
+    }
+    if (newSize > cEntry->noPossibleClients)
+    {
+      clients = allocSlabData(newSize);
+    }
 
-    if (cEntry->clients)
+    if (clients)
     {
+      memcpy(clients, cEntry->clients, cEntry->noPossibleClients);
       for (idx = cEntry->noPossibleClients; idx < newSize; idx++)
       { // initialize with zero "0"
-        cEntry->clients[idx] = (uint8_t)0;
+        clients[idx] = (uint8_t)0;
       }
+      freeSlabData(cEntry->clients, cEntry->noPossibleClients);
+      cEntry->clients = clients;
       // Now add the new client
       cEntry->clients[cEntry->noPossibleClients] = clientID;
       cEntry->noPossibleClients = (uint8_t)newSize;
@@ -498,6 +813,11 @@ bool _addClientReference(UpdateCache* self, CacheEntry* cEntry,
     }
   }
 
+  if (added && (cEntry->gcFlag != 0))
+  {
+    setGCFlag(self, cEntry, 0); // Reset the GC flag
+  }
+
   return added;
 }
 
@@ -541,9 +861,11 @@ bool _addClientReference(UpdateCache* self, CacheEntry* cEntry,
  */
 int storeUpdate(UpdateCache* self, uint8_t clientID, void* clientMapping,
                 SRxUpdateID* updateID, IPPrefix* prefix, uint32_t asn,
-                SRxDefaultResult* defRes, BGPSecData* bgpData, uint32_t pathId)
+                SRxDefaultResult* defRes, BGPSecData* bgpData, uint32_t pathId,
+                uint64_t digest)
 {
   CacheEntry* cEntry;
+  UC_Shard*   shard;
 
   int retVal = 1; // by default report it worked
 
@@ -551,6 +873,7 @@ int storeUpdate(UpdateCache* self, uint8_t clientID, void* clientMapping,
   // become MD5 or even more. For this we accept a pointer to the structure
   // but store it as value only. See documentation for SRxUpdateID for more info
   SRxUpdateID updID = *updateID;
+  shard = _getShard(self, updID);
 
   LOG(LEVEL_DEBUG, HDR "Store update [ID:0x%08X] in update cache.",
                    pthread_self(), updID);
@@ -560,41 +883,29 @@ int storeUpdate(UpdateCache* self, uint8_t clientID, void* clientMapping,
   {
     LOG(LEVEL_WARNING, "Attempt to store an update that already exists in "
                        "update cache!");
+    _releaseUpdatePath(self, pathId);
     retVal = 0;
   }
   else
   {
-    // The update will be stored in two phases, first it will be stored in the
-    // update list that is accessible from outside. The the update information
-    // will be stored in the hash table.
-
-    // Store a brand new update in the list
+    // The update will be initialized first and then stored in the hash table.
     // New entry
-    lockMutex(&self->itemMutex);
-
-    if (self->itemsUsed == NUM_PREALLOC)
+    cEntry = allocFromSlab(&_entryPool);
+    if (cEntry == NULL)
     {
-      // In case the pre-allocated empty space is used up, create more.
-      self->availItems = appendToSList(&self->allItems,
-                                       sizeof(CacheEntry) * NUM_PREALLOC);
-      if (self->availItems == NULL)
-      {
-        return -1;
-      }
-      self->itemsUsed = 0;
+      RAISE_SYS_ERROR("Not enough memory to store update [0x%08X]!", updID);
+      _releaseUpdatePath(self, pathId);
+      return -1;
     }
+    memset(cEntry, 0, sizeof(CacheEntry));
+    initTimer(&cEntry->gcTimer);
 
-    // now get the new accessible space.
-    cEntry = (CacheEntry*)(self->availItems
-                           + (self->itemsUsed * sizeof(CacheEntry)));
-    // mark the entry as used for now.
-    self->itemsUsed++;
-
-  //    unlockMutex(&self->itemMutex);
+    lockMutex(&shard->itemMutex);
 
     cEntry->updateID      = updID;
     cEntry->asn           = asn;
     cEntry->aspathCacheID = pathId;
+    cEntry->digest        = digest;
     cpyPrefix(&cEntry->prefix, prefix);
     cEntry->srxResult.bgpsecResult = SRx_RESULT_UNDEFINED;
     cEntry->srxResult.roaResult    = SRx_RESULT_UNDEFINED;
@@ -637,25 +948,11 @@ int storeUpdate(UpdateCache* self, uint8_t clientID, void* clientMapping,
       // in this case we do not need to register the update with the ski cache.
       // it is already in
     }
-    else
-    {
-      // If this here throws a SEGDEV then it is time to replace the SList
-      // implementation
-      UC_UpdateData* data = &cEntry->pathData;
-      if (data->bgpsec_path != NULL)
-      {
-        free(data->bgpsec_path);
-      }
-      if (data->asn_path != NULL)
-      {
-        free(data->asn_path);
-      }
-      memset(data, 0, sizeof(UC_UpdateData));
-    }
+    // else the path data is already zeroed out.
 
     // Add the client ID to the update
     int memsize = sizeof(uint8_t) * self->minNumberOfClients;
-    cEntry->clients = malloc(memsize);
+    cEntry->clients = allocSlabData(memsize);
     memset(cEntry->clients, 0, memsize);
     cEntry->noPossibleClients = self->minNumberOfClients;
 
@@ -674,19 +971,58 @@ int storeUpdate(UpdateCache* self, uint8_t clientID, void* clientMapping,
     }
     else
     {
-      // Mark for GC
-      uint16_t keepWindow = (uint16_t)self->sysConfig->defaultKeepWindow;
-      cEntry->gcFlag = getGCTime(keepWindow);
+      // Mark for GC, the garbage collector ignores the entry until it is
+      // found in the hash table.
+      setGCFlag(self, cEntry, getGCTime(self->sysConfig->defaultKeepWindow));
     }
 
+    unlockMutex(&shard->itemMutex);
+
     // Finally add the entry to cache.
     tableAdd(self, cEntry);
-
-    unlockMutex(&self->itemMutex);
   }
   return retVal;
 }
 
+/**
+ * Reserve the AS path for an update that is about to be stored. Must be called
+ * before the AS path is looked up in or added to the AS path cache. As long as
+ * the reservation exists, the garbage collector does not remove the AS path 
+ * from the AS path cache. storeUpdate takes over the reservation.
+ *
+ * @param self The update cache.
+ * @param pathId The AS path cache key ID, 0 is ignored.
+ *
+ * @return false if not enough memory is available.
+ *
+ * @since 0.6.2.0
+ */
+bool reserveUpdatePath(UpdateCache* self, uint32_t pathId)
+{
+  UC_Shard*    shard    = _getShard(self, pathId);
+  PathUpdates* pUpdates = NULL;
+
+  if (pathId == 0)
+  {
+    return true;
+  }
+
+  acquireWriteLock(&shard->tableLock);
+  pUpdates = _pathIndexGet(shard, pathId);
+  if (pUpdates != NULL)
+  {
+    pUpdates->pending++;
+  }
+  unlockWriteLock(&shard->tableLock);
+
+  if (pUpdates == NULL)
+  {
+    RAISE_ERROR("Not enough memory to reserve the AS path [0x%08X]", pathId);
+  }
+
+  return pUpdates != NULL;
+}
+
 /**
  * Stores a result for in the update cache for later retrieval. If this
  * overwrites an existing update result, then the registered
@@ -724,6 +1060,7 @@ bool modifyUpdateResult(UpdateCache* self, SRxUpdateID* updateID,
   SRxUpdateID updID = *updateID;
 
   // Existing entry then only update the result values.
+  enterEpoch(&self->gcReaders);
   if (!tableFind(self, updID, &cEntry))
   {
     RAISE_SYS_ERROR("Does not exist in update cache, can not modify it!");
@@ -731,7 +1068,8 @@ bool modifyUpdateResult(UpdateCache* self, SRxUpdateID* updateID,
   }
   else
   {
-    lockMutex(&self->itemMutex);
+    UC_Shard* shard = _getShard(self, updID);
+    lockMutex(&shard->itemMutex);
 
     SRxValidationResult valRes;
     valRes.updateID = updID;
@@ -792,8 +1130,9 @@ bool modifyUpdateResult(UpdateCache* self, SRxUpdateID* updateID,
       }
     }
 
-    unlockMutex(&self->itemMutex);
+    unlockMutex(&shard->itemMutex);
   }
+  leaveEpoch(&self->gcReaders);
 
   return retVal;
 }
@@ -806,6 +1145,7 @@ bool modifyUpdateCacheResultWithAspaVal(UpdateCache* self, SRxUpdateID* updateID
   bool retVal = false;
   SRxUpdateID updID = *updateID;
 
+  enterEpoch(&self->gcReaders);
   if (!tableFind(self, updID, &cEntry))
   {
     RAISE_SYS_ERROR("Does not exist in update cache, can not modify aspa result!");
@@ -813,7 +1153,8 @@ bool modifyUpdateCacheResultWithAspaVal(UpdateCache* self, SRxUpdateID* updateID
   }
   else
   {
-    lockMutex(&self->itemMutex);
+    UC_Shard* shard = _getShard(self, updID);
+    lockMutex(&shard->itemMutex);
 
     // Check if ASPA srxResult_aspas can be used.
     if (srxResult_aspa->aspaResult != SRx_RESULT_DONOTUSE)
@@ -827,88 +1168,54 @@ bool modifyUpdateCacheResultWithAspaVal(UpdateCache* self, SRxUpdateID* updateID
       }
     }
 
-    unlockMutex(&self->itemMutex);
+    unlockMutex(&shard->itemMutex);
   }
+  leaveEpoch(&self->gcReaders);
   return retVal;
 }
 
 /**
- * Try to finally delete the update.
- *
- * @param self The Update cache
- * @param cEntry The cache entry (update)
- * @param pCache The prefix cache.
- * @param force  Force the deletion of the update. This ignores if the update is
- *               still referenced by clients.
+ * Set the time when the update can be garbage collected and schedule it with
+ * the garbage collector. The caller MUST hold the item mutex of the shard.
  *
- * @return true if the update was deleted, otherwise false/
- *
- * @since 0.3.0
+ * @param self The update cache
+ * @param cEntry The cache entry - update
+ * @param timeOfDeletion The GC time when the update can be deleted, 0 removes
+ *                       the update from the garbage collector.
  */
-bool gcTestAndDeleteUpdate(UpdateCache* self, CacheEntry* cEntry,
-                           void* pCache, bool force)
+void setGCFlag(UpdateCache* self, CacheEntry* cEntry, uint32_t timeOfDeletion)
 {
-  //TODO: Test one last time if the update can be deleted. If so then delete it.
-  // This method MUST be called by the garbage collector.
-  LOG(LEVEL_INFO,"IMPLEMENTATION CAN BE EXPECTED WITH VERSION 0.4");
-  bool delete = !force;
-
-  if (!force)
-  {
-    // 1. CHECK IF GC TIME IS READY
-
-    // 2. CHECK ONE MORE TIME IF NO REFERENCE EXISTS
-  }
-
-  if (delete)
+  cEntry->gcFlag = timeOfDeletion;
+  if (!cEntry->gcReclaimed)
   {
-    if (!removeUpdate((PrefixCache*)pCache, &cEntry->updateID, &cEntry->prefix,
-                      cEntry->asn))
+    lockMutex(&self->gcMutex);
+    if (timeOfDeletion != 0)
     {
-      // The reason might be that the update was not validated. (stored only)
-      LOG(LEVEL_WARNING, "Could not delete the update 0x08X from the prefix "
-                         "cache!");
+      scheduleTimer(&self->gcWheel, &cEntry->gcTimer, timeOfDeletion);
     }
-
-    // now remove it from the update cache
-    // Does not release the memory but only removes the hash table entry
-    tableDel(self, cEntry);
-    // Now remove it from the allItems list of the cache
-    deleteFromSList(&self->allItems, cEntry);
-
-    // Free the memory of the bgpsec blob;
-    _cleanCachPathData(cEntry);
-    // Free the cache entry.
-    free(cEntry);
+    else
+    {
+      cancelTimer(&self->gcWheel, &cEntry->gcTimer);
+    }
+    unlockMutex(&self->gcMutex);
   }
-
-  return delete;
-}
-
-/**
- * Set the flag when the update can be garbage collected.
- *
- * @param cEntry The cache entry - update
- * @param timeOfDeletion The GC time when the update can be deleted.
- */
-void setGCFlag(CacheEntry* cEntry, uint16_t timeOfDeletion)
-{
-  cEntry->gcFlag = timeOfDeletion;
 }
 
 /**
  * Calculates a new GC time when to run.
  *
- * @param keepTime The proposed time to wait
+ * @param keepTime The proposed time to wait in seconds
  *
- * @return the next time the GC can run. Notice that this timestamp is a 16 bit,
- *         NOT 32 bit number. The Garbage collector knows how to deal with
- *         overflows
+ * @return the next time the GC can run. The time is taken from the monotonic
+ *         clock in seconds and never 0. The Garbage collector knows how to
+ *         deal with overflows
  */
-uint16_t getGCTime(uint16_t keepTime)
+uint32_t getGCTime(uint32_t keepTime)
 {
-  time_t nextRealTime = time(NULL) + keepTime;
-  return (uint16_t)(nextRealTime);
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  uint32_t gcTime = (uint32_t)now.tv_sec + keepTime;
+  return gcTime != 0 ? gcTime : 1;
 }
 
 /**
@@ -981,7 +1288,7 @@ int _deleteUpdateFromCache_clientMgmt(CacheEntry* entry, uint8_t clientID)
  *              the client was found.
  */
 int _deleteUpdateFromCache(UpdateCache* self, uint8_t clientID,
-                           CacheEntry*  cEntry, uint16_t timeOfDeletion)
+                           CacheEntry*  cEntry, uint32_t timeOfDeletion)
 {
   bool retVal = false;
 
@@ -995,7 +1302,7 @@ int _deleteUpdateFromCache(UpdateCache* self, uint8_t clientID,
       retVal = false;
       break;
     case 0 : // no reference left
-      setGCFlag(cEntry, timeOfDeletion);
+      setGCFlag(self, cEntry, timeOfDeletion);
     case 1 : // still some left, don't delete
     default:
       retVal = true;
@@ -1005,9 +1312,9 @@ int _deleteUpdateFromCache(UpdateCache* self, uint8_t clientID,
 }
 
 /**
- * Removes the update data from the list and releases all memory associated to
- * it. Also, if this update contains bgpsec blob, it will remove this
- * update from the SKI Cache.
+ * Removes the association of the client to the update. The update is
+ * scheduled for the garbage collector if no further client uses it, the
+ * garbage collector also removes the update from the SKI Cache.
  *
  * @note This method ONLY deletes the update from the update cache. It is
  *       important to assure that other references such as the prefix_cache
@@ -1040,32 +1347,371 @@ bool deleteUpdateFromCache(UpdateCache* self, uint8_t clientID,
   {
     keepTime = self->sysConfig->defaultKeepWindow;
   }
-  uint16_t timeToBeDeleted = getGCTime(keepTime);
+  uint32_t timeToBeDeleted = getGCTime(keepTime);
 
   // Get the update cache entry from the update cache.
+  enterEpoch(&self->gcReaders);
   if (tableFind(self, updID, &cEntry))
   {
-    retVal = _deleteUpdateFromCache(self, clientID, cEntry, timeToBeDeleted);
-    if (retVal && (cEntry->pathData.bgpsec_path != NULL))
+    UC_Shard* shard = _getShard(self, updID);
+    lockMutex(&shard->itemMutex);
+    retVal = !cEntry->gcReclaimed
+             && _deleteUpdateFromCache(self, clientID, cEntry, timeToBeDeleted);
+    unlockMutex(&shard->itemMutex);
+  }
+  else
+  {
+    LOG(LEVEL_INFO, "Delete aborted, update [0x%08X] not found!", updID);
+  }
+  leaveEpoch(&self->gcReaders);
+
+  return retVal;
+}
+
+/*-------------------
+ * Garbage collector
+ */
+
+/**
+ * Return the memory used by the cache entry including its path data and
+ * client list.
+ *
+ * @param cEntry The cache entry.
+ *
+ * @return The size in bytes.
+ *
+ * @since 0.6.2.0
+ */
+static uint64_t _getCacheEntrySize(CacheEntry* cEntry)
+{
+  return sizeof(CacheEntry) + (cEntry->pathData.hops * 4)
+         + cEntry->pathData.length + cEntry->noPossibleClients;
+}
+
+/**
+ * Determine if any client uses the update.
+ *
+ * @param cEntry The cache entry.
+ *
+ * @return true if at least one client is registered with the update.
+ *
+ * @since 0.6.2.0
+ */
+static bool _hasClients(CacheEntry* cEntry)
+{
+  int idx;
+
+  for (idx = 0; idx < cEntry->noPossibleClients; idx++)
+  {
+    if (cEntry->clients[idx] != 0)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Remove the expired update from the hash table if it is still unused. The
+ * update is only removed if it was not scheduled again and no client
+ * registered meanwhile. An update that is not stored in the hash table yet is
+ * scheduled for the next pass.
+ *
+ * @param self The update cache.
+ * @param cEntry The expired update.
+ *
+ * @return true if the update was removed from the hash table.
+ *
+ * @since 0.6.2.0
+ */
+static bool _gcUnlinkUpdate(UpdateCache* self, CacheEntry* cEntry)
+{
+  UC_Shard*   shard  = _getShard(self, cEntry->updateID);
+  CacheEntry* stored = NULL;
+  bool        unlink = false;
+
+  acquireWriteLock(&shard->tableLock);
+  lockMutex(&shard->itemMutex);
+  lockMutex(&self->gcMutex);
+  if (   (cEntry->gcFlag != 0) && !isTimerScheduled(&cEntry->gcTimer)
+      && !_hasClients(cEntry))
+  {
+    HASH_FIND(hh, (CacheEntry*)shard->table, &cEntry->updateID,
+              sizeof(SRxUpdateID), stored);
+    if (stored == cEntry)
+    {
+      HASH_DEL(*((CacheEntry**)&shard->table), cEntry);
+      cEntry->gcReclaimed = true;
+      unlink = true;
+    }
+    else
+    {
+      // storeUpdate did not add it to the hash table yet.
+      scheduleTimer(&self->gcWheel, &cEntry->gcTimer,
+                    getGCTime(UC_GC_INTERVAL));
+    }
+  }
+  unlockMutex(&self->gcMutex);
+  unlockMutex(&shard->itemMutex);
+  unlockWriteLock(&shard->tableLock);
+
+  return unlink;
+}
+
+/**
+ * Remove all references of the other caches to the update that was removed
+ * from the hash table.
+ *
+ * @param self The update cache.
+ * @param cEntry The removed update.
+ *
+ * @since 0.6.2.0
+ */
+static void _gcUnregisterUpdate(UpdateCache* self, CacheEntry* cEntry)
+{
+  // Removes the AS path from the AS path cache if no other update uses it.
+  if (cEntry->aspathCacheID != 0)
+  {
+    pathIndexDel(self, cEntry);
+  }
+
+  // The locks are released already, the update might be stored again with the
+  // same id meanwhile. The prefix cache keeps the update in this case.
+  // The update is not in the prefix cache if it was never validated.
+  if (self->prefixCache != NULL)
+  {
+    removeUpdate((PrefixCache*)self->prefixCache, &cEntry->updateID,
+                 &cEntry->prefix, cEntry->asn);
+  }
+
+  // The SKI cache counts the registrations of each update id, a registration
+  // of the update stored again is not affected.
+  if (cEntry->pathData.bgpsec_path != NULL)
+  {
+    if (!ski_unregisterUpdate(getSKICache(), &cEntry->updateID,
+                              cEntry->pathData.bgpsec_path))
+    {
+      LOG(LEVEL_WARNING, "Could not unregister update [0x%08X] from the ski "
+                         "cache!", cEntry->updateID);
+    }
+  }
+}
+
+/**
+ * Release the updates that were removed with the previous pass. Waits until
+ * no reader can use them anymore.
+ *
+ * @param self The update cache.
+ * @param limbo The list of removed updates.
+ *
+ * @since 0.6.2.0
+ */
+static void _gcReleaseUpdates(UpdateCache* self, CacheEntry* limbo)
+{
+  CacheEntry* next = NULL;
+
+  if (limbo != NULL)
+  {
+    synchronizeEpoch(&self->gcReaders);
+  }
+
+  while (limbo != NULL)
+  {
+    next = limbo->gcNext;
+    _releaseCacheEntry(limbo);
+    limbo = next;
+  }
+}
+
+/**
+ * The garbage collector thread. With each pass it takes the expired updates
+ * from the timing wheel, removes the unused ones from all caches and releases
+ * the updates removed with the previous pass.
+ *
+ * @param arg The update cache.
+ *
+ * @return NULL
+ *
+ * @since 0.6.2.0
+ */
+static void* _gcThread(void* arg)
+{
+  UpdateCache* self     = (UpdateCache*)arg;
+  CacheEntry*  expired  = NULL;
+  CacheEntry*  limbo    = NULL;
+  CacheEntry*  cEntry   = NULL;
+  TW_Timer*    timer    = NULL;
+  uint64_t     bytes    = 0;
+  uint32_t     count    = 0;
+
+  LOG(LEVEL_DEBUG, HDR "Garbage collector started", pthread_self());
+
+  lockMutex(&self->gcMutex);
+  while (self->gcRunning)
+  {
+    waitCond(&self->gcCond, &self->gcMutex, UC_GC_INTERVAL * 1000);
+    if (!self->gcRunning)
+    {
+      break;
+    }
+
+    // The timers of the expired updates can be scheduled again as soon as the
+    // mutex is released, therefore link the updates in their own list.
+    expired = NULL;
+    timer   = advanceTimerWheel(&self->gcWheel, getGCTime(0));
+    while (timer != NULL)
+    {
+      cEntry = (CacheEntry*)((char*)timer - offsetof(CacheEntry, gcTimer));
+      timer  = timer->next;
+      cEntry->gcNext = expired;
+      expired = cEntry;
+    }
+    unlockMutex(&self->gcMutex);
+
+    // Release the updates removed with the previous pass.
+    _gcReleaseUpdates(self, limbo);
+    limbo   = NULL;
+    bytes   = 0;
+    count   = 0;
+
+    while (expired != NULL)
     {
-      // Unregister the update from the SKI CACHE.
-      SKI_CACHE* sCache = getSKICache();
-      UC_UpdateData* data = &cEntry->pathData;
-      if (!ski_unregisterUpdate(sCache, updateID, data->bgpsec_path))
+      cEntry  = expired;
+      expired = cEntry->gcNext;
+      if (_gcUnlinkUpdate(self, cEntry))
       {
-        LOG(LEVEL_WARNING, "Could not unregister update [0x%08X] from the ski "
-                           "cache!", updID);
+        _gcUnregisterUpdate(self, cEntry);
+        bytes += _getCacheEntrySize(cEntry);
+        count++;
+        cEntry->gcNext = limbo;
+        limbo = cEntry;
       }
     }
+
+    lockMutex(&self->gcMutex);
+    self->gcStats.passes++;
+    self->gcStats.reclaimed      += count;
+    self->gcStats.reclaimedBytes += bytes;
+    self->gcStats.deferred        = count;
+    if (count > 0)
+    {
+      LOG(LEVEL_DEBUG, HDR "Garbage collector removed %u updates",
+          pthread_self(), count);
+    }
   }
-  else
+  self->gcStats.deferred = 0;
+  unlockMutex(&self->gcMutex);
+
+  _gcReleaseUpdates(self, limbo);
+
+  LOG(LEVEL_DEBUG, HDR "Garbage collector stopped", pthread_self());
+  return NULL;
+}
+
+/**
+ * Start the garbage collector thread. Updates that are not used by any client
+ * anymore are removed once their keep time passed. The given caches are
+ * cleaned from the removed updates.
+ *
+ * @param self The update cache
+ * @param prefixCache The prefix cache (PrefixCache*), can be NULL.
+ * @param aspathCache The AS path cache (AspathCache*), can be NULL.
+ *
+ * @return true if the garbage collector is running.
+ *
+ * @since 0.6.2.0
+ */
+bool startUpdateCacheGC(UpdateCache* self, void* prefixCache,
+                        void* aspathCache)
+{
+  bool retVal = true;
+
+  lockMutex(&self->gcMutex);
+  if (!self->gcRunning)
   {
-    LOG(LEVEL_INFO, "Delete aborted, update [0x%08X] not found!", updID);
+    self->prefixCache = prefixCache;
+    self->aspathCache = aspathCache;
+    self->gcRunning   = true;
+    if (pthread_create(&self->gcThread, NULL, _gcThread, self) != 0)
+    {
+      RAISE_SYS_ERROR("Could not start the update cache garbage collector!");
+      self->gcRunning = false;
+      retVal = false;
+    }
   }
+  unlockMutex(&self->gcMutex);
 
   return retVal;
 }
 
+/**
+ * Stop the garbage collector thread and wait for it to terminate. Nothing
+ * happens if the garbage collector is not running.
+ *
+ * @param self The update cache
+ *
+ * @since 0.6.2.0
+ */
+void stopUpdateCacheGC(UpdateCache* self)
+{
+  bool running;
+
+  lockMutex(&self->gcMutex);
+  running = self->gcRunning;
+  self->gcRunning = false;
+  signalCond(&self->gcCond);
+  unlockMutex(&self->gcMutex);
+
+  if (running)
+  {
+    pthread_join(self->gcThread, NULL);
+  }
+}
+
+/**
+ * Return the statistics of the garbage collector.
+ *
+ * @param self The update cache
+ * @param stats OUT parameter receiving the statistics.
+ *
+ * @since 0.6.2.0
+ */
+void getUpdateCacheGCStats(UpdateCache* self, UC_GCStats* stats)
+{
+  lockMutex(&self->gcMutex);
+  *stats = self->gcStats;
+  stats->scheduled = self->gcWheel.count;
+  unlockMutex(&self->gcMutex);
+}
+
+/**
+ * Enter a read section of the update cache. The garbage collector does not 
+ * release any update that was removed while the read section was open. 
+ * Read sections can be nested but MUST NOT be kept open while waiting for
+ * the garbage collector.
+ *
+ * @param self The update cache
+ *
+ * @since 0.6.2.0
+ */
+void enterUpdateCacheReader(UpdateCache* self)
+{
+  enterEpoch(&self->gcReaders);
+}
+
+/**
+ * Leave the read section of the update cache.
+ *
+ * @param self The update cache
+ *
+ * @since 0.6.2.0
+ */
+void leaveUpdateCacheReader(UpdateCache* self)
+{
+  leaveEpoch(&self->gcReaders);
+}
+
 /**
  * This function returns the update signature if already existent. It will NOT
  * start the signing. If no signature exists the return value is NULL
@@ -1132,13 +1778,17 @@ bool getUpdateStats(UpdateCache* self, UC_UpdateStatistics* statistics)
   if (statistics == NULL)
   {
     RAISE_SYS_ERROR("The given statistics block is NULL!");
+    return false;
   }
   else if (*statistics->updateID == 0)
   {
     RAISE_SYS_ERROR("The given updaetID is 0 (INVALID ID)!");
+    return false;
   }
+
   // Look for the update
-  else if (tableFind(self, *statistics->updateID, &cEntry))
+  enterEpoch(&self->gcReaders);
+  if (tableFind(self, *statistics->updateID, &cEntry))
   {
     retVal = true;
     statistics->asn                           = cEntry->asn;
@@ -1157,16 +1807,21 @@ bool getUpdateStats(UpdateCache* self, UC_UpdateStatistics* statistics)
     statistics->result.bgpsecResult = cEntry->srxResult.bgpsecResult;
     statistics->roa_count           = cEntry->roaRefCount;
   }
+  leaveEpoch(&self->gcReaders);
+
   return retVal;
 }
 
 /**
- * Return the cache internal copy of the update data.
+ * Return the cache internal copy of the update data. The data can be removed
+ * by the garbage collector at any time, therefore the caller MUST call this
+ * function and use the data within a read section (enterUpdateCacheReader).
  *
  * @param self The update cache
  * @param updateID The ID of the update
  *
- * @return the pointer to the internal stored bgp update data
+ * @return the pointer to the internal stored bgp update data or NULL if the
+ *         update is not stored (anymore).
  *
  * @since 0.5.0.0
  */
@@ -1174,13 +1829,11 @@ UC_UpdateData* getUpdateData(UpdateCache* self, SRxUpdateID* updateID)
 {
   CacheEntry* cEntry = NULL;
   UC_UpdateData* data = NULL;
-  SCA_BGP_PathAttribute* bgpsec_path = NULL;
 
-  // Look for the update
+  // Look for the update, the caller is within a read section.
   if (tableFind(self, *updateID, &cEntry))
   {
     data = &cEntry->pathData;
-    bgpsec_path = data->bgpsec_path;
   }
 
   return data;
@@ -1196,18 +1849,35 @@ UC_UpdateData* getUpdateData(UpdateCache* self, SRxUpdateID* updateID)
 void emptyUpdateCache(UpdateCache* self)
 {
   ////////////////////////////////////////////////////////////////////////////// TOUCHED(X); OK ( ); NOT YET ( ); Tested ( )
-  acquireWriteLock(&self->tableLock);
-  lockMutex(&self->itemMutex);
-  emptySList(&self->allItems);
+  UC_Shard*   shard  = NULL;
+  CacheEntry* cEntry = NULL;
+  CacheEntry* tmp    = NULL;
+  int idx;
+
+  for (idx = 0; idx < UC_NUM_SHARDS; idx++)
+  {
+    shard = &self->shards[idx];
+    acquireWriteLock(&shard->tableLock);
+    lockMutex(&shard->itemMutex);
+    lockMutex(&self->gcMutex);
+    HASH_ITER(hh, (CacheEntry*)shard->table, cEntry, tmp)
+    {
+      HASH_DEL(*((CacheEntry**)&shard->table), cEntry);
+      cancelTimer(&self->gcWheel, &cEntry->gcTimer);
+      _releaseCacheEntry(cEntry);
+    }
+    unlockMutex(&self->gcMutex);
+    unlockMutex(&shard->itemMutex);
+
+    shard->table     = NULL;
+    _emptyPathIndex(shard);
+
+    unlockWriteLock(&shard->tableLock);
+  }
+
   SKI_CACHE* sCache = getSKICache();
   // clean all updates from the update cache.
   ski_clean(sCache, SKI_CLEAN_UPDATES);
-  unlockMutex(&self->itemMutex);
-
-  self->table     = NULL;
-  self->itemsUsed = NUM_PREALLOC;
-
-  unlockWriteLock(&self->tableLock);
 }
 
 
@@ -1251,6 +1921,7 @@ int getClientIDsOfUpdate(UpdateCache* self, SRxUpdateID* updateID,
   int idx = 0;
 
   // Look for the update
+  enterEpoch(&self->gcReaders);
   if (tableFind(self, *updateID, &cEntry))
   {
     if (cEntry->noPossibleClients <= size)
@@ -1270,6 +1941,7 @@ int getClientIDsOfUpdate(UpdateCache* self, SRxUpdateID* updateID,
       retVal = -1;
     }
   }
+  leaveEpoch(&self->gcReaders);
 
   return retVal;
 }
@@ -1290,33 +1962,50 @@ int unregisterClientID(UpdateCache* self, uint8_t clientID, void* clientMapping,
                        uint32_t keepTime)
 {
   int idsRemoved = -1;
-  SListNode*  lNode;
   CacheEntry* cEntry;
+  CacheEntry* tmp;
+  UC_Shard*   shard;
+  uint32_t    timeToBeDeleted = getGCTime(keepTime);
+  int         idx;
+  bool        locked = true;
   ProxyClientMapping* mapping = (ProxyClientMapping*)clientMapping;
 
-  acquireWriteLock(&self->tableLock);
-  lockMutex(&self->itemMutex);
+  lockMutex(&self->clientMutex);
   if (!self->lockedClients[clientID])
   {
-    idsRemoved = 0;
     self->lockedClients[clientID]=true;
-    FOREACH_SLIST(&self->allItems, lNode)
+    locked = false;
+  }
+  unlockMutex(&self->clientMutex);
+
+  if (!locked)
+  {
+    idsRemoved = 0;
+    // Process the cache shard by shard
+    for (idx = 0; idx < UC_NUM_SHARDS && mapping->updateCount != 0; idx++)
     {
-      cEntry = (CacheEntry*)lNode->data;
-      if (cEntry != NULL)
+      shard = &self->shards[idx];
+      acquireWriteLock(&shard->tableLock);
+      lockMutex(&shard->itemMutex);
+      HASH_ITER(hh, (CacheEntry*)shard->table, cEntry, tmp)
       {
-        if (_deleteUpdateFromCache(self, clientID, cEntry, keepTime))
+        if (_deleteUpdateFromCache(self, clientID, cEntry, timeToBeDeleted))
         {
           idsRemoved++;
           mapping->updateCount--;
         }
+        if (mapping->updateCount == 0)
+        {
+          break;
+        }
       }
-      if (mapping->updateCount == 0)
-      {
-        break;
-      }
+      unlockMutex(&shard->itemMutex);
+      unlockWriteLock(&shard->tableLock);
     }
+
+    lockMutex(&self->clientMutex);
     self->lockedClients[clientID]=false;
+    unlockMutex(&self->clientMutex);
   }
   else
   {
@@ -1324,8 +2013,6 @@ int unregisterClientID(UpdateCache* self, uint8_t clientID, void* clientMapping,
                      "cache!", clientID);
 
   }
-  unlockMutex(&self->itemMutex);
-  unlockWriteLock(&self->tableLock);
 
   return idsRemoved;
 }
@@ -1345,7 +2032,7 @@ int unregisterClientID(UpdateCache* self, uint8_t clientID, void* clientMapping,
  * @return true if a collision could be detected!
  */
 bool detectCollision(UpdateCache* self, SRxUpdateID* updateID, IPPrefix* prefix,
-                     uint32_t asn, BGPSecData* bgpsecData)
+                     uint32_t asn, BGPSecData* bgpsecData, uint64_t digest)
 {
   CacheEntry* cEntry;
   UC_UpdateData* data;
@@ -1355,47 +2042,50 @@ bool detectCollision(UpdateCache* self, SRxUpdateID* updateID, IPPrefix* prefix,
   int length = 0;
 
   // Try to find the update itself.
+  enterEpoch(&self->gcReaders);
   if (tableFind(self, *updateID, &cEntry))
   {
     data = &cEntry->pathData;
 
-    // An update was found, now declare collision until it is determined that
-    // the update found is the same as the update requested.
-    collision = true;
-    if (cEntry->asn == asn)
+    // Different digests always identify different updates, only equal 
+    // digests require the comparison of the update data.
+    collision = cEntry->digest != digest;
+    if (!collision)
     {
-      if (data->hops == bgpsecData->numberHops)
+      // An update was found, now declare collision until it is determined 
+      // that the update found is the same as the update requested.
+      collision = true;
+      if (cEntry->asn == asn 
+          && data->hops == bgpsecData->numberHops
+          && data->length == bgpsecData->attr_length
+          && cEntry->prefix.length == prefix->length)
       {
         // Now check the ip prefix first, then the data blob
-        int  idx = 0;
+        // (4 bytes of v4 and v6 overlap)
         int  bytes = (cEntry->prefix.ip.version == 4) ? 4  : 16;
-        // collision will be set true as soon as a collision is found.
-        collision = false;
-        while (!collision && idx < bytes)
-        {
-          // 1. 4 bytes of v4 and v6 overlap
-          collision = (        prefix->ip.addr.v6.u8[bytes] !=
-                       cEntry->prefix.ip.addr.v6.u8[bytes]);
-          idx++;
-        }
+        collision = memcmp(prefix->ip.addr.v6.u8, 
+                           cEntry->prefix.ip.addr.v6.u8, bytes) != 0;
 
-        idx = 0;
         // Now check the BGP4 path - only if  not already collided
-        length = data->hops * 4;
-        u_int8_t* d1 = (u_int8_t*)data->asn_path;
-        u_int8_t* d2 = (u_int8_t*)bgpsecData->asPath;
-        collision = memcmp(d1, d2, length);
+        if (!collision)
+        {
+          length = data->hops * 4;
+          u_int8_t* d1 = (u_int8_t*)data->asn_path;
+          u_int8_t* d2 = (u_int8_t*)bgpsecData->asPath;
+          collision = memcmp(d1, d2, length) != 0;
+        }
 
         // Now check the BGPsec_PATH
         if (!collision)
         {
           u_int8_t* d1 = (u_int8_t*)data->bgpsec_path;
           u_int8_t* d2 = bgpsecData->bgpsec_path_attr;
-          collision = memcmp(d1, d2, data->length);
+          collision = memcmp(d1, d2, data->length) != 0;
         }
       }
     }
   }
+  leaveEpoch(&self->gcReaders);
 
   return collision;
 }
@@ -1487,8 +2177,11 @@ void outputUpdateCacheAsXML(UpdateCache* self, FILE* stream, int maxBlob)
 {
 #define CLIENT_LIST_STRING_LEN 1024
   XMLOut      out;
-  SListNode*  updateListNode;
   CacheEntry* update;
+  CacheEntry* tmp;
+  UC_Shard*   shard;
+  int         shIdx;
+  bool        hasUpdates = false;
   uint8_t     clIdx;
   uint8_t     noClients;
   char        clientString[CLIENT_LIST_STRING_LEN];
@@ -1501,75 +2194,86 @@ void outputUpdateCacheAsXML(UpdateCache* self, FILE* stream, int maxBlob)
   addU32Attrib(&out, "current-gc-time", getGCTime(0));
 
   // Updates
-  if (sizeOfSList(&self->allItems))
+  hasUpdates = getNumberOfUpdates(self) > 0;
+  if (hasUpdates)
   {
     openTag(&out, "updates");
-    FOREACH_SLIST(&self->allItems, updateListNode)
+    // Process the cache shard by shard
+    for (shIdx = 0; shIdx < UC_NUM_SHARDS; shIdx++)
     {
-      update = (CacheEntry*)getDataOfSListNode(updateListNode);
-      openTag(&out, "update");
-        addH32Attrib(&out, "update-id", update->updateID);
-        // noClients contains the number of clients used during the last run.
-        // the multiplicator "4" is used for the maximum space used for any
-        // client ID (3 char + comma)
-        memset(clientString, '\0', noClients*4);
-        noClients = 0;
-        strPtr = clientString;
-        for(clIdx = 0; clIdx < update->noPossibleClients; clIdx++)
-        {
-          if (update->clients[clIdx] != 0)
+      shard = &self->shards[shIdx];
+      acquireReadLock(&shard->tableLock);
+      lockMutex(&shard->itemMutex);
+      HASH_ITER(hh, (CacheEntry*)shard->table, update, tmp)
+      {
+        openTag(&out, "update");
+          addH32Attrib(&out, "update-id", update->updateID);
+          // noClients contains the number of clients used during the last run.
+          // the multiplicator "4" is used for the maximum space used for any
+          // client ID (3 char + comma)
+          memset(clientString, '\0', noClients*4);
+          noClients = 0;
+          strPtr = clientString;
+          for(clIdx = 0; clIdx < update->noPossibleClients; clIdx++)
           {
-            noClients++;
-            if (noClients == 1)
+            if (update->clients[clIdx] != 0)
             {
-              strPtr += sprintf(strPtr, "%u", update->clients[clIdx]);
-            }
-            else
-            {
-              strPtr += sprintf(strPtr, ",%u", update->clients[clIdx]);
+              noClients++;
+              if (noClients == 1)
+              {
+                strPtr += sprintf(strPtr, "%u", update->clients[clIdx]);
+              }
+              else
+              {
+                strPtr += sprintf(strPtr, ",%u", update->clients[clIdx]);
+              }
             }
           }
-        }
-        addU32Attrib(&out, "no-clients", noClients);
-        if (noClients > 0)
-        {
-          addStrAttrib(&out, "client-list", clientString);
-        }
-        addU32Attrib(&out, "gc", update->gcFlag);
-        addU32Attrib(&out, "origin-as", update->asn);
-        addAttrib(&out, "prefix", "%s/%u",
-                  ipToStr(&update->prefix.ip),
-                  update->prefix.length);
-        addIntAttrib(&out, "roa-count", update->roaRefCount);
-        if (!printXMLValResult(&out, "origin-val",
-                               update->srxResult.roaResult, true))
-        {
-          RAISE_ERROR("Update[0%x08X] with invalid origin validation state %d",
-                      update->updateID, update->srxResult.roaResult);
-        }
-        if (!printXMLValResult(&out, "path-val", update->srxResult.bgpsecResult,
-                               false))
-        {
-          RAISE_ERROR("Update[0%x08X] with invalid path validation state %d",
-                      update->updateID, update->srxResult.bgpsecResult);
-        }
-        if (!printXMLValResult(&out, "def-origin-val",
-                               update->defaultResult.result.roaResult, true))
-        {
-          RAISE_ERROR("Update[0%x08X] with invalid default origin validation "
-                      "state %d", update->updateID,
-                      update->defaultResult.result.roaResult);
-        }
-        if (!printXMLValResult(&out, "def-path-val",
-                               update->defaultResult.result.bgpsecResult, true))
-        {
-          RAISE_ERROR("Update[0%x08X] with invalid default path validation "
-                      "state %d", update->updateID,
-                      update->defaultResult.result.bgpsecResult);
-        }
-        addIntAttrib(&out, "hops", update->pathData.hops);
-        addIntAttrib(&out, "bgpsec-len", update->pathData.length);
-      closeTag(&out);
+          addU32Attrib(&out, "no-clients", noClients);
+          if (noClients > 0)
+          {
+            addStrAttrib(&out, "client-list", clientString);
+          }
+          addU32Attrib(&out, "gc", update->gcFlag);
+          addU32Attrib(&out, "origin-as", update->asn);
+          addAttrib(&out, "prefix", "%s/%u",
+                    ipToStr(&update->prefix.ip),
+                    update->prefix.length);
+          addIntAttrib(&out, "roa-count", update->roaRefCount);
+          if (!printXMLValResult(&out, "origin-val",
+                                 update->srxResult.roaResult, true))
+          {
+            RAISE_ERROR("Update[0%x08X] with invalid origin validation "
+                        "state %d", update->updateID,
+                        update->srxResult.roaResult);
+          }
+          if (!printXMLValResult(&out, "path-val",
+                                 update->srxResult.bgpsecResult, false))
+          {
+            RAISE_ERROR("Update[0%x08X] with invalid path validation state %d",
+                        update->updateID, update->srxResult.bgpsecResult);
+          }
+          if (!printXMLValResult(&out, "def-origin-val",
+                                 update->defaultResult.result.roaResult, true))
+          {
+            RAISE_ERROR("Update[0%x08X] with invalid default origin validation "
+                        "state %d", update->updateID,
+                        update->defaultResult.result.roaResult);
+          }
+          if (!printXMLValResult(&out, "def-path-val",
+                                 update->defaultResult.result.bgpsecResult,
+                                 true))
+          {
+            RAISE_ERROR("Update[0%x08X] with invalid default path validation "
+                        "state %d", update->updateID,
+                        update->defaultResult.result.bgpsecResult);
+          }
+          addIntAttrib(&out, "hops", update->pathData.hops);
+          addIntAttrib(&out, "bgpsec-len", update->pathData.length);
+        closeTag(&out);
+      }
+      unlockMutex(&shard->itemMutex);
+      unlockReadLock(&shard->tableLock);
     }
     closeTag(&out);
   }
@@ -1580,22 +2284,66 @@ void outputUpdateCacheAsXML(UpdateCache* self, FILE* stream, int maxBlob)
 
 
 
-void process_ASPA_EndOfData(UpdateCache* self, 
-                            int (*cb)(void* uCache, void* hldr, uint32_t uid, uint32_t pid, time_t ct), 
-                            void* rpkiHandler)
+/**
+ * Return the number of updates stored in the update cache. This is a snapshot
+ * for display purpose only, the shards are locked one at a time.
+ *
+ * @param self The update cache.
+ *
+ * @return The number of updates.
+ *
+ * @since 0.6.2.0
+ */
+int getNumberOfUpdates(UpdateCache* self)
 {
-  time_t lastEndOfDataTime = time(NULL);
-  int count=0;
-  CacheEntry* cEntry, *tmp;
-    
-  LOG(LEVEL_DEBUG, "Last end of Data Time: %u", lastEndOfDataTime);
-  HASH_ITER(hh, (CacheEntry*)self->table, cEntry, tmp) 
+  int elements = 0;
+  int idx;
+
+  for (idx = 0; idx < UC_NUM_SHARDS; idx++)
   {
-    LOG(LEVEL_DEBUG, "[%d] updateID: 0x%08X  pathID: 0x%08X", 
-        count++, cEntry->updateID, cEntry->aspathCacheID);
+    acquireReadLock(&self->shards[idx].tableLock);
+    elements += HASH_COUNT((CacheEntry*)self->shards[idx].table);
+    unlockReadLock(&self->shards[idx].tableLock);
+  }
 
-    cb((void*)self, (void*)rpkiHandler, cEntry->updateID, cEntry->aspathCacheID, 
-        lastEndOfDataTime); // call process_ASPA_EndOfData_main
+  return elements;
+}
+
+/**
+ * Return the IDs of all updates that use the given AS path.
+ *
+ * @param self The update cache.
+ * @param pathId The AS path cache key ID.
+ * @param updateIDs OUT parameter, a newly allocated list of update IDs or NULL
+ *                  if no update uses the path. Must be freed by the caller.
+ *
+ * @return The number of update IDs in the list.
+ *
+ * @since 0.6.2.0
+ */
+uint32_t getUpdateIDsOfPath(UpdateCache* self, uint32_t pathId,
+                            SRxUpdateID** updateIDs)
+{
+  UC_Shard*    shard    = _getShard(self, pathId);
+  PathUpdates* pUpdates = NULL;
+  uint32_t     count    = 0;
+
+  *updateIDs = NULL;
+
+  acquireReadLock(&shard->tableLock);
+  HASH_FIND(hh, (PathUpdates*)shard->pathIndex, &pathId, sizeof(uint32_t),
+            pUpdates);
+  if (pUpdates != NULL && pUpdates->count > 0)
+  {
+    *updateIDs = malloc(pUpdates->count * sizeof(SRxUpdateID));
+    if (*updateIDs != NULL)
+    {
+      memcpy(*updateIDs, pUpdates->updateIDs,
+             pUpdates->count * sizeof(SRxUpdateID));
+      count = pUpdates->count;
+    }
   }
+  unlockReadLock(&shard->tableLock);
 
+  return count;
 }
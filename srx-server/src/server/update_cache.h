@@ -20,15 +20,36 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * The update cache holds the updates in two separate structures, one is the 
- * update cache, a hash table with the update id as key and the update as 
- * value. The other is a list, that allows to scan through all updates. Both 
- * MUST be maintained the same.
+ * The update cache holds the updates in a hash table with the update id as 
+ * key and the update as value. The table is partitioned into UC_NUM_SHARDS 
+ * shards with their own locks, the shard is selected by the update ID.
+ *
+ * Updates without any client are scheduled with their deletion time in a 
+ * timing wheel. The garbage collector thread removes them once the time 
+ * passed from the update cache, the prefix cache, the AS path cache and the 
+ * SKI cache and releases their memory with its next pass, once no reader of
+ * the update cache can still use them. Code that uses a cache entry after the
+ * function that found it returned (getUpdateData) has to enclose the use
+ * between enterUpdateCacheReader and leaveUpdateCacheReader.
  * 
- * @version 0.5.0.0
+ * @version 0.6.2.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Added pathIndex and getUpdateIDsOfPath.
+ *            * Added the 64 bit digest to storeUpdate and detectCollision.
+ *            * Partitioned the update cache into shards (UC_Shard).
+ *            * Added getNumberOfUpdates.
+ *            * Removed process_ASPA_EndOfData.
+ *            * Removed availItems and itemsUsed from UC_Shard, cache entries
+ *              are allocated from a slab pool.
+ *            * Removed allItems from UC_Shard.
+ *            * Added the garbage collector: startUpdateCacheGC, 
+ *              stopUpdateCacheGC and getUpdateCacheGCStats.
+ *            * Added gcReaders, enterUpdateCacheReader and 
+ *              leaveUpdateCacheReader.
+ *            * Added reserveUpdatePath.
  * 0.5.0.0  - 2017/07/06 - oborchert
  *            * Renamed getUpdateData into getUpdateStats
  *            * Modified function modifyUpdateResult and added parameter
@@ -66,9 +87,11 @@
 #include "server/configuration.h"
 #include "shared/srx_defs.h"
 #include "shared/srx_packets.h"
+#include "util/epoch.h"
 #include "util/mutex.h"
 #include "util/rwlock.h"
 #include "util/slist.h"
+#include "util/timer_wheel.h"
 
 /**
  * Function that is called in case a result changed.
@@ -78,19 +101,50 @@
  */
 typedef void (*UpdateResultChanged)(SRxValidationResult* result);
 
+/** Number of shards of the update cache (must be a power of 2) */
+#define UC_NUM_SHARDS 16
+/** Interval of the garbage collector in seconds (one tick of the wheel) */
+#define UC_GC_INTERVAL 1
+
+/**
+ * One partition of the update cache. The shard of an update is selected by its
+ * update ID, the path index entry of an AS path by its path ID.
+ * 
+ * @since 0.6.2.0
+ */
+typedef struct {
+  Mutex               itemMutex;  // Protects the content of the updates
+  RWLock              tableLock;
+  void*               table;      // The hash table for quick lookup
+  void*               pathIndex;  // The updates per AS path (tableLock)
+} UC_Shard;
+
+/**
+ * The statistics of the garbage collector.
+ *
+ * @since 0.6.2.0
+ */
+typedef struct {
+  /** Number of updates waiting for their deletion time */
+  uint32_t            scheduled;
+  /** Number of removed updates whose memory is released with the next pass */
+  uint32_t            deferred;
+  /** Total number of updates reclaimed */
+  uint64_t            reclaimed;
+  /** Total number of bytes reclaimed (update, path data and client list) */
+  uint64_t            reclaimedBytes;
+  /** Number of passes of the garbage collector */
+  uint64_t            passes;
+} UC_GCStats;
+
 /**
  * A single Update Cache.
  */
 typedef struct {  
   Configuration*      sysConfig;  // The system configuration
   UpdateResultChanged resChangedCallback;
-  Mutex               itemMutex;
-  // TODO Check if allItems can be removed!
-  SList               allItems;   // All updates in an SList.
-  void*               availItems; // pointer to the next available cEntry
-  int                 itemsUsed;  // number of cEntries used
-  RWLock              tableLock;
-  void*               table;      // The hash table for quick lookup
+  UC_Shard            shards[UC_NUM_SHARDS];
+  Mutex               clientMutex; // Protects lockedClients
   // The is also the maximum number of clients currently installed. It is
   // called minNumberOfclients because it is the minimum expected and therefore
   // the initial number of array elements needed per update. This number might
@@ -101,6 +155,17 @@ typedef struct {
   // cache works on cleaning updates from this client. During this phase no 
   // updates can be assigned to this client.
   uint32_t*           lockedClients;
+
+  // The garbage collector, lock order is tableLock, itemMutex, gcMutex
+  Mutex               gcMutex;     // Protects gcWheel, gcRunning and gcStats
+  Cond                gcCond;      // Wakes the garbage collector to stop
+  TimerWheel          gcWheel;     // The updates without clients
+  pthread_t           gcThread;
+  bool                gcRunning;
+  UC_GCStats          gcStats;
+  EpochDomain         gcReaders;   // Users of entries the GC might remove
+  void*               prefixCache; // The prefix cache (PrefixCache*)
+  void*               aspathCache; // The AS path cache (AspathCache*)
 } UpdateCache;
 
 /** Return value for method getUpdateSignature the memory of this instance
@@ -171,6 +236,63 @@ bool createUpdateCache(UpdateCache* self, UpdateResultChanged chCallback,
  */
 void releaseUpdateCache(UpdateCache* self);
 
+/**
+ * Start the garbage collector thread. Updates that are not used by any client
+ * anymore are removed once their keep time passed. The given caches are
+ * cleaned from the removed updates.
+ *
+ * @param self The update cache
+ * @param prefixCache The prefix cache (PrefixCache*), can be NULL.
+ * @param aspathCache The AS path cache (AspathCache*), can be NULL.
+ *
+ * @return true if the garbage collector is running.
+ *
+ * @since 0.6.2.0
+ */
+bool startUpdateCacheGC(UpdateCache* self, void* prefixCache,
+                        void* aspathCache);
+
+/**
+ * Stop the garbage collector thread and wait for it to terminate. Nothing
+ * happens if the garbage collector is not running.
+ *
+ * @param self The update cache
+ *
+ * @since 0.6.2.0
+ */
+void stopUpdateCacheGC(UpdateCache* self);
+
+/**
+ * Return the statistics of the garbage collector.
+ *
+ * @param self The update cache
+ * @param stats OUT parameter receiving the statistics.
+ *
+ * @since 0.6.2.0
+ */
+void getUpdateCacheGCStats(UpdateCache* self, UC_GCStats* stats);
+
+/**
+ * Enter a read section of the update cache. The garbage collector does not 
+ * release any update that was removed while the read section was open. 
+ * Read sections can be nested but MUST NOT be kept open while waiting for
+ * the garbage collector.
+ *
+ * @param self The update cache
+ *
+ * @since 0.6.2.0
+ */
+void enterUpdateCacheReader(UpdateCache* self);
+
+/**
+ * Leave the read section of the update cache.
+ *
+ * @param self The update cache
+ *
+ * @since 0.6.2.0
+ */
+void leaveUpdateCacheReader(UpdateCache* self);
+
 /**
  * Queries the update cache for the result associated with the update. This
  * method DOES NOT create a cache entry if no update was found. This method DOES
@@ -226,17 +348,35 @@ UpdSigResult* getUpdateSignature(UpdateCache* self, UpdSigResult* result,
 bool getUpdateStats(UpdateCache* self, UC_UpdateStatistics* statistics);
 
 /**
- * Return the cache internal copy of the update data.
+ * Return the cache internal copy of the update data. The data can be removed
+ * by the garbage collector at any time, therefore the caller MUST call this
+ * function and use the data within a read section (enterUpdateCacheReader).
  * 
  * @param self The update cache
  * @param updateID The ID of the update
  * 
- * @return the pointer to the internal stored bgp update data
+ * @return the pointer to the internal stored bgp update data or NULL if the
+ *         update is not stored (anymore).
  * 
  * @since 0.5.0.0
  */
 UC_UpdateData* getUpdateData(UpdateCache* self, SRxUpdateID* updateID);
 
+/**
+ * Reserve the AS path for an update that is about to be stored. Must be called
+ * before the AS path is looked up in or added to the AS path cache. As long as
+ * the reservation exists, the garbage collector does not remove the AS path 
+ * from the AS path cache. storeUpdate takes over the reservation.
+ *
+ * @param self The update cache.
+ * @param pathId The AS path cache key ID, 0 is ignored.
+ *
+ * @return false if not enough memory is available.
+ *
+ * @since 0.6.2.0
+ */
+bool reserveUpdatePath(UpdateCache* self, uint32_t pathId);
+
 /**
  * Stores an update in the update cache. This method returns 0 in case the 
  * update already exists in the update cache. In this case depending on the 
@@ -270,6 +410,10 @@ UC_UpdateData* getUpdateData(UpdateCache* self, SRxUpdateID* updateID);
  *               storage, the internal UNDEFINED and UNKNOWN will be used.
  * @param bgpData Contains BGP / BGPsec data. This parameter as well as defRes 
  *               is only used during initial storing of an update. (CAN BE NULL)
+ * @param pathID The AS path cache key ID of the update's AS path. The 
+ *               reservation of the path (reserveUpdatePath) is taken over or 
+ *               released if the update is not stored.
+ * @param digest The 64 bit identifier of the update (generateIdentifier64).
  * 
  *
  * @return 1 the result stored, 0 the update is already stored, 
@@ -278,12 +422,12 @@ UC_UpdateData* getUpdateData(UpdateCache* self, SRxUpdateID* updateID);
 int storeUpdate(UpdateCache* self, uint8_t clientID, void* clientMapping,
                 SRxUpdateID* updateID, IPPrefix* prefix, 
                 uint32_t asn, SRxDefaultResult* defRes,
-                BGPSecData* bgpData, uint32_t pathID);
+                BGPSecData* bgpData, uint32_t pathID, uint64_t digest);
 
 /**
- * Removes the update data from the list and releases all memory associated to 
- * it. Also, if this update contains bgpsec blob, it will remove this
- * update from the SKI Cache.
+ * Removes the association of the client to the update. The update is 
+ * scheduled for the garbage collector if no further client uses it, the 
+ * garbage collector also removes the update from the SKI Cache.
  *
  * @param self The instance of the update cache 
  * @param clientID The ID of the srx-server client. This is NOT the proxyID,
@@ -307,7 +451,8 @@ bool deleteUpdateFromCache(UpdateCache* self, uint8_t clientID,
  * For each update that contains BGPsec data it calls the unregister update
  * function.
  *
- * @note Primarily for development purposes or program shutdown.
+ * @note Primarily for development purposes or program shutdown. The garbage
+ *       collector MUST be stopped.
  *
  * @param self Instance of the update cache.
  */
@@ -398,11 +543,13 @@ int unregisterClientID(UpdateCache* self, uint8_t clientID, void* clientMapping,
  * @param prefix the prefix of the update
  * @param asn the Origin AS of the update
  * @param bgpsecData The bgpsec data blob.
+ * @param digest The 64 bit identifier of the update (generateIdentifier64).
+ *               Updates with different digests are not compared any further.
  * 
  * @return true if a collision could be detected!
  */
 bool detectCollision(UpdateCache* self, SRxUpdateID* updateID, IPPrefix* prefix, 
-                     uint32_t asn, BGPSecData* bgpsecData);
+                     uint32_t asn, BGPSecData* bgpsecData, uint64_t digest);
 
 /**
  * This function selects the data from bgpsecData that is used for ID generation
@@ -439,9 +586,32 @@ void outputUpdateCacheAsXML(UpdateCache* self, FILE* stream, int maxBlob);
 bool modifyUpdateCacheResultWithAspaVal(UpdateCache* self, SRxUpdateID* updateID,
                         SRxResult* srxResult_aspa);
 
-void process_ASPA_EndOfData(UpdateCache* self, 
-                            int (*cb)(void* uCache, void* hldr, uint32_t uid, uint32_t pid, time_t), 
-                            void* rpkiHandler);
+/**
+ * Return the number of updates stored in the update cache. This is a snapshot
+ * for display purpose only, the shards are not locked.
+ *
+ * @param self The update cache.
+ *
+ * @return The number of updates.
+ *
+ * @since 0.6.2.0
+ */
+int getNumberOfUpdates(UpdateCache* self);
+
+/**
+ * Return the IDs of all updates that use the given AS path.
+ *
+ * @param self The update cache.
+ * @param pathId The AS path cache key ID.
+ * @param updateIDs OUT parameter, a newly allocated list of update IDs or NULL
+ *                  if no update uses the path. Must be freed by the caller.
+ *
+ * @return The number of update IDs in the list.
+ *
+ * @since 0.6.2.0
+ */
+uint32_t getUpdateIDsOfPath(UpdateCache* self, uint32_t pathId,
+                            SRxUpdateID** updateIDs);
 #endif // !__UPDATE_CACHE_H__
 
 
@@ -20,10 +20,12 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.3.0.10
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Added crc32c (Castagnoli) with SSE4.2 support.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Added Changelog
  *            * Fixed speller in documentation header
@@ -41,6 +43,22 @@ extern "C" {
 
 uint32_t crc32(uint8_t *pData, uint32_t uSize);
 
+/**
+ * Generates a CRC-32C (Castagnoli) number for the given data block. Uses the
+ * SSE4.2 crc32 instruction if the CPU supports it. The CRC can be calculated
+ * over multiple data blocks by passing the result of the previous call as
+ * crc, the first call uses 0.
+ *
+ * @param crc The CRC of the previous data blocks or 0
+ * @param pData The data block
+ * @param uSize The size of the data block
+ *
+ * @return the CRC
+ *
+ * @since 0.6.2.0
+ */
+uint32_t crc32c(uint32_t crc, const void* pData, uint32_t uSize);
+
 #ifdef	__cplusplus
 }
 #endif
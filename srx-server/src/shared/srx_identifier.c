@@ -20,10 +20,15 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.5.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * generateIdentifier hashes the binary data using CRC32C instead
+ *              of printing it as hex string first. This also fixes a buffer
+ *              overflow for blob bytes larger than 0x7F (sign extension).
+ *            * Added generateIdentifier64.
  * 0.5.0.0  - 2017/06/21 - oborchert
  *            * Add method compareSrxUpdateID
  *            * Fixed speller in documentation
@@ -45,19 +50,23 @@
 #include "util/prefix.h"
 #include "srx_defs.h"
 
+/** Multiplier of the 64 bit hash (golden ratio) */
+#define HASH64_PRIME 0x9E3779B97F4A7C15ULL
+/** Initial value of the 64 bit hash */
+#define HASH64_SEED  0xCBF29CE484222325ULL
+
 /**
- * This particular method generates an ID out of the given data using a simple
- * CRC32 algorithm. All data is used as is, no transformation from host to
- * network and vice versa is performed.
+ * Select the data blob that is used for the ID generation. A change in the 
+ * blob selection does impact the function update_cache.c:storeCacheEntryBlob
  *
- * @param originAS The origin AS of the data
- * @param prefix The prefix to be announced (IPPrefix)
  * @param data The bgpsec data object which contains the BGP4 path as well.
+ * @param blobLength OUT parameter, the length of the blob
  *
- * @return return an ID.
+ * @return The data blob.
+ *
+ * @since 0.6.2.0
  */
-uint32_t generateIdentifier(uint32_t originAS, IPPrefix* prefix, 
-                            BGPSecData* data)
+static uint8_t* _getIdentifierBlob(BGPSecData* data, uint32_t* blobLength)
 {
   // @TODO: Check what the data block should consist of, the BGP4 path or the 
   //        BGPSec Path or maybe both ?
@@ -65,63 +74,116 @@ uint32_t generateIdentifier(uint32_t originAS, IPPrefix* prefix,
   // Then if we receive a request if a particular BGPSEC path for a particular
   // BGP4 path exist this can only be answered by the BGP4 path.
   // This needs some more thoughts later one. 
-  uint32_t blobLength = 0;
-  uint8_t* blob = NULL;
-  // A change in the blob generation does impact the function 
-  // update_cache.c:storeCacheEntryBlob
   if (data->bgpsec_path_attr != 0)
   {
-    blobLength = data->attr_length;
-    blob = (uint8_t*)data->bgpsec_path_attr;    
-  }
-  else
-  {
-    blobLength = data->numberHops * 4;
-    blob = (uint8_t*)data->asPath;
+    *blobLength = data->attr_length;
+    return (uint8_t*)data->bgpsec_path_attr;    
   }
 
-  uint32_t crc  = 0;
-  uint32_t prefixSize = prefix->ip.version == 4 ? 4
-                                                : sizeof(prefix->ip.addr.v6.u8);
-  uint32_t length = (  4           /* OriginAS */
-                     + prefixSize  /* IPPrefix */
-                     + 1           /* Prefix Length */
-                     + blobLength  /* The length of the data blob */
-                    ) * 2;         /* To generate a hex string. */
+  *blobLength = data->numberHops * 4;
+  return (uint8_t*)data->asPath;
+}
 
-  char dataText[length];
-  memset(dataText, '\0', length);
-  char* dataPtr = dataText;
-  int i;
+/**
+ * Mix the given data block into a 64 bit hash value. Multiply and xor-shift
+ * over 8 byte words.
+ *
+ * @param hash The hash of the previous data blocks.
+ * @param block The data block
+ * @param size The size of the data block
+ *
+ * @return The new hash value
+ *
+ * @since 0.6.2.0
+ */
+static uint64_t _hash64(uint64_t hash, const uint8_t* block, uint32_t size)
+{
+  uint64_t word = 0;
 
-  sprintf(dataPtr, "%08X", originAS);
-  dataPtr += 8;
-  if (prefix->ip.version == 4)
+  while (size >= 8)
   {
-    sprintf(dataPtr, "%08X%02X", prefix->ip.addr.v4.u32, prefix->length);
-    dataPtr += 10;
+    memcpy(&word, block, 8);
+    hash   = (hash ^ word) * HASH64_PRIME;
+    hash  ^= hash >> 32;
+    block += 8;
+    size  -= 8;
   }
-  else
+  if (size > 0)
   {
-    for (i = 0; i < prefixSize; i++)
-    {
-      sprintf(dataPtr, "%02X", prefix->ip.addr.v6.u8[i]);
-      dataPtr += 2;
-    }
-    sprintf(dataPtr, "%02X", prefix->length);
-    dataPtr += 2;
+    word = (uint64_t)size << 56;
+    memcpy(&word, block, size);
+    hash  = (hash ^ word) * HASH64_PRIME;
+    hash ^= hash >> 32;
   }
 
-  for (i = 0; i < blobLength; i++)
-  {
-    sprintf(dataPtr, "%02X", *(char*)blob);
-    dataPtr += 2;
-    blob++;
-  }  
-  crc = crc32((uint8_t*)dataText, length);
+  return hash;
+}
+
+/**
+ * This particular method generates an ID out of the given data using the 
+ * CRC32C algorithm (SSE4.2 if supported). All data is used as is, no 
+ * transformation from host to network and vice versa is performed.
+ *
+ * @param originAS The origin AS of the data
+ * @param prefix The prefix to be announced (IPPrefix)
+ * @param data The bgpsec data object which contains the BGP4 path as well.
+ *
+ * @return return an ID.
+ */
+uint32_t generateIdentifier(uint32_t originAS, IPPrefix* prefix, 
+                            BGPSecData* data)
+{
+  uint32_t blobLength = 0;
+  uint8_t* blob       = _getIdentifierBlob(data, &blobLength);
+  uint32_t prefixSize = prefix->ip.version == 4 ? 4
+                                                : sizeof(prefix->ip.addr.v6.u8);
+  uint32_t crc = 0;
+
+  crc = crc32c(crc, &originAS, 4);
+  crc = crc32c(crc, prefix->ip.addr.v6.u8, prefixSize);
+  crc = crc32c(crc, &prefix->length, 1);
+  crc = crc32c(crc, blob, blobLength);
+
   return crc;
 }
 
+/**
+ * Generates a 64 bit identifier (digest) out of the same data as 
+ * generateIdentifier, using an independent hash function. The update cache
+ * keeps it next to the 32 bit update ID. Two updates with different digests
+ * are different, this allows to resolve ID collisions without comparing the
+ * update data.
+ *
+ * @param originAS The origin AS of the data
+ * @param prefix The prefix to be announced (IPPrefix)
+ * @param data The bgpsec data object which contains the BGP4 path as well.
+ *
+ * @return return the 64 bit identifier.
+ *
+ * @since 0.6.2.0
+ */
+uint64_t generateIdentifier64(uint32_t originAS, IPPrefix* prefix, 
+                              BGPSecData* data)
+{
+  uint32_t blobLength = 0;
+  uint8_t* blob       = _getIdentifierBlob(data, &blobLength);
+  uint32_t prefixSize = prefix->ip.version == 4 ? 4
+                                                : sizeof(prefix->ip.addr.v6.u8);
+  uint64_t hash = HASH64_SEED;
+
+  hash = _hash64(hash, (uint8_t*)&originAS, 4);
+  hash = _hash64(hash, prefix->ip.addr.v6.u8, prefixSize);
+  hash = _hash64(hash, &prefix->length, 1);
+  hash = _hash64(hash, blob, blobLength);
+
+  // Final avalanche
+  hash ^= hash >> 29;
+  hash *= HASH64_PRIME;
+  hash ^= hash >> 32;
+
+  return hash;
+}
+
 /**
  * Compare two given SRx update identifiers with each other. 
  * The result is less than 0 for u1 less than u2, equals 0 if u1 equals u2 and
@@ -20,10 +20,12 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.5.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Added generateIdentifier64.
  * 0.5.0.0  - 2017/06/21 - oborchert
  *            * Add method compareSrxUpdateID
  *            * Added enumeration type e_SRx_uID_Compare
@@ -55,9 +57,9 @@ typedef enum {
 } e_SRx_uID_Compare;
 
 /**
- * This particular method generates an ID out of the given data using a simple
- * CRC32 algorithm. All data is used as is, no transformation from host to
- * network and vice versa is performed.
+ * This particular method generates an ID out of the given data using the 
+ * CRC32C algorithm (SSE4.2 if supported). All data is used as is, no 
+ * transformation from host to network and vice versa is performed.
  *
  * @param originAS The origin AS of the data
  * @param prefix The prefix to be announced (IPPrefix)
@@ -69,6 +71,24 @@ typedef enum {
 uint32_t generateIdentifier(uint32_t originAS, IPPrefix* prefix, 
                             BGPSecData* data);
 
+/**
+ * Generates a 64 bit identifier (digest) out of the same data as 
+ * generateIdentifier, using an independent hash function. The update cache
+ * keeps it next to the 32 bit update ID. Two updates with different digests
+ * are different, this allows to resolve ID collisions without comparing the
+ * update data.
+ *
+ * @param originAS The origin AS of the data
+ * @param prefix The prefix to be announced (IPPrefix)
+ * @param data The bgpsec data object which contains the BGP4 path as well.
+ *
+ * @return return the 64 bit identifier.
+ *
+ * @since 0.6.2.0
+ */
+uint64_t generateIdentifier64(uint32_t originAS, IPPrefix* prefix, 
+                              BGPSecData* data);
+
 /**
  * Compare two given srx update identifiers with each other. 
  * The result is less than 0 for u1 less than u2, equals 0 if u1 equals u2 and
@@ -21,10 +21,13 @@
  * by this software.
  *
  *
- * @version 0.4.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Added the batched verify request and aligned the packet type
+ *              strings with SRxProxyPDUType.
  * 0.4.0.0  - 2016/06/19 - oborchert
  *            * moved up to version 0.4.0.0 to be synched with header file.
  * 0.3.0.10 - 2015/11/10 - oborchert
@@ -51,12 +54,14 @@ static const char* PACKET_TYPES[PDU_SRXPROXY_UNKNOWN + 1] = {
   "Goodbye",
   "Verify_IPv4",
   "Verify_IPv6",
-  "Request_Receipt",
-  "Delete_Update",
-  "Synch_Request",
+  "Sign_Request",
   "Verification_Notification",
   "Signature_Notification",
+  "Delete_Update",
+  "Peer_Change",
+  "Synch_Request",
   "Error",
+  "Verify_Batch",
   "Unknown"
 };
 
@@ -28,10 +28,13 @@
  * other licenses. Please refer to the licenses of all libraries required
  * by this software.
  *
- * @version 0.6.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Added PDU_SRXPROXY_VERIFY_BATCH_REQUEST that carries multiple
+ *              verify requests in one PDU.
  * 0.6.0.0  - 2021/04/06 - oborchert
  *            * Moved asType and asRelType to SRXRPOXY_BasicHeader_VerifyRequest
  *              from struct SRXPROXY_VERIFY_V4_REQUEST and struct 
@@ -118,7 +121,8 @@ typedef enum {
   PDU_SRXPROXY_PEER_CHANGE       =  9,
   PDU_SRXPROXY_SYNC_REQUEST      = 10,
   PDU_SRXPROXY_ERROR             = 11,
-  PDU_SRXPROXY_UNKNOWN           = 12    // NOT IN SPEC
+  PDU_SRXPROXY_VERIFY_BATCH_REQUEST = 12, // NOT IN SPEC
+  PDU_SRXPROXY_UNKNOWN           = 13    // NOT IN SPEC
 } SRxProxyPDUType;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -262,6 +266,21 @@ typedef struct {
   BGPSECValReqData bgpsecValReqData;
 } __attribute__((packed)) SRXPROXY_VERIFY_V6_REQUEST;
 
+/**
+ * This struct specifies the batched verify request packet. The header is
+ * followed by count complete verify request PDUs (type 3 and 4), each with
+ * its own length field.
+ *
+ * @since 0.6.2.0
+ */
+typedef struct {
+  uint8_t     type;            // 12
+  uint16_t    reserved16;
+  uint8_t     reserved8;
+  uint32_t    count;           // Number of verify requests that follow
+  uint32_t    length;          // 12(+) Bytes
+} __attribute__((packed)) SRXPROXY_VERIFY_BATCH_REQUEST;
+
 /**
  * This struct specifies the sign request packet
  */
@@ -0,0 +1,418 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ *
+ * This files is used for testing the deferred ROA results of the Prefix Cache
+ * and the validation of updates below prefixes that were flagged stale. The
+ * update cache functions used by the prefix cache are replaced by the ones
+ * below, they keep the ROA result of each update.
+ *
+ * @version 0.6.2.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * File created
+ *            * Added tests for stale prefixes without updates.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include "server/prefix_cache.h"
+#include "server/rpki_queue.h"
+
+#define NO_UPDATES  11
+#define TEST_AS     65001
+#define OTHER_AS    65002
+#define VAL_CACHE   1
+
+/** The RPKI Queue */
+static RPKI_QUEUE* rpki_queue = NULL;
+
+/** The update cache, only its address is used. */
+static UpdateCache updateCache;
+
+/** The ROA result stored for each update. */
+static SRxValidationResultVal roaResult[NO_UPDATES];
+/** Indicates if the last stored result of each update was suppressed. */
+static bool suppressed[NO_UPDATES];
+/** The number of stored results. */
+static int  noModified = 0;
+
+/**
+ * Replaces the function of the update cache, keeps the ROA result.
+ */
+bool modifyUpdateResult(UpdateCache* self, SRxUpdateID* updateID,
+                        SRxResult* result, bool suppressNotification)
+{
+  if (*updateID >= NO_UPDATES)
+  {
+    return false;
+  }
+  if (result->roaResult != SRx_RESULT_DONOTUSE)
+  {
+    roaResult[*updateID]  = result->roaResult;
+    suppressed[*updateID] = suppressNotification;
+    noModified++;
+  }
+  return true;
+}
+
+/**
+ * Replaces the function of the update cache, returns the kept ROA result.
+ */
+bool getUpdateResult(UpdateCache* self, SRxUpdateID* updateID,
+                     uint8_t clientID, void* clientMapping,
+                     SRxResult* srxRes, SRxDefaultResult* defaultRes,
+                     uint32_t *pathID)
+{
+  if (*updateID >= NO_UPDATES)
+  {
+    return false;
+  }
+  srxRes->roaResult    = roaResult[*updateID];
+  srxRes->bgpsecResult = SRx_RESULT_UNDEFINED;
+  srxRes->aspaResult   = SRx_RESULT_UNDEFINED;
+  return true;
+}
+
+/**
+ * Replaces the function of the server.
+ */
+RPKI_QUEUE* getRPKIQueue()
+{
+  return rpki_queue;
+}
+
+/**
+ * check the value against expected, if not match then exit.
+ *
+ * @param val the value to be checked
+ * @param expected the value to be checked against (expected value)
+ * @param error the error string in case of exit
+ */
+static void assert_int(int val, int expected, char* error)
+{
+  if (val != expected)
+  {
+    printf ("Error: %s; Expected %i but received %i\n", error, expected, val);
+    exit (EXIT_FAILURE);
+  }
+}
+
+/**
+ * Fill the given IPv4 prefix.
+ *
+ * @param prefix The prefix to be filled.
+ * @param addr The address in host format.
+ * @param length The prefix length.
+ *
+ * @return the prefix.
+ */
+static IPPrefix* _setPrefix(IPPrefix* prefix, uint32_t addr, uint8_t length)
+{
+  memset(prefix, 0, sizeof(IPPrefix));
+  prefix->ip.version      = 4;
+  prefix->ip.addr.v4.u32  = htonl(addr);
+  prefix->length          = length;
+  return prefix;
+}
+
+/**
+ * Request the validation of the given update and return its ROA result.
+ *
+ * @param cache The prefix cache.
+ * @param updateID The id of the update.
+ * @param addr The address of the prefix in host format.
+ * @param length The prefix length.
+ *
+ * @return the ROA result of the update.
+ */
+static int _validate(PrefixCache* cache, SRxUpdateID updateID, uint32_t addr,
+                     uint8_t length)
+{
+  IPPrefix prefix;
+
+  requestUpdateValidation(cache, &updateID, _setPrefix(&prefix, addr, length),
+                          TEST_AS);
+  return roaResult[updateID];
+}
+
+/**
+ * Add update 1 (10.1.0.0/24) and its result to the prefix cache. No ROA exists
+ * yet.
+ *
+ * @param cache The prefix cache.
+ */
+static void _initialize(PrefixCache* cache)
+{
+  IPPrefix    prefix;
+  SRxUpdateID updateID = 1;
+
+  printf ("Initialize experiment\n");
+  rpki_queue = rq_createQueue();
+  initializePrefixCache(cache, &updateCache);
+
+  _setPrefix(&prefix, 0x0A010000, 24);
+  requestUpdateValidation(cache, &updateID, &prefix, TEST_AS);
+  assert_int(roaResult[1], SRx_RESULT_NOTFOUND, "Initial result");
+  assert_int(suppressed[1], false, "Initial notification");
+  printf ("         passed.\n");
+}
+
+/**
+ * Add a covering ROA during a synchronization that gets interrupted, the
+ * deferred result is stored and the clients are notified without an end of
+ * data.
+ *
+ * @param cache The prefix cache.
+ */
+static void _test1(PrefixCache* cache)
+{
+  IPPrefix prefix;
+
+  printf ("Test #1: Store the deferred result of an interrupted "
+          "synchronization!\n");
+
+  noModified = 0;
+  addROAwl(cache, TEST_AS, _setPrefix(&prefix, 0x0A010000, 16), 24, 0,
+           VAL_CACHE, true);
+  assert_int(noModified, 0, "Result stored before the end of data");
+
+  // Connection lost
+  assert_int(flushDeferredResults(cache), 1, "Flushed results");
+  assert_int(roaResult[1], SRx_RESULT_VALID, "Flushed result");
+  assert_int(suppressed[1], false, "Notification of flushed result");
+  assert_int(rq_size(rpki_queue), 0, "RPKI queue after flush");
+
+  // Nothing must remain for the next synchronization
+  assert_int(flushDeferredResults(cache), 0, "Second flush");
+  assert_int(applyDeferredResults(cache), 0, "End of data after flush");
+  printf ("         passed.\n");
+}
+
+/**
+ * Remove and re-add the ROA during a synchronization that gets interrupted,
+ * the update is not reported.
+ *
+ * @param cache The prefix cache.
+ */
+static void _test2(PrefixCache* cache)
+{
+  IPPrefix prefix;
+
+  printf ("Test #2: Skip a flapping result of an interrupted "
+          "synchronization!\n");
+
+  noModified = 0;
+  _setPrefix(&prefix, 0x0A010000, 16);
+  delROAwl(cache, TEST_AS, &prefix, 24, 0, VAL_CACHE, true);
+  addROAwl(cache, TEST_AS, &prefix, 24, 0, VAL_CACHE, true);
+
+  // Cache reset
+  assert_int(flushDeferredResults(cache), 0, "Flushed results");
+  assert_int(noModified, 0, "Stored results");
+  assert_int(roaResult[1], SRx_RESULT_VALID, "Result");
+  printf ("         passed.\n");
+}
+
+/**
+ * Add a ROA of another AS during a synchronization that ends with an end of
+ * data, the result is stored and the update is queued.
+ *
+ * @param cache The prefix cache.
+ */
+static void _test3(PrefixCache* cache)
+{
+  IPPrefix prefix;
+
+  printf ("Test #3: Queue the deferred result at the end of data!\n");
+
+  _setPrefix(&prefix, 0x0A010000, 16);
+  delROAwl(cache, TEST_AS, &prefix, 24, 0, VAL_CACHE, true);
+  addROAwl(cache, OTHER_AS, &prefix, 24, 0, VAL_CACHE, true);
+
+  // End of data
+  assert_int(applyDeferredResults(cache), 1, "Applied results");
+  assert_int(roaResult[1], SRx_RESULT_INVALID, "Applied result");
+  assert_int(suppressed[1], true, "Notification of applied result");
+  assert_int(rq_size(rpki_queue), 1, "RPKI queue after end of data");
+  assert_int(flushDeferredResults(cache), 0, "Flush after end of data");
+  printf ("         passed.\n");
+}
+
+/**
+ * Add and delete ROAs above prefixes without updates. The prefixes are only
+ * flagged stale, updates that arrive for them or below them later on are
+ * validated with the current ROA coverage.
+ *
+ * @param cache The prefix cache.
+ */
+static void _test4(PrefixCache* cache)
+{
+  IPPrefix prefix;
+
+  printf ("Test #4: Validate updates below a stale prefix!\n");
+
+  // 20.1.0.0/16 gets flagged stale by the added ROA
+  addROAwl(cache, OTHER_AS, _setPrefix(&prefix, 0x14010000, 16), 16, 0,
+           VAL_CACHE, false);
+  addROAwl(cache, TEST_AS, _setPrefix(&prefix, 0x14000000, 8), 24, 0,
+           VAL_CACHE, false);
+  assert_int(_validate(cache, 4, 0x14010000, 16), SRx_RESULT_VALID,
+             "Update on stale prefix after add");
+  assert_int(_validate(cache, 5, 0x14010100, 24), SRx_RESULT_VALID,
+             "Update below stale prefix after add");
+  delROAwl(cache, OTHER_AS, _setPrefix(&prefix, 0x14010000, 16), 16, 0,
+           VAL_CACHE, false);
+  assert_int(roaResult[4], SRx_RESULT_VALID, "Update 4 after delete");
+  delROAwl(cache, TEST_AS, _setPrefix(&prefix, 0x14000000, 8), 24, 0,
+           VAL_CACHE, false);
+  assert_int(roaResult[4], SRx_RESULT_NOTFOUND, "Update 4 without ROA");
+  assert_int(roaResult[5], SRx_RESULT_NOTFOUND, "Update 5 without ROA");
+
+  // 21.1.0.0/16 gets flagged stale by the deleted ROA
+  addROAwl(cache, TEST_AS, _setPrefix(&prefix, 0x15000000, 8), 24, 0,
+           VAL_CACHE, false);
+  addROAwl(cache, OTHER_AS, _setPrefix(&prefix, 0x15010000, 16), 16, 0,
+           VAL_CACHE, false);
+  delROAwl(cache, TEST_AS, _setPrefix(&prefix, 0x15000000, 8), 24, 0,
+           VAL_CACHE, false);
+  assert_int(_validate(cache, 6, 0x15010000, 16), SRx_RESULT_INVALID,
+             "Update on stale prefix after delete");
+  assert_int(_validate(cache, 7, 0x15010100, 24), SRx_RESULT_INVALID,
+             "Update below stale prefix after delete");
+  delROAwl(cache, OTHER_AS, _setPrefix(&prefix, 0x15010000, 16), 16, 0,
+           VAL_CACHE, false);
+  assert_int(roaResult[6], SRx_RESULT_NOTFOUND, "Update 6 without ROA");
+  assert_int(roaResult[7], SRx_RESULT_NOTFOUND, "Update 7 without ROA");
+  printf ("         passed.\n");
+}
+
+/**
+ * Add a ROA above nested prefixes without updates, only the least specific
+ * one is flagged stale. An update for a more specific prefix requires both
+ * to be recalculated, its sibling is recalculated with the next update.
+ *
+ * @param cache The prefix cache.
+ */
+static void _test5(PrefixCache* cache)
+{
+  IPPrefix prefix;
+
+  printf ("Test #5: Validate updates below a stale ancestor!\n");
+
+  addROAwl(cache, OTHER_AS, _setPrefix(&prefix, 0x1E000000, 8), 8, 0,
+           VAL_CACHE, false);
+  addROAwl(cache, OTHER_AS, _setPrefix(&prefix, 0x1E010000, 16), 16, 0,
+           VAL_CACHE, false);
+  addROAwl(cache, OTHER_AS, _setPrefix(&prefix, 0x1E020000, 16), 16, 0,
+           VAL_CACHE, false);
+  // Flags 30.0.0.0/8 stale but not the more specific prefixes
+  addROAwl(cache, TEST_AS, _setPrefix(&prefix, 0x1E000000, 7), 24, 0,
+           VAL_CACHE, false);
+  assert_int(_validate(cache, 8, 0x1E010000, 16), SRx_RESULT_VALID,
+             "Update below stale ancestor");
+  // The sibling is not on the path of the previous update
+  assert_int(_validate(cache, 10, 0x1E020000, 16), SRx_RESULT_VALID,
+             "Update beside the recalculated path");
+  delROAwl(cache, TEST_AS, _setPrefix(&prefix, 0x1E000000, 7), 24, 0,
+           VAL_CACHE, false);
+  assert_int(roaResult[8], SRx_RESULT_INVALID, "Update 8 after delete");
+  assert_int(roaResult[10], SRx_RESULT_INVALID, "Update 10 after delete");
+  delROAwl(cache, OTHER_AS, _setPrefix(&prefix, 0x1E010000, 16), 16, 0,
+           VAL_CACHE, false);
+  delROAwl(cache, OTHER_AS, _setPrefix(&prefix, 0x1E020000, 16), 16, 0,
+           VAL_CACHE, false);
+  delROAwl(cache, OTHER_AS, _setPrefix(&prefix, 0x1E000000, 8), 8, 0,
+           VAL_CACHE, false);
+  assert_int(roaResult[8], SRx_RESULT_NOTFOUND, "Update 8 without ROA");
+  assert_int(roaResult[10], SRx_RESULT_NOTFOUND, "Update 10 without ROA");
+  printf ("         passed.\n");
+}
+
+/**
+ * Delete the last ROA of a stale prefix, the prefix is freed but its more
+ * specific prefix has to be recalculated.
+ *
+ * @param cache The prefix cache.
+ */
+static void _test6(PrefixCache* cache)
+{
+  IPPrefix prefix;
+
+  printf ("Test #6: Free a stale prefix!\n");
+
+  addROAwl(cache, OTHER_AS, _setPrefix(&prefix, 0x28000000, 16), 16, 0,
+           VAL_CACHE, false);
+  addROAwl(cache, OTHER_AS, _setPrefix(&prefix, 0x28000100, 24), 24, 0,
+           VAL_CACHE, false);
+  // Flags 40.0.0.0/16 stale but not 40.0.1.0/24
+  addROAwl(cache, TEST_AS, _setPrefix(&prefix, 0x28000000, 8), 24, 0,
+           VAL_CACHE, false);
+  // Frees 40.0.0.0/16
+  delROAwl(cache, OTHER_AS, _setPrefix(&prefix, 0x28000000, 16), 16, 0,
+           VAL_CACHE, false);
+  assert_int(_validate(cache, 9, 0x28000100, 24), SRx_RESULT_VALID,
+             "Update below freed prefix");
+  delROAwl(cache, TEST_AS, _setPrefix(&prefix, 0x28000000, 8), 24, 0,
+           VAL_CACHE, false);
+  assert_int(roaResult[9], SRx_RESULT_INVALID, "Update after delete");
+  delROAwl(cache, OTHER_AS, _setPrefix(&prefix, 0x28000100, 24), 24, 0,
+           VAL_CACHE, false);
+  assert_int(roaResult[9], SRx_RESULT_NOTFOUND, "Update without ROA");
+  printf ("         passed.\n");
+}
+
+/**
+ * This is the main function
+ */
+int main(int argc, char** argv)
+{
+  PrefixCache cache;
+
+  _initialize(&cache);
+
+  printf("\nRun test #1 to flush the deferred result on session loss\n");
+  _test1(&cache);
+
+  printf("\nRun test #2 to flush a flapping result on cache reset\n");
+  _test2(&cache);
+
+  printf("\nRun test #3 to apply the deferred result at the end of data\n");
+  _test3(&cache);
+
+  printf("\nRun test #4 for updates below a stale prefix\n");
+  _test4(&cache);
+
+  printf("\nRun test #5 for updates below a stale ancestor\n");
+  _test5(&cache);
+
+  printf("\nRun test #6 for the removal of a stale prefix\n");
+  _test6(&cache);
+
+  releasePrefixCache(&cache);
+  rq_releaseQueue(rpki_queue);
+
+  printf ("End of all tests!\n");
+  return (EXIT_SUCCESS);
+}
@@ -0,0 +1,226 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ *
+ * This files is used for testing the origin validation of the ROA Table.
+ *
+ * @version 0.6.2.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * File created
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include "server/roa_table.h"
+
+#define TEST_AS   65001
+#define OTHER_AS  65002
+
+/**
+ * check the value against expected, if not match then exit.
+ *
+ * @param table the table, released in case of an error.
+ * @param val the value to be checked
+ * @param expected the value to be checked against (expected value)
+ * @param error the error string in case of exit
+ */
+static void assert_int(ROA_Table* table, int val, int expected, char* error)
+{
+  if (val != expected)
+  {
+    printf ("Error: %s; Expected %i but received %i\n", error, expected, val);
+    freeROATable(table);
+    exit (EXIT_FAILURE);
+  }
+}
+
+/**
+ * Fill the given prefix.
+ *
+ * @param prefix The prefix to be filled.
+ * @param address The address in text format.
+ * @param length The prefix length.
+ *
+ * @return the prefix.
+ */
+static IPPrefix* _setPrefix(IPPrefix* prefix, const char* address,
+                            uint8_t length)
+{
+  memset(prefix, 0, sizeof(IPPrefix));
+  if (strchr(address, ':') != NULL)
+  {
+    prefix->ip.version = 6;
+    inet_pton(AF_INET6, address, &prefix->ip.addr.v6);
+  }
+  else
+  {
+    prefix->ip.version = 4;
+    inet_pton(AF_INET, address, &prefix->ip.addr.v4);
+  }
+  prefix->length = length;
+  return prefix;
+}
+
+/**
+ * Return the result of the lookup.
+ *
+ * @param table The table.
+ * @param address The address in text format.
+ * @param length The prefix length.
+ * @param asn The origin AS.
+ *
+ * @return the validation result.
+ */
+static int _lookup(ROA_Table* table, const char* address, uint8_t length,
+                   uint32_t asn)
+{
+  IPPrefix prefix;
+  return lookupROATable(table, _setPrefix(&prefix, address, length), asn);
+}
+
+/**
+ * Create the table with the ROAs used by all tests.
+ *
+ * @return the finished table.
+ */
+static ROA_Table* _initialize()
+{
+  ROA_Table* table = newROATable();
+  IPPrefix   prefix;
+
+  printf ("Initialize experiment\n");
+  if (table == NULL)
+  {
+    printf ("Error: Could not create the table\n");
+    exit (EXIT_FAILURE);
+  }
+  addROATableEntry(table, _setPrefix(&prefix, "10.1.0.0", 16), 20, TEST_AS);
+  addROATableEntry(table, _setPrefix(&prefix, "10.1.0.0", 16), 20, TEST_AS);
+  addROATableEntry(table, _setPrefix(&prefix, "10.2.0.0", 16), 16, TEST_AS);
+  addROATableEntry(table, _setPrefix(&prefix, "10.2.3.0", 24), 24, OTHER_AS);
+  addROATableEntry(table, _setPrefix(&prefix, "2001:db8::", 32), 48, TEST_AS);
+  addROATableEntry(table, _setPrefix(&prefix, "2001:db8:0:0:1::", 80), 96,
+                   OTHER_AS);
+  finishROATable(table);
+
+  assert_int(table, getROATableSize(table, 4), 3, "IPv4 entries");
+  assert_int(table, getROATableSize(table, 6), 2, "IPv6 entries");
+  printf ("         passed.\n");
+  return table;
+}
+
+/**
+ * Check covered and not covered IPv4 prefixes.
+ *
+ * @param table The table.
+ */
+static void _test1(ROA_Table* table)
+{
+  printf ("Test #1: Lookup covered and not covered IPv4 prefixes!\n");
+
+  assert_int(table, _lookup(table, "10.1.0.0", 16, TEST_AS),
+             SRx_RESULT_VALID, "Exact match");
+  assert_int(table, _lookup(table, "10.1.0.0", 16, OTHER_AS),
+             SRx_RESULT_INVALID, "Other origin");
+  assert_int(table, _lookup(table, "10.3.0.0", 16, TEST_AS),
+             SRx_RESULT_NOTFOUND, "Not covered");
+  assert_int(table, _lookup(table, "10.0.0.0", 8, TEST_AS),
+             SRx_RESULT_NOTFOUND, "Less specific");
+  // Covered by 10.2.0.0/16 (TEST_AS) and 10.2.3.0/24 (OTHER_AS)
+  assert_int(table, _lookup(table, "10.2.3.0", 24, OTHER_AS),
+             SRx_RESULT_VALID, "More specific ROA");
+  assert_int(table, _lookup(table, "10.2.3.0", 24, TEST_AS),
+             SRx_RESULT_INVALID, "Less specific ROA exceeds max length");
+  printf ("         passed.\n");
+}
+
+/**
+ * Check the max length boundaries.
+ *
+ * @param table The table.
+ */
+static void _test2(ROA_Table* table)
+{
+  printf ("Test #2: Lookup prefixes at the max length boundary!\n");
+
+  assert_int(table, _lookup(table, "10.1.240.0", 20, TEST_AS),
+             SRx_RESULT_VALID, "Prefix length equals max length");
+  assert_int(table, _lookup(table, "10.1.255.0", 21, TEST_AS),
+             SRx_RESULT_INVALID, "Prefix length exceeds max length");
+  assert_int(table, _lookup(table, "10.2.0.0", 16, TEST_AS),
+             SRx_RESULT_VALID, "Max length equals ROA length");
+  assert_int(table, _lookup(table, "10.2.128.0", 17, TEST_AS),
+             SRx_RESULT_INVALID, "Max length equals ROA length exceeded");
+  printf ("         passed.\n");
+}
+
+/**
+ * Check IPv6 prefixes, including prefixes longer than /64.
+ *
+ * @param table The table.
+ */
+static void _test3(ROA_Table* table)
+{
+  printf ("Test #3: Lookup IPv6 prefixes!\n");
+
+  assert_int(table, _lookup(table, "2001:db8:ffff::", 48, TEST_AS),
+             SRx_RESULT_VALID, "IPv6 within max length");
+  assert_int(table, _lookup(table, "2001:db8:ffff:1::", 64, TEST_AS),
+             SRx_RESULT_INVALID, "IPv6 exceeds max length");
+  assert_int(table, _lookup(table, "2001:db9::", 32, TEST_AS),
+             SRx_RESULT_NOTFOUND, "IPv6 not covered");
+  // The ROA and the prefixes differ only in the lower 64 bit
+  assert_int(table, _lookup(table, "2001:db8:0:0:1:2::", 96, OTHER_AS),
+             SRx_RESULT_VALID, "IPv6 longer than /64");
+  assert_int(table, _lookup(table, "2001:db8:0:0:1:2:3::", 112, OTHER_AS),
+             SRx_RESULT_INVALID, "IPv6 longer than /64 exceeds max length");
+  assert_int(table, _lookup(table, "2001:db8:0:0:2::", 80, OTHER_AS),
+             SRx_RESULT_INVALID, "IPv6 longer than /64 only less specific");
+  assert_int(table, _lookup(table, "10.1.0.0", 16, OTHER_AS),
+             SRx_RESULT_INVALID, "IPv4 not affected");
+  printf ("         passed.\n");
+}
+
+/**
+ * This is the main function
+ */
+int main(int argc, char** argv)
+{
+  ROA_Table* table = _initialize();
+
+  printf("\nRun test #1 for covered and not covered prefixes\n");
+  _test1(table);
+
+  printf("\nRun test #2 for the max length boundaries\n");
+  _test2(table);
+
+  printf("\nRun test #3 for IPv6 prefixes\n");
+  _test3(table);
+
+  freeROATable(table);
+
+  printf ("End of all tests!\n");
+  return (EXIT_SUCCESS);
+}
@@ -22,10 +22,12 @@
  *  
  * This files is used for testing the RPKI Queue functions.
  *
- * @version 0.5.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * Added test #5 for large queues and rq_dequeueBatch.
  * 0.5.0.0  - 2017/06/22 - oborchert
  *            * File created
  */
@@ -37,6 +39,8 @@
 #include "server/rpki_queue.h"
 
 #define NO_ELEMENTS 12
+#define NO_ELEMENTS_LARGE 5000
+#define BATCH_SIZE  64
 
 /**
  * check the value against expected, if not match then exit.
@@ -198,6 +202,57 @@ static void _test4(RPKI_QUEUE* queue)
   printf ("         passed.\n");
 }
 
+/**
+ * Queue noElements elements three times (RQ_ROA, RQ_KEY in reverse order and 
+ * RQ_ASPA for each even element), the queue has to grow multiple times. Then 
+ * drain the queue in batches and check the order and the reasons.
+ * 
+ * @param queue The queue to be tested
+ * @param noElements The number of elements to be added
+ */
+static void _test5(RPKI_QUEUE* queue, int noElements)
+{
+  printf ("Test #5: Queue %i elements three times and de-queue them in "
+          "batches of %i!\n", noElements, BATCH_SIZE);
+  
+  RPKI_QUEUE_ELEM elems[BATCH_SIZE];
+  SRxUpdateID updateID = 0;
+  SRxUpdateID expected = 0;
+  int count = 0;
+  int idx   = 0;
+  
+  for (updateID = 0; updateID < noElements; updateID++)
+  {
+    rq_queue(queue, RQ_ROA, &updateID);
+  }
+  for (updateID = noElements; updateID > 0; updateID--)
+  {
+    expected = updateID - 1;
+    rq_queue(queue, RQ_KEY, &expected);
+  }
+  for (updateID = 0; updateID < noElements; updateID += 2)
+  {
+    rq_queue(queue, RQ_ASPA, &updateID);
+  }
+  assert_int (queue, rq_size(queue), noElements, "After Queue was filled");
+  
+  expected = 0;
+  while ((count = rq_dequeueBatch(queue, elems, BATCH_SIZE)) > 0)
+  {
+    for (idx = 0; idx < count; idx++)
+    {
+      assert_int(queue, elems[idx].updateID, expected, "Queue order");
+      assert_int(queue, elems[idx].reason, 
+                 (expected % 2 == 0) ? RQ_ALL : RQ_BOTH, "Element reason");
+      expected++;
+    }
+  }
+  assert_int(queue, expected, noElements, "Number of de-queued elements");
+  assert_int(queue, rq_size(queue), 0, "Queue should be empty");
+  
+  printf ("         passed.\n");
+}
+
 /**
  * This is the main function
  */
@@ -236,6 +291,9 @@ int main(int argc, char** argv)
   // Clean
   _test4(queue);
 
+  printf("\nRun test #5 to store %i elements, check the order and empty the "
+         "queue in batches\n", NO_ELEMENTS_LARGE);
+  _test5(queue, NO_ELEMENTS_LARGE);
   
   rq_releaseQueue(queue);
   
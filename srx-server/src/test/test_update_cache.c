@@ -0,0 +1,406 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ *
+ * This files is used for testing the garbage collector of the Update Cache.
+ * The functions of the AS path cache and the SKI cache used by the garbage
+ * collector are replaced by the ones below.
+ *
+ * @version 0.6.2.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * File created
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include "server/update_cache.h"
+#include "server/prefix_cache.h"
+#include "server/aspath_cache.h"
+#include "server/ski_cache.h"
+#include "server/main.h"
+#include "server/server_connection_handler.h"
+#include "server/rpki_queue.h"
+
+#define CLIENT_ID     1
+#define TEST_AS       65001
+#define NO_HOPS       3
+/** The AS path of the update stored again, its shard differs from the one
+ * of the update */
+#define PATH_ID       3
+/** The maximum number of seconds to wait for the garbage collector */
+#define MAX_WAIT      (UC_GC_INTERVAL * 5)
+
+/** The update cache */
+static UpdateCache       updateCache;
+/** The configuration, only the keep window is used */
+static Configuration     config;
+/** The client mapping of the test client */
+static ProxyClientMapping clientMapping;
+/** The prefix cache */
+static PrefixCache       prefixCache;
+/** The AS path cache, only its address is used */
+static AspathCache       aspathCache;
+/** The update stored again when the garbage collector removes its AS path */
+static SRxUpdateID       restoreID = 0;
+/** The prefix of the update stored again */
+static IPPrefix          restorePrefix;
+
+/**
+ * Replaces the function of the server, the RPKI queue is not used.
+ */
+RPKI_QUEUE* getRPKIQueue()
+{
+  return NULL;
+}
+
+/**
+ * Store the update again and request its validation.
+ *
+ * @param updateID The update ID.
+ * @param prefix The prefix of the update.
+ * @param pathID The AS path ID, 0 for none.
+ *
+ * @return the result of storeUpdate.
+ */
+static int _storeUpdate(SRxUpdateID updateID, IPPrefix* prefix,
+                        uint32_t pathID)
+{
+  SRxDefaultResult defResult;
+  int              retVal;
+
+  memset(&defResult, 0, sizeof(SRxDefaultResult));
+  defResult.result.roaResult    = SRx_RESULT_UNDEFINED;
+  defResult.result.bgpsecResult = SRx_RESULT_UNDEFINED;
+  defResult.result.aspaResult   = SRx_RESULT_UNDEFINED;
+
+  if (pathID != 0)
+  {
+    reserveUpdatePath(&updateCache, pathID);
+  }
+  retVal = storeUpdate(&updateCache, CLIENT_ID, &clientMapping, &updateID,
+                       prefix, TEST_AS, &defResult, NULL, pathID, updateID);
+  requestUpdateValidation(&prefixCache, &updateID, prefix, TEST_AS);
+
+  return retVal;
+}
+
+/**
+ * Replaces the function of the AS path cache. The garbage collector calls it
+ * after the update was removed from the update cache and before it is removed
+ * from the prefix cache, the update given in restoreID is stored again here.
+ */
+bool deleteAspathCache(AspathCache* self, uint32_t pathId,
+                       AS_PATH_LIST* aspl)
+{
+  if (restoreID != 0)
+  {
+    _storeUpdate(restoreID, &restorePrefix, 0);
+    restoreID = 0;
+  }
+  return true;
+}
+
+/**
+ * Replaces the function of the SKI cache.
+ */
+e_Upd_RegRes ski_registerUpdate(SKI_CACHE* cache, SRxUpdateID* updateID,
+                                SCA_BGP_PathAttribute* bgpsec)
+{
+  return REGVAL_UNKNOWN;
+}
+
+/**
+ * Replaces the function of the SKI cache.
+ */
+bool ski_unregisterUpdate(SKI_CACHE* cache, SRxUpdateID* updateID,
+                          SCA_BGP_PathAttribute* bgpsec)
+{
+  return true;
+}
+
+/**
+ * Replaces the function of the SKI cache.
+ */
+bool ski_clean(SKI_CACHE* cache, e_SKI_clean type)
+{
+  return true;
+}
+
+/**
+ * Replaces the function of the server, no SKI cache is used.
+ */
+SKI_CACHE* getSKICache()
+{
+  return NULL;
+}
+
+/**
+ * Receives the changed results, not used in this test.
+ */
+static void _resultChanged(SRxValidationResult* result)
+{
+}
+
+/**
+ * check the value against expected, if not match then exit.
+ *
+ * @param val the value to be checked
+ * @param expected the value to be checked against (expected value)
+ * @param error the error string in case of exit
+ */
+static void assert_int(int val, int expected, char* error)
+{
+  if (val != expected)
+  {
+    printf ("Error: %s; Expected %i but received %i\n", error, expected, val);
+    exit (EXIT_FAILURE);
+  }
+}
+
+/**
+ * Return the statistics of the garbage collector.
+ *
+ * @param stats OUT parameter receiving the statistics.
+ *
+ * @return the statistics.
+ */
+static UC_GCStats* _getStats(UC_GCStats* stats)
+{
+  getUpdateCacheGCStats(&updateCache, stats);
+  return stats;
+}
+
+/**
+ * Wait until the garbage collector reclaimed the given number of updates or
+ * finished more passes than the given one.
+ *
+ * @param reclaimed The number of reclaimed updates to wait for.
+ * @param passes The number of passes to exceed.
+ *
+ * @return true if the garbage collector got there in time.
+ */
+static bool _waitForGC(uint64_t reclaimed, uint64_t passes)
+{
+  UC_GCStats stats;
+  int        waited = 0;
+
+  while (   (_getStats(&stats)->reclaimed < reclaimed
+          || stats.passes <= passes) && (waited < MAX_WAIT * 10))
+  {
+    usleep(100000);
+    waited++;
+  }
+
+  return (stats.reclaimed >= reclaimed) && (stats.passes > passes);
+}
+
+/**
+ * Check if the given update is still in the update cache.
+ *
+ * @param updateID The update ID.
+ *
+ * @return true if the update is found.
+ */
+static bool _isStored(SRxUpdateID updateID)
+{
+  SRxResult        result;
+  SRxDefaultResult defResult;
+
+  return getUpdateResult(&updateCache, &updateID, 0, NULL, &result, &defResult,
+                         NULL);
+}
+
+/**
+ * Fill the given IPv4 prefix.
+ *
+ * @param prefix The prefix to be filled.
+ * @param addr The address in host format.
+ * @param length The prefix length.
+ *
+ * @return the prefix.
+ */
+static IPPrefix* _setPrefix(IPPrefix* prefix, uint32_t addr, uint8_t length)
+{
+  memset(prefix, 0, sizeof(IPPrefix));
+  prefix->ip.version      = 4;
+  prefix->ip.addr.v4.u32  = htonl(addr);
+  prefix->length          = length;
+  return prefix;
+}
+
+/**
+ * Create the update cache and the prefix cache and start the garbage
+ * collector.
+ */
+static void _initialize()
+{
+  printf ("Initialize experiment\n");
+  memset(&config, 0, sizeof(Configuration));
+  config.defaultKeepWindow = 1;
+  if (!createUpdateCache(&updateCache, _resultChanged, 2, &config))
+  {
+    printf ("Error: Could not create the update cache\n");
+    exit (EXIT_FAILURE);
+  }
+  if (!initializePrefixCache(&prefixCache, &updateCache))
+  {
+    printf ("Error: Could not create the prefix cache\n");
+    exit (EXIT_FAILURE);
+  }
+  if (!startUpdateCacheGC(&updateCache, &prefixCache, &aspathCache))
+  {
+    printf ("Error: Could not start the garbage collector\n");
+    exit (EXIT_FAILURE);
+  }
+  printf ("         passed.\n");
+}
+
+/**
+ * Store an update with an AS path, hold its path data inside a read section
+ * and let it expire. The garbage collector removes the update from the caches
+ * but does not release it before the read section is left.
+ */
+static void _test1()
+{
+  uint32_t         asPath[NO_HOPS] = { htonl(65003), htonl(65002),
+                                       htonl(TEST_AS) };
+  SRxUpdateID      updateID = 1;
+  IPPrefix         prefix;
+  BGPSecData       bgpData;
+  SRxDefaultResult defResult;
+  UC_UpdateData*   data = NULL;
+  UC_GCStats       stats;
+  uint64_t         passes;
+  int              idx;
+
+  printf ("Test #1: Hold an update that expires in a read section!\n");
+
+  _setPrefix(&prefix, 0x0A010000, 24);
+  memset(&bgpData, 0, sizeof(BGPSecData));
+  bgpData.numberHops = NO_HOPS;
+  bgpData.asPath     = asPath;
+  memset(&defResult, 0, sizeof(SRxDefaultResult));
+  defResult.result.roaResult    = SRx_RESULT_UNDEFINED;
+  defResult.result.bgpsecResult = SRx_RESULT_UNDEFINED;
+  defResult.result.aspaResult   = SRx_RESULT_UNDEFINED;
+
+  assert_int(storeUpdate(&updateCache, CLIENT_ID, &clientMapping, &updateID,
+                         &prefix, TEST_AS, &defResult, &bgpData, 0, updateID),
+             1, "Store update");
+  requestUpdateValidation(&prefixCache, &updateID, &prefix, TEST_AS);
+
+  enterUpdateCacheReader(&updateCache);
+  data = getUpdateData(&updateCache, &updateID);
+  assert_int(data != NULL, true, "Update data");
+  assert_int(data->hops, NO_HOPS, "Number of hops");
+
+  // The client withdraws the update, it expires with the keep window
+  assert_int(deleteUpdateFromCache(&updateCache, CLIENT_ID, &updateID, 0),
+             true, "Delete update");
+  assert_int(_getStats(&stats)->scheduled, 1, "Scheduled updates");
+  assert_int(_waitForGC(1, 0), true, "Update removed by the garbage collector");
+  assert_int(_isStored(updateID), false, "Removed update found");
+  assert_int(findUpdate(&prefixCache, &updateID, &prefix) == NULL, true,
+             "Update removed from the prefix cache");
+  assert_int(prefixCache.prefixTree->num_active_node, 0,
+             "Tree nodes of the prefix cache");
+
+  // The next pass waits for the read section before releasing the update
+  passes = _getStats(&stats)->passes;
+  assert_int(_waitForGC(1, passes + 1), false, "Pass during the read section");
+  assert_int(_getStats(&stats)->passes, passes, "Passes during read section");
+  assert_int(stats.deferred, 1, "Deferred updates");
+  assert_int(data->hops, NO_HOPS, "Number of hops of the held update");
+  for (idx = 0; idx < NO_HOPS; idx++)
+  {
+    assert_int(data->asn_path[idx], asPath[idx], "AS path of the held update");
+  }
+
+  leaveUpdateCacheReader(&updateCache);
+  assert_int(_waitForGC(1, passes), true, "Pass after the read section");
+  assert_int(_getStats(&stats)->reclaimed, 1, "Reclaimed updates");
+  printf ("         passed.\n");
+}
+
+/**
+ * Store an update again after the garbage collector removed it from the update
+ * cache but before it removed it from the prefix cache. The update stored
+ * again stays in the prefix cache.
+ */
+static void _test2()
+{
+  SRxUpdateID updateID = 2;
+  IPPrefix    prefix;
+  SRxResult   result;
+  SRxDefaultResult defResult;
+  UC_GCStats  stats;
+
+  printf ("Test #2: Store an update again while it is removed!\n");
+
+  _setPrefix(&prefix, 0x0A020000, 24);
+  assert_int(_storeUpdate(updateID, &prefix, PATH_ID), 1, "Store update");
+  assert_int(findUpdate(&prefixCache, &updateID, &prefix) != NULL, true,
+             "Update in the prefix cache");
+
+  restorePrefix = prefix;
+  restoreID     = updateID;
+  assert_int(deleteUpdateFromCache(&updateCache, CLIENT_ID, &updateID, 0),
+             true, "Delete update");
+  assert_int(_waitForGC(2, _getStats(&stats)->passes), true,
+             "Update removed by the garbage collector");
+  assert_int(restoreID, 0, "Update stored again");
+
+  assert_int(_isStored(updateID), true, "Update stored again found");
+  assert_int(findUpdate(&prefixCache, &updateID, &prefix) != NULL, true,
+             "Update stored again in the prefix cache");
+  assert_int(prefixCache.numUpdates, 1, "Updates in the prefix cache");
+  getUpdateResult(&updateCache, &updateID, 0, NULL, &result, &defResult,
+                  NULL);
+  assert_int(result.roaResult, SRx_RESULT_NOTFOUND,
+             "ROA result of the update stored again");
+  printf ("         passed.\n");
+}
+
+/**
+ * This is the main function
+ */
+int main(int argc, char** argv)
+{
+  _initialize();
+
+  printf("\nRun test #1 for an update that expires while it is used\n");
+  _test1();
+
+  printf("\nRun test #2 for an update that is stored again while it is "
+         "removed\n");
+  _test2();
+
+  releaseUpdateCache(&updateCache);
+  releasePrefixCache(&prefixCache);
+
+  printf ("End of all tests!\n");
+  return (EXIT_SUCCESS);
+}
@@ -0,0 +1,208 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Epoch based reclamation. A reader stores the current global epoch in its
+ * own record before it touches the shared data and clears it afterwards.
+ * The writer swaps the data pointer, increments the global epoch and waits
+ * until no record holds an epoch older than the new one. All accesses to the
+ * epoch values are sequentially consistent, therefore a reader that was not
+ * seen by the writer is guaranteed to see the new data pointer.
+ *
+ * @version 0.6.2.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Code created.
+ */
+#include <sched.h>
+#include <stdlib.h>
+#include "util/epoch.h"
+#include "util/log.h"
+
+/**
+ * Called when a thread terminates. The record stays in the list of the
+ * domain and will be re-used by the next thread that registers.
+ *
+ * @param record The reader record of the terminating thread.
+ */
+static void _releaseReader(void* record)
+{
+  EpochReader* reader = (EpochReader*)record;
+  __atomic_store_n(&reader->epoch, 0, __ATOMIC_SEQ_CST);
+  reader->nesting = 0;
+  __atomic_store_n(&reader->inUse, false, __ATOMIC_RELEASE);
+}
+
+/**
+ * Return the reader record of the calling thread, register one if needed.
+ *
+ * @param self The domain
+ *
+ * @return The reader record.
+ */
+static EpochReader* _getReader(EpochDomain* self)
+{
+  EpochReader* reader = pthread_getspecific(self->readerKey);
+
+  if (reader == NULL)
+  {
+    lockMutex(&self->readerMutex);
+    for (reader = self->readers; reader != NULL; reader = reader->next)
+    {
+      if (!__atomic_load_n(&reader->inUse, __ATOMIC_ACQUIRE))
+      {
+        break;
+      }
+    }
+    if (reader == NULL)
+    {
+      reader = calloc(1, sizeof(EpochReader));
+      if (reader == NULL)
+      {
+        unlockMutex(&self->readerMutex);
+        RAISE_ERROR("Not enough memory to register an epoch reader!");
+        abort();
+      }
+      reader->next  = self->readers;
+      self->readers = reader;
+    }
+    reader->epoch   = 0;
+    reader->nesting = 0;
+    __atomic_store_n(&reader->inUse, true, __ATOMIC_RELEASE);
+    unlockMutex(&self->readerMutex);
+
+    pthread_setspecific(self->readerKey, reader);
+  }
+
+  return reader;
+}
+
+/**
+ * Initializes an epoch domain.
+ *
+ * @param self The domain to be initialized
+ * @return \c true = successful, \c false = failed
+ */
+bool initEpochDomain(EpochDomain* self)
+{
+  self->globalEpoch = 1;
+  self->readers     = NULL;
+
+  if (!initMutex(&self->readerMutex))
+  {
+    return false;
+  }
+  if (pthread_key_create(&self->readerKey, _releaseReader) != 0)
+  {
+    RAISE_ERROR("Failed to create the epoch reader key");
+    releaseMutex(&self->readerMutex);
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Releases the epoch domain and all reader records. No thread may be within
+ * a read section at this point.
+ *
+ * @param self The domain
+ */
+void releaseEpochDomain(EpochDomain* self)
+{
+  EpochReader* reader = NULL;
+
+  if (self != NULL)
+  {
+    pthread_key_delete(self->readerKey);
+    lockMutex(&self->readerMutex);
+    while (self->readers != NULL)
+    {
+      reader = self->readers;
+      self->readers = reader->next;
+      free(reader);
+    }
+    unlockMutex(&self->readerMutex);
+    releaseMutex(&self->readerMutex);
+  }
+}
+
+/**
+ * Enter a read section. This call does not block. Read sections can be
+ * nested.
+ *
+ * @param self The domain
+ */
+void enterEpoch(EpochDomain* self)
+{
+  EpochReader* reader = _getReader(self);
+
+  if (reader->nesting++ == 0)
+  {
+    __atomic_store_n(&reader->epoch,
+                     __atomic_load_n(&self->globalEpoch, __ATOMIC_SEQ_CST),
+                     __ATOMIC_SEQ_CST);
+  }
+}
+
+/**
+ * Leave the read section.
+ *
+ * @param self The domain
+ */
+void leaveEpoch(EpochDomain* self)
+{
+  EpochReader* reader = _getReader(self);
+
+  if (--reader->nesting == 0)
+  {
+    __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+  }
+}
+
+/**
+ * Wait until all readers that entered their read section before this call
+ * left it. Data unlinked before this call can be freed afterwards. Must not
+ * be called from within a read section.
+ *
+ * @param self The domain
+ */
+void synchronizeEpoch(EpochDomain* self)
+{
+  EpochReader* reader = NULL;
+  uint64_t     epoch  = 0;
+  uint64_t     target = __atomic_add_fetch(&self->globalEpoch, 1,
+                                           __ATOMIC_SEQ_CST);
+
+  lockMutex(&self->readerMutex);
+  for (reader = self->readers; reader != NULL; reader = reader->next)
+  {
+    epoch = __atomic_load_n(&reader->epoch, __ATOMIC_SEQ_CST);
+    while (epoch != 0 && epoch < target)
+    {
+      sched_yield();
+      epoch = __atomic_load_n(&reader->epoch, __ATOMIC_SEQ_CST);
+    }
+  }
+  unlockMutex(&self->readerMutex);
+}
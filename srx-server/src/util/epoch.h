@@ -0,0 +1,108 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ *
+ * Epoch based reclamation for read-mostly data. Readers enclose each access
+ * to a shared structure between enterEpoch and leaveEpoch and never block.
+ * A writer publishes a new version of the structure by an atomic pointer
+ * swap, calls synchronizeEpoch, and then frees the old version - no reader
+ * can still be using it at that point.
+ *
+ * @version 0.6.2.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Code created.
+ */
+
+#ifndef __EPOCH_H__
+#define __EPOCH_H__
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "util/mutex.h"
+
+/** The reader record of one thread within one epoch domain. */
+typedef struct _EpochReader {
+  /** The epoch the reader entered, 0 if not within a read section */
+  uint64_t             epoch;
+  /** Allows nested read sections */
+  uint32_t             nesting;
+  /** Indicates if the record is assigned to a living thread */
+  bool                 inUse;
+  struct _EpochReader* next;
+} EpochReader;
+
+/** An epoch domain, usually one per protected data structure. */
+typedef struct {
+  /** The global epoch, starts with 1 */
+  uint64_t      globalEpoch;
+  /** All reader records ever registered */
+  EpochReader*  readers;
+  /** Protects the list of reader records */
+  Mutex         readerMutex;
+  /** Provides the reader record of the calling thread */
+  pthread_key_t readerKey;
+} EpochDomain;
+
+/**
+ * Initializes an epoch domain.
+ *
+ * @param self The domain to be initialized
+ * @return \c true = successful, \c false = failed
+ */
+extern bool initEpochDomain(EpochDomain* self);
+
+/**
+ * Releases the epoch domain and all reader records. No thread may be within
+ * a read section at this point.
+ *
+ * @param self The domain
+ */
+extern void releaseEpochDomain(EpochDomain* self);
+
+/**
+ * Enter a read section. This call does not block. Read sections can be
+ * nested.
+ *
+ * @param self The domain
+ */
+extern void enterEpoch(EpochDomain* self);
+
+/**
+ * Leave the read section.
+ *
+ * @param self The domain
+ */
+extern void leaveEpoch(EpochDomain* self);
+
+/**
+ * Wait until all readers that entered their read section before this call
+ * left it. Data unlinked before this call can be freed afterwards. Must not
+ * be called from within a read section.
+ *
+ * @param self The domain
+ */
+extern void synchronizeEpoch(EpochDomain* self);
+
+#endif // !__EPOCH_H__
@@ -19,10 +19,15 @@
  * to set the log method at the beginning of the application - otherwise
  * eventual message will be discarded.
  *
- * @version 0.5.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Exported the active log level for the LOG macro.
+ *           * Made the time stamp buffer thread local.
+ *           * Added the asynchronous mode, messages are passed through a lock
+ *             free ring buffer to a writer thread.
  * 0.5.0.0 - 2017/07/03 - oborchert
  *           * Added missing debug level text
  *           * Fixed issue in _writeToFile where levels are passed that are 
@@ -38,6 +43,11 @@
  *           * Code Created
  * -----------------------------------------------------------------------------
  */
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <time.h>
 #include <syslog.h>
 #include "util/log.h"
@@ -49,6 +59,11 @@
 #define TIMESTAMP_MAX_LEN 18
 #define TIMESTAMP_FORMAT  "%D %I:%M.%S"
 
+/** Number of messages the ring buffer of the asynchronous mode holds (2^n) */
+#define ASYNC_LOG_SLOTS   1024
+/** Maximum length of a message in the asynchronous mode */
+#define ASYNC_LOG_MSG_LEN 512
+
 static const char* LOG_LEVEL_TEXT[] = {
      "EMERGENCY",
      "CRITICAL",
@@ -65,8 +80,8 @@ static const char* LOG_LEVEL_TEXT[] = {
  * Global variables
  */
 
-static LogLevel _activeLevel = LEVEL_DEBUG;
-static char _tsBuf[TIMESTAMP_MAX_LEN];
+LogLevel logActiveLevel = LEVEL_DEBUG;
+static __thread char _tsBuf[TIMESTAMP_MAX_LEN];
 static LogMessagePosted _callback = NULL;
 
 /*--------------------
@@ -77,6 +92,32 @@ static FILE* _stream;
 static char* _buffer;
 static size_t _bufMax;
 
+/*-------------------------------
+ * Asynchronous mode (ring buffer)
+ */
+
+/** A message in the ring buffer. */
+typedef struct {
+  /** Equals the ticket of a writable slot and ticket + 1 of a written one */
+  uint64_t seq;
+  LogLevel level;
+  char     msg[ASYNC_LOG_MSG_LEN];
+} AsyncLogSlot;
+
+static AsyncLogSlot*    _ring         = NULL;
+/** The ticket of the next message to be posted */
+static uint64_t         _ringHead     = 0;
+/** The ticket of the next message to be written, used by the writer only */
+static uint64_t         _ringTail     = 0;
+/** Counts the posted messages, wakes up the writer thread */
+static sem_t            _ringSem;
+static pthread_t        _asyncThread;
+static bool             _asyncRunning = false;
+static bool             _asyncStop    = false;
+/** The log method used by the writer thread */
+static LogMessagePosted _asyncTarget  = NULL;
+static unsigned long    _asyncDropped = 0;
+
 /*--------------------------
  * Internal _write functions
  */
@@ -124,31 +165,242 @@ static void _writeToBuffer (LogLevel level, const char* fmt, va_list args)
   vsnprintf(_buffer + cw, _bufMax - cw, fmt, args);
 }
 
+/**
+ * Formats a single message into the next free slot of the ring buffer. The
+ * slot is claimed by taking a ticket from the ring head, no lock is needed.
+ *
+ * @note LogMessagePosted syntax
+ *
+ * @param fmt Format string
+ * @param args Arguments
+ */
+static void _writeToRing (LogLevel level, const char* fmt, va_list args)
+{
+  uint64_t      pos  = __atomic_load_n(&_ringHead, __ATOMIC_RELAXED);
+  AsyncLogSlot* slot = NULL;
+  int64_t       diff = 0;
+
+  while (true)
+  {
+    slot = &_ring[pos & (ASYNC_LOG_SLOTS - 1)];
+    diff = (int64_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+    if (diff == 0)
+    {
+      // On failure pos receives the current head
+      if (__atomic_compare_exchange_n(&_ringHead, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      {
+        break;
+      }
+    }
+    else if (diff < 0)
+    {
+      // The writer thread did not catch up, the ring is full
+      __atomic_add_fetch(&_asyncDropped, 1, __ATOMIC_RELAXED);
+      return;
+    }
+    else
+    {
+      pos = __atomic_load_n(&_ringHead, __ATOMIC_RELAXED);
+    }
+  }
+
+  slot->level = level;
+  vsnprintf(slot->msg, ASYNC_LOG_MSG_LEN, fmt, args);
+  __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+  sem_post(&_ringSem);
+}
+
+/**
+ * Pass an already formatted message to the log method of the writer thread.
+ *
+ * @param level The log level
+ * @param fmt Format string
+ * @param ... Additional arguments
+ */
+static void _writeAsyncMessage (LogLevel level, const char* fmt, ...)
+{
+  va_list al;
+
+  va_start(al, fmt);
+  _asyncTarget(level, fmt, al);
+  va_end(al);
+}
+
+/**
+ * The writer thread of the asynchronous mode. Writes the messages in the
+ * order of their tickets until it is stopped and all tickets are processed.
+ *
+ * @param arg unused
+ *
+ * @return NULL
+ */
+static void* _asyncLogLoop (void* arg)
+{
+  AsyncLogSlot* slot = NULL;
+
+  while (true)
+  {
+    if (sem_wait(&_ringSem) != 0)
+    {
+      // Interrupted by a signal
+      continue;
+    }
+    if (_ringTail == __atomic_load_n(&_ringHead, __ATOMIC_ACQUIRE))
+    {
+      if (__atomic_load_n(&_asyncStop, __ATOMIC_ACQUIRE))
+      {
+        break;
+      }
+      continue;
+    }
+
+    // The ticket is taken, wait until the message is completely written
+    slot = &_ring[_ringTail & (ASYNC_LOG_SLOTS - 1)];
+    while (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != _ringTail + 1)
+    {
+      sched_yield();
+    }
+    if (_asyncTarget != NULL)
+    {
+      _writeAsyncMessage(slot->level, "%s", slot->msg);
+    }
+    __atomic_store_n(&slot->seq, _ringTail + ASYNC_LOG_SLOTS,
+                     __ATOMIC_RELEASE);
+    _ringTail++;
+  }
+
+  return NULL;
+}
+
+/**
+ * Set the log method. In asynchronous mode the method of the writer thread
+ * is changed.
+ *
+ * @param cb The log method, can be NULL.
+ */
+static void _setLogMethod (LogMessagePosted cb)
+{
+  if (_asyncRunning)
+  {
+    _asyncTarget = cb;
+  }
+  else
+  {
+    _callback = cb;
+  }
+}
+
 /*
  * SetLogMethod* functions
  */
 void setLogMethodToFile (FILE* stream)
 {
   _stream = stream;
-  _callback = (_stream != NULL) ? _writeToFile : NULL;
+  _setLogMethod((_stream != NULL) ? _writeToFile : NULL);
 }
 
 void setLogMethodToSyslog ()
 {
-  _callback = _writeToSyslog;
+  _setLogMethod(_writeToSyslog);
 }
 
 void setLogMethodToBuffer (char* buffer, size_t max)
 {
   _buffer = buffer;
   _bufMax = max;
-  _callback = ((buffer != NULL) && (max > 0)) ?
-  _writeToBuffer : (LogMessagePosted) NULL;
+  _setLogMethod(((buffer != NULL) && (max > 0)) ?
+                _writeToBuffer : (LogMessagePosted) NULL);
 }
 
 void setLogMethodToCallback (LogMessagePosted cb)
 {
-  _callback = cb;
+  _setLogMethod(cb);
+}
+
+/**
+ * Hand all messages to a background thread that writes them using the
+ * currently selected log method.
+ *
+ * @return true if the background thread is running.
+ *
+ * @since 0.6.2.0
+ */
+bool startAsyncLog ()
+{
+  uint32_t idx = 0;
+
+  if (_asyncRunning)
+  {
+    return true;
+  }
+
+  // The ring and its semaphore are kept once allocated, a late message might
+  // still be posted into them after stopAsyncLog. Such messages are counted
+  // by the semaphore and written by the next writer thread.
+  if (_ring == NULL)
+  {
+    _ring = malloc(sizeof(AsyncLogSlot) * ASYNC_LOG_SLOTS);
+    if (_ring == NULL)
+    {
+      return false;
+    }
+    if (sem_init(&_ringSem, 0, 0) != 0)
+    {
+      free(_ring);
+      _ring = NULL;
+      return false;
+    }
+    for (idx = 0; idx < ASYNC_LOG_SLOTS; idx++)
+    {
+      _ring[idx].seq = idx;
+    }
+    _ringHead = 0;
+    _ringTail = 0;
+  }
+
+  _asyncStop   = false;
+  _asyncTarget = _callback;
+  if (pthread_create(&_asyncThread, NULL, _asyncLogLoop, NULL) != 0)
+  {
+    return false;
+  }
+  _asyncRunning = true;
+  _callback     = _writeToRing;
+
+  return true;
+}
+
+/**
+ * Write all pending messages, stop the background thread and return to
+ * synchronous logging. The semaphore is not destroyed, a thread that selected
+ * the asynchronous mode before might still post a message.
+ *
+ * @since 0.6.2.0
+ */
+void stopAsyncLog ()
+{
+  if (_asyncRunning)
+  {
+    _callback = _asyncTarget;
+    __atomic_store_n(&_asyncStop, true, __ATOMIC_RELEASE);
+    sem_post(&_ringSem);
+    pthread_join(_asyncThread, NULL);
+    _asyncRunning = false;
+  }
+}
+
+/**
+ * Return the number of messages dropped because the ring buffer of the
+ * asynchronous mode was full.
+ *
+ * @return The number of dropped messages.
+ *
+ * @since 0.6.2.0
+ */
+unsigned long getDroppedLogMessages ()
+{
+  return __atomic_load_n(&_asyncDropped, __ATOMIC_RELAXED);
 }
 
 /*
@@ -156,7 +408,7 @@ void setLogMethodToCallback (LogMessagePosted cb)
  */
 void setLogLevel (LogLevel level)
 {
-  _activeLevel = level;
+  logActiveLevel = level;
 }
 
 /**
@@ -168,7 +420,7 @@ void setLogLevel (LogLevel level)
  */
 LogLevel getLogLevel()
 {
-  return _activeLevel;
+  return logActiveLevel;
 }
 
 /*
@@ -180,7 +432,7 @@ LogLevel getLogLevel()
  */
 void writeLog (LogLevel level, const char* fmt, ...)
 {
-  if ((_callback != NULL) && (level <= _activeLevel))
+  if ((_callback != NULL) && (level <= logActiveLevel))
   {
     va_list al;
 
@@ -19,10 +19,16 @@
  * to set the log method at the beginning of the application - otherwise 
  * eventual message will be discarded.
  *  
- * @version 0.5.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.6.2.0  - 2026/10/18
+ *            * The LOG, RAISE_ERROR and RAISE_SYS_ERROR macros check the log
+ *              level before any argument or the time stamp is evaluated.
+ *            * Added LOG_COMPILE_LEVEL to remove messages above the given
+ *              level at compile time.
+ *            * Added startAsyncLog and stopAsyncLog.
  * 0.5.0.0  - 2017/07/03 - oborchert
  *            * Added some documentation
  * 0.3.0.10 - 2015/11/09 - oborchert
@@ -45,6 +51,7 @@
 #include <string.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <stdbool.h>
 
 /** 
  * Log levels.
@@ -73,6 +80,22 @@ typedef enum {
   LEVEL_COMM    = 8
 } LogLevel;
 
+/**
+ * Messages with a level above this level are removed by the compiler. Set it
+ * using -DLOG_COMPILE_LEVEL=<level> to strip debug messages from a production
+ * build.
+ */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LEVEL_COMM
+#endif
+
+/**
+ * The active log level. Do not modify directly, use setLogLevel instead.
+ *
+ * @since 0.6.2.0
+ */
+extern LogLevel logActiveLevel;
+
 /** 
  * Function that is called when a log message has been received.
  *
@@ -140,6 +163,39 @@ extern void setLogLevel(LogLevel level);
  */
 extern LogLevel getLogLevel(); 
 
+/**
+ * Hand all messages to a background thread that writes them using the
+ * currently selected log method. The calling threads only format the message
+ * into a ring buffer, they neither block nor take a lock. If the ring buffer
+ * is full the message is dropped and counted.
+ *
+ * Changing the log method while the asynchronous mode is active changes the
+ * method used by the background thread.
+ *
+ * @return true if the background thread is running.
+ *
+ * @since 0.6.2.0
+ */
+extern bool startAsyncLog();
+
+/**
+ * Write all pending messages, stop the background thread and return to
+ * synchronous logging.
+ *
+ * @since 0.6.2.0
+ */
+extern void stopAsyncLog();
+
+/**
+ * Return the number of messages dropped because the ring buffer of the
+ * asynchronous mode was full.
+ *
+ * @return The number of dropped messages.
+ *
+ * @since 0.6.2.0
+ */
+extern unsigned long getDroppedLogMessages();
+
 /**
  * Writes a single message. 
  * The function syntax is similar to 'printf'.
@@ -166,9 +222,20 @@ extern const char* logTimeStamp();
  * Macros
  */
 
-/** See writeLog. */
+/**
+ * Evaluates to true if messages of the given level are written. For a
+ * constant level above LOG_COMPILE_LEVEL this is false at compile time.
+ */
+#define LOG_ENABLED(LEVEL) \
+  __builtin_expect(((LEVEL) <= LOG_COMPILE_LEVEL) \
+                   && ((LEVEL) <= logActiveLevel), 0)
+
+/** See writeLog. The arguments are only evaluated if the level is enabled. */
 #define LOG(LEVEL, FMT, ...) \
-  writeLog(LEVEL, "[%s] " FMT, logTimeStamp(), ## __VA_ARGS__)
+  do { \
+    if (LOG_ENABLED(LEVEL)) \
+    { writeLog(LEVEL, "[%s] " FMT, logTimeStamp(), ## __VA_ARGS__); } \
+  } while (0)
 
 #define STRINGIFY_ARG(ARG) #ARG
 #define STRINGIFY_IND(ARG) STRINGIFY_ARG(ARG)
@@ -180,8 +247,11 @@ extern const char* logTimeStamp();
 
 /** Raises an error - simply a writeLog(LEVEL_ERROR, ...) shortcut */
 #define RAISE_ERROR(FMT, ...) \
-  writeLog(LEVEL_ERROR, ERROR_LEAD FMT, logTimeStamp(), \
-           __func__,  ## __VA_ARGS__)
+  do { \
+    if (LOG_ENABLED(LEVEL_ERROR)) \
+    { writeLog(LEVEL_ERROR, ERROR_LEAD FMT, logTimeStamp(), \
+               __func__,  ## __VA_ARGS__); } \
+  } while (0)
 
 /**
  * Raises a system error. It uses errnum to determine the exact, detailed 
@@ -193,8 +263,11 @@ extern const char* logTimeStamp();
  * @see raiseError
  */
 #define RAISE_SYS_ERROR(FMT, ...) \
-  writeLog(LEVEL_ERROR, ERROR_LEAD FMT " - %s", logTimeStamp(), \
-           __func__, ## __VA_ARGS__, strerror(errno))
+  do { \
+    if (LOG_ENABLED(LEVEL_ERROR)) \
+    { writeLog(LEVEL_ERROR, ERROR_LEAD FMT " - %s", logTimeStamp(), \
+               __func__, ## __VA_ARGS__, strerror(errno)); } \
+  } while (0)
 
 #endif // !__LOG_H__
 
@@ -22,10 +22,14 @@
  *
  * Provides functionality to handle the SRx server socket.
  *
- * @version 0.5.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ *  0.6.2.0 - 2026/10/18
+ *            * Added MODE_EPOLL_CLIENTS, an epoll reactor with a fixed pool of
+ *              worker threads that reads the packets of all connections.
+ *            * Added sendPacketsToClient.
  *  0.5.0.0 - 2017/06/16 - oborchert
  *            * Version 0.4.1.0 is trashed and moved to 0.5.0.0
  *          - 2016/10/26 - oborchert
@@ -56,6 +60,8 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -131,7 +137,8 @@ static void clientThreadCleanup(ClientMode mode, ClientThread* ct)
   if (ct->svrSock->statusCallback != NULL)
   {
     ct->svrSock->statusCallback(ct->svrSock,
-                                (mode == MODE_SINGLE_CLIENT) ? ct : NULL,
+                                ((mode == MODE_SINGLE_CLIENT)
+                                 || (mode == MODE_EPOLL_CLIENTS)) ? ct : NULL,
                                 ct->clientFD, false, ct->svrSock->user);
   }
 
@@ -144,8 +151,12 @@ static void clientThreadCleanup(ClientMode mode, ClientThread* ct)
         socketToStr(ct->clientFD, true, buf, MAX_SOCKET_STRING_LEN));
   }
 
-  // The instance can be reused
-  releaseMutex(&ct->writeMutex);
+  // The instance can be reused, in MODE_EPOLL_CLIENTS the mutex is released
+  // once the server loop stops.
+  if (mode != MODE_EPOLL_CLIENTS)
+  {
+    releaseMutex(&ct->writeMutex);
+  }
   ct->active = false;
 }
 
@@ -525,6 +536,315 @@ static void* custom_handleClient(void* data)
   pthread_exit(0);
 }
 
+/*-------------------
+ * MODE_EPOLL_CLIENTS
+ */
+
+/**
+ * Register the connection with the epoll instance or re-arm it. Each
+ * connection is registered as one-shot, therefore only one worker at a time
+ * reads from it and the packets are dispatched in the order received.
+ *
+ * @note MODE_EPOLL_CLIENTS
+ *
+ * @param cthread The client connection
+ * @param op EPOLL_CTL_ADD or EPOLL_CTL_MOD
+ *
+ * @return true if the connection is (re-)armed
+ */
+static bool epoll_armClient(ClientThread* cthread, int op)
+{
+  struct epoll_event event;
+
+  memset(&event, 0, sizeof(struct epoll_event));
+  event.events   = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+  event.data.ptr = cthread;
+
+  if (epoll_ctl(cthread->svrSock->epollFD, op, cthread->clientFD, &event) != 0)
+  {
+    RAISE_SYS_ERROR("Failed to register the client connection for events");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Read all data available on the connection without blocking and pass each
+ * completed packet to the ServerPacketReceived callback. Incomplete packets
+ * remain in the receive buffer of the connection.
+ *
+ * @note MODE_EPOLL_CLIENTS
+ *
+ * @param cthread The client connection
+ *
+ * @return false if the connection is closed or broken.
+ */
+static bool epoll_receivePackets(ClientThread* cthread)
+{
+  ServerSocket*         svrSock   = cthread->svrSock;
+  uint32_t              basicLen  = sizeof(SRXPROXY_BasicHeader);
+  SRXPROXY_BasicHeader* hdr       = NULL;
+  uint32_t              pduLength = 0;
+  uint32_t              offset    = 0;
+  uint8_t*              newBuf    = NULL;
+  ssize_t               rbytes    = 0;
+
+  while (__atomic_load_n(&cthread->active, __ATOMIC_ACQUIRE))
+  {
+    rbytes = recv(cthread->clientFD, cthread->recvBuffer + cthread->recvFill,
+                  cthread->recvBufferSize - cthread->recvFill,
+                  MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (rbytes == 0)
+    {
+      LOG(LEVEL_DEBUG, HDR "Connection to client closed", pthread_self());
+      return false;
+    }
+    if (rbytes < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+      {
+        // All available data is read
+        return true;
+      }
+      LOG(LEVEL_DEBUG, HDR "Connection to client broken (errno %d)",
+                       pthread_self(), errno);
+      return false;
+    }
+    cthread->recvFill += (uint32_t)rbytes;
+
+    // Dispatch all completed packets
+    offset    = 0;
+    pduLength = 0;
+    while ((cthread->recvFill - offset) >= basicLen)
+    {
+      hdr       = (SRXPROXY_BasicHeader*)(cthread->recvBuffer + offset);
+      pduLength = ntohl(hdr->length);
+      if (pduLength < basicLen)
+      {
+        RAISE_ERROR("Received PDU is invalid (length %u)!", pduLength);
+        return false;
+      }
+      if ((cthread->recvFill - offset) < pduLength)
+      {
+        break;
+      }
+      ((ServerPacketReceived)svrSock->modeCallback)(svrSock, cthread, hdr,
+                                                    pduLength, svrSock->user);
+      offset   += pduLength;
+      pduLength = 0;
+      if (!__atomic_load_n(&cthread->active, __ATOMIC_ACQUIRE))
+      {
+        // The connection was closed by the callback.
+        return false;
+      }
+    }
+
+    // Move the incomplete packet to the front
+    if (offset > 0)
+    {
+      cthread->recvFill -= offset;
+      memmove(cthread->recvBuffer, cthread->recvBuffer + offset,
+              cthread->recvFill);
+    }
+
+    // The incomplete packet does not fit into the buffer
+    if (pduLength > cthread->recvBufferSize)
+    {
+      newBuf = realloc(cthread->recvBuffer, pduLength);
+      if (newBuf == NULL)
+      {
+        RAISE_ERROR("Not enough memory for receiving packets");
+        return false;
+      }
+      cthread->recvBuffer     = newBuf;
+      cthread->recvBufferSize = pduLength;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Release the connection once it is closed. If the client closed the
+ * connection the user is informed using the status callback. If the
+ * connection was closed using closeClientConnection only the socket and the
+ * receive buffer are released. This is the only place the socket of a
+ * connection is closed while the worker threads are running.
+ *
+ * @note MODE_EPOLL_CLIENTS
+ *
+ * @param cthread The client connection
+ */
+static void epoll_releaseClient(ClientThread* cthread)
+{
+  bool wasActive;
+
+  // Exactly one of the worker and closeClientConnection sets the connection
+  // inactive. closeClientConnection only shuts down an active connection,
+  // therefore its socket is still open.
+  lockMutex(&cthread->stateMutex);
+  wasActive       = cthread->active;
+  cthread->active = false;
+  unlockMutex(&cthread->stateMutex);
+
+  epoll_ctl(cthread->svrSock->epollFD, EPOLL_CTL_DEL, cthread->clientFD, NULL);
+  if (wasActive)
+  {
+    // The connection was closed by the client
+    clientThreadCleanup(MODE_EPOLL_CLIENTS, cthread);
+  }
+
+  // Senders that passed the active check before fail on the closed socket.
+  lockMutex(&cthread->writeMutex);
+  close(cthread->clientFD);
+  cthread->clientFD = -1;
+  unlockMutex(&cthread->writeMutex);
+  safeFree(cthread->recvBuffer);
+  cthread->recvBuffer     = NULL;
+  cthread->recvBufferSize = 0;
+  cthread->recvFill       = 0;
+}
+
+/**
+ * Worker thread that waits for data on any of the client connections and
+ * dispatches the received packets.
+ *
+ * @note MODE_EPOLL_CLIENTS
+ * @note PThread syntax
+ *
+ * @param data ServerSocket instance
+ * @return Always \c NULL
+ */
+static void* epoll_handleClients(void* data)
+{
+  ServerSocket*      self = (ServerSocket*)data;
+  ClientThread*      cthread;
+  struct epoll_event event;
+  int                ret;
+
+  LOG(LEVEL_DEBUG, "([0x%08X]) > Proxy Client Worker Thread started "
+                   "(ServerSocket::epoll_handleClients)", pthread_self());
+
+  while (__atomic_load_n(&self->stopping, __ATOMIC_ACQUIRE) == 0)
+  {
+    // One event at a time, the other workers serve the remaining connections
+    ret = epoll_wait(self->epollFD, &event, 1, -1);
+    if (ret < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      RAISE_SYS_ERROR("An error occurred while waiting for client data");
+      break;
+    }
+    if ((ret == 0) || (event.data.ptr == NULL))
+    {
+      // Woken up to check the stopping flag.
+      continue;
+    }
+
+    cthread = (ClientThread*)event.data.ptr;
+    if (!epoll_receivePackets(cthread)
+        || !epoll_armClient(cthread, EPOLL_CTL_MOD))
+    {
+      epoll_releaseClient(cthread);
+    }
+  }
+
+  LOG(LEVEL_DEBUG, "([0x%08X]) < Proxy Client Worker Thread stopped "
+                   "(ServerSocket::epoll_handleClients)", pthread_self());
+  return NULL;
+}
+
+/**
+ * Create the epoll instance and start the worker threads, one per CPU.
+ *
+ * @note MODE_EPOLL_CLIENTS
+ *
+ * @param self The server socket
+ *
+ * @return true if at least one worker is running
+ */
+static bool epoll_startWorkers(ServerSocket* self)
+{
+  struct epoll_event event;
+  long               numCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+  int                numThreads;
+
+  self->numWorkers = 0;
+  self->epollFD    = epoll_create1(EPOLL_CLOEXEC);
+  if (self->epollFD < 0)
+  {
+    RAISE_SYS_ERROR("Failed to create the epoll instance");
+    return false;
+  }
+  self->wakeFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (self->wakeFD < 0)
+  {
+    RAISE_SYS_ERROR("Failed to create the wake-up event");
+    close(self->epollFD);
+    return false;
+  }
+  // Level triggered and never read, once signaled all workers wake up.
+  memset(&event, 0, sizeof(struct epoll_event));
+  event.events   = EPOLLIN;
+  event.data.ptr = NULL;
+  if (epoll_ctl(self->epollFD, EPOLL_CTL_ADD, self->wakeFD, &event) != 0)
+  {
+    RAISE_SYS_ERROR("Failed to register the wake-up event");
+    close(self->wakeFD);
+    close(self->epollFD);
+    return false;
+  }
+
+  numThreads = (numCPUs < 1) ? 1 : (int)numCPUs;
+  if (numThreads > MAX_SOCKET_WORKERS)
+  {
+    numThreads = MAX_SOCKET_WORKERS;
+  }
+  for (; self->numWorkers < numThreads; self->numWorkers++)
+  {
+    if (pthread_create(&self->workers[self->numWorkers], NULL,
+                       epoll_handleClients, self) != 0)
+    {
+      RAISE_ERROR("Failed to create a client worker thread");
+      break;
+    }
+  }
+
+  return self->numWorkers > 0;
+}
+
+/**
+ * Wake up and join all worker threads. The stopping flag must be set.
+ *
+ * @note MODE_EPOLL_CLIENTS
+ *
+ * @param self The server socket
+ */
+static void epoll_stopWorkers(ServerSocket* self)
+{
+  uint64_t signal = 1;
+  int      idx;
+
+  if (write(self->wakeFD, &signal, sizeof(uint64_t)) != sizeof(uint64_t))
+  {
+    RAISE_SYS_ERROR("Failed to wake up the client worker threads");
+  }
+  for (idx = 0; idx < self->numWorkers; idx++)
+  {
+    pthread_join(self->workers[idx], NULL);
+  }
+  self->numWorkers = 0;
+  close(self->wakeFD);
+  close(self->epollFD);
+}
+
 /*--------
  * Exports
  */
@@ -678,7 +998,8 @@ void runServerLoop(ServerSocket* self, ClientMode clMode,
   static void* (*CL_THREAD_ROUTINES[NUM_CLIENT_MODES])(void*) = {
                                single_handleClient,
                                multi_handleClient,
-                               custom_handleClient
+                               custom_handleClient,
+                               NULL // MODE_EPOLL_CLIENTS uses the workers
   };
 
   int cliendFD;
@@ -701,6 +1022,14 @@ void runServerLoop(ServerSocket* self, ClientMode clMode,
   // No active threads
   initSList(&self->cthreads);
 
+  // The worker threads serve all connections
+  if ((clMode == MODE_EPOLL_CLIENTS) && !epoll_startWorkers(self))
+  {
+    RAISE_ERROR("Failed to start the client worker threads");
+    pthread_attr_destroy(&attr);
+    return;
+  }
+
   // Prepare socket to accept connections
   listen(self->serverFD, MAX_PENDING_CONNECTIONS);
   
@@ -771,14 +1100,42 @@ void runServerLoop(ServerSocket* self, ClientMode clMode,
         cthread->clientFD = cliendFD;
         cthread->svrSock  = self;
         cthread->caddr	  = caddr;
+        cthread->recvBuffer     = NULL;
+        cthread->recvBufferSize = 0;
+        cthread->recvFill       = 0;
 
-        ret = pthread_create(&(cthread->thread), &attr,
-                             CL_THREAD_ROUTINES[clMode],
-                             (void*)cthread);
-        if (ret != 0)
+        if (clMode == MODE_EPOLL_CLIENTS)
+        {
+          // No thread, the connection is registered with the workers.
+          cthread->thread     = 0;
+          cthread->recvBuffer = malloc(EPOLL_RECV_BUFFER_SIZE);
+          if (cthread->recvBuffer == NULL)
+          {
+            accepted = false;
+            RAISE_ERROR("Not enough memory for another connection");
+          }
+          else
+          {
+            cthread->recvBufferSize = EPOLL_RECV_BUFFER_SIZE;
+            accepted = initWriteMutex(cthread)
+                       && initMutex(&cthread->stateMutex)
+                       && epoll_armClient(cthread, EPOLL_CTL_ADD);
+          }
+          if (!accepted)
+          {
+            safeFree(cthread->recvBuffer);
+          }
+        }
+        else
         {
-          accepted = false;
-          RAISE_ERROR("Failed to create a client thread");
+          ret = pthread_create(&(cthread->thread), &attr,
+                               CL_THREAD_ROUTINES[clMode],
+                               (void*)cthread);
+          if (ret != 0)
+          {
+            accepted = false;
+            RAISE_ERROR("Failed to create a client thread");
+          }
         }
       }
 
@@ -802,7 +1159,36 @@ static void _killClientThread(void* clt)
 {
   ClientThread* clientThread = (ClientThread*)clt;
 
-  if (clientThread->active)
+  if (clientThread->svrSock->mode == MODE_EPOLL_CLIENTS)
+  {
+    if (__atomic_load_n(&clientThread->svrSock->stopping, 
+                        __ATOMIC_ACQUIRE) == 0)
+    {
+      lockMutex(&clientThread->stateMutex);
+      if (clientThread->active)
+      {
+        __atomic_store_n(&clientThread->active, false, __ATOMIC_RELEASE);
+        // Wakes up the worker serving the connection which releases it.
+        shutdown(clientThread->clientFD, SHUT_RDWR);
+      }
+      unlockMutex(&clientThread->stateMutex);
+    }
+    else
+    {
+      // The workers are stopped already, release what they did not release.
+      clientThread->active = false;
+      if (clientThread->clientFD >= 0)
+      {
+        close(clientThread->clientFD);
+        clientThread->clientFD = -1;
+      }
+      safeFree(clientThread->recvBuffer);
+      clientThread->recvBuffer = NULL;
+      releaseMutex(&clientThread->writeMutex);
+      releaseMutex(&clientThread->stateMutex);
+    }
+  }
+  else if (clientThread->active)
   {
     // Close the client connection
     close(clientThread->clientFD);
@@ -826,11 +1212,17 @@ static void _killClientThread(void* clt)
  */
 void stopServerLoop(ServerSocket* self)
 {
-  if (++self->stopping == 1)
+  if (__atomic_add_fetch(&self->stopping, 1, __ATOMIC_ACQ_REL) == 1)
   {
     // Stop accepting connections 
     close(self->serverFD);
 
+    if (self->mode == MODE_EPOLL_CLIENTS)
+    {
+      // No worker touches a connection after this point
+      epoll_stopWorkers(self);
+    }
+
     // Kill all threads
     foreachInSList(&self->cthreads, _killClientThread);
     releaseSList(&self->cthreads);
@@ -848,7 +1240,8 @@ bool sendPacketToClient(ServerSocket* self, ServerClient* client,
     return false;
   }
 
-  if (self->mode == MODE_SINGLE_CLIENT)
+  if ((self->mode == MODE_SINGLE_CLIENT)
+      || (self->mode == MODE_EPOLL_CLIENTS))
   {
     return single_sendResult(client, data, size);
   }
@@ -860,6 +1253,102 @@ bool sendPacketToClient(ServerSocket* self, ServerClient* client,
   return false;
 }
 
+/**
+ * Sends the packets to a client using a single scatter-gather write as far as
+ * this is possible without blocking. A packet that could only be send in part
+ * is completed blocking, the returned number of bytes therefore always ends
+ * with a complete packet.
+ *
+ * @note For MODE_MULTIPLE_CLIENTS each packet is send using
+ *       sendPacketToClient.
+ *
+ * @param self Server-socket instance
+ * @param client Client
+ * @param packets One element per packet
+ * @param count The number of packets
+ *
+ * @return The number of bytes send or -1 if an error occurred (e.g. inactive
+ *         client)
+ *
+ * @since 0.6.2.0
+ */
+ssize_t sendPacketsToClient(ServerSocket* self, ServerClient* client,
+                            struct iovec* packets, int count)
+{
+  ClientThread* clt  = (ClientThread*)client;
+  ssize_t       sent = 0;
+  ssize_t       sbytes;
+  size_t        done = 0;
+  size_t        left = 0;
+  struct msghdr msg;
+  int           idx;
+
+  if (self == NULL)
+  {
+    RAISE_ERROR("Server Socket instance is NULL");
+    return -1;
+  }
+
+  if (self->mode == MODE_MULTIPLE_CLIENTS)
+  {
+    for (idx = 0; idx < count; idx++)
+    {
+      if (!multi_sendResult(client, packets[idx].iov_base, 
+                            packets[idx].iov_len))
+      {
+        return sent > 0 ? sent : -1;
+      }
+      sent += packets[idx].iov_len;
+    }
+    return sent;
+  }
+
+  if ((self->mode != MODE_SINGLE_CLIENT) && (self->mode != MODE_EPOLL_CLIENTS))
+  {
+    RAISE_ERROR("Cannot send packets in this mode");
+    return -1;
+  }
+
+  if (!clt->active)
+  {
+    RAISE_ERROR("Trying to send a packet over an inactive connection");
+    return -1;
+  }
+
+  memset(&msg, 0, sizeof(struct msghdr));
+  msg.msg_iov    = packets;
+  msg.msg_iovlen = count;
+
+  lockMutex(&clt->writeMutex);
+  sbytes = sendmsg(clt->clientFD, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+  if (sbytes < 0)
+  {
+    // Nothing could be send without blocking.
+    sent = ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : -1;
+  }
+  else
+  {
+    // Find the packet that was send in part if any.
+    for (idx = 0; (idx < count) 
+                  && (done + packets[idx].iov_len <= (size_t)sbytes); idx++)
+    {
+      done += packets[idx].iov_len;
+    }
+    sent = sbytes;
+    if (done < (size_t)sbytes)
+    {
+      // Complete it so no other packet gets written in between.
+      left = packets[idx].iov_len - ((size_t)sbytes - done);
+      sent = sendNum(&clt->clientFD, 
+                     (uint8_t*)packets[idx].iov_base + ((size_t)sbytes - done),
+                     left) ? sbytes + (ssize_t)left : -1;
+    }
+  }
+  unlockMutex(&clt->writeMutex);
+
+  return sent;
+}
+
 /**
  * Closes the connection associated with the given client.
  * 
@@ -882,7 +1371,12 @@ int closeClientConnection(ServerSocket* self, ServerClient* client)
                   clientThread->proxyID);
   LOG(LEVEL_INFO, "Client connection [ID:%u] closed!", clientThread->proxyID);
 
-  deleteFromSList(&self->cthreads, clientThread);
+  // The worker serving the connection still releases it, the instance is
+  // removed once the server loop stops.
+  if (self->mode != MODE_EPOLL_CLIENTS)
+  {
+    deleteFromSList(&self->cthreads, clientThread);
+  }
   
   return true;
 }
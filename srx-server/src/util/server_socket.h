@@ -23,10 +23,14 @@
  * Function to create a server-socket and to start/stop a server runloop.
  * Provides functionality to handle the SRx server socket.
  *
- * @version 0.5.0.0
+ * @version 0.6.2.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ *  0.6.2.0 - 2026/10/18
+ *            * Added MODE_EPOLL_CLIENTS.
+ *            * Added sendPacketsToClient.
+ *            * Added stateMutex to ClientThread.
  *  0.5.0.0 - 2017/06/16 - oborchert
  *            * Version 0.4.1.0 is trashed and moved to 0.5.0.0
  *  0.5.0.0 - 2016/08/19 - oborchert
@@ -71,18 +75,30 @@
  *   <td>ClientConnectionAccepted</td>
  *   <td>no</td>
  * </tr>
+ * <tr>
+ *   <td>MODE_EPOLL_CLIENTS</td>
+ *   <td>N clients, 1 connection each, served by a fixed pool of threads</td>
+ *   <td>ServerPacketReceived</td>
+ *   <td>yes</td>
+ * </tr>
  * </table>
  *
  */
 #ifndef __SERVER_SOCKET_H__
 #define __SERVER_SOCKET_H__
 
+#include <sys/types.h>
+#include <sys/uio.h>
 #include "util/mutex.h"
 #include "util/packet.h"
 #include "util/slist.h"
 
 /** Maximum number of clients waiting to be accepted for connection. */
 #define MAX_PENDING_CONNECTIONS 5
+/** Maximum number of threads serving the connections in MODE_EPOLL_CLIENTS */
+#define MAX_SOCKET_WORKERS      8
+/** Initial size of the receive buffer of a connection in MODE_EPOLL_CLIENTS */
+#define EPOLL_RECV_BUFFER_SIZE  65536
 
 ////////////////////////////////////////////////////////////////////////////////
 // ERROR STRINGS - Moved from code to here with version 0.5.0.0
@@ -132,6 +148,7 @@ typedef enum
   MODE_SINGLE_CLIENT = 0, // 1 client  : 1 connection, ServerPacketReceived
   MODE_MULTIPLE_CLIENTS, // N clients : 1 connection, ServerPacketReceived
   MODE_CUSTOM_CALLBACK, // Custom, ClientConnectionAccepted
+  MODE_EPOLL_CLIENTS,   // N clients : N connections, ServerPacketReceived
 
   NUM_CLIENT_MODES ///< Number of different modes (needs to be the last item)
 } ClientMode;
@@ -224,6 +241,15 @@ struct _ServerSocket
   int stopping;
   SList cthreads;
   bool verbose;
+
+  // MODE_EPOLL_CLIENTS
+  /** The epoll instance all client connections are registered with. */
+  int epollFD;
+  /** Event file descriptor used to wake up the worker threads. */
+  int wakeFD;
+  /** The threads that read and dispatch the packets. */
+  pthread_t workers[MAX_SOCKET_WORKERS];
+  int numWorkers;
 } ;
 
 /**
@@ -259,6 +285,16 @@ typedef struct
   
   Mutex writeMutex;
 
+  /** MODE_EPOLL_CLIENTS: Serializes closing the connection with its release
+   * by the worker thread, only the worker closes the socket. */
+  Mutex stateMutex;
+  /** MODE_EPOLL_CLIENTS: Buffer of the partially received packets. */
+  uint8_t* recvBuffer;
+  /** MODE_EPOLL_CLIENTS: The size of the receive buffer. */
+  uint32_t recvBufferSize;
+  /** MODE_EPOLL_CLIENTS: The number of bytes in the receive buffer. */
+  uint32_t recvFill;
+
   /* the server socket itself. */
   ServerSocket* svrSock;
   /* The socket address. */
@@ -318,8 +354,34 @@ void stopServerLoop(ServerSocket* self);
 bool sendPacketToClient(ServerSocket* self, ServerClient* client,
                         void* data, size_t size);
 
+/**
+ * Sends the packets to a client using a single scatter-gather write as far as
+ * this is possible without blocking. A packet that could only be send in part
+ * is completed blocking, the returned number of bytes therefore always ends
+ * with a complete packet.
+ *
+ * @note For MODE_MULTIPLE_CLIENTS each packet is send using
+ *       sendPacketToClient.
+ *
+ * @param self Server-socket instance
+ * @param client Client
+ * @param packets One element per packet
+ * @param count The number of packets
+ *
+ * @return The number of bytes send or -1 if an error occurred (e.g. inactive
+ *         client)
+ *
+ * @since 0.6.2.0
+ */
+ssize_t sendPacketsToClient(ServerSocket* self, ServerClient* client,
+                            struct iovec* packets, int count);
+
 /**
  * Closes the connection associated with the given client.
+ *
+ * @note In MODE_EPOLL_CLIENTS the connection is shut down here and released
+ *       by the worker thread serving it. The client object remains valid
+ *       until the server loop stops.
  * 
  * @param self The server socket whose client has to be handled,
  * @param client The client connection object to be closed.
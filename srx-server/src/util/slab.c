@@ -0,0 +1,428 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Slab pools. Free objects are linked through their first bytes, the first
+ * bytes of a slab link all slabs of a pool. A thread takes objects from its
+ * own cache first and moves half a cache between its cache and the free list
+ * of the pool when the cache runs empty or full. The cache counters are only
+ * written by the owning thread, the statistics read them without locking.
+ *
+ * @version 0.6.2.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Code created.
+ */
+#include <stdlib.h>
+#include "util/slab.h"
+#include "util/log.h"
+
+/** The alignment of all objects */
+#define SLAB_ALIGN       16
+/** The size of the slab header, keeps the objects aligned */
+#define SLAB_HEADER      SLAB_ALIGN
+/** The smallest size class of allocSlabData is 2^SLAB_MIN_SHIFT */
+#define SLAB_MIN_SHIFT   4
+/** The number of size classes of allocSlabData */
+#define SLAB_NUM_CLASSES 9
+
+/** All pools that are set up */
+static SlabPool*       _pools     = NULL;
+/** Protects the list of pools and the setup of a pool */
+static pthread_mutex_t _poolMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** The size classes of allocSlabData, 16 to 4096 bytes */
+static SlabPool _dataPools[SLAB_NUM_CLASSES] = {
+  SLAB_POOL_INITIALIZER("data-16",   16),
+  SLAB_POOL_INITIALIZER("data-32",   32),
+  SLAB_POOL_INITIALIZER("data-64",   64),
+  SLAB_POOL_INITIALIZER("data-128",  128),
+  SLAB_POOL_INITIALIZER("data-256",  256),
+  SLAB_POOL_INITIALIZER("data-512",  512),
+  SLAB_POOL_INITIALIZER("data-1024", 1024),
+  SLAB_POOL_INITIALIZER("data-2048", 2048),
+  SLAB_POOL_INITIALIZER("data-4096", 4096)
+};
+
+/**
+ * Move objects from the cache into the free list of the pool.
+ *
+ * @param pool The pool
+ * @param cache The cache of the calling thread
+ * @param count The number of objects to move
+ */
+static void _flushCache(SlabPool* pool, SlabCache* cache, uint32_t count)
+{
+  void* obj = NULL;
+
+  lockMutex(&pool->mutex);
+  while (count-- > 0 && cache->count > 0)
+  {
+    obj = cache->objects[--cache->count];
+    *(void**)obj   = pool->freeList;
+    pool->freeList = obj;
+    pool->freeCount++;
+  }
+  unlockMutex(&pool->mutex);
+}
+
+/**
+ * Called when a thread terminates. The cached objects are returned to the
+ * pool, the cache stays in the list of the pool and will be re-used by the
+ * next thread that registers.
+ *
+ * @param record The cache of the terminating thread.
+ */
+static void _releaseCache(void* record)
+{
+  SlabCache* cache = (SlabCache*)record;
+
+  _flushCache(cache->pool, cache, SLAB_CACHE_SIZE);
+  __atomic_store_n(&cache->inUse, false, __ATOMIC_RELEASE);
+}
+
+/**
+ * Set up the pool with its first use.
+ *
+ * @param pool The pool
+ *
+ * @return true if the pool is set up.
+ */
+static bool _initPool(SlabPool* pool)
+{
+  bool retVal = true;
+
+  pthread_mutex_lock(&_poolMutex);
+  if (!pool->initialized)
+  {
+    pool->slotSize = pool->objSize < sizeof(void*) ? sizeof(void*)
+                                                   : pool->objSize;
+    pool->slotSize = (pool->slotSize + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+    pool->objsPerSlab = (SLAB_SIZE - SLAB_HEADER) / pool->slotSize;
+    if (pool->objsPerSlab == 0)
+    {
+      pool->objsPerSlab = 1;
+    }
+    pool->numSlabs  = 0;
+    pool->slabs     = NULL;
+    pool->freeList  = NULL;
+    pool->freeCount = 0;
+    pool->caches    = NULL;
+
+    if (pthread_key_create(&pool->cacheKey, _releaseCache) != 0)
+    {
+      RAISE_ERROR("Failed to create the cache key of slab pool '%s'",
+                  pool->name);
+      retVal = false;
+    }
+    else
+    {
+      pool->next = _pools;
+      _pools     = pool;
+      __atomic_store_n(&pool->initialized, true, __ATOMIC_RELEASE);
+    }
+  }
+  pthread_mutex_unlock(&_poolMutex);
+
+  return retVal;
+}
+
+/**
+ * Return the cache of the calling thread, register one if needed.
+ *
+ * @param pool The pool
+ *
+ * @return The cache or NULL if no memory is available.
+ */
+static SlabCache* _getCache(SlabPool* pool)
+{
+  SlabCache* cache = NULL;
+
+  if (!__atomic_load_n(&pool->initialized, __ATOMIC_ACQUIRE))
+  {
+    if (!_initPool(pool))
+    {
+      return NULL;
+    }
+  }
+
+  cache = pthread_getspecific(pool->cacheKey);
+  if (cache == NULL)
+  {
+    lockMutex(&pool->mutex);
+    for (cache = pool->caches; cache != NULL; cache = cache->next)
+    {
+      if (!__atomic_load_n(&cache->inUse, __ATOMIC_ACQUIRE))
+      {
+        break;
+      }
+    }
+    if (cache == NULL)
+    {
+      cache = calloc(1, sizeof(SlabCache));
+      if (cache == NULL)
+      {
+        unlockMutex(&pool->mutex);
+        RAISE_ERROR("Not enough memory to register a slab cache!");
+        return NULL;
+      }
+      cache->pool  = pool;
+      cache->next  = pool->caches;
+      pool->caches = cache;
+    }
+    __atomic_store_n(&cache->inUse, true, __ATOMIC_RELEASE);
+    unlockMutex(&pool->mutex);
+
+    pthread_setspecific(pool->cacheKey, cache);
+  }
+
+  return cache;
+}
+
+/**
+ * Move up to half a cache of objects from the pool into the cache. Allocates
+ * a new slab if the free list of the pool is empty.
+ *
+ * @param pool The pool
+ * @param cache The cache of the calling thread
+ *
+ * @return false if no memory is available.
+ */
+static bool _refillCache(SlabPool* pool, SlabCache* cache)
+{
+  uint8_t* slab = NULL;
+  void*    obj  = NULL;
+  uint32_t idx;
+
+  lockMutex(&pool->mutex);
+  if (pool->freeList == NULL)
+  {
+    slab = malloc(SLAB_HEADER + (pool->objsPerSlab * pool->slotSize));
+    if (slab == NULL)
+    {
+      unlockMutex(&pool->mutex);
+      RAISE_ERROR("Not enough memory for a new slab of pool '%s'", pool->name);
+      return false;
+    }
+    *(void**)slab = pool->slabs;
+    pool->slabs   = slab;
+    __atomic_store_n(&pool->numSlabs, pool->numSlabs + 1, __ATOMIC_RELAXED);
+
+    // Link the objects in ascending order
+    for (idx = pool->objsPerSlab; idx > 0; idx--)
+    {
+      obj = slab + SLAB_HEADER + ((idx - 1) * pool->slotSize);
+      *(void**)obj   = pool->freeList;
+      pool->freeList = obj;
+    }
+    pool->freeCount += pool->objsPerSlab;
+  }
+
+  while (pool->freeList != NULL && cache->count < (SLAB_CACHE_SIZE / 2))
+  {
+    obj = pool->freeList;
+    pool->freeList = *(void**)obj;
+    pool->freeCount--;
+    cache->objects[cache->count++] = obj;
+  }
+  unlockMutex(&pool->mutex);
+
+  return true;
+}
+
+/**
+ * Allocate an object from the pool. The memory is NOT initialized.
+ *
+ * @param pool The pool
+ *
+ * @return The object or NULL if no memory is available.
+ */
+void* allocFromSlab(SlabPool* pool)
+{
+  SlabCache* cache = _getCache(pool);
+
+  if (cache == NULL)
+  {
+    return NULL;
+  }
+  if (cache->count == 0)
+  {
+    if (!_refillCache(pool, cache))
+    {
+      return NULL;
+    }
+  }
+
+  __atomic_store_n(&cache->allocs, cache->allocs + 1, __ATOMIC_RELAXED);
+  return cache->objects[--cache->count];
+}
+
+/**
+ * Return the object to the pool it was allocated from.
+ *
+ * @param pool The pool
+ * @param obj The object, can be NULL.
+ */
+void freeToSlab(SlabPool* pool, void* obj)
+{
+  SlabCache* cache = NULL;
+
+  if (obj == NULL)
+  {
+    return;
+  }
+
+  cache = _getCache(pool);
+  if (cache == NULL)
+  {
+    // Not able to register a cache, put it back directly.
+    lockMutex(&pool->mutex);
+    *(void**)obj   = pool->freeList;
+    pool->freeList = obj;
+    pool->freeCount++;
+    unlockMutex(&pool->mutex);
+    return;
+  }
+
+  if (cache->count == SLAB_CACHE_SIZE)
+  {
+    _flushCache(pool, cache, SLAB_CACHE_SIZE / 2);
+  }
+  cache->objects[cache->count++] = obj;
+  __atomic_store_n(&cache->frees, cache->frees + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Return the size class for the given size.
+ *
+ * @param size The number of bytes (> 0)
+ *
+ * @return The index of the class, SLAB_NUM_CLASSES if the size is too large.
+ */
+static inline int _getSizeClass(size_t size)
+{
+  int sClass = 0;
+
+  if (size > (1 << SLAB_MIN_SHIFT))
+  {
+    sClass = (int)(sizeof(unsigned long) * 8)
+             - __builtin_clzl((unsigned long)(size - 1)) - SLAB_MIN_SHIFT;
+  }
+
+  return sClass < SLAB_NUM_CLASSES ? sClass : SLAB_NUM_CLASSES;
+}
+
+/**
+ * Allocate memory of the given size from the smallest fitting size class.
+ * Sizes above the largest class are allocated using malloc. The memory is NOT
+ * initialized.
+ *
+ * @param size The number of bytes needed.
+ *
+ * @return The memory or NULL if size is 0 or no memory is available.
+ */
+void* allocSlabData(size_t size)
+{
+  int sClass;
+
+  if (size == 0)
+  {
+    return NULL;
+  }
+  sClass = _getSizeClass(size);
+
+  return sClass < SLAB_NUM_CLASSES ? allocFromSlab(&_dataPools[sClass])
+                                   : malloc(size);
+}
+
+/**
+ * Release memory allocated using allocSlabData.
+ *
+ * @param data The memory, can be NULL.
+ * @param size The size that was provided when allocating the memory.
+ */
+void freeSlabData(void* data, size_t size)
+{
+  int sClass;
+
+  if (data != NULL)
+  {
+    sClass = _getSizeClass(size);
+    if (sClass < SLAB_NUM_CLASSES)
+    {
+      freeToSlab(&_dataPools[sClass], data);
+    }
+    else
+    {
+      free(data);
+    }
+  }
+}
+
+/**
+ * Fill the statistics of all pools set up so far.
+ *
+ * @param stats The array receiving the statistics.
+ * @param maxStats The number of elements in the array.
+ *
+ * @return The number of pools, can be larger than maxStats.
+ */
+int getSlabStatistics(SlabStats* stats, int maxStats)
+{
+  SlabPool*  pool  = NULL;
+  SlabCache* cache = NULL;
+  SlabStats* stat  = NULL;
+  int        count = 0;
+
+  pthread_mutex_lock(&_poolMutex);
+  for (pool = _pools; pool != NULL; pool = pool->next, count++)
+  {
+    if (count >= maxStats)
+    {
+      continue;
+    }
+    stat = &stats[count];
+    stat->name     = pool->name;
+    stat->slotSize = pool->slotSize;
+    stat->allocs   = 0;
+    stat->frees    = 0;
+    stat->cached   = 0;
+
+    lockMutex(&pool->mutex);
+    stat->numSlabs = pool->numSlabs;
+    stat->capacity = (uint64_t)pool->numSlabs * pool->objsPerSlab;
+    for (cache = pool->caches; cache != NULL; cache = cache->next)
+    {
+      stat->allocs += __atomic_load_n(&cache->allocs, __ATOMIC_RELAXED);
+      stat->frees  += __atomic_load_n(&cache->frees,  __ATOMIC_RELAXED);
+      stat->cached += __atomic_load_n(&cache->count,  __ATOMIC_RELAXED);
+    }
+    unlockMutex(&pool->mutex);
+
+    // The counters of other threads might be slightly behind
+    stat->inUse = stat->allocs > stat->frees ? stat->allocs - stat->frees : 0;
+  }
+  pthread_mutex_unlock(&_poolMutex);
+
+  return count;
+}
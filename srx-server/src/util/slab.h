@@ -0,0 +1,177 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ *
+ * Slab pools for objects that are allocated and released per update. A pool
+ * hands out objects of one fixed size that are carved from large slabs. The
+ * slabs are never returned to the system, released objects are kept for
+ * re-use. Each thread keeps a small cache of objects per pool, therefore most
+ * allocations and releases do not need to lock the pool.
+ *
+ * Pools are declared static using SLAB_POOL_INITIALIZER and set up with their
+ * first allocation. Data of variable length can be allocated from a set of
+ * size classes using allocSlabData / freeSlabData.
+ *
+ * @version 0.6.2.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Code created.
+ */
+
+#ifndef __SLAB_H__
+#define __SLAB_H__
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "util/mutex.h"
+
+/** Number of objects a thread keeps cached per pool */
+#define SLAB_CACHE_SIZE 32
+/** The size of a single slab */
+#define SLAB_SIZE       65536
+
+/** The per thread object cache of one pool. */
+typedef struct _SlabCache {
+  /** The pool this cache belongs to */
+  struct _SlabPool*  pool;
+  /** The cached objects */
+  void*              objects[SLAB_CACHE_SIZE];
+  /** Number of cached objects */
+  uint32_t           count;
+  /** Number of objects allocated by the thread(s) using this cache */
+  uint64_t           allocs;
+  /** Number of objects released by the thread(s) using this cache */
+  uint64_t           frees;
+  /** Indicates if the cache is assigned to a living thread */
+  bool               inUse;
+  struct _SlabCache* next;
+} SlabCache;
+
+/** A pool of objects of the same size. */
+typedef struct _SlabPool {
+  /** The name displayed in the statistics */
+  const char*        name;
+  /** The requested object size */
+  size_t             objSize;
+  /** The object size including alignment */
+  size_t             slotSize;
+  /** Number of objects per slab */
+  uint32_t           objsPerSlab;
+  /** Number of slabs allocated */
+  uint32_t           numSlabs;
+  /** All slabs of this pool */
+  void*              slabs;
+  /** Released objects not held by any thread cache */
+  void*              freeList;
+  /** Number of objects in the free list */
+  uint32_t           freeCount;
+  /** All thread caches ever registered */
+  SlabCache*         caches;
+  /** Protects slabs, free list and the list of caches */
+  Mutex              mutex;
+  /** Provides the cache of the calling thread */
+  pthread_key_t      cacheKey;
+  /** Indicates if the pool is set up */
+  bool               initialized;
+  /** The next pool in the list of all pools */
+  struct _SlabPool*  next;
+} SlabPool;
+
+/** The statistics of one pool. */
+typedef struct {
+  const char* name;
+  /** The object size including alignment */
+  size_t      slotSize;
+  /** Number of slabs allocated */
+  uint32_t    numSlabs;
+  /** Number of objects all slabs can hold */
+  uint64_t    capacity;
+  /** Number of objects currently in use */
+  uint64_t    inUse;
+  /** Number of objects held in thread caches */
+  uint64_t    cached;
+  /** Total number of allocations */
+  uint64_t    allocs;
+  /** Total number of releases */
+  uint64_t    frees;
+} SlabStats;
+
+/**
+ * Static initializer of a pool.
+ *
+ * @param NAME The name of the pool
+ * @param SIZE The size of the objects
+ */
+#define SLAB_POOL_INITIALIZER(NAME, SIZE) \
+  { .name = (NAME), .objSize = (SIZE), .mutex = PTHREAD_MUTEX_INITIALIZER, \
+    .initialized = false }
+
+/**
+ * Allocate an object from the pool. The memory is NOT initialized.
+ *
+ * @param pool The pool
+ *
+ * @return The object or NULL if no memory is available.
+ */
+extern void* allocFromSlab(SlabPool* pool);
+
+/**
+ * Return the object to the pool it was allocated from.
+ *
+ * @param pool The pool
+ * @param obj The object, can be NULL.
+ */
+extern void freeToSlab(SlabPool* pool, void* obj);
+
+/**
+ * Allocate memory of the given size from the smallest fitting size class.
+ * Sizes above the largest class are allocated using malloc. The memory is NOT
+ * initialized.
+ *
+ * @param size The number of bytes needed.
+ *
+ * @return The memory or NULL if size is 0 or no memory is available.
+ */
+extern void* allocSlabData(size_t size);
+
+/**
+ * Release memory allocated using allocSlabData.
+ *
+ * @param data The memory, can be NULL.
+ * @param size The size that was provided when allocating the memory.
+ */
+extern void freeSlabData(void* data, size_t size);
+
+/**
+ * Fill the statistics of all pools set up so far.
+ *
+ * @param stats The array receiving the statistics.
+ * @param maxStats The number of elements in the array.
+ *
+ * @return The number of pools, can be larger than maxStats.
+ */
+extern int getSlabStatistics(SlabStats* stats, int maxStats);
+
+#endif // !__SLAB_H__
@@ -0,0 +1,236 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ *
+ * Hierarchical timing wheel. Ticks are compared as signed differences,
+ * therefore the wheel keeps working when the tick counter wraps.
+ *
+ * @version 0.6.2.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Code created.
+ */
+#include <string.h>
+#include "util/timer_wheel.h"
+
+#define TW_SLOT_MASK (TW_SLOTS - 1)
+/** The number of ticks covered by the wheel */
+#define TW_RANGE     ((uint32_t)1 << (TW_SLOT_BITS * TW_LEVELS))
+
+/**
+ * Insert the timer into the slot matching its remaining time.
+ *
+ * @param wheel The wheel
+ * @param timer The timer, its expiry must not be before the current tick.
+ */
+static void _placeTimer(TimerWheel* wheel, TW_Timer* timer)
+{
+  uint32_t delta = timer->expires - wheel->now;
+  uint32_t at    = timer->expires;
+  int level      = 0;
+
+  if (delta >= TW_RANGE)
+  {
+    // Keep it in the last slot reachable, it is re-placed from there.
+    at    = wheel->now + TW_RANGE - 1;
+    delta = TW_RANGE - 1;
+  }
+  while (delta >= ((uint32_t)1 << (TW_SLOT_BITS * (level + 1))))
+  {
+    level++;
+  }
+
+  TW_Timer** slot = &wheel->slots[level]
+                                 [(at >> (TW_SLOT_BITS * level)) & TW_SLOT_MASK];
+  timer->next  = *slot;
+  timer->pprev = slot;
+  if (*slot != NULL)
+  {
+    (*slot)->pprev = &timer->next;
+  }
+  *slot = timer;
+}
+
+/**
+ * Remove the timer from its slot.
+ *
+ * @param timer The scheduled timer
+ */
+static void _unlinkTimer(TW_Timer* timer)
+{
+  *timer->pprev = timer->next;
+  if (timer->next != NULL)
+  {
+    timer->next->pprev = timer->pprev;
+  }
+  timer->next  = NULL;
+  timer->pprev = NULL;
+}
+
+/**
+ * Move all timers of the given slot into lower levels.
+ *
+ * @param wheel The wheel
+ * @param level The level of the slot
+ * @param index The index of the slot
+ */
+static void _cascade(TimerWheel* wheel, int level, int index)
+{
+  TW_Timer* timer = wheel->slots[level][index];
+  wheel->slots[level][index] = NULL;
+
+  while (timer != NULL)
+  {
+    TW_Timer* next = timer->next;
+    _placeTimer(wheel, timer);
+    timer = next;
+  }
+}
+
+/**
+ * Initialize the wheel.
+ *
+ * @param wheel The wheel
+ * @param now The current tick
+ */
+void initTimerWheel(TimerWheel* wheel, uint32_t now)
+{
+  memset(wheel, 0, sizeof(TimerWheel));
+  wheel->now = now;
+}
+
+/**
+ * Initialize a timer. This must be called once before the timer is used.
+ *
+ * @param timer The timer
+ */
+void initTimer(TW_Timer* timer)
+{
+  timer->next    = NULL;
+  timer->pprev   = NULL;
+  timer->expires = 0;
+}
+
+/**
+ * Schedule the timer. A timer that is scheduled already is moved. A timer
+ * that expires at or before the current tick expires with the next tick,
+ * one that expires beyond the range of the wheel is kept in the last slot
+ * and re-placed until it is due.
+ *
+ * @param wheel The wheel
+ * @param timer The timer
+ * @param expires The tick the timer expires
+ */
+void scheduleTimer(TimerWheel* wheel, TW_Timer* timer, uint32_t expires)
+{
+  if (timer->pprev != NULL)
+  {
+    _unlinkTimer(timer);
+    wheel->count--;
+  }
+  if ((int32_t)(expires - wheel->now) <= 0)
+  {
+    expires = wheel->now + 1;
+  }
+  timer->expires = expires;
+  _placeTimer(wheel, timer);
+  wheel->count++;
+}
+
+/**
+ * Remove the timer from the wheel. Nothing happens if the timer is not
+ * scheduled.
+ *
+ * @param wheel The wheel
+ * @param timer The timer
+ */
+void cancelTimer(TimerWheel* wheel, TW_Timer* timer)
+{
+  if (timer->pprev != NULL)
+  {
+    _unlinkTimer(timer);
+    wheel->count--;
+  }
+}
+
+/**
+ * Determine if the timer is scheduled.
+ *
+ * @param timer The timer
+ *
+ * @return true if the timer is in the wheel.
+ */
+bool isTimerScheduled(TW_Timer* timer)
+{
+  return timer->pprev != NULL;
+}
+
+/**
+ * Advance the wheel up to the given tick and remove all timers that expired.
+ * The expired timers are returned as a list linked by their next field,
+ * they are not scheduled anymore.
+ *
+ * @param wheel The wheel
+ * @param now The current tick
+ *
+ * @return The expired timers or NULL.
+ */
+TW_Timer* advanceTimerWheel(TimerWheel* wheel, uint32_t now)
+{
+  TW_Timer*  expired = NULL;
+  TW_Timer** tail    = &expired;
+
+  while ((int32_t)(now - wheel->now) > 0)
+  {
+    wheel->now++;
+
+    // Find the highest level whose slot is reached with this tick and move
+    // the timers down, starting with the highest level.
+    int level = 0;
+    while (level < TW_LEVELS - 1
+           && ((wheel->now >> (TW_SLOT_BITS * level)) & TW_SLOT_MASK) == 0)
+    {
+      level++;
+    }
+    for (; level > 0; level--)
+    {
+      _cascade(wheel, level,
+               (wheel->now >> (TW_SLOT_BITS * level)) & TW_SLOT_MASK);
+    }
+
+    TW_Timer* timer = wheel->slots[0][wheel->now & TW_SLOT_MASK];
+    wheel->slots[0][wheel->now & TW_SLOT_MASK] = NULL;
+    while (timer != NULL)
+    {
+      TW_Timer* next = timer->next;
+      timer->pprev = NULL;
+      timer->next  = NULL;
+      *tail = timer;
+      tail  = &timer->next;
+      wheel->count--;
+      timer = next;
+    }
+  }
+
+  return expired;
+}
@@ -0,0 +1,131 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ *
+ * Hierarchical timing wheel. The wheel has TW_LEVELS levels of TW_SLOTS
+ * slots each, the slots of level n cover TW_SLOTS^n ticks. A timer is placed
+ * into the lowest level that covers its remaining time and is moved down a
+ * level each time the slot of its level is reached. Scheduling and
+ * cancelling a timer is O(1), advancing the wheel touches the expired timers
+ * and the timers moved down only.
+ *
+ * The timers are embedded into the objects they belong to. The wheel itself
+ * is NOT synchronized, the caller must protect it.
+ *
+ * @version 0.6.2.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.6.2.0 - 2026/10/18
+ *           * Code created.
+ */
+
+#ifndef __TIMER_WHEEL_H__
+#define __TIMER_WHEEL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Number of bits used for the slot index of a level */
+#define TW_SLOT_BITS 6
+/** Number of slots per level */
+#define TW_SLOTS     (1 << TW_SLOT_BITS)
+/** Number of levels */
+#define TW_LEVELS    4
+
+/** A timer embedded into the object it belongs to. */
+typedef struct _TW_Timer {
+  /** The next timer in the same slot or the next expired timer */
+  struct _TW_Timer*  next;
+  /** The link pointing to this timer, NULL if the timer is not scheduled */
+  struct _TW_Timer** pprev;
+  /** The tick the timer expires */
+  uint32_t           expires;
+} TW_Timer;
+
+/** The wheel. */
+typedef struct {
+  /** The slots of all levels */
+  TW_Timer* slots[TW_LEVELS][TW_SLOTS];
+  /** The current tick */
+  uint32_t  now;
+  /** Number of scheduled timers */
+  uint32_t  count;
+} TimerWheel;
+
+/**
+ * Initialize the wheel.
+ *
+ * @param wheel The wheel
+ * @param now The current tick
+ */
+void initTimerWheel(TimerWheel* wheel, uint32_t now);
+
+/**
+ * Initialize a timer. This must be called once before the timer is used.
+ *
+ * @param timer The timer
+ */
+void initTimer(TW_Timer* timer);
+
+/**
+ * Schedule the timer. A timer that is scheduled already is moved. A timer
+ * that expires at or before the current tick expires with the next tick,
+ * one that expires beyond the range of the wheel is kept in the last slot
+ * and re-placed until it is due.
+ *
+ * @param wheel The wheel
+ * @param timer The timer
+ * @param expires The tick the timer expires
+ */
+void scheduleTimer(TimerWheel* wheel, TW_Timer* timer, uint32_t expires);
+
+/**
+ * Remove the timer from the wheel. Nothing happens if the timer is not
+ * scheduled.
+ *
+ * @param wheel The wheel
+ * @param timer The timer
+ */
+void cancelTimer(TimerWheel* wheel, TW_Timer* timer);
+
+/**
+ * Determine if the timer is scheduled.
+ *
+ * @param timer The timer
+ *
+ * @return true if the timer is in the wheel.
+ */
+bool isTimerScheduled(TW_Timer* timer);
+
+/**
+ * Advance the wheel up to the given tick and remove all timers that expired.
+ * The expired timers are returned as a list linked by their next field,
+ * they are not scheduled anymore.
+ *
+ * @param wheel The wheel
+ * @param now The current tick
+ *
+ * @return The expired timers or NULL.
+ */
+TW_Timer* advanceTimerWheel(TimerWheel* wheel, uint32_t now);
+
+#endif // !__TIMER_WHEEL_H__